@@ -0,0 +1,159 @@
+#include "anomalydetector.h"
+#include <QHostAddress>
+#include <cmath>
+
+namespace {
+
+// عينات قبل الثقة بالمتوسط؛ قبلها لا تنبيه على القفزات
+const quint32 kWarmupSamples = 10;
+// الجهاز "جديد" خلال هذه المدة من أول ظهور
+const qint64 kNewDeviceMs = 10 * 60 * 1000;
+// نافذة عدّ العناوين لكل MAC
+const qint64 kAddressWindowMs = 10 * 60 * 1000;
+// الأجهزة الصامتة أطول من هذا تُحذف إحصاءاتها
+const qint64 kIdleEvictMs = 24 * 60 * 60 * 1000LL;
+
+void updateEwma(double value, double alpha, double *mean, double *variance) {
+    double diff = value - *mean;
+    double increment = alpha * diff;
+    *mean += increment;
+    *variance = (1.0 - alpha) * (*variance + diff * increment);
+}
+
+QString formatRate(double bytesPerSec) {
+    return QString("%1 MB/s").arg(bytesPerSec / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+} // namespace
+
+AnomalyDetector::AnomalyDetector(QObject *parent)
+    : QObject(parent), m_evictTimer(new QTimer(this))
+{
+    // التنظيف دوري ومطفأ الكلفة، لا يمس مسار العينات
+    m_evictTimer->start(10 * 60 * 1000);
+    connect(m_evictTimer, &QTimer::timeout, this, &AnomalyDetector::evictIdle);
+}
+
+void AnomalyDetector::setSensitivity(double zThreshold, double alpha) {
+    m_zThreshold = zThreshold;
+    m_alpha = qBound(0.001, alpha, 1.0);
+}
+
+AnomalyDetector::Stats &AnomalyDetector::statsFor(const QString &macAddress, qint64 nowMs) {
+    auto it = m_stats.find(macAddress);
+    if (it == m_stats.end()) {
+        it = m_stats.insert(macAddress, Stats());
+        it->firstSeenMs = nowMs;
+        it->addressWindowStartMs = nowMs;
+    }
+    return it.value();
+}
+
+void AnomalyDetector::observeTraffic(const QString &macAddress, qint64 bytesReceived, qint64 bytesSent,
+                                     qint64 timestampMs) {
+    if (macAddress.isEmpty()) {
+        return;
+    }
+    Stats &stats = statsFor(macAddress, timestampMs);
+
+    qint64 elapsedMs = timestampMs - stats.lastSampleMs;
+    bool haveDelta = stats.lastSent >= 0 && elapsedMs > 0 &&
+                     bytesSent >= stats.lastSent && bytesReceived >= stats.lastReceived;
+    double upRate = haveDelta ? (bytesSent - stats.lastSent) * 1000.0 / elapsedMs : 0.0;
+    double downRate = haveDelta ? (bytesReceived - stats.lastReceived) * 1000.0 / elapsedMs : 0.0;
+
+    stats.lastSampleMs = timestampMs;
+    stats.lastSent = bytesSent;
+    stats.lastReceived = bytesReceived;
+    if (!haveDelta) {
+        return; // أول عينة أو إعادة ضبط العدادات بعد إعادة ارتباط
+    }
+
+    if (timestampMs - stats.firstSeenMs < kNewDeviceMs && upRate >= m_heavyNewRate) {
+        raise(stats, TrafficAlert::HeavyNewDevice, macAddress,
+              QString("جهاز جديد %1 يرفع بمعدل %2").arg(macAddress, formatRate(upRate)),
+              upRate, stats.meanUp, timestampMs);
+    }
+
+    if (stats.samples >= kWarmupSamples && upRate >= m_minUploadRate) {
+        double deviation = std::sqrt(std::max(stats.varUp, 0.0));
+        // تباين شبه صفري لجهاز ثابت السلوك: نعتبر الحد الأدنى 10% من المتوسط
+        deviation = std::max(deviation, stats.meanUp * 0.1);
+        if (upRate > stats.meanUp + m_zThreshold * deviation) {
+            raise(stats, TrafficAlert::UploadSpike, macAddress,
+                  QString("قفزة رفع من %1: %2 (المعتاد %3)")
+                      .arg(macAddress, formatRate(upRate), formatRate(stats.meanUp)),
+                  upRate, stats.meanUp, timestampMs);
+        }
+    }
+
+    updateEwma(upRate, m_alpha, &stats.meanUp, &stats.varUp);
+    updateEwma(downRate, m_alpha, &stats.meanDown, &stats.varDown);
+    ++stats.samples;
+}
+
+void AnomalyDetector::observeAddress(const QString &macAddress, const QString &ipv4Address) {
+    QHostAddress address(ipv4Address);
+    if (macAddress.isEmpty() || address.protocol() != QAbstractSocket::IPv4Protocol) {
+        return;
+    }
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    Stats &stats = statsFor(macAddress, now);
+
+    if (now - stats.addressWindowStartMs > kAddressWindowMs) {
+        stats.addressCount = 0;
+        stats.addressWindowStartMs = now;
+    }
+
+    // بحث خطي في 8 خانات على الأكثر
+    quint32 ip = address.toIPv4Address();
+    for (int i = 0; i < stats.addressCount; ++i) {
+        if (stats.addresses[i] == ip) {
+            return;
+        }
+    }
+    if (stats.addressCount < kAddressSlots) {
+        stats.addresses[stats.addressCount++] = ip;
+    }
+
+    if (stats.addressCount >= m_addressLimit) {
+        raise(stats, TrafficAlert::ManyAddresses, macAddress,
+              QString("الجهاز %1 استخدم %2 عناوين IPv4 خلال دقائق (انتحال ARP محتمل)")
+                  .arg(macAddress).arg(stats.addressCount),
+              stats.addressCount, 1.0, now);
+    }
+}
+
+void AnomalyDetector::forget(const QString &macAddress) {
+    m_stats.remove(macAddress);
+}
+
+void AnomalyDetector::raise(Stats &stats, TrafficAlert::Kind kind, const QString &macAddress,
+                            const QString &message, double value, double baseline, qint64 nowMs) {
+    qint64 &last = stats.lastAlertMs[kind];
+    if (last != 0 && nowMs - last < m_cooldownMs) {
+        return;
+    }
+    last = nowMs;
+
+    TrafficAlert alert;
+    alert.kind = kind;
+    alert.macAddress = macAddress;
+    alert.message = message;
+    alert.value = value;
+    alert.baseline = baseline;
+    alert.when = QDateTime::fromMSecsSinceEpoch(nowMs);
+    emit alertRaised(alert);
+}
+
+void AnomalyDetector::evictIdle() {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_stats.begin(); it != m_stats.end();) {
+        qint64 lastActivity = std::max(it->lastSampleMs, it->addressWindowStartMs);
+        if (now - lastActivity > kIdleEvictMs) {
+            it = m_stats.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef ANOMALYDETECTOR_H
+#define ANOMALYDETECTOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QDateTime>
+#include <array>
+
+struct TrafficAlert {
+    enum Kind {
+        UploadSpike,      // رفع أعلى بكثير من المعتاد لهذا الجهاز
+        HeavyNewDevice,   // جهاز ظهر للتو ويرسل بكثافة
+        ManyAddresses,    // MAC واحد يدعي عناوين IPv4 كثيرة (انتحال ARP محتمل)
+        AddressConflict,  // عنوان IPv4 واحد يدعيه أكثر من MAC في الوقت نفسه (ArpGuard)
+        WatchedMacChanged,// تغير MAC البوابة أو عنوان محمي آخر (ArpGuard)
+        GratuitousFlood,  // سيل ARP مجاني من جهاز واحد (ArpGuard)
+        KindCount
+    };
+
+    Kind kind = UploadSpike;
+    QString macAddress;
+    QString message;
+    double value = 0.0;       // القيمة المرصودة (بايت/ث أو عدد العناوين)
+    double baseline = 0.0;    // المتوسط المتوقع وقت الرصد
+    QDateTime when;
+};
+
+// كشف السلوك الشاذ لكل جهاز بإحصاءات متدفقة: متوسط وتباين أسيان (EWMA)
+// لمعدل الرفع والتنزيل، وعدد ثابت من خانات العناوين الحديثة. الذاكرة ثابتة
+// لكل جهاز وكلفة كل عينة O(1) مهما بلغ عدد الأجهزة.
+class AnomalyDetector : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AnomalyDetector(QObject *parent = nullptr);
+
+    // zThreshold: عدد الانحرافات المعيارية فوق المتوسط، alpha: وزن العينة الجديدة
+    void setSensitivity(double zThreshold, double alpha);
+    // أقل معدل رفع (بايت/ث) يستحق تنبيهاً؛ يمنع التنبيه على أجهزة شبه صامتة
+    void setMinimumUploadRate(double bytesPerSec) { m_minUploadRate = bytesPerSec; }
+    void setHeavyNewDeviceRate(double bytesPerSec) { m_heavyNewRate = bytesPerSec; }
+    void setAddressLimit(int addresses) { m_addressLimit = qBound(2, addresses, kAddressSlots); }
+    void setCooldown(int ms) { m_cooldownMs = ms; }
+
+    // عدادات تراكمية من مصدر القياس (نقطة الوصول)؛ المعدل يُشتق من الفرق
+    void observeTraffic(const QString &macAddress, qint64 bytesReceived, qint64 bytesSent, qint64 timestampMs);
+    void observeAddress(const QString &macAddress, const QString &ipv4Address);
+    void forget(const QString &macAddress);
+
+    int trackedCount() const { return m_stats.size(); }
+
+signals:
+    void alertRaised(const TrafficAlert &alert);
+
+private slots:
+    void evictIdle();
+
+private:
+    static constexpr int kAddressSlots = 8;
+
+    struct Stats {
+        qint64 firstSeenMs = 0;
+        qint64 lastSampleMs = 0;
+        qint64 lastReceived = -1;
+        qint64 lastSent = -1;
+        double meanUp = 0.0;
+        double varUp = 0.0;
+        double meanDown = 0.0;
+        double varDown = 0.0;
+        quint32 samples = 0;
+        std::array<qint64, TrafficAlert::KindCount> lastAlertMs = {};
+        std::array<quint32, kAddressSlots> addresses = {};
+        quint8 addressCount = 0;
+        qint64 addressWindowStartMs = 0;
+    };
+
+    QHash<QString, Stats> m_stats;
+    QTimer *m_evictTimer;
+
+    double m_zThreshold = 4.0;
+    double m_alpha = 0.1;
+    double m_minUploadRate = 1024.0 * 1024.0;
+    double m_heavyNewRate = 5.0 * 1024.0 * 1024.0;
+    int m_addressLimit = 4;
+    int m_cooldownMs = 10 * 60 * 1000;
+
+    Stats &statsFor(const QString &macAddress, qint64 nowMs);
+    void raise(Stats &stats, TrafficAlert::Kind kind, const QString &macAddress,
+               const QString &message, double value, double baseline, qint64 nowMs);
+};
+
+#endif // ANOMALYDETECTOR_H
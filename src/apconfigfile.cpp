@@ -0,0 +1,217 @@
+#include "apconfigfile.h"
+#include <QFileInfo>
+
+namespace {
+
+bool isPrintable(const QByteArray &bytes) {
+    for (char c : bytes) {
+        quint8 byte = quint8(c);
+        if (byte < 0x20 || byte == 0x7f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// بداية المفتاح بعد المسافات البادئة؛ -1 للتعليقات والأسطر الفارغة
+int keyStart(const QByteArray &line) {
+    int start = 0;
+    while (start < line.size() && (line[start] == ' ' || line[start] == '\t')) {
+        ++start;
+    }
+    if (start == line.size() || line[start] == '#') {
+        return -1;
+    }
+    return start;
+}
+
+} // namespace
+
+ApConfigFile::ApConfigFile(Format format)
+    : m_format(format)
+{
+}
+
+ApConfigFile::Format ApConfigFile::formatFor(const QString &path) {
+    return QFileInfo(path).fileName().startsWith("wpa_supplicant") ? Supplicant : Hostapd;
+}
+
+void ApConfigFile::parse(const QByteArray &contents) {
+    m_crlf = contents.contains("\r\n");
+    m_lines = contents.split('\n');
+    if (m_crlf) {
+        for (QByteArray &line : m_lines) {
+            if (line.endsWith('\r')) {
+                line.chop(1);
+            }
+        }
+    }
+    m_modified = false;
+    index();
+}
+
+void ApConfigFile::index() {
+    m_keyLines.clear();
+    m_blockEnd = -1;
+
+    bool inBlock = false;
+    bool blockSeen = false;
+    for (int i = 0; i < m_lines.size(); ++i) {
+        const QByteArray &line = m_lines[i];
+        int start = keyStart(line);
+        if (start < 0) {
+            continue;
+        }
+        if (m_format == Supplicant) {
+            QByteArray trimmed = line.trimmed();
+            if (!inBlock) {
+                // لا نعدل إلا أول شبكة؛ الشبكات الأخرى للمستخدم
+                if (!blockSeen && trimmed.startsWith("network=") && trimmed.endsWith('{')) {
+                    inBlock = true;
+                    blockSeen = true;
+                }
+                continue;
+            }
+            if (trimmed == "}") {
+                inBlock = false;
+                m_blockEnd = i;
+                continue;
+            }
+        }
+        int equals = line.indexOf('=', start);
+        if (equals > start) {
+            m_keyLines[line.mid(start, equals - start).trimmed()].append(i);
+        }
+    }
+}
+
+QByteArray ApConfigFile::serialize() const {
+    return m_lines.join(m_crlf ? "\r\n" : "\n");
+}
+
+bool ApConfigFile::contains(const QString &key) const {
+    return m_keyLines.contains(key.toUtf8());
+}
+
+QString ApConfigFile::value(const QString &key) const {
+    auto it = m_keyLines.constFind(key.toUtf8());
+    if (it == m_keyLines.constEnd()) {
+        return QString();
+    }
+    // hostapd يعتمد آخر تعريف للمفتاح
+    const QByteArray &line = m_lines[it->last()];
+    QByteArray raw = line.mid(line.indexOf('=') + 1);
+    if (m_format == Supplicant) {
+        raw = raw.trimmed();
+        if (raw.size() >= 2 && raw.startsWith('"') && raw.endsWith('"')) {
+            return QString::fromUtf8(raw.mid(1, raw.size() - 2));
+        }
+        if (key == "ssid") {
+            return QString::fromUtf8(QByteArray::fromHex(raw));
+        }
+    }
+    return QString::fromUtf8(raw);
+}
+
+QByteArray ApConfigFile::encodeValue(const QString &key, const QString &value) const {
+    QByteArray bytes = value.toUtf8();
+    if (m_format == Hostapd) {
+        return bytes;
+    }
+    if (key == "ssid" && !isPrintable(bytes)) {
+        return bytes.toHex();
+    }
+    if (key == "ssid" || key == "psk") {
+        return '"' + bytes + '"';
+    }
+    return bytes;
+}
+
+bool ApConfigFile::set(const QString &key, const QString &value, QString *error) {
+    if (!validate(key, value, error)) {
+        return false;
+    }
+    const QByteArray keyBytes = key.toUtf8();
+    const QByteArray encoded = encodeValue(key, value);
+
+    auto it = m_keyLines.constFind(keyBytes);
+    if (it != m_keyLines.constEnd()) {
+        // كل تكرارات المفتاح، حتى لا يتغلب تعريف قديم على الجديد
+        for (int lineIndex : *it) {
+            QByteArray &line = m_lines[lineIndex];
+            int start = keyStart(line);
+            QByteArray replacement = line.left(start) + keyBytes + '=' + encoded;
+            if (line != replacement) {
+                line = replacement;
+                m_modified = true;
+            }
+        }
+        return true;
+    }
+
+    if (m_format == Supplicant) {
+        if (m_blockEnd < 0) {
+            if (error) {
+                *error = "لا توجد كتلة network في الملف";
+            }
+            return false;
+        }
+        m_lines.insert(m_blockEnd, '\t' + keyBytes + '=' + encoded);
+    } else {
+        // قبل السطر الفارغ الأخير الناتج عن نهاية الملف
+        int position = !m_lines.isEmpty() && m_lines.last().isEmpty() ? m_lines.size() - 1 : m_lines.size();
+        m_lines.insert(position, keyBytes + '=' + encoded);
+    }
+    m_modified = true;
+    index();
+    return true;
+}
+
+bool ApConfigFile::apply(const QHash<QString, QString> &changes, QString *error) {
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (!validate(it.key(), it.value(), error)) {
+            return false;
+        }
+    }
+
+    const QList<QByteArray> original = m_lines;
+    const bool wasModified = m_modified;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (!set(it.key(), it.value(), error)) {
+            m_lines = original;
+            m_modified = wasModified;
+            index();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ApConfigFile::validate(const QString &key, const QString &value, QString *error) {
+    QString problem;
+    const QByteArray bytes = value.toUtf8();
+    if (key.isEmpty() || key.contains('=') || key.contains('\n') || key.contains('#')) {
+        problem = QString("مفتاح غير صالح: %1").arg(key);
+    } else if (bytes.contains('\n') || bytes.contains('\r') || bytes.contains('\0')) {
+        problem = "القيمة تحتوي على سطر جديد";
+    } else if (key == "ssid" && (bytes.isEmpty() || bytes.size() > 32)) {
+        problem = "اسم الشبكة يجب أن يكون بين 1 و 32 بايت";
+    } else if ((key == "wpa_passphrase" || key == "psk") &&
+               (bytes.size() < 8 || bytes.size() > 63 || !isPrintable(bytes) || bytes.size() != value.size())) {
+        problem = "كلمة المرور يجب أن تكون بين 8 و 63 محرفاً ASCII";
+    } else if (key == "channel") {
+        bool ok = false;
+        int channel = value.toInt(&ok);
+        if (!ok || channel < 0 || channel > 233) {
+            problem = QString("قناة غير صالحة: %1").arg(value);
+        }
+    }
+
+    if (problem.isEmpty()) {
+        return true;
+    }
+    if (error) {
+        *error = problem;
+    }
+    return false;
+}
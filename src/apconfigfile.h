@@ -0,0 +1,58 @@
+#ifndef APCONFIGFILE_H
+#define APCONFIGFILE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include <QString>
+
+// محرر ملفات hostapd.conf و wpa_supplicant.conf داخل العملية. يحتفظ بكل
+// سطر كما هو (التعليقات والترتيب والمسافات ونهايات الأسطر) ويستبدل قيم
+// المفاتيح المطلوبة فقط، فتُكتب عدة تغييرات في كتابة ذرية واحدة.
+//
+// hostapd: key=value في المستوى الأعلى، والقيمة حتى نهاية السطر دون تفسير.
+// wpa_supplicant: المفاتيح داخل أول كتلة network={...}، والنصوص بين
+// علامتي تنصيص أو بترميز hex عند وجود محارف غير قابلة للطباعة.
+class ApConfigFile {
+public:
+    enum Format {
+        Hostapd,
+        Supplicant
+    };
+
+    explicit ApConfigFile(Format format = Hostapd);
+
+    // الصيغة من اسم الملف
+    static Format formatFor(const QString &path);
+
+    void parse(const QByteArray &contents);
+    QByteArray serialize() const;
+
+    bool contains(const QString &key) const;
+    QString value(const QString &key) const;
+
+    // يضيف المفتاح إن غاب (في نهاية الملف، أو آخر كتلة الشبكة)
+    bool set(const QString &key, const QString &value, QString *error = nullptr);
+
+    // كل التغييرات أو لا شيء
+    bool apply(const QHash<QString, QString> &changes, QString *error = nullptr);
+
+    Format format() const { return m_format; }
+    bool isModified() const { return m_modified; }
+
+    // قيود hostapd نفسها: SSID من 1 إلى 32 بايت، وكلمة المرور 8-63 محرفاً قابلاً للطباعة
+    static bool validate(const QString &key, const QString &value, QString *error = nullptr);
+
+private:
+    Format m_format;
+    QList<QByteArray> m_lines;
+    QHash<QByteArray, QList<int>> m_keyLines; // المفتاح -> أسطره (أول كتلة شبكة في wpa_supplicant)
+    int m_blockEnd = -1;                 // سطر "}" لأول كتلة network
+    bool m_crlf = false;
+    bool m_modified = false;
+
+    void index();
+    QByteArray encodeValue(const QString &key, const QString &value) const;
+};
+
+#endif // APCONFIGFILE_H
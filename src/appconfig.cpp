@@ -0,0 +1,310 @@
+#include "appconfig.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStandardPaths>
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace {
+
+// المحررات تكتب عادة ملفاً مؤقتاً ثم تعيد تسميته؛ ننتظر حتى تهدأ الأحداث
+const int kReloadDelayMs = 200;
+
+class Reader {
+public:
+    explicit Reader(QString *error) : m_error(error) {}
+
+    bool ok() const { return m_ok; }
+
+    void readInt(const QJsonObject &object, const QString &key, int minimum, int maximum, int *value) {
+        QJsonValue field = object.value(key);
+        if (field.isUndefined()) {
+            return;
+        }
+        if (!field.isDouble() || field.toDouble() != double(field.toInt())) {
+            fail(QString("%1 يجب أن يكون عدداً صحيحاً").arg(key));
+            return;
+        }
+        int number = field.toInt();
+        if (number < minimum || number > maximum) {
+            fail(QString("%1 خارج المدى %2..%3").arg(key).arg(minimum).arg(maximum));
+            return;
+        }
+        *value = number;
+    }
+
+    void readBool(const QJsonObject &object, const QString &key, bool *value) {
+        QJsonValue field = object.value(key);
+        if (field.isUndefined()) {
+            return;
+        }
+        if (!field.isBool()) {
+            fail(QString("%1 يجب أن يكون true أو false").arg(key));
+            return;
+        }
+        *value = field.toBool();
+    }
+
+    void readString(const QJsonObject &object, const QString &key, QString *value) {
+        QJsonValue field = object.value(key);
+        if (field.isUndefined()) {
+            return;
+        }
+        if (!field.isString() || field.toString().isEmpty()) {
+            fail(QString("%1 يجب أن يكون نصاً غير فارغ").arg(key));
+            return;
+        }
+        *value = field.toString();
+    }
+
+    void readStringList(const QJsonObject &object, const QString &key, QStringList *value) {
+        QJsonValue field = object.value(key);
+        if (field.isUndefined()) {
+            return;
+        }
+        if (!field.isArray()) {
+            fail(QString("%1 يجب أن يكون مصفوفة نصوص").arg(key));
+            return;
+        }
+        QStringList items;
+        for (const QJsonValue &item : field.toArray()) {
+            if (!item.isString()) {
+                fail(QString("%1 يجب أن يكون مصفوفة نصوص").arg(key));
+                return;
+            }
+            items.append(item.toString());
+        }
+        *value = items;
+    }
+
+    // المسارات تصل إلى المساعد المميز وأوامر النظام كما هي
+    void checkPath(const QString &key, const QString &path) {
+        bool valid = path.startsWith('/');
+        for (QChar c : path) {
+            valid = valid && c.category() != QChar::Other_Control;
+        }
+        if (!valid) {
+            fail(QString("%1 يجب أن يكون مساراً مطلقاً دون محارف تحكم").arg(key));
+        }
+    }
+
+    // أسماء الوحدات تُمرر إلى systemctl؛ لا خيارات ولا محارف غريبة
+    void checkUnit(const QString &key, const QString &unit) {
+        static const QRegularExpression pattern("^[A-Za-z0-9@._:-]+$");
+        if (!pattern.match(unit).hasMatch() || unit.startsWith('-')) {
+            fail(QString("%1: اسم وحدة غير صالح: %2").arg(key, unit));
+        }
+    }
+
+    QJsonObject section(const QJsonObject &object, const QString &key) {
+        QJsonValue field = object.value(key);
+        if (!field.isUndefined() && !field.isObject()) {
+            fail(QString("%1 يجب أن يكون كائناً").arg(key));
+        }
+        return field.toObject();
+    }
+
+    void readScanProfile(const QJsonObject &object, AppConfig::ScanProfile *profile) {
+        readInt(object, "minIntervalMs", 500, 3600000, &profile->minIntervalMs);
+        readInt(object, "maxIntervalMs", 500, 3600000, &profile->maxIntervalMs);
+        readInt(object, "fullSweepIntervalMs", 10000, 86400000, &profile->fullSweepIntervalMs);
+        if (profile->maxIntervalMs < profile->minIntervalMs) {
+            fail("maxIntervalMs أصغر من minIntervalMs");
+        }
+    }
+
+    void fail(const QString &message) {
+        // أول خطأ يكفي لرفض الملف
+        if (m_ok && m_error) {
+            *m_error = message;
+        }
+        m_ok = false;
+    }
+
+private:
+    QString *m_error;
+    bool m_ok = true;
+};
+
+} // namespace
+
+ConfigManager::ConfigManager(QObject *parent)
+    : QObject(parent), m_watcher(new QFileSystemWatcher(this)), m_reloadTimer(new QTimer(this))
+{
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(kReloadDelayMs);
+    connect(m_reloadTimer, &QTimer::timeout, this, &ConfigManager::reload);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ConfigManager::onWatchedPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ConfigManager::onWatchedPathChanged);
+}
+
+QString ConfigManager::defaultPath() {
+    QString path = qEnvironmentVariable("WIFIMANAGER_CONFIG");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    if (QFile::exists("/etc/wifimanager/config.json")) {
+        return "/etc/wifimanager/config.json";
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) + "/config.json";
+}
+
+bool ConfigManager::load(const QString &path) {
+    m_path = path.isEmpty() ? defaultPath() : path;
+    watch();
+
+    QFile file(m_path);
+    if (!file.exists()) {
+        qDebug() << "Config: no file at" << m_path << "- using defaults";
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit errorOccurred(QString("تعذر قراءة ملف الإعدادات %1: %2").arg(m_path, file.errorString()));
+        return false;
+    }
+    m_contents = file.readAll();
+
+    AppConfig config;
+    QString error;
+    if (!parse(m_contents, &config, &error)) {
+        emit errorOccurred(QString("ملف الإعدادات %1 غير صالح: %2").arg(m_path, error));
+        return false;
+    }
+    m_config = config;
+    return true;
+}
+
+void ConfigManager::watch() {
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    // المجلد أيضاً: إعادة التسمية فوق الملف تزيله من المراقبة، وإنشاؤه لاحقاً يظهر هنا
+    QString directory = QFileInfo(m_path).absolutePath();
+    if (QFileInfo::exists(directory)) {
+        m_watcher->addPath(directory);
+    }
+    if (QFile::exists(m_path)) {
+        m_watcher->addPath(m_path);
+    }
+}
+
+void ConfigManager::onWatchedPathChanged() {
+    m_reloadTimer->start();
+}
+
+void ConfigManager::reload() {
+    // الملف المستبدل يحتاج إعادة إضافة إلى المراقب
+    if (QFile::exists(m_path) && !m_watcher->files().contains(m_path)) {
+        m_watcher->addPath(m_path);
+    }
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return; // حُذف الملف: نبقي الإعدادات الحالية
+    }
+    QByteArray contents = file.readAll();
+    if (contents == m_contents) {
+        return; // حدث في المجلد لا يخص ملفنا
+    }
+    m_contents = contents;
+
+    AppConfig config;
+    QString error;
+    if (!parse(contents, &config, &error)) {
+        emit errorOccurred(QString("ملف الإعدادات %1 غير صالح، الإعدادات السابقة باقية: %2").arg(m_path, error));
+        return;
+    }
+    qDebug() << "Config: reloaded" << m_path;
+    m_config = config;
+    emit configChanged(m_config);
+}
+
+bool ConfigManager::parse(const QByteArray &json, AppConfig *config, QString *error) {
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        if (error) {
+            *error = parseError.error != QJsonParseError::NoError
+                         ? QString("%1 عند الموضع %2").arg(parseError.errorString()).arg(parseError.offset)
+                         : QString("الجذر يجب أن يكون كائناً");
+        }
+        return false;
+    }
+
+    AppConfig result;
+    Reader reader(error);
+    QJsonObject root = document.object();
+
+    QJsonObject scan = reader.section(root, "scan");
+    reader.readScanProfile(reader.section(scan, "passive"), &result.passiveScan);
+    reader.readScanProfile(reader.section(scan, "active"), &result.activeScan);
+    reader.readInt(scan, "budgetMsPerMinute", 100, 60000, &result.scanBudgetMsPerMinute);
+    reader.readInt(scan, "budgetPacketsPerMinute", 10, 1000000, &result.scanBudgetPacketsPerMinute);
+    reader.readInt(scan, "subnetPrefix", 0, 30, &result.subnetPrefix);
+    if (result.subnetPrefix != 0 && result.subnetPrefix < 16) {
+        reader.fail("subnetPrefix أقل من 16 يعني مسح عشرات آلاف العناوين");
+    }
+
+    QJsonObject liveness = reader.section(root, "liveness");
+    reader.readInt(liveness, "probeAfterMs", 1000, 3600000, &result.probeAfterMs);
+    reader.readInt(liveness, "probeIntervalMs", 500, 600000, &result.probeIntervalMs);
+    reader.readInt(liveness, "missesBeforeInactive", 1, 100, &result.missesBeforeInactive);
+
+    QJsonObject intervals = reader.section(root, "intervals");
+    reader.readInt(intervals, "statsMs", 250, 60000, &result.statsIntervalMs);
+    reader.readInt(intervals, "networkInfoMs", 1000, 600000, &result.networkInfoIntervalMs);
+    reader.readInt(intervals, "telemetryMs", 500, 60000, &result.telemetryIntervalMs);
+
+    reader.readInt(root, "commandTimeoutMs", 1000, 300000, &result.commandTimeoutMs);
+
+    QJsonObject accessPoint = reader.section(root, "accessPoint");
+    reader.readStringList(accessPoint, "hostapdConfigPaths", &result.hostapdConfigPaths);
+    reader.readStringList(accessPoint, "supplicantConfigPaths", &result.supplicantConfigPaths);
+    reader.readString(accessPoint, "hostapdControlDir", &result.hostapdControlDir);
+    reader.readStringList(accessPoint, "services", &result.services);
+    for (const QString &path : result.hostapdConfigPaths) {
+        reader.checkPath("hostapdConfigPaths", path);
+    }
+    for (const QString &path : result.supplicantConfigPaths) {
+        reader.checkPath("supplicantConfigPaths", path);
+    }
+    reader.checkPath("hostapdControlDir", result.hostapdControlDir);
+    for (const QString &unit : result.services) {
+        reader.checkUnit("services", unit);
+    }
+
+    QJsonObject fingerprint = reader.section(root, "fingerprint");
+    reader.readBool(fingerprint, "enabled", &result.fingerprintEnabled);
+    reader.readBool(fingerprint, "probe", &result.fingerprintProbe);
+    reader.readInt(fingerprint, "maxConnections", 1, 64, &result.fingerprintMaxConnections);
+    reader.readInt(fingerprint, "hostIntervalMs", 0, 60000, &result.fingerprintHostIntervalMs);
+    reader.readInt(fingerprint, "connectTimeoutMs", 100, 30000, &result.fingerprintConnectTimeoutMs);
+
+    QJsonObject dnsLog = reader.section(root, "dnsLog");
+    reader.readString(dnsLog, "path", &result.dnsLogPath);
+    if (!result.dnsLogPath.isEmpty()) {
+        reader.checkPath("dnsLog.path", result.dnsLogPath);
+    }
+    reader.readInt(dnsLog, "capacity", 4, 4096, &result.dnsLogCapacity);
+
+    QJsonObject api = reader.section(root, "api");
+    reader.readString(api, "bind", &result.apiBind);
+    reader.readInt(api, "port", 0, 65535, &result.apiPort);
+    if (api.contains("token")) {
+        // نص فارغ مسموح هنا: يعيد الوضع المحلي فقط
+        result.apiToken = api.value("token").toString();
+    }
+
+    if (!reader.ok()) {
+        return false;
+    }
+    *config = result;
+    return true;
+}
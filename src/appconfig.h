@@ -0,0 +1,99 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include <QObject>
+#include <QStringList>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+// كل القيم القابلة للضبط في مكان واحد؛ القيم الافتراضية هنا هي سلوك التطبيق
+// دون ملف إعدادات. الحقول الغائبة من الملف تبقى على قيمها الافتراضية.
+struct AppConfig {
+    struct ScanProfile {
+        int minIntervalMs;
+        int maxIntervalMs;
+        int fullSweepIntervalMs;
+    };
+
+    // جدولة المسح مع الاكتشاف السلبي وبدونه
+    ScanProfile passiveScan = {5000, 60000, 900000};
+    ScanProfile activeScan = {2000, 30000, 300000};
+    int scanBudgetMsPerMinute = 6000;
+    int scanBudgetPacketsPerMinute = 2000;
+    // طول بادئة الشبكة للمسح الكامل؛ 0 = من عنوان الواجهة
+    int subnetPrefix = 24;
+
+    // فحص بقاء الأجهزة
+    int probeAfterMs = 30000;
+    int probeIntervalMs = 5000;
+    int missesBeforeInactive = 3;
+
+    // فواصل التحديث
+    int statsIntervalMs = 1000;
+    int networkInfoIntervalMs = 10000;
+    int telemetryIntervalMs = 2000;
+
+    int commandTimeoutMs = 10000;
+
+    // نقطة الوصول
+    QStringList hostapdConfigPaths = {"/etc/hostapd/hostapd.conf", "/etc/hostapd.conf"};
+    QStringList supplicantConfigPaths = {"/etc/wpa_supplicant/wpa_supplicant.conf"};
+    QString hostapdControlDir = "/var/run/hostapd";
+    QStringList services = {"hostapd", "dnsmasq", "networking", "NetworkManager"};
+
+    // تصنيف نوع الجهاز؛ الفحص النشط (اتصال TCP بمنافذ شائعة) عند نقص الأدلة فقط
+    bool fingerprintEnabled = true;
+    bool fingerprintProbe = true;
+    int fingerprintMaxConnections = 8;
+    int fingerprintHostIntervalMs = 500;
+    int fingerprintConnectTimeoutMs = 1500;
+
+    // سجل استعلامات dnsmasq (log-queries + log-facility)؛ فارغ = المسار المعتاد
+    QString dnsLogPath;
+    int dnsLogCapacity = 64;     // عدادات النطاقات لكل عميل
+
+    // واجهة التحكم عن بعد (HTTP/WebSocket)؛ المنفذ 0 يعطلها.
+    // دون رمز تُقبل الطلبات من localhost فقط
+    QString apiBind = "127.0.0.1";
+    int apiPort = 9107;
+    QString apiToken;
+};
+
+// تحميل ملف الإعدادات (JSON) ومراقبته عبر inotify؛ كل تعديل صالح يُطبق فوراً
+// عبر configChanged، والملف غير الصالح يُرفض كاملاً وتبقى الإعدادات السابقة.
+class ConfigManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ConfigManager(QObject *parent = nullptr);
+
+    // WIFIMANAGER_CONFIG، ثم /etc/wifimanager/config.json، ثم مجلد إعدادات المستخدم
+    static QString defaultPath();
+
+    // تحميل أولي وبدء المراقبة؛ غياب الملف ليس خطأ
+    bool load(const QString &path = QString());
+
+    const AppConfig &config() const { return m_config; }
+    QString path() const { return m_path; }
+
+    static bool parse(const QByteArray &json, AppConfig *config, QString *error);
+
+signals:
+    void configChanged(const AppConfig &config);
+    void errorOccurred(const QString &error);
+
+private slots:
+    void onWatchedPathChanged();
+    void reload();
+
+private:
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_reloadTimer;
+    AppConfig m_config;
+    QString m_path;
+    QByteArray m_contents;
+
+    void watch();
+};
+
+#endif // APPCONFIG_H
@@ -0,0 +1,355 @@
+#include "arpguard.h"
+#include <QFile>
+#include <QHostAddress>
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+
+namespace {
+
+// ادعاءان لعنوان واحد من MACين مختلفين خلال هذه النافذة = تعارض
+const qint64 kConflictWindowMs = 120 * 1000;
+// تنبيه واحد لكل عنوان أو جهاز خلال هذه المدة
+const qint64 kAlertCooldownMs = 10 * 60 * 1000;
+// أكثر من هذا العدد من ARP المجاني خلال النافذة = سيل
+const qint64 kFloodWindowMs = 10 * 1000;
+const quint32 kFloodThreshold = 20;
+// المداخل الصامتة أطول من هذا تُحذف
+const qint64 kIdleEvictMs = 60 * 60 * 1000;
+
+const quint32 kPcapMagic = 0xa1b2c3d4;
+const quint32 kPcapMagicNanos = 0xa1b23c4d;
+const quint32 kLinkTypeEthernet = 1;
+
+quint64 packMac(const uchar *mac) {
+    quint64 value = 0;
+    for (int i = 0; i < 6; ++i) {
+        value = (value << 8) | mac[i];
+    }
+    return value;
+}
+
+quint64 packMac(const QString &mac) {
+    QByteArray bytes = QByteArray::fromHex(mac.toLatin1().replace(':', ""));
+    return bytes.size() == 6 ? packMac(reinterpret_cast<const uchar *>(bytes.constData())) : 0;
+}
+
+QString unpackMac(quint64 mac) {
+    QByteArray bytes(6, Qt::Uninitialized);
+    for (int i = 5; i >= 0; --i) {
+        bytes[i] = char(mac & 0xff);
+        mac >>= 8;
+    }
+    return QString::fromLatin1(bytes.toHex(':').toUpper());
+}
+
+quint32 packAddress(const QString &ipAddress) {
+    QHostAddress address(ipAddress);
+    return address.protocol() == QAbstractSocket::IPv4Protocol ? address.toIPv4Address() : 0;
+}
+
+QString unpackAddress(quint32 ip) {
+    return QHostAddress(ip).toString();
+}
+
+} // namespace
+
+ArpGuard::ArpGuard(QObject *parent)
+    : QObject(parent), m_evictTimer(new QTimer(this))
+{
+    m_evictTimer->start(10 * 60 * 1000);
+    connect(m_evictTimer, &QTimer::timeout, this, &ArpGuard::evictIdle);
+}
+
+void ArpGuard::watchAddress(const QString &ipAddress, const QString &expectedMac, const QString &label) {
+    quint32 ip = packAddress(ipAddress);
+    if (ip == 0) {
+        return;
+    }
+    Watched &watched = m_watched[ip];
+    watched.mac = packMac(expectedMac);
+    watched.label = label;
+}
+
+void ArpGuard::clearWatched() {
+    m_watched.clear();
+}
+
+void ArpGuard::observe(const PassiveObservation &observation) {
+    if (observation.source == PassiveObservation::Arp) {
+        observe(observation.macAddress, observation.ipAddress, observation.timestamp.toMSecsSinceEpoch(),
+                observation.isGratuitous, Passive);
+    }
+}
+
+void ArpGuard::observe(const QString &macAddress, const QString &ipAddress, qint64 timestampMs,
+                       bool gratuitous, Source source) {
+    quint64 mac = packMac(macAddress);
+    quint32 ip = packAddress(ipAddress);
+    if (mac == 0 || ip == 0) {
+        return;
+    }
+    m_latestMs = qMax(m_latestMs, timestampMs);
+
+    // IP -> MACs: تحديث خانة الجهاز أو أخذ أقدم خانة
+    AddressEntry &address = m_byAddress[ip];
+    int slot = 0;
+    for (int i = 0; i < kClaimSlots; ++i) {
+        if (address.claims[i].mac == mac) {
+            slot = i;
+            break;
+        }
+        if (address.claims[i].seenMs < address.claims[slot].seenMs) {
+            slot = i;
+        }
+    }
+    address.claims[slot].mac = mac;
+    address.claims[slot].seenMs = qMax(address.claims[slot].seenMs, timestampMs);
+
+    // MAC -> IPs بنفس الطريقة
+    MacEntry &entry = m_byMac[mac];
+    int addressSlot = 0;
+    for (int i = 0; i < kAddressSlots; ++i) {
+        if (entry.addresses[i] == ip) {
+            addressSlot = i;
+            break;
+        }
+        if (entry.seenMs[i] < entry.seenMs[addressSlot]) {
+            addressSlot = i;
+        }
+    }
+    entry.addresses[addressSlot] = ip;
+    entry.seenMs[addressSlot] = qMax(entry.seenMs[addressSlot], timestampMs);
+
+    // جدول الجيران قد يحمل مدخلاً قديماً؛ وقته الحقيقي يمنع التعارض الكاذب
+    checkConflict(address, ip, mac, timestampMs);
+    checkWatched(ip, mac, timestampMs);
+    if (gratuitous && source != Scan) {
+        checkFlood(entry, mac, timestampMs);
+    }
+}
+
+void ArpGuard::checkConflict(AddressEntry &entry, quint32 ip, quint64 mac, qint64 nowMs) {
+    for (const Claim &claim : entry.claims) {
+        if (claim.mac == 0 || claim.mac == mac || nowMs - claim.seenMs > kConflictWindowMs) {
+            continue;
+        }
+        if (entry.lastAlertMs != 0 && nowMs - entry.lastAlertMs < kAlertCooldownMs) {
+            return;
+        }
+        entry.lastAlertMs = nowMs;
+        raise(TrafficAlert::AddressConflict, mac,
+              QString("تعارض عناوين: %1 يدعيه %2 و %3")
+                  .arg(unpackAddress(ip), unpackMac(claim.mac), unpackMac(mac)),
+              2.0, nowMs);
+        return;
+    }
+}
+
+void ArpGuard::checkWatched(quint32 ip, quint64 mac, qint64 nowMs) {
+    auto it = m_watched.find(ip);
+    if (it == m_watched.end()) {
+        return;
+    }
+    if (it->mac == 0) {
+        it->mac = mac;
+        qDebug() << "ARP guard: pinned" << it->label << unpackAddress(ip) << "to" << unpackMac(mac);
+        return;
+    }
+    if (it->mac == mac || (it->lastAlertMs != 0 && nowMs - it->lastAlertMs < kAlertCooldownMs)) {
+        return;
+    }
+    it->lastAlertMs = nowMs;
+
+    // المهاجم عادة يحتفظ بعنوانه الحقيقي أيضاً؛ ذكره يسهّل تحديد الجهاز
+    QStringList others;
+    const MacEntry &entry = m_byMac[mac];
+    for (int i = 0; i < kAddressSlots; ++i) {
+        if (entry.addresses[i] != 0 && entry.addresses[i] != ip) {
+            others.append(unpackAddress(entry.addresses[i]));
+        }
+    }
+    QString message = QString("تغير MAC %1 (%2) من %3 إلى %4")
+                          .arg(it->label, unpackAddress(ip), unpackMac(it->mac), unpackMac(mac));
+    if (!others.isEmpty()) {
+        message += QString(" - الجهاز نفسه يستخدم %1 (انتحال ARP محتمل)").arg(others.join(", "));
+    }
+    raise(TrafficAlert::WatchedMacChanged, mac, message, others.size(), nowMs);
+}
+
+void ArpGuard::checkFlood(MacEntry &entry, quint64 mac, qint64 nowMs) {
+    if (nowMs - entry.floodWindowStartMs > kFloodWindowMs) {
+        entry.floodWindowStartMs = nowMs;
+        entry.gratuitousInWindow = 0;
+    }
+    if (++entry.gratuitousInWindow <= kFloodThreshold) {
+        return;
+    }
+    if (entry.lastFloodAlertMs != 0 && nowMs - entry.lastFloodAlertMs < kAlertCooldownMs) {
+        return;
+    }
+    entry.lastFloodAlertMs = nowMs;
+    raise(TrafficAlert::GratuitousFlood, mac,
+          QString("سيل ARP مجاني من %1: %2 حزمة خلال %3 ثوانٍ")
+              .arg(unpackMac(mac)).arg(entry.gratuitousInWindow).arg(kFloodWindowMs / 1000),
+          entry.gratuitousInWindow, nowMs);
+}
+
+void ArpGuard::raise(TrafficAlert::Kind kind, quint64 mac, const QString &message, double value, qint64 nowMs) {
+    TrafficAlert alert;
+    alert.kind = kind;
+    alert.macAddress = unpackMac(mac);
+    alert.message = message;
+    alert.value = value;
+    alert.when = QDateTime::fromMSecsSinceEpoch(nowMs);
+    emit alertRaised(alert);
+}
+
+QStringList ArpGuard::macsFor(const QString &ipAddress) const {
+    QStringList result;
+    auto it = m_byAddress.constFind(packAddress(ipAddress));
+    if (it != m_byAddress.constEnd()) {
+        for (const Claim &claim : it->claims) {
+            if (claim.mac != 0) {
+                result.append(unpackMac(claim.mac));
+            }
+        }
+    }
+    return result;
+}
+
+QStringList ArpGuard::addressesFor(const QString &macAddress) const {
+    QStringList result;
+    auto it = m_byMac.constFind(packMac(macAddress));
+    if (it != m_byMac.constEnd()) {
+        for (quint32 ip : it->addresses) {
+            if (ip != 0) {
+                result.append(unpackAddress(ip));
+            }
+        }
+    }
+    return result;
+}
+
+void ArpGuard::evictIdle() {
+    for (auto it = m_byAddress.begin(); it != m_byAddress.end();) {
+        qint64 latest = 0;
+        for (const Claim &claim : it->claims) {
+            latest = qMax(latest, claim.seenMs);
+        }
+        if (m_latestMs - latest > kIdleEvictMs) {
+            it = m_byAddress.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_byMac.begin(); it != m_byMac.end();) {
+        qint64 latest = 0;
+        for (qint64 seen : it->seenMs) {
+            latest = qMax(latest, seen);
+        }
+        if (m_latestMs - latest > kIdleEvictMs) {
+            it = m_byMac.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int ArpGuard::replayCapture(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return -1;
+    }
+
+    // pcap الكلاسيكي بأي ترتيب بايتات؛ pcapng غير مدعوم
+    QByteArray header = file.read(24);
+    if (header.size() != 24) {
+        if (error) {
+            *error = "ملف التقاط قصير";
+        }
+        return -1;
+    }
+    const uchar *h = reinterpret_cast<const uchar *>(header.constData());
+    quint32 magic = qFromLittleEndian<quint32>(h);
+    bool swapped = false;
+    if (magic != kPcapMagic && magic != kPcapMagicNanos) {
+        magic = qFromBigEndian<quint32>(h);
+        swapped = true;
+    }
+    if (magic != kPcapMagic && magic != kPcapMagicNanos) {
+        if (error) {
+            *error = "ليس ملف pcap";
+        }
+        return -1;
+    }
+    auto readU32 = [swapped](const uchar *p) {
+        return swapped ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+    };
+    if (readU32(h + 20) != kLinkTypeEthernet) {
+        if (error) {
+            *error = "نوع الوصلة في الالتقاط ليس Ethernet";
+        }
+        return -1;
+    }
+    qint64 fractionDivisor = magic == kPcapMagicNanos ? 1000000 : 1000;
+
+    int frames = 0;
+    QByteArray record;
+    while (true) {
+        QByteArray recordHeader = file.read(16);
+        if (recordHeader.size() < 16) {
+            break;
+        }
+        const uchar *r = reinterpret_cast<const uchar *>(recordHeader.constData());
+        qint64 timestampMs = qint64(readU32(r)) * 1000 + readU32(r + 4) / fractionDivisor;
+        quint32 captured = readU32(r + 8);
+        if (captured > 262144) {
+            if (error) {
+                *error = "سجل التقاط تالف";
+            }
+            return -1;
+        }
+        record = file.read(captured);
+        if (record.size() != int(captured)) {
+            break; // التقاط مقطوع؛ ما قبله صالح
+        }
+
+        const uchar *senderMac = nullptr;
+        quint32 senderIp = 0;
+        bool gratuitous = false;
+        if (PassiveDiscovery::decodeArp(reinterpret_cast<const uchar *>(record.constData()), captured,
+                                        &senderMac, &senderIp, &gratuitous)) {
+            observe(unpackMac(packMac(senderMac)), unpackAddress(senderIp), timestampMs, gratuitous, Replay);
+            ++frames;
+        }
+    }
+    return frames;
+}
+
+QString ArpGuard::defaultGateway(const QString &interface) {
+    QFile file("/proc/net/route");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    file.readLine(); // سطر العناوين
+    while (!file.atEnd()) {
+        // Iface Destination Gateway Flags ... بالنظام السداسي عشري وترتيب المضيف
+        QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        if (fields.size() < 3 || fields[1] != "00000000") {
+            continue;
+        }
+        if (!interface.isEmpty() && fields[0] != interface.toLatin1()) {
+            continue;
+        }
+        bool ok = false;
+        quint32 gateway = fields[2].toUInt(&ok, 16);
+        if (ok && gateway != 0) {
+            return QHostAddress(qFromBigEndian(gateway)).toString();
+        }
+    }
+    return QString();
+}
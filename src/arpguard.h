@@ -0,0 +1,87 @@
+#ifndef ARPGUARD_H
+#define ARPGUARD_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <array>
+#include "anomalydetector.h"
+#include "passivediscovery.h"
+
+// كشف انتحال ARP وتكرار العناوين: خريطتان متعددتا القيم IP -> MACs و
+// MAC -> IPs تُغذيان من المسح ومن ARP الملتقط سلبياً. لكل مدخل عدد ثابت من
+// الخانات فيبقى كل تحديث O(1)، والتنبيهات تصدر لحظة وصول الملاحظة.
+// كل ملاحظة تحمل وقتها، فإعادة تشغيل التقاط مسجل تعطي النتائج نفسها.
+class ArpGuard : public QObject {
+    Q_OBJECT
+
+public:
+    enum Source { Scan, Passive, Replay };
+
+    explicit ArpGuard(QObject *parent = nullptr);
+
+    // عنوان يجب أن يبقى على MAC واحد (البوابة، عنوان هذا الجهاز).
+    // MAC فارغ: يُثبت أول MAC يُرى للعنوان (الثقة عند أول استخدام)
+    void watchAddress(const QString &ipAddress, const QString &expectedMac, const QString &label);
+    void clearWatched();
+
+    void observe(const QString &macAddress, const QString &ipAddress, qint64 timestampMs,
+                 bool gratuitous, Source source);
+    void observe(const PassiveObservation &observation);
+
+    QStringList macsFor(const QString &ipAddress) const;
+    QStringList addressesFor(const QString &macAddress) const;
+
+    // إعادة تشغيل التقاط pcap (Ethernet) بأوقاته المسجلة؛ يعيد عدد إطارات ARP أو -1
+    int replayCapture(const QString &path, QString *error = nullptr);
+
+    // البوابة الافتراضية للواجهة من /proc/net/route
+    static QString defaultGateway(const QString &interface);
+
+signals:
+    void alertRaised(const TrafficAlert &alert);
+
+private slots:
+    void evictIdle();
+
+private:
+    static constexpr int kClaimSlots = 4;
+    static constexpr int kAddressSlots = 8;
+
+    struct Claim {
+        quint64 mac = 0;
+        qint64 seenMs = 0;
+    };
+
+    struct AddressEntry {
+        std::array<Claim, kClaimSlots> claims = {};
+        qint64 lastAlertMs = 0;
+    };
+
+    struct MacEntry {
+        std::array<quint32, kAddressSlots> addresses = {};
+        std::array<qint64, kAddressSlots> seenMs = {};
+        qint64 floodWindowStartMs = 0;
+        quint32 gratuitousInWindow = 0;
+        qint64 lastFloodAlertMs = 0;
+    };
+
+    struct Watched {
+        quint64 mac = 0;
+        QString label;
+        qint64 lastAlertMs = 0;
+    };
+
+    QHash<quint32, AddressEntry> m_byAddress;
+    QHash<quint64, MacEntry> m_byMac;
+    QHash<quint32, Watched> m_watched;
+    QTimer *m_evictTimer;
+    qint64 m_latestMs = 0;   // أحدث وقت ملاحظة؛ مرجع التنظيف حتى مع الإعادة
+
+    void checkConflict(AddressEntry &entry, quint32 ip, quint64 mac, qint64 nowMs);
+    void checkWatched(quint32 ip, quint64 mac, qint64 nowMs);
+    void checkFlood(MacEntry &entry, quint64 mac, qint64 nowMs);
+    void raise(TrafficAlert::Kind kind, quint64 mac, const QString &message, double value, qint64 nowMs);
+};
+
+#endif // ARPGUARD_H
@@ -0,0 +1,528 @@
+#include "associationtracker.h"
+#include "nl80211.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <cstring>
+#include <cerrno>
+
+namespace {
+
+const int kDefaultCapacity = 8192;
+// رمز السبب من إطار deauth يلحق بحدث DEL_STATION إن وصل خلال هذه المدة
+const qint64 kReasonMatchUs = 1000 * 1000;
+
+qint64 nowUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+quint64 packMac(const quint8 *mac) {
+    quint64 key = 0;
+    for (int i = 0; i < 6; ++i) {
+        key = (key << 8) | mac[i];
+    }
+    return key;
+}
+
+void unpackMac(quint64 key, quint8 *mac) {
+    for (int i = 5; i >= 0; --i) {
+        mac[i] = static_cast<quint8>(key & 0xff);
+        key >>= 8;
+    }
+}
+
+QString formatMac(const quint8 *mac) {
+    static const char hex[] = "0123456789ABCDEF";
+    char buffer[17];
+    for (int i = 0; i < 6; ++i) {
+        buffer[i * 3] = hex[mac[i] >> 4];
+        buffer[i * 3 + 1] = hex[mac[i] & 0x0f];
+        if (i < 5) {
+            buffer[i * 3 + 2] = ':';
+        }
+    }
+    return QString::fromLatin1(buffer, 17);
+}
+
+bool parseMac(const QString &text, quint8 *mac) {
+    QStringList parts = text.split(':');
+    if (parts.size() != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i) {
+        bool ok = false;
+        mac[i] = static_cast<quint8>(parts[i].toUInt(&ok, 16));
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+QString AssociationEvent::macAddress() const {
+    return formatMac(mac);
+}
+
+AssociationTracker::AssociationTracker(QObject *parent)
+    : QObject(parent), m_hostapdRetry(new QTimer(this))
+{
+    m_ring.resize(kDefaultCapacity);
+
+    // hostapd قد يُعاد تشغيله (تغيير SSID مثلاً)؛ نعيد الربط بهدوء
+    m_hostapdRetry->setSingleShot(true);
+    m_hostapdRetry->setInterval(10000);
+    connect(m_hostapdRetry, &QTimer::timeout, this, &AssociationTracker::retryHostapd);
+}
+
+AssociationTracker::~AssociationTracker() {
+    stop();
+}
+
+bool AssociationTracker::start(const QString &interface) {
+    stop();
+    m_interface = interface;
+    m_ifindex = static_cast<int>(if_nametoindex(interface.toLocal8Bit().constData()));
+    if (m_ifindex == 0) {
+        return false;
+    }
+
+    if (startNl80211()) {
+        m_source = AssociationEvent::Nl80211;
+        return true;
+    }
+    if (startHostapd()) {
+        m_source = AssociationEvent::Hostapd;
+        return true;
+    }
+    qDebug() << "Association tracker: neither nl80211 nor hostapd events available on" << interface;
+    return false;
+}
+
+void AssociationTracker::stop() {
+    m_hostapdRetry->stop();
+    closeNl80211();
+    closeHostapd();
+    m_source = 0;
+}
+
+void AssociationTracker::setCapacity(int events) {
+    std::vector<AssociationEvent> kept = this->events();
+    size_t capacity = static_cast<size_t>(qMax(16, events));
+    if (kept.size() > capacity) {
+        kept.erase(kept.begin(), kept.end() - static_cast<std::ptrdiff_t>(capacity));
+    }
+    m_ring.assign(capacity, AssociationEvent());
+    std::copy(kept.begin(), kept.end(), m_ring.begin());
+    m_next = kept.size() % capacity;
+    m_wrapped = kept.size() == capacity;
+}
+
+std::vector<AssociationEvent> AssociationTracker::events(qint64 sinceUs) const {
+    std::vector<AssociationEvent> result;
+    size_t count = m_wrapped ? m_ring.size() : m_next;
+    size_t start = m_wrapped ? m_next : 0;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const AssociationEvent &event = m_ring[(start + i) % m_ring.size()];
+        if (event.timestampUs >= sinceUs) {
+            result.push_back(event);
+        }
+    }
+    return result;
+}
+
+std::vector<AssociationEvent> AssociationTracker::eventsFor(const QString &macAddress) const {
+    std::vector<AssociationEvent> result;
+    quint8 mac[6];
+    if (!parseMac(macAddress, mac)) {
+        return result;
+    }
+    for (const AssociationEvent &event : events()) {
+        if (std::memcmp(event.mac, mac, 6) == 0) {
+            result.push_back(event);
+        }
+    }
+    return result;
+}
+
+StationSessions AssociationTracker::sessions(const QString &macAddress) const {
+    quint8 mac[6];
+    if (!parseMac(macAddress, mac)) {
+        return StationSessions();
+    }
+    return m_sessions.value(packMac(mac));
+}
+
+QHash<QString, StationSessions> AssociationTracker::allSessions() const {
+    QHash<QString, StationSessions> result;
+    result.reserve(m_sessions.size());
+    for (auto it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it) {
+        quint8 mac[6];
+        unpackMac(it.key(), mac);
+        result.insert(formatMac(mac), it.value());
+    }
+    return result;
+}
+
+QString AssociationTracker::reasonText(quint16 reasonCode) {
+    switch (reasonCode) {
+    case 0: return "غير معروف";
+    case 1: return "سبب غير محدد";
+    case 2: return "المصادقة السابقة لم تعد صالحة";
+    case 3: return "الجهاز غادر الشبكة";
+    case 4: return "انقطاع بسبب عدم النشاط";
+    case 5: return "نقطة الوصول مشغولة";
+    case 6:
+    case 7: return "إطار من جهاز غير مرتبط";
+    case 8: return "الجهاز غادر نقطة الوصول";
+    case 9: return "جهاز غير مصادق";
+    case 14: return "فشل التحقق من سلامة الرسالة (MIC)";
+    case 15: return "انتهاء مهلة المصافحة الرباعية";
+    case 16: return "انتهاء مهلة تحديث مفتاح المجموعة";
+    case 23: return "فشل مصادقة 802.1X";
+    case 34: return "ظروف قناة سيئة";
+    default: return QString("رمز %1").arg(reasonCode);
+    }
+}
+
+bool AssociationTracker::startNl80211() {
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_nl address;
+    std::memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    quint32 group = 0;
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        !Nl80211::resolve(fd, &m_nlFamily, &group)) {
+        ::close(fd);
+        return false;
+    }
+
+    if (::setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+        qDebug() << "Association tracker: cannot join nl80211 mlme group:" << strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    // موجة ارتباطات (إعادة تشغيل نقطة الوصول مثلاً) قد تملأ المخزن الافتراضي
+    int receiveBuffer = 256 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    m_nlSocket = fd;
+    m_nlNotifier = new QSocketNotifier(m_nlSocket, QSocketNotifier::Read, this);
+    connect(m_nlNotifier, &QSocketNotifier::activated, this, &AssociationTracker::onNl80211Readable);
+
+    // المحطات المرتبطة قبل البدء: تفريغ واحد فقط، وبعده كل شيء أحداث
+    requestStationDump();
+    return true;
+}
+
+void AssociationTracker::closeNl80211() {
+    if (m_nlNotifier) {
+        m_nlNotifier->setEnabled(false);
+        m_nlNotifier->deleteLater();
+        m_nlNotifier = nullptr;
+    }
+    if (m_nlSocket >= 0) {
+        ::close(m_nlSocket);
+        m_nlSocket = -1;
+    }
+}
+
+bool AssociationTracker::requestStationDump() {
+    m_dumpSeq = static_cast<quint32>(nowUs() & 0x7fffffff) | 1;
+    return Nl80211::sendStationDump(m_nlSocket, m_nlFamily, m_ifindex, m_dumpSeq);
+}
+
+void AssociationTracker::onNl80211Readable() {
+    alignas(nlmsghdr) char buffer[32768];
+
+    // تفريغ كل ما تراكم؛ الطابع الزمني يؤخذ لحظة القراءة لكل دفعة
+    for (;;) {
+        int length = static_cast<int>(::recv(m_nlSocket, buffer, sizeof(buffer), 0));
+        if (length < 0) {
+            if (errno == ENOBUFS) {
+                // فاتتنا أحداث: حالة المحطات الحالية تُستعاد من النواة
+                qDebug() << "Association tracker: nl80211 event overrun, resyncing stations";
+                requestStationDump();
+                continue;
+            }
+            break;
+        }
+        if (length == 0) {
+            break;
+        }
+
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR) {
+                continue;
+            }
+            if (header->nlmsg_type != m_nlFamily) {
+                continue;
+            }
+            handleNl80211Message(NLMSG_DATA(header),
+                                 static_cast<int>(header->nlmsg_len) - NLMSG_HDRLEN,
+                                 header->nlmsg_seq);
+        }
+    }
+}
+
+void AssociationTracker::handleNl80211Message(const void *message, int length, quint32 seq) {
+    if (length < GENL_HDRLEN) {
+        return;
+    }
+    const genlmsghdr *genl = static_cast<const genlmsghdr *>(message);
+    const nlattr *attributes[NL80211_ATTR_MAX + 1];
+    Nl80211::parseAttributes(static_cast<const char *>(message) + GENL_HDRLEN, length - GENL_HDRLEN,
+                             attributes, NL80211_ATTR_MAX);
+
+    if (Nl80211::attributeU32(attributes[NL80211_ATTR_IFINDEX]) != static_cast<quint32>(m_ifindex)) {
+        return;
+    }
+
+    qint64 now = nowUs();
+    const nlattr *macAttribute = attributes[NL80211_ATTR_MAC];
+    const quint8 *mac = macAttribute && Nl80211::attributeLength(macAttribute) >= 6
+        ? static_cast<const quint8 *>(Nl80211::attributeData(macAttribute)) : nullptr;
+
+    switch (genl->cmd) {
+    case NL80211_CMD_NEW_STATION:
+        if (!mac) {
+            return;
+        }
+        if (seq != 0 && seq == m_dumpSeq) {
+            // رد التفريغ: محطة مرتبطة مسبقاً، مدة ارتباطها من STA_INFO
+            StationInfo station;
+            Nl80211::parseStation(static_cast<const char *>(message) + GENL_HDRLEN,
+                                  length - GENL_HDRLEN, &station);
+            seedStation(mac, station.connectedSecs);
+        } else {
+            record(AssociationEvent::Connected, mac, 0, AssociationEvent::Nl80211, now);
+        }
+        break;
+
+    case NL80211_CMD_DEL_STATION: {
+        if (!mac) {
+            return;
+        }
+        quint16 reason = Nl80211::attributeU16(attributes[NL80211_ATTR_REASON_CODE]);
+        auto pending = m_pendingReasons.find(packMac(mac));
+        if (pending != m_pendingReasons.end()) {
+            if (reason == 0 && now - pending->timestampUs <= kReasonMatchUs) {
+                reason = pending->reasonCode;
+            }
+            m_pendingReasons.erase(pending);
+        }
+        record(AssociationEvent::Disconnected, mac, reason, AssociationEvent::Nl80211, now);
+        break;
+    }
+
+    case NL80211_CMD_DEAUTHENTICATE:
+    case NL80211_CMD_DISASSOCIATE: {
+        // إطار الإدارة نفسه: DA@4 و SA@10 ورمز السبب بعد الترويسة (24 بايت)
+        const nlattr *frameAttribute = attributes[NL80211_ATTR_FRAME];
+        if (!frameAttribute || Nl80211::attributeLength(frameAttribute) < 26) {
+            return;
+        }
+        const quint8 *frame = static_cast<const quint8 *>(Nl80211::attributeData(frameAttribute));
+        PendingReason pending;
+        pending.reasonCode = static_cast<quint16>(frame[24] | (frame[25] << 8));
+        pending.timestampUs = now;
+        if (m_pendingReasons.size() > 256) {
+            m_pendingReasons.clear(); // إطارات لمحطات لم تُحذف أبداً؛ لا نتركها تتراكم
+        }
+        m_pendingReasons.insert(packMac(frame + 4), pending);
+        m_pendingReasons.insert(packMac(frame + 10), pending);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+bool AssociationTracker::startHostapd() {
+    QString serverPath = QString("%1/%2").arg(m_hostapdControlDir, m_interface);
+    if (!QFile::exists(serverPath)) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // hostapd يرد على عنوان المرسل، فنحتاج مساراً محلياً مربوطاً
+    m_hostapdLocalPath = QDir::temp().filePath(QString("wifimanager-hostapd-%1").arg(getpid()));
+    QByteArray localPath = QFile::encodeName(m_hostapdLocalPath);
+    QByteArray remotePath = QFile::encodeName(serverPath);
+    ::unlink(localPath.constData());
+
+    sockaddr_un local;
+    std::memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    std::strncpy(local.sun_path, localPath.constData(), sizeof(local.sun_path) - 1);
+
+    sockaddr_un remote;
+    std::memset(&remote, 0, sizeof(remote));
+    remote.sun_family = AF_UNIX;
+    std::strncpy(remote.sun_path, remotePath.constData(), sizeof(remote.sun_path) - 1);
+
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0 ||
+        ::connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) < 0) {
+        ::close(fd);
+        ::unlink(localPath.constData());
+        return false;
+    }
+
+    // الرد "OK" يصل قبل أي حدث؛ مهلة قصيرة حتى لا يعلق البدء إن كان hostapd معطلاً
+    timeval timeout = {1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char reply[16] = {};
+    if (::send(fd, "ATTACH", 6, 0) < 0 ||
+        ::recv(fd, reply, sizeof(reply) - 1, 0) < 2 || std::strncmp(reply, "OK", 2) != 0) {
+        ::close(fd);
+        ::unlink(localPath.constData());
+        return false;
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    m_hostapdSocket = fd;
+    m_hostapdNotifier = new QSocketNotifier(m_hostapdSocket, QSocketNotifier::Read, this);
+    connect(m_hostapdNotifier, &QSocketNotifier::activated, this, &AssociationTracker::onHostapdReadable);
+    return true;
+}
+
+void AssociationTracker::closeHostapd() {
+    if (m_hostapdNotifier) {
+        m_hostapdNotifier->setEnabled(false);
+        m_hostapdNotifier->deleteLater();
+        m_hostapdNotifier = nullptr;
+    }
+    if (m_hostapdSocket >= 0) {
+        ::send(m_hostapdSocket, "DETACH", 6, MSG_DONTWAIT);
+        ::close(m_hostapdSocket);
+        m_hostapdSocket = -1;
+        ::unlink(QFile::encodeName(m_hostapdLocalPath).constData());
+    }
+}
+
+void AssociationTracker::retryHostapd() {
+    if (m_source != AssociationEvent::Hostapd || m_hostapdSocket >= 0) {
+        return;
+    }
+    if (!startHostapd()) {
+        m_hostapdRetry->start();
+    }
+}
+
+void AssociationTracker::onHostapdReadable() {
+    char buffer[4096];
+    for (;;) {
+        ssize_t length = ::recv(m_hostapdSocket, buffer, sizeof(buffer) - 1, 0);
+        if (length < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // hostapd أُغلق أو أُعيد تشغيله
+                qDebug() << "Association tracker: lost hostapd control socket:" << strerror(errno);
+                closeHostapd();
+                m_hostapdRetry->start();
+            }
+            return;
+        }
+        handleHostapdLine(QByteArray(buffer, static_cast<int>(length)));
+    }
+}
+
+void AssociationTracker::handleHostapdLine(const QByteArray &line) {
+    // "<3>AP-STA-CONNECTED aa:bb:cc:dd:ee:ff ..." ؛ الأولوية بين <> ليست مهمة هنا
+    int start = line.startsWith('<') ? line.indexOf('>') + 1 : 0;
+    QList<QByteArray> parts = line.mid(start).trimmed().split(' ');
+    if (parts.size() < 2) {
+        return;
+    }
+
+    AssociationEvent::Type type;
+    if (parts[0] == "AP-STA-CONNECTED") {
+        type = AssociationEvent::Connected;
+    } else if (parts[0] == "AP-STA-DISCONNECTED") {
+        type = AssociationEvent::Disconnected;
+    } else {
+        return;
+    }
+
+    quint8 mac[6];
+    if (!parseMac(QString::fromLatin1(parts[1]), mac)) {
+        return;
+    }
+    // أحداث hostapd لا تحمل رمز السبب
+    record(type, mac, 0, AssociationEvent::Hostapd, nowUs());
+}
+
+void AssociationTracker::seedStation(const quint8 *mac, qint64 connectedSecs) {
+    StationSessions &session = m_sessions[packMac(mac)];
+    if (session.connectedSinceUs == 0) {
+        session.connectedSinceUs = nowUs() - connectedSecs * 1000000;
+        ++session.sessionCount;
+    }
+}
+
+void AssociationTracker::record(AssociationEvent::Type type, const quint8 *mac, quint16 reasonCode,
+                                AssociationEvent::Source source, qint64 timestampUs) {
+    AssociationEvent &event = m_ring[m_next];
+    event.timestampUs = timestampUs;
+    std::memcpy(event.mac, mac, 6);
+    event.type = type;
+    event.source = source;
+    event.reasonCode = reasonCode;
+    event.ifindex = m_ifindex;
+    if (++m_next == m_ring.size()) {
+        m_next = 0;
+        m_wrapped = true;
+    }
+
+    StationSessions &session = m_sessions[packMac(mac)];
+    QString macAddress = formatMac(mac);
+
+    if (type == AssociationEvent::Connected) {
+        // ارتباط جديد دون انفصال مسجل (فاتنا الحدث): نغلق الجلسة السابقة هنا
+        if (session.connectedSinceUs != 0) {
+            session.lastSessionUs = timestampUs - session.connectedSinceUs;
+            session.totalConnectedUs += session.lastSessionUs;
+        } else if (session.lastDisconnectUs != 0 &&
+                   timestampUs - session.lastDisconnectUs < kQuickReconnectUs) {
+            ++session.quickReconnects;
+        }
+        session.connectedSinceUs = timestampUs;
+        ++session.sessionCount;
+        emit stationConnected(macAddress, timestampUs);
+    } else {
+        if (session.connectedSinceUs != 0) {
+            session.lastSessionUs = timestampUs - session.connectedSinceUs;
+            session.totalConnectedUs += session.lastSessionUs;
+            session.connectedSinceUs = 0;
+        }
+        ++session.disconnectCount;
+        session.lastDisconnectUs = timestampUs;
+        session.lastReasonCode = reasonCode;
+        emit stationDisconnected(macAddress, reasonCode, timestampUs);
+    }
+}
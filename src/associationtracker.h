@@ -0,0 +1,119 @@
+#ifndef ASSOCIATIONTRACKER_H
+#define ASSOCIATIONTRACKER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <vector>
+
+// حدث ارتباط واحد كما سُجل لحظة وصوله من النواة أو من hostapd.
+// الحجم ثابت (24 بايت) حتى تبقى الحلقة مضغوطة مهما طال التشغيل.
+struct AssociationEvent {
+    enum Type : quint8 { Connected = 1, Disconnected = 2 };
+    enum Source : quint8 { Nl80211 = 1, Hostapd = 2 };
+
+    qint64 timestampUs = 0;   // ميكروثانية منذ epoch
+    quint8 mac[6] = {};
+    quint8 type = 0;
+    quint8 source = 0;
+    quint16 reasonCode = 0;   // رمز السبب في 802.11 (0 = غير معروف)
+    qint32 ifindex = 0;
+
+    QString macAddress() const;
+};
+
+// ملخص جلسات محطة واحدة محسوب من الأحداث مباشرة دون أي استطلاع
+struct StationSessions {
+    int sessionCount = 0;
+    int disconnectCount = 0;
+    int quickReconnects = 0;      // عودة خلال أقل من kQuickReconnectUs من الانقطاع
+    qint64 connectedSinceUs = 0;  // 0 = غير مرتبط الآن
+    qint64 totalConnectedUs = 0;  // مجموع الجلسات المنتهية
+    qint64 lastSessionUs = 0;
+    qint64 lastDisconnectUs = 0;
+    quint16 lastReasonCode = 0;
+};
+
+// تتبع الارتباط بالأحداث: الاشتراك في مجموعة mlme في nl80211 (NEW/DEL_STATION
+// وإطارات deauth/disassoc لرموز السبب)، أو في واجهة تحكم hostapd إن لم تتوفر.
+// يلتقط الانقطاعات القصيرة التي تفوتها دورات المسح كل بضع ثوانٍ.
+class AssociationTracker : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr qint64 kQuickReconnectUs = 10 * 1000 * 1000;
+
+    explicit AssociationTracker(QObject *parent = nullptr);
+    ~AssociationTracker();
+
+    bool start(const QString &interface);
+    void stop();
+    bool isRunning() const { return m_source != 0; }
+    AssociationEvent::Source source() const { return static_cast<AssociationEvent::Source>(m_source); }
+
+    // سعة الحلقة بالأحداث؛ الأقدم يُستبدل عند الامتلاء
+    void setCapacity(int events);
+
+    // مجلد مقابس تحكم hostapd (ctrl_interface)؛ يُستخدم عند الربط التالي
+    void setHostapdControlDir(const QString &directory) { m_hostapdControlDir = directory; }
+
+    // الأحداث بترتيب زمني، اختيارياً لمحطة واحدة أو بعد لحظة معينة
+    std::vector<AssociationEvent> events(qint64 sinceUs = 0) const;
+    std::vector<AssociationEvent> eventsFor(const QString &macAddress) const;
+
+    StationSessions sessions(const QString &macAddress) const;
+    QHash<QString, StationSessions> allSessions() const;
+
+    static QString reasonText(quint16 reasonCode);
+
+signals:
+    void stationConnected(const QString &macAddress, qint64 timestampUs);
+    void stationDisconnected(const QString &macAddress, quint16 reasonCode, qint64 timestampUs);
+
+private slots:
+    void onNl80211Readable();
+    void onHostapdReadable();
+    void retryHostapd();
+
+private:
+    struct PendingReason {
+        quint16 reasonCode = 0;
+        qint64 timestampUs = 0;
+    };
+
+    QString m_interface;
+    int m_ifindex = 0;
+    quint8 m_source = 0;
+
+    int m_nlSocket = -1;
+    int m_nlFamily = 0;
+    quint32 m_dumpSeq = 0;
+    QSocketNotifier *m_nlNotifier = nullptr;
+
+    int m_hostapdSocket = -1;
+    QString m_hostapdLocalPath;
+    QString m_hostapdControlDir = "/var/run/hostapd";
+    QSocketNotifier *m_hostapdNotifier = nullptr;
+    QTimer *m_hostapdRetry;
+
+    std::vector<AssociationEvent> m_ring;
+    size_t m_next = 0;
+    bool m_wrapped = false;
+    QHash<quint64, StationSessions> m_sessions;       // MAC مضغوط في 48 بت
+    QHash<quint64, PendingReason> m_pendingReasons;   // من إطارات deauth قبل DEL_STATION
+
+    bool startNl80211();
+    bool startHostapd();
+    void closeNl80211();
+    void closeHostapd();
+    bool requestStationDump();
+    void handleNl80211Message(const void *message, int length, quint32 seq);
+    void handleHostapdLine(const QByteArray &line);
+    void seedStation(const quint8 *mac, qint64 connectedSecs);
+    void record(AssociationEvent::Type type, const quint8 *mac, quint16 reasonCode,
+                AssociationEvent::Source source, qint64 timestampUs);
+};
+
+#endif // ASSOCIATIONTRACKER_H
@@ -0,0 +1,421 @@
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <cctype>
+#include <cstdio>
+#include <unistd.h>
+#include "wifimanager.h"
+#include "networkstats.h"
+#include "updatebus.h"
+#include "inventoryio.h"
+#include "appconfig.h"
+#include "privilegedhelper.h"
+
+// واجهة سطر أوامر للسكربتات و cron: نفس نواة الواجهة الرسومية دون
+// QApplication ولا Charts، فتبدأ وتنتهي في أجزاء من الثانية.
+
+namespace {
+
+enum class Format { Json, Tsv };
+
+struct CliOptions {
+    QString command;
+    QStringList arguments;
+    Format format = Format::Json;
+    bool formatGiven = false;
+    bool scan = false;           // list --scan: مسح كامل بدلاً من القائمة المحفوظة
+    int intervalMs = -1;         // stats: فترة حساب السرعة، watch: أدنى فاصل بين سطرين
+    QString interface;
+    bool verbose = false;
+};
+
+const char *const kUsage =
+    "الاستخدام: wifimanager-cli [--json|--tsv] <أمر> [وسائط]\n"
+    "\n"
+    "  list [--scan]              الأجهزة من آخر قائمة محفوظة، أو بعد مسح كامل\n"
+    "  stats [--interval ms]      إحصائيات الواجهة؛ 0 = العدادات فقط دون انتظار\n"
+    "  block MAC...               حظر أجهزة في معاملة جدار ناري واحدة\n"
+    "  unblock MAC...             إلغاء الحظر\n"
+    "  watch [--interval ms]      مراقبة مستمرة، سطر JSON لكل تغيير (NDJSON)\n"
+    "\n"
+    "  --interface IF  --verbose\n"
+    "الحظر والمسح والمراقبة تتطلب الجذر أو wifimanager-helper.\n";
+
+bool parseOptions(int argc, char *argv[], CliOptions *options, QString *error) {
+    for (int i = 1; i < argc; ++i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        QString next = i + 1 < argc ? QString::fromLocal8Bit(argv[i + 1]) : QString();
+        if (arg == "--json" || arg == "--tsv") {
+            options->format = arg == "--json" ? Format::Json : Format::Tsv;
+            options->formatGiven = true;
+        } else if (arg == "--format") {
+            if (next != "json" && next != "tsv") {
+                *error = "--format يقبل json أو tsv";
+                return false;
+            }
+            options->format = next == "json" ? Format::Json : Format::Tsv;
+            options->formatGiven = true;
+            ++i;
+        } else if (arg == "--scan") {
+            options->scan = true;
+        } else if (arg == "--interval") {
+            bool ok = false;
+            options->intervalMs = next.toInt(&ok);
+            if (!ok || options->intervalMs < 0) {
+                *error = "--interval يتطلب عدداً من الميلي ثانية";
+                return false;
+            }
+            ++i;
+        } else if (arg == "--interface" && !next.isEmpty()) {
+            options->interface = next;
+            ++i;
+        } else if (arg == "--verbose" || arg == "-v") {
+            options->verbose = true;
+        } else if (arg == "--help" || arg == "-h") {
+            options->command = "help";
+            return true;
+        } else if (arg.startsWith("--")) {
+            *error = QString("خيار غير معروف: %1").arg(arg);
+            return false;
+        } else if (options->command.isEmpty()) {
+            options->command = arg;
+        } else {
+            options->arguments << arg;
+        }
+    }
+    return true;
+}
+
+bool isMacAddress(const QString &text) {
+    if (text.size() != 17) {
+        return false;
+    }
+    for (int i = 0; i < text.size(); ++i) {
+        if (i % 3 == 2 ? text[i] != ':' : !isxdigit(text[i].toLatin1())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// السطر كاملاً ثم تفريغ فوري: القارئ في الطرف الآخر من الأنبوب ينتظر سطراً سطراً
+void writeLine(const QByteArray &line) {
+    std::fwrite(line.constData(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+void writeJson(const QJsonObject &object) {
+    writeLine(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+QString tsvField(QString value) {
+    value.replace('\t', ' ');
+    value.replace('\n', ' ');
+    return value;
+}
+
+bool privileged() {
+    return geteuid() == 0 || PrivilegedHelper::isConnected() || PrivilegedHelper::connectTo();
+}
+
+bool ensurePrivileges(const char *command) {
+    if (privileged()) {
+        return true;
+    }
+    std::fprintf(stderr, "%s يتطلب صلاحيات الجذر (root) أو المساعد wifimanager-helper.\n", command);
+    return false;
+}
+
+// نفس حقول الإحصائيات في واجهة التحكم عن بعد
+QJsonObject statsToJson(const NetworkStats &stats) {
+    return QJsonObject{{"interface", stats.interface},
+                       {"rx", stats.bytesReceived},
+                       {"tx", stats.bytesSent},
+                       {"downloadBytesPerSec", stats.downloadSpeed * 1024.0},
+                       {"uploadBytesPerSec", stats.uploadSpeed * 1024.0}};
+}
+
+void printDevices(const std::vector<Device> &devices, Format format) {
+    if (format == Format::Json) {
+        QJsonArray array;
+        for (const Device &device : devices) {
+            array.append(InventoryIO::deviceToJson(device));
+        }
+        writeLine(QJsonDocument(array).toJson(QJsonDocument::Compact));
+        return;
+    }
+    writeLine("mac\tip\thostname\tmanufacturer\ttype\tactive\tblocked\tsignal_dbm\trx\ttx\tlast_seen");
+    for (const Device &device : devices) {
+        QStringList fields = {device.macAddress,
+                              device.ipAddress,
+                              tsvField(device.hostname),
+                              tsvField(device.manufacturer),
+                              device.deviceType,
+                              device.isActive ? "1" : "0",
+                              device.isBlocked ? "1" : "0",
+                              QString::number(device.signalStrength),
+                              QString::number(device.bytesReceived),
+                              QString::number(device.bytesSent),
+                              device.lastSeen.toString(Qt::ISODate)};
+        writeLine(fields.join('\t').toUtf8());
+    }
+}
+
+void printStats(const NetworkStats &stats, Format format) {
+    if (format == Format::Json) {
+        writeJson(statsToJson(stats));
+        return;
+    }
+    writeLine("interface\trx\ttx\tdownload_bps\tupload_bps");
+    writeLine(QStringList({stats.interface,
+                           QString::number(stats.bytesReceived),
+                           QString::number(stats.bytesSent),
+                           QString::number(qint64(stats.downloadSpeed * 1024.0)),
+                           QString::number(qint64(stats.uploadSpeed * 1024.0))}).join('\t').toUtf8());
+}
+
+void reportErrors(WifiManager *wifiManager) {
+    QObject::connect(wifiManager, &WifiManager::errorOccurred, [](const QString &error) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+    });
+}
+
+int runList(const CliOptions &options, const AppConfig &config) {
+    if (options.scan && !ensurePrivileges("list --scan")) {
+        return 1;
+    }
+
+    WifiManager wifiManager;
+    wifiManager.applyConfig(config);
+    reportErrors(&wifiManager);
+    std::vector<Device> devices;
+    QObject::connect(&wifiManager, &WifiManager::devicesUpdated,
+                     [&devices](const std::vector<Device> &current) { devices = current; });
+
+    // حالة الحظر قبل تحميل القائمة حتى تُعلَّم الأجهزة عند دمجها
+    if (privileged()) {
+        wifiManager.loadBlockedDevices();
+    }
+    wifiManager.loadDeviceCache();
+
+    if (options.scan) {
+        // المسح يعمل في خيط خاص وينشر القائمة قبل إشارة انتهائه
+        QEventLoop loop;
+        QObject::connect(&wifiManager, &WifiManager::sweepFinished, &loop, &QEventLoop::quit);
+        wifiManager.refreshDevices();
+        loop.exec();
+    }
+
+    printDevices(devices, options.format);
+    return 0;
+}
+
+int runStats(QCoreApplication &app, const CliOptions &options) {
+    NetworkStatsManager statsManager;
+    if (!options.interface.isEmpty()) {
+        statsManager.setInterface(options.interface);
+    }
+
+    // السرعة تحتاج قراءتين؛ --interval 0 يطبع العدادات فوراً
+    int intervalMs = options.intervalMs < 0 ? 1000 : options.intervalMs;
+    if (intervalMs == 0) {
+        statsManager.startMonitoring();
+        statsManager.stopMonitoring();
+        printStats(statsManager.getCurrentStats(), options.format);
+        return 0;
+    }
+
+    statsManager.setUpdateInterval(intervalMs);
+    QObject::connect(&statsManager, &NetworkStatsManager::statsUpdated,
+                     [&app, &options](const NetworkStats &stats) {
+        printStats(stats, options.format);
+        app.quit();
+    });
+    statsManager.startMonitoring();
+    return app.exec();
+}
+
+int runFirewall(const CliOptions &options, const AppConfig &config, bool block) {
+    if (options.arguments.isEmpty()) {
+        std::fprintf(stderr, "%s يتطلب عنوان MAC واحداً على الأقل\n", qPrintable(options.command));
+        return 2;
+    }
+    QStringList macs;
+    for (const QString &argument : options.arguments) {
+        if (!isMacAddress(argument)) {
+            std::fprintf(stderr, "عنوان MAC غير صالح: %s\n", qPrintable(argument));
+            return 2;
+        }
+        macs << argument.toUpper();
+    }
+    if (!ensurePrivileges(qPrintable(options.command))) {
+        return 1;
+    }
+
+    WifiManager wifiManager;
+    wifiManager.applyConfig(config);
+    reportErrors(&wifiManager);
+    for (const QString &mac : macs) {
+        if (block) {
+            wifiManager.queueBlock(mac);
+        } else {
+            wifiManager.queueUnblock(mac);
+        }
+    }
+    // كل العناوين في معاملة واحدة: إما تُطبق كلها أو لا شيء
+    bool applied = wifiManager.commitFirewallChanges();
+
+    if (options.format == Format::Json) {
+        writeJson(QJsonObject{{"ok", applied},
+                              {"action", options.command},
+                              {"macs", QJsonArray::fromStringList(macs)}});
+    } else if (applied) {
+        for (const QString &mac : macs) {
+            writeLine(QString("%1\t%2").arg(mac, block ? "blocked" : "unblocked").toUtf8());
+        }
+    }
+    return applied ? 0 : 1;
+}
+
+int runWatch(QCoreApplication &app, const CliOptions &options, const AppConfig &config) {
+    if (options.formatGiven && options.format != Format::Json) {
+        std::fprintf(stderr, "watch يكتب NDJSON فقط\n");
+        return 2;
+    }
+    if (!ensurePrivileges("watch")) {
+        return 1;
+    }
+
+    UpdateBus bus;
+    bus.setMinimumInterval(options.intervalMs < 0 ? 1000 : options.intervalMs);
+    WifiManager wifiManager;
+    NetworkStatsManager statsManager;
+    wifiManager.applyConfig(config);
+    statsManager.setUpdateInterval(config.statsIntervalMs);
+    if (!options.interface.isEmpty()) {
+        statsManager.setInterface(options.interface);
+    }
+    wifiManager.setUpdateBus(&bus);
+    statsManager.setUpdateBus(&bus);
+    reportErrors(&wifiManager);
+
+    // سطر أول بالقائمة كاملة، ثم الفروق فقط بنفس شكل قناة WebSocket
+    QHash<QString, QJsonObject> known;
+    auto diffDevices = [&known, &bus]() {
+        UpdateBus::DeviceSnapshot snapshot = bus.devices();
+        QHash<QString, QJsonObject> current;
+        QJsonArray upserted;
+        if (snapshot.data) {
+            for (const Device &device : *snapshot.data) {
+                QString key = device.macAddress.isEmpty() ? device.ipAddress : device.macAddress;
+                QJsonObject object = InventoryIO::deviceToJson(device);
+                if (known.value(key) != object) {
+                    upserted.append(object);
+                }
+                current.insert(key, object);
+            }
+        }
+        QJsonArray removed;
+        for (auto it = known.constBegin(); it != known.constEnd(); ++it) {
+            if (!current.contains(it.key())) {
+                removed.append(it.key());
+            }
+        }
+        known.swap(current);
+        if (!upserted.isEmpty() || !removed.isEmpty()) {
+            writeJson(QJsonObject{{"type", "devices"},
+                                  {"version", double(snapshot.version)},
+                                  {"time", QDateTime::currentDateTime().toString(Qt::ISODateWithMs)},
+                                  {"upserted", upserted},
+                                  {"removed", removed}});
+        }
+    };
+
+    wifiManager.loadDeviceCache();
+    UpdateBus::DeviceSnapshot initial = bus.devices();
+    QJsonArray devices;
+    if (initial.data) {
+        for (const Device &device : *initial.data) {
+            QJsonObject object = InventoryIO::deviceToJson(device);
+            known.insert(device.macAddress.isEmpty() ? device.ipAddress : device.macAddress, object);
+            devices.append(object);
+        }
+    }
+    writeJson(QJsonObject{{"type", "snapshot"},
+                          {"version", double(initial.version)},
+                          {"time", QDateTime::currentDateTime().toString(Qt::ISODateWithMs)},
+                          {"devices", devices}});
+
+    QObject::connect(&bus, &UpdateBus::updated, [&bus, &diffDevices](quint32 topics) {
+        if (topics & UpdateBus::Devices) {
+            diffDevices();
+        }
+        if (topics & UpdateBus::Stats) {
+            UpdateBus::StatsSnapshot snapshot = bus.stats();
+            if (snapshot.data) {
+                QJsonObject stats = statsToJson(*snapshot.data);
+                stats["type"] = "stats";
+                writeJson(stats);
+            }
+        }
+    });
+    QObject::connect(&wifiManager, &WifiManager::trafficAlert, [](const TrafficAlert &alert) {
+        writeJson(QJsonObject{{"type", "alert"},
+                              {"kind", int(alert.kind)},
+                              {"mac", alert.macAddress},
+                              {"message", alert.message},
+                              {"time", alert.when.toString(Qt::ISODateWithMs)}});
+    });
+
+    wifiManager.startMonitoring();
+    statsManager.startMonitoring();
+    return app.exec();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    CliOptions options;
+    QString error;
+    if (!parseOptions(argc, argv, &options, &error)) {
+        std::fprintf(stderr, "%s\n\n%s", qPrintable(error), kUsage);
+        return 2;
+    }
+    if (options.command.isEmpty() || options.command == "help") {
+        std::fputs(kUsage, options.command.isEmpty() ? stderr : stdout);
+        return options.command.isEmpty() ? 2 : 0;
+    }
+
+    QCoreApplication app(argc, argv);
+    // نفس مسار الذاكرة المؤقتة (قائمة الأجهزة المحفوظة) كالواجهة الرسومية
+    QCoreApplication::setApplicationName("WifiManager");
+    // رسائل التشخيص تخلط مخرجات السكربتات؛ تُظهر بـ --verbose فقط
+    if (!options.verbose) {
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    }
+
+    ConfigManager config;
+    QObject::connect(&config, &ConfigManager::errorOccurred,
+                     [](const QString &message) { std::fprintf(stderr, "%s\n", qPrintable(message)); });
+    config.load();
+
+    if (options.command == "list") {
+        return runList(options, config.config());
+    }
+    if (options.command == "stats") {
+        return runStats(app, options);
+    }
+    if (options.command == "block" || options.command == "unblock") {
+        return runFirewall(options, config.config(), options.command == "block");
+    }
+    if (options.command == "watch") {
+        return runWatch(app, options, config.config());
+    }
+    std::fprintf(stderr, "أمر غير معروف: %s\n\n%s", qPrintable(options.command), kUsage);
+    return 2;
+}
@@ -0,0 +1,388 @@
+#include "columnarfile.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char kFileMagic[8] = {'W', 'M', 'C', 'O', 'L', 0, 0, 1};
+const char kTableMarker = 'T';
+const char kChunkMarker = 'C';
+const char kEndMarker = 'E';
+// حد أعلى لكتلة عمود واحد؛ يحمي من ملف تالف يطلب حجز ذاكرة ضخمة
+const quint64 kMaxColumnBytes = 64 * 1024 * 1024;
+
+void writeVarint(QByteArray &out, quint64 value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void writeString(QByteArray &out, const QString &value) {
+    QByteArray utf8 = value.toUtf8();
+    writeVarint(out, static_cast<quint64>(utf8.size()));
+    out += utf8;
+}
+
+quint64 zigzag(qint64 value) {
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 unzigzag(quint64 value) {
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+// قارئ متسلسل لكتلة عمود في الذاكرة
+struct BlockReader {
+    const uchar *data;
+    const uchar *end;
+    bool ok = true;
+
+    explicit BlockReader(const QByteArray &block)
+        : data(reinterpret_cast<const uchar *>(block.constData())), end(data + block.size()) {}
+
+    quint64 varint() {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data >= end) {
+                ok = false;
+                return 0;
+            }
+            uchar byte = *data++;
+            value |= static_cast<quint64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    QString string() {
+        quint64 length = varint();
+        if (!ok || length > static_cast<quint64>(end - data)) {
+            ok = false;
+            return QString();
+        }
+        QString value = QString::fromUtf8(reinterpret_cast<const char *>(data), static_cast<int>(length));
+        data += length;
+        return value;
+    }
+};
+
+} // namespace
+
+ColumnarWriter::ColumnarWriter(QIODevice *device)
+    : m_device(device)
+{
+}
+
+bool ColumnarWriter::writeFileHeader() {
+    return m_device->write(kFileMagic, sizeof(kFileMagic)) == sizeof(kFileMagic);
+}
+
+bool ColumnarWriter::beginTable(const QString &name, const std::vector<Columnar::Column> &columns, int chunkRows) {
+    if (m_inTable && !endTable()) {
+        return false;
+    }
+    m_columns = columns;
+    m_buffers.assign(columns.size(), Buffer());
+    m_chunkRows = qMax(1, chunkRows);
+    m_rows = 0;
+    m_column = 0;
+
+    QByteArray header;
+    header += kTableMarker;
+    writeString(header, name);
+    writeVarint(header, static_cast<quint64>(columns.size()));
+    for (const Columnar::Column &column : columns) {
+        header += static_cast<char>(column.type);
+        writeString(header, column.name);
+    }
+    m_inTable = m_device->write(header) == header.size();
+    return m_inTable;
+}
+
+void ColumnarWriter::addInt(qint64 value) {
+    if (m_column >= static_cast<int>(m_buffers.size())) {
+        return;
+    }
+    Buffer &buffer = m_buffers[m_column++];
+    writeVarint(buffer.data, zigzag(value - buffer.previous));
+    buffer.previous = value;
+}
+
+void ColumnarWriter::addDouble(double value) {
+    if (m_column >= static_cast<int>(m_buffers.size())) {
+        return;
+    }
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = qToLittleEndian(bits);
+    m_buffers[m_column++].data.append(reinterpret_cast<const char *>(&bits), sizeof(bits));
+}
+
+void ColumnarWriter::addString(const QString &value) {
+    if (m_column >= static_cast<int>(m_buffers.size())) {
+        return;
+    }
+    Buffer &buffer = m_buffers[m_column++];
+    auto it = buffer.dictionaryIndex.constFind(value);
+    int index;
+    if (it == buffer.dictionaryIndex.constEnd()) {
+        index = buffer.dictionary.size();
+        buffer.dictionary.append(value);
+        buffer.dictionaryIndex.insert(value, index);
+    } else {
+        index = it.value();
+    }
+    buffer.indexes.push_back(index);
+}
+
+bool ColumnarWriter::endRow() {
+    if (!m_inTable || m_column != static_cast<int>(m_columns.size())) {
+        m_column = 0;
+        return false; // صف ناقص أو زائد: خطأ برمجي عند المستدعي
+    }
+    m_column = 0;
+    if (++m_rows >= m_chunkRows) {
+        return flushChunk();
+    }
+    return true;
+}
+
+bool ColumnarWriter::flushChunk() {
+    if (!m_inTable || m_rows == 0) {
+        return true;
+    }
+
+    QByteArray chunk;
+    chunk += kChunkMarker;
+    writeVarint(chunk, static_cast<quint64>(m_rows));
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        Buffer &buffer = m_buffers[i];
+        if (m_columns[i].type == Columnar::String) {
+            QByteArray block;
+            writeVarint(block, static_cast<quint64>(buffer.dictionary.size()));
+            for (const QString &value : buffer.dictionary) {
+                writeString(block, value);
+            }
+            for (int index : buffer.indexes) {
+                writeVarint(block, static_cast<quint64>(index));
+            }
+            writeVarint(chunk, static_cast<quint64>(block.size()));
+            chunk += block;
+        } else {
+            writeVarint(chunk, static_cast<quint64>(buffer.data.size()));
+            chunk += buffer.data;
+        }
+        buffer = Buffer(); // كل كتلة مستقلة: فروقها وقاموسها يبدآن من الصفر
+    }
+    m_rows = 0;
+    return m_device->write(chunk) == chunk.size();
+}
+
+bool ColumnarWriter::endTable() {
+    if (!m_inTable) {
+        return true;
+    }
+    bool ok = flushChunk() && m_device->write(&kEndMarker, 1) == 1;
+    m_inTable = false;
+    return ok;
+}
+
+ColumnarReader::ColumnarReader(QIODevice *device)
+    : m_device(device)
+{
+}
+
+bool ColumnarReader::open() {
+    char magic[sizeof(kFileMagic)];
+    if (m_device->read(magic, sizeof(magic)) != sizeof(magic) ||
+        std::memcmp(magic, kFileMagic, sizeof(magic)) != 0) {
+        m_error = true;
+        return false;
+    }
+    m_validLength = m_device->pos();
+    return true;
+}
+
+int ColumnarReader::columnIndex(const std::vector<Columnar::Column> &columns, const QString &name,
+                                Columnar::Type type) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].name == name && columns[i].type == type) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool ColumnarReader::readVarint(quint64 *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        char byte;
+        if (!m_device->getChar(&byte)) {
+            return false;
+        }
+        *value |= static_cast<quint64>(static_cast<uchar>(byte) & 0x7f) << shift;
+        if (!(static_cast<uchar>(byte) & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ColumnarReader::skipTableRemainder() {
+    Columnar::Chunk ignored;
+    while (nextChunk(&ignored)) {
+    }
+    return !m_error;
+}
+
+bool ColumnarReader::nextTable(QString *name, std::vector<Columnar::Column> *columns) {
+    if (m_inTable && !skipTableRemainder()) {
+        return false;
+    }
+
+    char marker;
+    if (!m_device->getChar(&marker)) {
+        return false; // نهاية الملف
+    }
+    if (marker != kTableMarker) {
+        m_error = true;
+        return false;
+    }
+
+    auto readText = [this](QString *text) {
+        quint64 length = 0;
+        if (!readVarint(&length) || length > 4096) {
+            return false;
+        }
+        QByteArray utf8 = m_device->read(static_cast<qint64>(length));
+        if (utf8.size() != static_cast<int>(length)) {
+            return false;
+        }
+        *text = QString::fromUtf8(utf8);
+        return true;
+    };
+
+    quint64 count = 0;
+    if (!readText(name) || !readVarint(&count) || count == 0 || count > 256) {
+        m_error = true;
+        return false;
+    }
+    m_columns.clear();
+    for (quint64 i = 0; i < count; ++i) {
+        char type;
+        Columnar::Column column;
+        if (!m_device->getChar(&type) || !readText(&column.name) ||
+            type < Columnar::Int64 || type > Columnar::String) {
+            m_error = true;
+            return false;
+        }
+        column.type = static_cast<Columnar::Type>(type);
+        m_columns.push_back(column);
+    }
+    *columns = m_columns;
+    m_inTable = true;
+    m_validLength = m_device->pos();
+    return true;
+}
+
+bool ColumnarReader::nextChunk(Columnar::Chunk *chunk) {
+    if (!m_inTable) {
+        return false;
+    }
+
+    // جدول من جلسة لم تُغلق بشكل سليم ينتهي بجدول جديد أو بنهاية الملف مباشرة
+    QByteArray marker = m_device->peek(1);
+    if (marker.isEmpty() || marker[0] == kTableMarker) {
+        m_inTable = false;
+        return false;
+    }
+    m_device->getChar(nullptr);
+    if (marker[0] == kEndMarker) {
+        m_inTable = false;
+        m_validLength = m_device->pos();
+        return false;
+    }
+
+    quint64 rows = 0;
+    if (marker[0] != kChunkMarker || !readVarint(&rows) || rows == 0 || rows > 10000000) {
+        m_error = true;
+        m_inTable = false;
+        return false;
+    }
+
+    chunk->rows = static_cast<int>(rows);
+    chunk->columns.assign(m_columns.size(), Columnar::ColumnData());
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        quint64 length = 0;
+        if (!readVarint(&length) || length > kMaxColumnBytes) {
+            m_error = true;
+            break;
+        }
+        QByteArray block = m_device->read(static_cast<qint64>(length));
+        if (block.size() != static_cast<int>(length)) {
+            // كتلة مبتورة في آخر الملف (انقطاع أثناء الكتابة): نتوقف دون خطأ
+            m_inTable = false;
+            return false;
+        }
+
+        // كل صف يشغل بايتاً على الأقل (varint) أو 8 بايتات بالضبط (Double)؛ يُتحقق من ذلك
+        // قبل أي حجز حتى لا يفرض عدد صفوف مزيف في ترويسة صغيرة حجز مئات الميغابايتات
+        bool fits = m_columns[i].type == Columnar::Double ? length == rows * sizeof(quint64) : length >= rows;
+        if (!fits) {
+            m_error = true;
+            break;
+        }
+
+        Columnar::ColumnData &column = chunk->columns[i];
+        BlockReader reader(block);
+        if (m_columns[i].type == Columnar::Int64) {
+            column.ints.reserve(rows);
+            qint64 previous = 0;
+            for (quint64 row = 0; row < rows && reader.ok; ++row) {
+                previous += unzigzag(reader.varint());
+                column.ints.push_back(previous);
+            }
+        } else if (m_columns[i].type == Columnar::Double) {
+            column.doubles.reserve(rows);
+            for (quint64 row = 0; row < rows && reader.ok; ++row) {
+                quint64 bits;
+                std::memcpy(&bits, block.constData() + row * sizeof(bits), sizeof(bits));
+                bits = qFromLittleEndian(bits);
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                column.doubles.push_back(value);
+            }
+        } else {
+            quint64 dictionarySize = reader.varint();
+            QStringList dictionary;
+            for (quint64 d = 0; d < dictionarySize && reader.ok && d <= rows; ++d) {
+                dictionary.append(reader.string());
+            }
+            column.strings.reserve(static_cast<int>(rows));
+            for (quint64 row = 0; row < rows && reader.ok; ++row) {
+                quint64 index = reader.varint();
+                if (index >= static_cast<quint64>(dictionary.size())) {
+                    reader.ok = false;
+                    break;
+                }
+                column.strings.append(dictionary[static_cast<int>(index)]);
+            }
+        }
+        if (!reader.ok) {
+            m_error = true;
+            break;
+        }
+    }
+
+    if (m_error) {
+        m_inTable = false;
+        return false;
+    }
+    m_validLength = m_device->pos();
+    return true;
+}
@@ -0,0 +1,116 @@
+#ifndef COLUMNARFILE_H
+#define COLUMNARFILE_H
+
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <vector>
+
+// حاوية عمودية مقسمة إلى كتل (.wmc): ترويسة الملف ثم جداول، وكل جدول
+// ترويسة مخطط تليها كتل من الصفوف. كل عمود في الكتلة مرمز على حدة:
+//  - Int64: فرق عن الصف السابق بترميز zigzag + varint (الأوقات والعدادات التراكمية تصغر جداً)
+//  - Double: 8 بايتات little-endian
+//  - String: قاموس لكل كتلة ثم فهرس varint لكل صف (عناوين MAC تتكرر في كل عينة)
+// علامة النهاية تغلق الجدول، ونهاية الملف أو بداية جدول آخر تغلقه أيضاً حتى
+// يبقى الملف المفتوح للإلحاق مقروءاً حتى آخر كتلة مكتملة.
+namespace Columnar {
+
+enum Type : quint8 {
+    Int64 = 1,
+    Double = 2,
+    String = 3
+};
+
+struct Column {
+    QString name;
+    Type type;
+};
+
+struct ColumnData {
+    std::vector<qint64> ints;
+    std::vector<double> doubles;
+    QStringList strings;
+};
+
+struct Chunk {
+    int rows = 0;
+    std::vector<ColumnData> columns;
+};
+
+} // namespace Columnar
+
+class ColumnarWriter {
+public:
+    explicit ColumnarWriter(QIODevice *device);
+
+    // ترويسة الملف؛ لا تُكتب عند الإلحاق بملف موجود
+    bool writeFileHeader();
+
+    bool beginTable(const QString &name, const std::vector<Columnar::Column> &columns, int chunkRows = 4096);
+
+    // قيم الصف بترتيب الأعمدة، ثم endRow
+    void addInt(qint64 value);
+    void addDouble(double value);
+    void addString(const QString &value);
+    bool endRow();
+
+    // كتابة الصفوف المعلقة ككتلة (تُستدعى تلقائياً عند امتلاء الكتلة)
+    bool flushChunk();
+    bool endTable();
+
+    int pendingRows() const { return m_rows; }
+    QString errorString() const { return m_device->errorString(); }
+
+private:
+    struct Buffer {
+        QByteArray data;
+        qint64 previous = 0;
+        QStringList dictionary;
+        QHash<QString, int> dictionaryIndex;
+        std::vector<int> indexes;
+    };
+
+    QIODevice *m_device;
+    std::vector<Columnar::Column> m_columns;
+    std::vector<Buffer> m_buffers;
+    int m_chunkRows = 4096;
+    int m_rows = 0;
+    int m_column = 0;
+    bool m_inTable = false;
+};
+
+class ColumnarReader {
+public:
+    explicit ColumnarReader(QIODevice *device);
+
+    // يتحقق من ترويسة الملف
+    bool open();
+
+    // الجدول التالي في الملف؛ false عند نهاية الملف
+    bool nextTable(QString *name, std::vector<Columnar::Column> *columns);
+
+    // الكتلة التالية في الجدول الحالي؛ false عند نهاية الجدول أو الملف
+    bool nextChunk(Columnar::Chunk *chunk);
+
+    bool hasError() const { return m_error; }
+
+    // طول الجزء السليم المقروء حتى الآن: ترويسة الملف والجداول والكتل المكتملة فقط
+    qint64 validLength() const { return m_validLength; }
+
+    // موقع العمود بالاسم والنوع؛ -1 إن غاب أو اختلف نوعه
+    static int columnIndex(const std::vector<Columnar::Column> &columns, const QString &name, Columnar::Type type);
+
+private:
+    QIODevice *m_device;
+    std::vector<Columnar::Column> m_columns;
+    bool m_inTable = false;
+    bool m_error = false;
+    qint64 m_validLength = 0;
+
+    bool readVarint(quint64 *value);
+    bool skipTableRemainder();
+};
+
+#endif // COLUMNARFILE_H
@@ -0,0 +1,753 @@
+#include "controlserver.h"
+#include "inventoryio.h"
+#include "firewall.h"
+#include "apconfigfile.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QCryptographicHash>
+#include <QUrlQuery>
+#include <QUrl>
+#include <QNetworkInterface>
+#include <QSet>
+#include <QDateTime>
+#include <QPointer>
+#include <QDebug>
+
+namespace {
+
+// حدود الطلب: الترويسات والجسم معاً، ورسائل القناة من العميل
+const int kMaxRequestBytes = 64 * 1024;
+// عميل قناة لا يقرأ بهذه السرعة يُفصل بدلاً من تكديس الذاكرة
+const qint64 kMaxPendingWrite = 4 * 1024 * 1024;
+const qint64 kNetworkCacheMs = 5000;
+const QByteArray kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+enum Opcode : quint8 {
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+struct HttpRequest {
+    QByteArray method;
+    QString path;
+    QUrlQuery query;
+    QHash<QByteArray, QByteArray> headers;   // أسماء بأحرف صغيرة
+    QByteArray body;
+};
+
+// يعيد عدد البايتات المستهلكة، 0 إن لم يكتمل الطلب، -1 إن كان تالفاً
+int parseRequest(const QByteArray &buffer, HttpRequest *request) {
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return buffer.size() > kMaxRequestBytes ? -1 : 0;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3 || !requestLine[2].startsWith("HTTP/1.")) {
+        return -1;
+    }
+    request->method = requestLine[0];
+    QByteArray target = requestLine[1];
+    int question = target.indexOf('?');
+    request->path = QString::fromUtf8(question < 0 ? target : target.left(question));
+    if (question >= 0) {
+        request->query = QUrlQuery(QString::fromUtf8(target.mid(question + 1)));
+    }
+
+    for (int i = 1; i < lines.size(); ++i) {
+        int colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            request->headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+        }
+    }
+
+    bool ok = true;
+    int length = request->headers.value("content-length", "0").toInt(&ok);
+    if (!ok || length < 0 || headerEnd + 4 + length > kMaxRequestBytes) {
+        return -1;
+    }
+    if (buffer.size() < headerEnd + 4 + length) {
+        return 0;
+    }
+    request->body = buffer.mid(headerEnd + 4, length);
+    return headerEnd + 4 + length;
+}
+
+const char *statusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 415: return "Unsupported Media Type";
+    case 500: return "Internal Server Error";
+    default: return "Error";
+    }
+}
+
+void writeJson(QTcpSocket *socket, int status, const QJsonObject &object) {
+    QByteArray body = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + statusText(status) +
+                          "\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: " +
+                          QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n";
+    socket->write(response);
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+QJsonObject errorObject(const QString &message) {
+    return QJsonObject{{"ok", false}, {"error", message}};
+}
+
+QString deviceKey(const Device &device) {
+    return device.macAddress.isEmpty() ? device.ipAddress : device.macAddress;
+}
+
+bool sameDevice(const Device &a, const Device &b) {
+    return a.macAddress == b.macAddress && a.ipAddress == b.ipAddress &&
+           a.ipv4Addresses == b.ipv4Addresses && a.ipv6Addresses == b.ipv6Addresses &&
+           a.hostname == b.hostname && a.manufacturer == b.manufacturer && a.deviceType == b.deviceType &&
+           a.signalStrength == b.signalStrength && a.bytesReceived == b.bytesReceived &&
+           a.bytesSent == b.bytesSent && a.isActive == b.isActive && a.isBlocked == b.isBlocked &&
+           a.weakLink == b.weakLink && a.lastSeen == b.lastSeen;
+}
+
+// الزمن لا يتبع موضع أول اختلاف، فلا يُخمن الرمز حرفاً حرفاً
+bool constantTimeEquals(const QByteArray &a, const QByteArray &b) {
+    quint8 difference = a.size() != b.size();
+    for (int i = 0; i < a.size(); ++i) {
+        difference |= quint8(a[i]) ^ (b.isEmpty() ? 0 : quint8(b[i % b.size()]));
+    }
+    return difference == 0;
+}
+
+// اسم المضيف من ترويسة Host دون المنفذ: example:9107 و[::1]:9107
+QString hostWithoutPort(const QString &value) {
+    QString host = value.trimmed();
+    if (host.startsWith('[')) {
+        int close = host.indexOf(']');
+        return close < 0 ? QString() : host.mid(1, close - 1);
+    }
+    int colon = host.indexOf(':');
+    if (colon >= 0 && colon == host.lastIndexOf(':')) {
+        host.truncate(colon);
+    }
+    return host.toLower();
+}
+
+// localhost أو عنوان حرفي لهذا الجهاز؛ أي اسم آخر قد يكون DNS rebinding
+bool isLocalHost(const QString &host, const QHostAddress &bound) {
+    if (host == "localhost") {
+        return true;
+    }
+    QHostAddress address(host);
+    if (address.isNull()) {
+        return false;
+    }
+    if (address.isLoopback() || address.isEqual(bound, QHostAddress::TolerantConversion)) {
+        return true;
+    }
+    if (bound == QHostAddress::Any || bound == QHostAddress::AnyIPv4 || bound == QHostAddress::AnyIPv6) {
+        const QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
+        for (const QHostAddress &local : addresses) {
+            if (address.isEqual(local, QHostAddress::TolerantConversion)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// المسار -> اسم الإجراء المشترك بين HTTP والقناة
+QString actionForPath(const QString &path) {
+    static const QHash<QString, QString> actions = {
+        {"/api/v1/devices/block", "block"},
+        {"/api/v1/devices/unblock", "unblock"},
+        {"/api/v1/network/ssid", "ssid"},
+        {"/api/v1/network/password", "password"},
+        {"/api/v1/network/restart", "restart"},
+        {"/api/v1/refresh", "refresh"}
+    };
+    return actions.value(path);
+}
+
+} // namespace
+
+ControlServer::ControlServer(WifiManager *wifiManager, QObject *parent)
+    : QObject(parent),
+      m_server(new QTcpServer(this)),
+      m_flushTimer(new QTimer(this)),
+      m_wifiManager(wifiManager)
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(250);
+    connect(m_flushTimer, &QTimer::timeout, this, &ControlServer::flushUpdates);
+    connect(m_server, &QTcpServer::newConnection, this, &ControlServer::onNewConnection);
+
+    connect(m_wifiManager, &WifiManager::trafficAlert, this, [this](const TrafficAlert &alert) {
+        broadcast(QJsonObject{{"type", "alert"},
+                              {"kind", int(alert.kind)},
+                              {"mac", alert.macAddress},
+                              {"message", alert.message},
+                              {"time", alert.when.toString(Qt::ISODateWithMs)}});
+    });
+
+    // restartRouter يعود فور البدء؛ نتيجة restart عن بعد بعد جاهزية الخدمات فعلاً
+    connect(m_wifiManager, &WifiManager::servicesRestarted, this, [this](bool success, qint64 elapsedMs) {
+        if (m_pendingRestarts.empty()) {
+            return;
+        }
+        const QString description = "إعادة تشغيل خدمات الشبكة عن بعد";
+        emit actionPerformed(description, success);
+        QJsonObject result = success ? QJsonObject{{"ok", true}} : errorObject(QString("فشل: %1").arg(description));
+        result["elapsedMs"] = double(elapsedMs);
+        const std::vector<Reply> replies = std::move(m_pendingRestarts);
+        m_pendingRestarts.clear();
+        for (const Reply &reply : replies) {
+            reply(success ? 200 : 500, result);
+        }
+    });
+}
+
+ControlServer::~ControlServer() {
+    close();
+}
+
+bool ControlServer::listen(const QHostAddress &address, quint16 port) {
+    m_address = address;
+    m_port = port;
+    if (!m_server->listen(address, port)) {
+        qDebug() << "Control server: cannot listen on" << address.toString() << port << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void ControlServer::close() {
+    m_server->close();
+    // abort يحذف العميل من m_clients عبر disconnected، فنكرر على نسخة
+    const QList<QTcpSocket *> sockets = m_clients.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->abort();
+    }
+}
+
+quint16 ControlServer::port() const {
+    return m_server->serverPort();
+}
+
+int ControlServer::streamClients() const {
+    int count = 0;
+    for (const Client &client : m_clients) {
+        if (client.webSocket) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ControlServer::applyConfig(const AppConfig &config) {
+    m_token = config.apiToken;
+    QHostAddress address(config.apiBind);
+    if (address.isNull()) {
+        qDebug() << "Control server: invalid bind address" << config.apiBind;
+        return;
+    }
+    if (m_server->isListening() && address == m_address && config.apiPort == m_port) {
+        return;
+    }
+    close();
+    if (config.apiPort != 0) {
+        listen(address, static_cast<quint16>(config.apiPort));
+    }
+}
+
+void ControlServer::setUpdateBus(UpdateBus *bus) {
+    m_updateBus = bus;
+    UpdateBus::DeviceSnapshot snapshot = bus->devices();
+    m_devices = snapshot.data;
+    m_devicesVersion = snapshot.version;
+    indexDevices();
+
+    connect(bus, &UpdateBus::updated, this, [this](quint32 topics) {
+        // لا عملاء للقناة: نكتفي بأحدث مؤشر، والفروق لا تُحسب أصلاً
+        if (streamClients() == 0) {
+            if (topics & UpdateBus::Devices) {
+                UpdateBus::DeviceSnapshot snapshot = m_updateBus->devices();
+                m_devices = snapshot.data;
+                m_devicesVersion = snapshot.version;
+                m_deviceIndex.clear();
+            }
+            return;
+        }
+        m_pendingTopics |= topics;
+        if (!m_flushTimer->isActive()) {
+            m_flushTimer->start();
+        }
+    });
+}
+
+void ControlServer::indexDevices() {
+    m_deviceIndex.clear();
+    if (!m_devices) {
+        return;
+    }
+    m_deviceIndex.reserve(static_cast<int>(m_devices->size()));
+    for (size_t i = 0; i < m_devices->size(); ++i) {
+        m_deviceIndex.insert(deviceKey((*m_devices)[i]), i);
+    }
+}
+
+void ControlServer::flushUpdates() {
+    quint32 topics = m_pendingTopics;
+    m_pendingTopics = 0;
+
+    if (topics & UpdateBus::Devices) {
+        UpdateBus::DeviceSnapshot snapshot = m_updateBus->devices();
+        if (m_deviceIndex.isEmpty() && m_devices && !m_devices->empty()) {
+            indexDevices(); // الفهرس أُهمل أثناء غياب العملاء
+        }
+
+        QJsonArray upserted;
+        QJsonArray removed;
+        QSet<QString> present;
+        if (snapshot.data) {
+            for (const Device &device : *snapshot.data) {
+                QString key = deviceKey(device);
+                present.insert(key);
+                auto previous = m_deviceIndex.constFind(key);
+                if (previous == m_deviceIndex.constEnd() || !sameDevice((*m_devices)[previous.value()], device)) {
+                    upserted.append(InventoryIO::deviceToJson(device));
+                }
+            }
+        }
+        for (auto it = m_deviceIndex.constBegin(); it != m_deviceIndex.constEnd(); ++it) {
+            if (!present.contains(it.key())) {
+                removed.append(it.key());
+            }
+        }
+
+        quint64 baseVersion = m_devicesVersion;
+        m_devices = snapshot.data;
+        m_devicesVersion = snapshot.version;
+        indexDevices();
+        if (!upserted.isEmpty() || !removed.isEmpty()) {
+            broadcast(QJsonObject{{"type", "devices"},
+                                  {"base", double(baseVersion)},
+                                  {"version", double(m_devicesVersion)},
+                                  {"upserted", upserted},
+                                  {"removed", removed}});
+        }
+    }
+
+    if (topics & UpdateBus::Stats) {
+        QJsonObject stats = statsObject();
+        stats["type"] = "stats";
+        broadcast(stats);
+    }
+}
+
+QJsonObject ControlServer::devicesObject() const {
+    QJsonArray devices;
+    if (m_devices) {
+        for (const Device &device : *m_devices) {
+            devices.append(InventoryIO::deviceToJson(device));
+        }
+    }
+    return QJsonObject{{"version", double(m_devicesVersion)}, {"devices", devices}};
+}
+
+QJsonObject ControlServer::statsObject() const {
+    QJsonObject object;
+    UpdateBus::StatsSnapshot snapshot = m_updateBus ? m_updateBus->stats() : UpdateBus::StatsSnapshot();
+    if (snapshot.data) {
+        object["interface"] = snapshot.data->interface;
+        object["rx"] = snapshot.data->bytesReceived;
+        object["tx"] = snapshot.data->bytesSent;
+        object["downloadBytesPerSec"] = snapshot.data->downloadSpeed * 1024.0;
+        object["uploadBytesPerSec"] = snapshot.data->uploadSpeed * 1024.0;
+    }
+    return object;
+}
+
+QJsonObject ControlServer::networkObject() {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - m_networkFetchedMs > kNetworkCacheMs) {
+        m_network = m_wifiManager->getCurrentNetwork();
+        m_networkFetchedMs = now;
+    }
+    return QJsonObject{{"ssid", m_network.ssid},
+                       {"bssid", m_network.bssid},
+                       {"encryption", m_network.encryption},
+                       {"channel", m_network.channel},
+                       {"frequency", m_network.frequency},
+                       {"signal", m_network.signalStrength},
+                       {"interface", m_network.interface}};
+}
+
+void ControlServer::onNewConnection() {
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        m_clients.insert(socket, Client());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_clients.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::onReadyRead(QTcpSocket *socket) {
+    auto it = m_clients.find(socket);
+    if (it == m_clients.end()) {
+        return;
+    }
+    it->buffer += socket->readAll();
+    if (it->webSocket) {
+        handleWebSocket(socket, it.value());
+    } else {
+        handleHttp(socket, it.value());
+    }
+}
+
+void ControlServer::handleHttp(QTcpSocket *socket, Client &client) {
+    HttpRequest request;
+    int consumed = parseRequest(client.buffer, &request);
+    if (consumed == 0) {
+        return;
+    }
+    if (consumed < 0) {
+        writeJson(socket, 400, errorObject("طلب غير صالح"));
+        return;
+    }
+    client.buffer.remove(0, consumed);
+
+    // صفحة ويب مفتوحة في متصفح الجهاز تصل إلى 127.0.0.1 أيضاً: نرفض الأسماء
+    // الغريبة في Host (DNS rebinding) وأي Origin ليس لهذا الجهاز، ومنها الترقية
+    if (!isLocalHost(hostWithoutPort(QString::fromLatin1(request.headers.value("host"))), m_address)) {
+        writeJson(socket, 403, errorObject("اسم مضيف غير مسموح"));
+        return;
+    }
+    if (request.headers.contains("origin") &&
+        !isLocalHost(QUrl(QString::fromLatin1(request.headers.value("origin"))).host().toLower(), m_address)) {
+        writeJson(socket, 403, errorObject("طلب من مصدر غير مسموح"));
+        return;
+    }
+
+    // الرمز في الترويسة، أو في الاستعلام لمتصفحات لا تضبط ترويسات WebSocket
+    if (!m_token.isEmpty()) {
+        const QByteArray token = m_token.toUtf8();
+        const QByteArray authorization = request.headers.value("authorization");
+        bool authorized = authorization.startsWith("Bearer ") && constantTimeEquals(authorization.mid(7), token);
+        if (!authorized && request.query.hasQueryItem("token")) {
+            authorized = constantTimeEquals(request.query.queryItemValue("token").toUtf8(), token);
+        }
+        if (!authorized) {
+            writeJson(socket, 401, errorObject("رمز الوصول مطلوب"));
+            return;
+        }
+    } else if (!socket->peerAddress().isLoopback()) {
+        writeJson(socket, 403, errorObject("الوصول من خارج الجهاز يتطلب api.token في الإعدادات"));
+        return;
+    }
+
+    if (request.path == "/api/v1/stream") {
+        QByteArray key = request.headers.value("sec-websocket-key");
+        if (request.headers.value("upgrade").toLower() != "websocket" || key.isEmpty()) {
+            writeJson(socket, 400, errorObject("يتطلب ترقية WebSocket"));
+            return;
+        }
+        QByteArray accept = QCryptographicHash::hash(key + kWebSocketGuid, QCryptographicHash::Sha1).toBase64();
+        socket->write("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Accept: " + accept + "\r\n\r\n");
+        // اللقطة من آخر قائمة أُرسلت للقناة، فتبدأ الفروق التالية من الأساس نفسه
+        if (m_deviceIndex.isEmpty()) {
+            indexDevices();
+        }
+        client.webSocket = true;
+        QJsonObject snapshot = devicesObject();
+        snapshot["type"] = "snapshot";
+        snapshot["stats"] = statsObject();
+        sendText(socket, snapshot);
+        if (!client.buffer.isEmpty()) {
+            handleWebSocket(socket, client);
+        }
+        return;
+    }
+
+    if (request.method == "GET") {
+        if (request.path == "/api/v1/devices") {
+            writeJson(socket, 200, devicesObject());
+        } else if (request.path.startsWith("/api/v1/devices/")) {
+            static const QString prefix = "/api/v1/devices/";
+            if (m_deviceIndex.isEmpty()) {
+                indexDevices();
+            }
+            auto index = m_deviceIndex.constFind(request.path.mid(prefix.size()).toUpper());
+            if (index == m_deviceIndex.constEnd()) {
+                writeJson(socket, 404, errorObject("جهاز غير معروف"));
+            } else {
+                const Device &device = (*m_devices)[index.value()];
+                QJsonObject object = InventoryIO::deviceToJson(device);
+                QJsonArray domains;
+                for (const DomainCount &entry : m_wifiManager->topDomains(device.macAddress, 20)) {
+                    domains.append(QJsonObject{{"domain", entry.domain},
+                                               {"count", double(entry.count)},
+                                               {"error", double(entry.error)}});
+                }
+                object["domains"] = domains;
+                writeJson(socket, 200, object);
+            }
+        } else if (request.path == "/api/v1/stats") {
+            writeJson(socket, 200, statsObject());
+        } else if (request.path == "/api/v1/network") {
+            writeJson(socket, 200, networkObject());
+        } else {
+            writeJson(socket, 404, errorObject("مسار غير معروف"));
+        }
+        return;
+    }
+
+    if (request.method == "POST") {
+        QString action = actionForPath(request.path);
+        if (action.isEmpty()) {
+            writeJson(socket, 404, errorObject("مسار غير معروف"));
+            return;
+        }
+        // نموذج HTML لا يرسل هذا النوع دون طلب preflight يرفضه غياب CORS
+        if (!request.headers.value("content-type").toLower().startsWith("application/json")) {
+            writeJson(socket, 415, errorObject("Content-Type يجب أن يكون application/json"));
+            return;
+        }
+        QJsonObject arguments;
+        if (!request.body.trimmed().isEmpty()) {
+            QJsonDocument document = QJsonDocument::fromJson(request.body);
+            if (!document.isObject()) {
+                writeJson(socket, 400, errorObject("الجسم يجب أن يكون كائن JSON"));
+                return;
+            }
+            arguments = document.object();
+        }
+        QPointer<QTcpSocket> target(socket);
+        perform(action, arguments, [target](int status, const QJsonObject &result) {
+            if (target) {
+                writeJson(target, status, result);
+            }
+        });
+        return;
+    }
+
+    writeJson(socket, 405, errorObject("طريقة غير مدعومة"));
+}
+
+void ControlServer::handleWebSocket(QTcpSocket *socket, Client &client) {
+    while (client.buffer.size() >= 2) {
+        const uchar *data = reinterpret_cast<const uchar *>(client.buffer.constData());
+        bool fin = data[0] & 0x80;
+        quint8 opcode = data[0] & 0x0f;
+        bool masked = data[1] & 0x80;
+        quint64 length = data[1] & 0x7f;
+        int offset = 2;
+        if (length == 126) {
+            if (client.buffer.size() < 4) {
+                return;
+            }
+            length = (quint64(data[2]) << 8) | data[3];
+            offset = 4;
+        } else if (length == 127) {
+            if (client.buffer.size() < 10) {
+                return;
+            }
+            length = 0;
+            for (int i = 0; i < 8; ++i) {
+                length = (length << 8) | data[2 + i];
+            }
+            offset = 10;
+        }
+        // إطارات العميل مقنّعة دائماً، ولا نقبل رسائل مجزأة أو كبيرة
+        if (!masked || !fin || opcode == Continuation || length > quint64(kMaxRequestBytes)) {
+            client.buffer.clear();
+            sendFrame(socket, Close, QByteArray::fromHex("03f0")); // 1008 policy violation
+            socket->disconnectFromHost();
+            return;
+        }
+        if (quint64(client.buffer.size()) < offset + 4 + length) {
+            return;
+        }
+
+        const uchar *mask = data + offset;
+        QByteArray payload(int(length), Qt::Uninitialized);
+        for (int i = 0; i < int(length); ++i) {
+            payload[i] = char(data[offset + 4 + i] ^ mask[i % 4]);
+        }
+        client.buffer.remove(0, offset + 4 + int(length));
+
+        switch (opcode) {
+        case Text: {
+            // {"action": "block", "macs": [...], "id": 1} -> {"type": "result", "id": 1, ...}
+            QJsonDocument document = QJsonDocument::fromJson(payload);
+            QJsonObject request = document.object();
+            QPointer<QTcpSocket> target(socket);
+            const QJsonValue id = request.value("id");
+            Reply reply = [this, target, id](int, const QJsonObject &result) {
+                if (!target) {
+                    return;
+                }
+                QJsonObject message = result;
+                message["type"] = "result";
+                if (!id.isUndefined()) {
+                    message["id"] = id;
+                }
+                sendText(target, message);
+            };
+            if (!document.isObject() || !request.value("action").isString()) {
+                reply(400, errorObject("رسالة غير صالحة"));
+            } else {
+                perform(request.value("action").toString(), request, reply);
+            }
+            break;
+        }
+        case Ping:
+            sendFrame(socket, Pong, payload);
+            break;
+        case Close:
+            client.buffer.clear();
+            sendFrame(socket, Close, payload.left(2));
+            socket->disconnectFromHost();
+            return;
+        default:
+            break; // Pong وBinary لا يعنياننا
+        }
+    }
+}
+
+void ControlServer::perform(const QString &action, const QJsonObject &arguments, const Reply &reply) {
+    bool success = false;
+    QString description;
+
+    if (action == "block" || action == "unblock") {
+        QStringList macs;
+        for (const QJsonValue &value : arguments.value("macs").toArray()) {
+            macs.append(value.toString().toUpper());
+        }
+        if (macs.isEmpty()) {
+            reply(400, errorObject("macs مطلوبة"));
+            return;
+        }
+        // الطلب كله يُرفض قبل أن يدخل أي عنوان قائمة الانتظار
+        for (const QString &mac : macs) {
+            if (!Firewall::isValidMac(mac)) {
+                reply(400, errorObject(QString("عنوان MAC غير صالح: %1").arg(mac)));
+                return;
+            }
+        }
+        bool block = action == "block";
+        for (const QString &mac : macs) {
+            if (block) {
+                m_wifiManager->queueBlock(mac);
+            } else {
+                m_wifiManager->queueUnblock(mac);
+            }
+        }
+        // دفعة واحدة للجدار الناري كما في الواجهة
+        success = m_wifiManager->commitFirewallChanges();
+        description = QString(block ? "حظر عن بعد: %1" : "إلغاء حظر عن بعد: %1").arg(macs.join(", "));
+    } else if (action == "ssid") {
+        QString ssid = arguments.value("ssid").toString();
+        if (ssid.isEmpty()) {
+            reply(400, errorObject("ssid مطلوب"));
+            return;
+        }
+        // القيم تُفحص هنا بقواعد كاتب الملفات نفسها فيصل الخطأ كـ 400 لا كفشل تنفيذ
+        QString error;
+        if (!ApConfigFile::validate("ssid", ssid, &error)) {
+            reply(400, errorObject(error));
+            return;
+        }
+        for (QChar c : ssid) {
+            if (c.category() == QChar::Other_Control) {
+                reply(400, errorObject("اسم الشبكة يحتوي على محارف تحكم"));
+                return;
+            }
+        }
+        success = m_wifiManager->changeSSID(ssid);
+        m_networkFetchedMs = 0;
+        description = QString("تغيير اسم الشبكة عن بعد إلى %1").arg(ssid);
+    } else if (action == "password") {
+        QString password = arguments.value("password").toString();
+        QString error;
+        if (!ApConfigFile::validate("wpa_passphrase", password, &error)) {
+            reply(400, errorObject(error));
+            return;
+        }
+        success = m_wifiManager->changePassword(password);
+        description = "تغيير كلمة المرور عن بعد";
+    } else if (action == "restart") {
+        // الرد مؤجل إلى servicesRestarted؛ الفشل الفوري (لا خدمات أو عملية جارية) يُرد الآن
+        if (m_wifiManager->restartRouter()) {
+            m_pendingRestarts.push_back(reply);
+            return;
+        }
+        description = "إعادة تشغيل خدمات الشبكة عن بعد";
+    } else if (action == "refresh") {
+        // الرد أولاً ثم المسح في الدورة التالية؛ النتيجة تصل عبر القناة كفروق
+        QTimer::singleShot(0, m_wifiManager, &WifiManager::refreshDevices);
+        success = true;
+        description = "طلب تحديث عن بعد";
+    } else {
+        reply(404, errorObject(QString("إجراء غير معروف: %1").arg(action)));
+        return;
+    }
+
+    emit actionPerformed(description, success);
+    if (!success) {
+        reply(500, errorObject(QString("فشل: %1").arg(description)));
+        return;
+    }
+    reply(200, QJsonObject{{"ok", true}});
+}
+
+void ControlServer::broadcast(const QJsonObject &message) {
+    QByteArray text = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        if (it->webSocket) {
+            sendFrame(it.key(), Text, text);
+        }
+    }
+}
+
+void ControlServer::sendText(QTcpSocket *socket, const QJsonObject &message) {
+    sendFrame(socket, Text, QJsonDocument(message).toJson(QJsonDocument::Compact));
+}
+
+void ControlServer::sendFrame(QTcpSocket *socket, quint8 opcode, const QByteArray &payload) {
+    if (socket->bytesToWrite() > kMaxPendingWrite) {
+        qDebug() << "Control server: dropping slow stream client" << socket->peerAddress().toString();
+        // مؤجل: قد نكون داخل حلقة على m_clients
+        QMetaObject::invokeMethod(socket, &QTcpSocket::abort, Qt::QueuedConnection);
+        return;
+    }
+    QByteArray header;
+    header.append(char(0x80 | opcode));
+    if (payload.size() < 126) {
+        header.append(char(payload.size()));
+    } else if (payload.size() <= 0xffff) {
+        header.append(char(126));
+        header.append(char((payload.size() >> 8) & 0xff));
+        header.append(char(payload.size() & 0xff));
+    } else {
+        header.append(char(127));
+        quint64 length = quint64(payload.size());
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            header.append(char((length >> shift) & 0xff));
+        }
+    }
+    socket->write(header);
+    socket->write(payload);
+}
@@ -0,0 +1,92 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QHash>
+#include <QTimer>
+#include <memory>
+#include <functional>
+#include <vector>
+#include "wifimanager.h"
+#include "updatebus.h"
+#include "appconfig.h"
+
+// واجهة تحكم محلية بنفس عمليات الأزرار: HTTP/JSON تحت /api/v1 وقناة
+// WebSocket على /api/v1/stream. القراءة تأتي من لقطات الناقل فلا يشغل أي طلب
+// مسحاً، والقناة ترسل لقطة كاملة عند الاتصال ثم الفروق فقط (أجهزة أُضيفت أو
+// تغيرت أو حُذفت) مجمعة كل 250 ms على الأكثر.
+class ControlServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ControlServer(WifiManager *wifiManager, QObject *parent = nullptr);
+    ~ControlServer();
+
+    bool listen(const QHostAddress &address, quint16 port);
+    void close();
+    quint16 port() const;
+
+    // رمز Bearer؛ دون رمز تُقبل الطلبات من localhost فقط
+    void setToken(const QString &token) { m_token = token; }
+    void setUpdateBus(UpdateBus *bus);
+
+    // يعيد الربط فقط إن تغير العنوان أو المنفذ
+    void applyConfig(const AppConfig &config);
+
+    int streamClients() const;
+
+signals:
+    // إجراء نُفذ عن بعد، ليظهر في سجل الأحداث
+    void actionPerformed(const QString &description, bool success);
+
+private slots:
+    void onNewConnection();
+    void flushUpdates();
+
+private:
+    struct Client {
+        QByteArray buffer;
+        bool webSocket = false;
+    };
+
+    using Reply = std::function<void(int status, const QJsonObject &result)>;
+
+    QTcpServer *m_server;
+    QTimer *m_flushTimer;
+    WifiManager *m_wifiManager;
+    UpdateBus *m_updateBus = nullptr;
+    QString m_token;
+    QHostAddress m_address;
+    quint16 m_port = 0;
+    QHash<QTcpSocket *, Client> m_clients;
+    std::vector<Reply> m_pendingRestarts;
+
+    // آخر لقطة أُرسلت للقناة ومواقع أجهزتها، أساس حساب الفروق
+    std::shared_ptr<const std::vector<Device>> m_devices;
+    QHash<QString, size_t> m_deviceIndex;
+    quint64 m_devicesVersion = 0;
+    quint32 m_pendingTopics = 0;
+
+    // معلومات الشبكة تشغل أدوات خارجية؛ نخزنها لثوانٍ
+    NetworkInfo m_network;
+    qint64 m_networkFetchedMs = 0;
+
+    void onReadyRead(QTcpSocket *socket);
+    void handleHttp(QTcpSocket *socket, Client &client);
+    void handleWebSocket(QTcpSocket *socket, Client &client);
+    // الرد فوري لكل الإجراءات عدا restart الذي يُرد عند اكتمال جاهزية الخدمات
+    void perform(const QString &action, const QJsonObject &arguments, const Reply &reply);
+    QJsonObject devicesObject() const;
+    QJsonObject statsObject() const;
+    QJsonObject networkObject();
+    void indexDevices();
+    void broadcast(const QJsonObject &message);
+    void sendText(QTcpSocket *socket, const QJsonObject &message);
+    void sendFrame(QTcpSocket *socket, quint8 opcode, const QByteArray &payload);
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,322 @@
+#include "devicesweeper.h"
+#include <QThread>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QRegularExpression>
+#include <QNetworkInterface>
+#include <QHostAddress>
+#include <QDebug>
+#include <sys/socket.h>
+#include "arpguard.h"
+#include "profiler.h"
+
+namespace {
+
+// انتظار العملية على دفعات قصيرة حتى يُقتل المسح عند الإغلاق دون انتظار المهلة كاملة
+const int kCancelPollMs = 100;
+
+} // namespace
+
+DeviceSweeper::DeviceSweeper(QObject *parent)
+    : QObject(parent),
+      m_thread(new QThread(this)),
+      m_worker(new QObject) {
+    m_thread->setObjectName("sweep");
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->start();
+}
+
+DeviceSweeper::~DeviceSweeper() {
+    m_cancelled.store(true);
+    m_thread->quit();
+    m_thread->wait();
+}
+
+bool DeviceSweeper::sweep(const SweepRequest &request) {
+    if (m_sweeping) {
+        return false;
+    }
+    m_sweeping = true;
+
+    QMetaObject::invokeMethod(m_worker, [this, request]() {
+        SweepResult result;
+        result.devices = scanWithNmap(request);
+        result.packets = 512;
+
+        if (result.devices.empty()) {
+            result.devices = scanWithArpScan(request.commandTimeoutMs);
+            result.packets += 256;
+        }
+
+        // تفريغ واحد بعد المسح، حين امتلأ الجدول بردوده، يخدم IPv4 و IPv6 معاً
+        const bool dumped = NeighborTable::dump(request.interface, &result.neighbors);
+        if (result.devices.empty()) {
+            result.devices = dumped ? neighborDevices(result.neighbors) : scanWithArpTable(request.commandTimeoutMs);
+        }
+
+        // لا حاجة لاستعلام DNS إذا كان الاسم معروفاً من عقود DHCP أو mDNS
+        for (Device &device : result.devices) {
+            if (device.hostname.isEmpty()) {
+                QString key = device.macAddress.isEmpty() ? device.ipAddress : device.macAddress;
+                device.hostname = request.knownHostnames.value(key);
+            }
+            if (device.hostname.isEmpty()) {
+                device.hostname = getHostname(device.ipAddress, request.commandTimeoutMs);
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, result]() {
+            m_sweeping = false;
+            emit sweepFinished(result);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+void DeviceSweeper::probeStartup(const QString &interface, const QStringList &tools, bool readFirewall,
+                                 int timeoutMs) {
+    QMetaObject::invokeMethod(m_worker, [this, interface, tools, readFirewall, timeoutMs]() {
+        StartupProbe probe;
+        for (const QString &tool : tools) {
+            probe.tools.insert(tool, findTool(tool));
+        }
+        probe.gateway = ArpGuard::defaultGateway(interface);
+        if (readFirewall && !m_cancelled.load()) {
+            probe.firewallRead = Firewall::isAvailable() && Firewall::readBlocked(&probe.blockRules, timeoutMs);
+        }
+
+        QMetaObject::invokeMethod(this, [this, probe]() {
+            emit startupProbed(probe);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void DeviceSweeper::readArpTable(int timeoutMs) {
+    QMetaObject::invokeMethod(m_worker, [this, timeoutMs]() {
+        std::vector<Device> devices = scanWithArpTable(timeoutMs);
+        QMetaObject::invokeMethod(this, [this, devices]() {
+            emit arpTableRead(devices);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+bool DeviceSweeper::findTool(const QString &command) {
+    // بحث في PATH دون تشغيل which
+    return !QStandardPaths::findExecutable(command).isEmpty() ||
+           !QStandardPaths::findExecutable(command, {"/usr/local/sbin", "/usr/sbin", "/sbin"}).isEmpty();
+}
+
+std::vector<Device> DeviceSweeper::neighborDevices(const std::vector<NeighborEntry> &neighbors) {
+    PROFILE_SCOPE(ScanArpTable);
+    std::vector<Device> devices;
+
+    // جدول الجيران مقروء مباشرة من النواة دون تشغيل arp
+    QDateTime now = QDateTime::currentDateTime();
+    for (const NeighborEntry &entry : neighbors) {
+        if (entry.family != AF_INET) {
+            continue;
+        }
+        Device device;
+        device.ipAddress = entry.ipAddress;
+        device.macAddress = entry.macAddress;
+        device.isActive = true;
+        // وقت آخر تأكيد من النواة، وليس وقت القراءة، حتى تبقى المداخل القديمة STALE قديمة
+        device.lastSeen = now.addMSecs(-entry.confirmedMsAgo);
+        devices.push_back(device);
+    }
+    return devices;
+}
+
+QString DeviceSweeper::runCommand(const QString &command, int timeoutMs) const {
+    PROFILE_SCOPE(ExecuteCommand);
+    if (m_cancelled.load()) {
+        return QString();
+    }
+
+    QProcess process;
+    process.start("bash", QStringList() << "-c" << command);
+    QElapsedTimer timer;
+    timer.start();
+    while (!process.waitForFinished(kCancelPollMs)) {
+        if (process.state() == QProcess::NotRunning || m_cancelled.load() || timer.elapsed() >= timeoutMs) {
+            process.kill();
+            process.waitForFinished();
+            return QString();
+        }
+    }
+
+    QString output = process.readAllStandardOutput();
+    QString error = process.readAllStandardError();
+
+    if (!error.isEmpty() && process.exitCode() != 0) {
+        qDebug() << "Command error:" << command << "Error:" << error;
+    }
+
+    return output;
+}
+
+std::vector<Device> DeviceSweeper::scanWithNmap(const SweepRequest &request) const {
+    PROFILE_SCOPE(ScanNmap);
+    std::vector<Device> devices;
+
+    if (!findTool("nmap")) {
+        return devices;
+    }
+
+    // الحصول على نطاق الشبكة
+    QString gateway = ArpGuard::defaultGateway(QString());
+    if (gateway.isEmpty()) {
+        return devices;
+    }
+
+    // تحويل عنوان البوابة إلى نطاق الشبكة بطول البادئة المضبوط أو بادئة الواجهة
+    QHostAddress gatewayAddress(gateway);
+    if (gatewayAddress.protocol() != QAbstractSocket::IPv4Protocol) {
+        return devices;
+    }
+    int prefix = request.subnetPrefix;
+    if (prefix == 0) {
+        prefix = 24;
+        QNetworkInterface local = QNetworkInterface::interfaceFromName(request.interface);
+        for (const QNetworkAddressEntry &entry : local.addressEntries()) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol &&
+                entry.ip().isInSubnet(gatewayAddress, entry.prefixLength())) {
+                prefix = qMax(16, entry.prefixLength());
+                break;
+            }
+        }
+    }
+    quint32 mask = prefix >= 32 ? 0xffffffffu : ~(0xffffffffu >> prefix);
+    QString network = QString("%1/%2").arg(QHostAddress(gatewayAddress.toIPv4Address() & mask).toString()).arg(prefix);
+
+    QString output = runCommand(QString("nmap -sn %1 2>/dev/null").arg(network), request.commandTimeoutMs);
+
+    QStringList lines = output.split('\n');
+    Device currentDevice;
+
+    for (const QString &line : lines) {
+        if (line.startsWith("Nmap scan report for")) {
+            if (!currentDevice.ipAddress.isEmpty()) {
+                devices.push_back(currentDevice);
+            }
+            currentDevice = Device();
+
+            QRegularExpression ipRegex("(\\d+\\.\\d+\\.\\d+\\.\\d+)");
+            QRegularExpressionMatch match = ipRegex.match(line);
+            if (match.hasMatch()) {
+                currentDevice.ipAddress = match.captured(1);
+                currentDevice.isActive = true;
+                currentDevice.lastSeen = QDateTime::currentDateTime();
+            }
+
+            // استخراج hostname إذا كان موجوداً
+            if (line.contains('(') && line.contains(')')) {
+                QRegularExpression hostnameRegex("\\(([^)]+)\\)");
+                QRegularExpressionMatch hostnameMatch = hostnameRegex.match(line);
+                if (hostnameMatch.hasMatch()) {
+                    QString hostname = hostnameMatch.captured(1);
+                    if (!hostname.contains('.') || hostname.split('.').size() == 4) {
+                        currentDevice.ipAddress = hostname;
+                    } else {
+                        currentDevice.hostname = hostname;
+                    }
+                }
+            }
+        } else if (line.contains("MAC Address:")) {
+            QRegularExpression macRegex("([0-9A-Fa-f]{2}[:-]){5}([0-9A-Fa-f]{2})");
+            QRegularExpressionMatch match = macRegex.match(line);
+            if (match.hasMatch()) {
+                currentDevice.macAddress = match.captured(0).toUpper();
+            }
+        }
+    }
+
+    if (!currentDevice.ipAddress.isEmpty()) {
+        devices.push_back(currentDevice);
+    }
+
+    return devices;
+}
+
+std::vector<Device> DeviceSweeper::scanWithArpScan(int timeoutMs) const {
+    PROFILE_SCOPE(ScanArpScan);
+    std::vector<Device> devices;
+
+    if (!findTool("arp-scan")) {
+        return devices;
+    }
+
+    QString output = runCommand("arp-scan --local 2>/dev/null", timeoutMs);
+
+    QStringList lines = output.split('\n');
+    QRegularExpression deviceRegex("(\\d+\\.\\d+\\.\\d+\\.\\d+)\\s+([0-9a-fA-F:]+)\\s+(.*)");
+
+    for (const QString &line : lines) {
+        QRegularExpressionMatch match = deviceRegex.match(line);
+        if (match.hasMatch()) {
+            Device device;
+            device.ipAddress = match.captured(1);
+            device.macAddress = match.captured(2).toUpper();
+            device.manufacturer = match.captured(3);
+            device.isActive = true;
+            device.lastSeen = QDateTime::currentDateTime();
+
+            devices.push_back(device);
+        }
+    }
+
+    return devices;
+}
+
+std::vector<Device> DeviceSweeper::scanWithArpTable(int timeoutMs) const {
+    PROFILE_SCOPE(ScanArpTable);
+    std::vector<Device> devices;
+
+    QString output = runCommand("arp -a 2>/dev/null", timeoutMs);
+
+    QStringList lines = output.split('\n');
+    QRegularExpression arpRegex("([^\\s]+)\\s+\\((\\d+\\.\\d+\\.\\d+\\.\\d+)\\)\\s+at\\s+([0-9a-fA-F:]+)");
+
+    for (const QString &line : lines) {
+        QRegularExpressionMatch match = arpRegex.match(line);
+        if (match.hasMatch()) {
+            Device device;
+            device.hostname = match.captured(1);
+            device.ipAddress = match.captured(2);
+            device.macAddress = match.captured(3).toUpper();
+            device.isActive = true;
+            device.lastSeen = QDateTime::currentDateTime();
+
+            devices.push_back(device);
+        }
+    }
+
+    return devices;
+}
+
+QString DeviceSweeper::getHostname(const QString &ipAddress, int timeoutMs) const {
+    PROFILE_SCOPE(GetHostname);
+    // محاولة الحصول على hostname
+    if (findTool("nslookup")) {
+        QString output = runCommand(QString("nslookup %1 2>/dev/null | grep 'name =' | head -1").arg(ipAddress),
+                                    timeoutMs);
+        QRegularExpression hostnameRegex("name = (.+)\\.");
+        QRegularExpressionMatch match = hostnameRegex.match(output);
+        if (match.hasMatch()) {
+            return match.captured(1);
+        }
+    }
+
+    if (findTool("host")) {
+        QString output = runCommand(QString("host %1 2>/dev/null | head -1").arg(ipAddress), timeoutMs);
+        QRegularExpression hostnameRegex("pointer (.+)\\.");
+        QRegularExpressionMatch match = hostnameRegex.match(output);
+        if (match.hasMatch()) {
+            return match.captured(1);
+        }
+    }
+
+    return QString();
+}
@@ -0,0 +1,80 @@
+#ifndef DEVICESWEEPER_H
+#define DEVICESWEEPER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+#include "wifimanager.h"
+#include "neighbortable.h"
+#include "firewall.h"
+
+class QThread;
+
+struct SweepRequest {
+    QString interface;
+    int subnetPrefix = 0;          // 0 = من بادئة الواجهة
+    int commandTimeoutMs = 10000;
+    QHash<QString, QString> knownHostnames; // مفتاح الجهاز -> اسم معروف من DHCP أو mDNS
+};
+
+struct SweepResult {
+    std::vector<Device> devices;
+    std::vector<NeighborEntry> neighbors;
+    int packets = 0;               // تقدير الحزم المرسلة على شبكة /24 لميزانية الجدولة
+};
+
+struct StartupProbe {
+    QHash<QString, bool> tools;    // الأداة -> متوفرة
+    QString gateway;
+    bool firewallRead = false;
+    Firewall::BlockRules blockRules;
+};
+
+// المسح الكامل (nmap / arp-scan / nslookup) وفحوصات البدء تنتظر عمليات خارجية
+// لثوانٍ، فتعمل على خيط خاص حتى لا تحجب حلقة أحداث الواجهة. النتائج تصل
+// كإشارات في خيط المالك، ومسح واحد فقط في كل مرة.
+class DeviceSweeper : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DeviceSweeper(QObject *parent = nullptr);
+    // يلغي العمل الجاري (العملية الحالية تُقتل) وينتظر الخيط
+    ~DeviceSweeper();
+
+    // false إن كان مسح سابق ما زال جارياً؛ نتيجته تخدم الطلب الجديد أيضاً
+    bool sweep(const SweepRequest &request);
+    bool isSweeping() const { return m_sweeping; }
+
+    // الأدوات المتوفرة في PATH، والبوابة الافتراضية، وقواعد الحظر عبر iptables-save
+    // (readFirewall: فقط عند التشغيل المحلي بصلاحيات الجذر دون المساعد)
+    void probeStartup(const QString &interface, const QStringList &tools, bool readFirewall, int timeoutMs);
+
+    // arp -a عند تعذر قراءة جدول الجيران عبر netlink
+    void readArpTable(int timeoutMs);
+
+    static bool findTool(const QString &command);
+    // أجهزة IPv4 من تفريغ جدول الجيران، بوقت آخر تأكيد من النواة
+    static std::vector<Device> neighborDevices(const std::vector<NeighborEntry> &neighbors);
+
+signals:
+    void sweepFinished(const SweepResult &result);
+    void startupProbed(const StartupProbe &probe);
+    void arpTableRead(const std::vector<Device> &devices);
+
+private:
+    QThread *m_thread;
+    QObject *m_worker;             // يعيش في m_thread؛ سياق الأعمال المرسلة إليه
+    std::atomic<bool> m_cancelled{false};
+    bool m_sweeping = false;
+
+    // تعمل كلها في m_thread
+    QString runCommand(const QString &command, int timeoutMs) const;
+    std::vector<Device> scanWithNmap(const SweepRequest &request) const;
+    std::vector<Device> scanWithArpScan(int timeoutMs) const;
+    std::vector<Device> scanWithArpTable(int timeoutMs) const;
+    QString getHostname(const QString &ipAddress, int timeoutMs) const;
+};
+
+#endif // DEVICESWEEPER_H
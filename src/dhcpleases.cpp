@@ -0,0 +1,153 @@
+#include "dhcpleases.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <QSet>
+
+DhcpLeaseWatcher::DhcpLeaseWatcher(QObject *parent)
+    : QObject(parent),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_debounceTimer(new QTimer(this))
+{
+    // dnsmasq يعيد كتابة الملف على عدة دفعات، نقرأه مرة واحدة بعد استقراره
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(100);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &DhcpLeaseWatcher::onPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DhcpLeaseWatcher::onPathChanged);
+    connect(m_debounceTimer, &QTimer::timeout, this, &DhcpLeaseWatcher::reload);
+}
+
+DhcpLeaseWatcher::~DhcpLeaseWatcher() {
+    stop();
+}
+
+QString DhcpLeaseWatcher::defaultLeaseFile() {
+    // Debian/Kali ثم Fedora/Arch
+    const QStringList candidates = {
+        "/var/lib/misc/dnsmasq.leases",
+        "/var/lib/dnsmasq/dnsmasq.leases"
+    };
+
+    for (const QString &path : candidates) {
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return candidates.first();
+}
+
+bool DhcpLeaseWatcher::start(const QString &path) {
+    stop();
+
+    m_path = path.isEmpty() ? defaultLeaseFile() : path;
+
+    // مراقبة المجلد أيضاً لالتقاط إنشاء الملف أو استبداله بإعادة التسمية
+    QString directory = QFileInfo(m_path).absolutePath();
+    if (!QFileInfo::exists(directory)) {
+        return false;
+    }
+    m_watcher->addPath(directory);
+    if (QFile::exists(m_path)) {
+        m_watcher->addPath(m_path);
+    }
+
+    reload();
+    return true;
+}
+
+void DhcpLeaseWatcher::stop() {
+    m_debounceTimer->stop();
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    m_lines.clear();
+}
+
+void DhcpLeaseWatcher::onPathChanged() {
+    // بعد الاستبدال بإعادة التسمية يسقط الملف من قائمة المراقبة
+    if (!m_watcher->files().contains(m_path) && QFile::exists(m_path)) {
+        m_watcher->addPath(m_path);
+    }
+    m_debounceTimer->start();
+}
+
+void DhcpLeaseWatcher::reload() {
+    QFile file(m_path);
+    QByteArray content;
+    if (file.open(QIODevice::ReadOnly)) {
+        content = file.readAll();
+    }
+
+    QHash<QByteArray, QString> lines;
+    lines.reserve(m_lines.size());
+    QSet<QString> present;
+
+    int start = 0;
+    while (start < content.size()) {
+        int end = content.indexOf('\n', start);
+        if (end < 0) {
+            end = content.size();
+        }
+        QByteArray line = content.mid(start, end - start);
+        start = end + 1;
+
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        // الأسطر غير المتغيرة لا تُحلل من جديد
+        auto it = m_lines.constFind(line);
+        if (it != m_lines.constEnd()) {
+            lines.insert(line, it.value());
+            present.insert(it.value());
+            continue;
+        }
+
+        DhcpLease lease;
+        if (!parseLine(line, &lease)) {
+            continue;
+        }
+        lines.insert(line, lease.macAddress);
+        present.insert(lease.macAddress);
+        emit leaseUpdated(lease);
+    }
+
+    for (auto it = m_lines.constBegin(); it != m_lines.constEnd(); ++it) {
+        if (!present.contains(it.value())) {
+            present.insert(it.value()); // إبلاغ واحد لكل جهاز
+            emit leaseRemoved(it.value());
+        }
+    }
+
+    m_lines.swap(lines);
+}
+
+bool DhcpLeaseWatcher::parseLine(const QByteArray &line, DhcpLease *lease) {
+    // <expiry> <mac> <ip> <hostname|*> <client-id|*>
+    QList<QByteArray> fields = line.split(' ');
+    if (fields.size() < 4) {
+        return false;
+    }
+
+    // أسطر IPv6 (duid و IAID) لا تحمل عنوان MAC
+    const QByteArray &mac = fields[1];
+    if (mac.size() != 17 || mac[2] != ':' || mac[5] != ':' || mac[14] != ':') {
+        return false;
+    }
+
+    bool ok = false;
+    qint64 expiry = fields[0].toLongLong(&ok);
+    if (!ok) {
+        return false;
+    }
+
+    lease->macAddress = QString::fromLatin1(mac).toUpper();
+    lease->ipAddress = QString::fromLatin1(fields[2]);
+    lease->hostname = fields[3] == "*" ? QString() : QString::fromUtf8(fields[3]);
+    lease->expiry = expiry > 0 ? QDateTime::fromSecsSinceEpoch(expiry) : QDateTime();
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef DHCPLEASES_H
+#define DHCPLEASES_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QDateTime>
+#include <QHash>
+
+struct DhcpLease {
+    QString macAddress;
+    QString ipAddress;
+    QString hostname;
+    QDateTime expiry; // غير صالح = عقد دائم
+};
+
+// مصدر أجهزة بدون أي مسح: قراءة ملف عقود dnsmasq ومراقبته عبر inotify
+class DhcpLeaseWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DhcpLeaseWatcher(QObject *parent = nullptr);
+    ~DhcpLeaseWatcher();
+
+    bool start(const QString &path = QString());
+    void stop();
+    QString leaseFile() const { return m_path; }
+
+    static QString defaultLeaseFile();
+
+signals:
+    void leaseUpdated(const DhcpLease &lease);
+    void leaseRemoved(const QString &macAddress);
+
+private slots:
+    void onPathChanged();
+    void reload();
+
+private:
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_debounceTimer;
+    QString m_path;
+
+    // سطر الملف -> عنوان MAC، لتخطي الأسطر التي لم تتغير دون تحليلها
+    QHash<QByteArray, QString> m_lines;
+
+    static bool parseLine(const QByteArray &line, DhcpLease *lease);
+};
+
+#endif // DHCPLEASES_H
@@ -0,0 +1,369 @@
+#include "dnsquerylog.h"
+#include "profiler.h"
+#include <QFileInfo>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+
+const int kReadDelayMs = 50;               // تجميع أحداث inotify المتلاحقة في قراءة واحدة
+const qint64 kChunkSize = 256 * 1024;
+const qint64 kBatchBudget = 4 * 1024 * 1024; // ثم عودة لحلقة الأحداث قبل المتابعة
+const int kMaxLineLength = 4096;
+const int kMaxClients = 4096;
+
+const char kQueryMarker[] = "query[";
+const int kQueryMarkerLength = sizeof(kQueryMarker) - 1;
+
+} // namespace
+
+DnsQueryLog::DnsQueryLog(QObject *parent)
+    : QObject(parent),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_readTimer(new QTimer(this))
+{
+    m_readTimer->setSingleShot(true);
+    m_readTimer->setInterval(kReadDelayMs);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &DnsQueryLog::onPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DnsQueryLog::onPathChanged);
+    connect(m_readTimer, &QTimer::timeout, this, &DnsQueryLog::readNew);
+}
+
+DnsQueryLog::~DnsQueryLog() {
+    stop();
+}
+
+QString DnsQueryLog::defaultLogFile() {
+    const QStringList candidates = {
+        "/var/log/dnsmasq.log",
+        "/var/log/dnsmasq/dnsmasq.log"
+    };
+
+    for (const QString &path : candidates) {
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return candidates.first();
+}
+
+bool DnsQueryLog::start(const QString &path) {
+    stop();
+
+    m_path = path.isEmpty() ? defaultLogFile() : path;
+
+    // المجلد أيضاً: التدوير يستبدل الملف بإعادة التسمية
+    QString directory = QFileInfo(m_path).absolutePath();
+    if (!QFileInfo::exists(directory)) {
+        emit errorOccurred(QString("مجلد سجل استعلامات DNS غير موجود: %1").arg(directory));
+        return false;
+    }
+    m_watcher->addPath(directory);
+    m_running = true;
+
+    struct stat info;
+    if (::stat(QFile::encodeName(m_path).constData(), &info) == 0) {
+        m_watcher->addPath(m_path);
+        reopen(info.st_ino, true);
+    }
+    qDebug() << "DNS log: following" << m_path;
+    return true;
+}
+
+void DnsQueryLog::stop() {
+    m_running = false;
+    m_readTimer->stop();
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    m_file.close();
+    m_inode = 0;
+    m_offset = 0;
+    m_pending.clear();
+    m_openFailed = false;
+}
+
+void DnsQueryLog::setCapacity(int domainsPerClient) {
+    domainsPerClient = std::max(4, domainsPerClient);
+    if (domainsPerClient != m_capacity) {
+        // العدادات الحالية بُنيت على سعة أخرى
+        m_capacity = domainsPerClient;
+        m_clients.clear();
+        m_recentClients.clear();
+    }
+}
+
+void DnsQueryLog::clear() {
+    m_clients.clear();
+    m_recentClients.clear();
+    m_totalQueries = 0;
+    m_evictedClients = 0;
+}
+
+bool DnsQueryLog::reopen(quint64 inode, bool fromEnd) {
+    m_file.close();
+    m_file.setFileName(m_path);
+    m_pending.clear();
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "DNS log: cannot open" << m_path << m_file.errorString();
+        m_inode = 0;
+        // dnsmasq يكتبه عادة لـ root:adm؛ يتكرر الفشل مع كل تدوير فنبلغ مرة
+        if (!m_openFailed) {
+            m_openFailed = true;
+            emit errorOccurred(QString("تعذرت قراءة سجل استعلامات DNS %1: %2")
+                                   .arg(m_path, m_file.errorString()));
+        }
+        return false;
+    }
+    m_openFailed = false;
+    m_inode = inode;
+    m_offset = fromEnd ? m_file.size() : 0;
+    return true;
+}
+
+void DnsQueryLog::onPathChanged() {
+    if (!m_watcher->files().contains(m_path) && QFile::exists(m_path)) {
+        m_watcher->addPath(m_path);
+    }
+    // كل سطر يكتبه dnsmasq حدث؛ نقرأ مرة واحدة لكل دفعة منها
+    if (!m_readTimer->isActive()) {
+        m_readTimer->start();
+    }
+}
+
+void DnsQueryLog::readNew() {
+    PROFILE_SCOPE(DnsLogRead);
+    if (!m_running) {
+        return;
+    }
+
+    int queries = 0;
+    qint64 budget = kBatchBudget;
+    struct stat info;
+    bool exists = ::stat(QFile::encodeName(m_path).constData(), &info) == 0;
+
+    if (!exists || info.st_ino != m_inode) {
+        // سُمي الملف القديم أو حُذف: ما كُتب فيه قبل التدوير يُقرأ أولاً
+        if (m_file.isOpen()) {
+            queries += readAvailable(budget);
+        }
+        if (!exists) {
+            m_file.close();
+            m_inode = 0;
+            if (queries > 0) {
+                emit queriesLogged(queries);
+            }
+            return;
+        }
+        reopen(info.st_ino, false);
+    } else if (info.st_size < m_offset) {
+        // قُص في مكانه (copytruncate)
+        m_offset = 0;
+        m_pending.clear();
+    }
+
+    if (m_file.isOpen()) {
+        queries += readAvailable(budget);
+        // بقية كبيرة: نكمل بعد أن تعالج حلقة الأحداث ما تراكم
+        if (m_file.size() > m_offset) {
+            m_readTimer->start(0);
+        }
+    }
+    if (queries > 0) {
+        emit queriesLogged(queries);
+    }
+}
+
+int DnsQueryLog::readAvailable(qint64 budget) {
+    int queries = 0;
+    if (!m_file.seek(m_offset)) {
+        return 0;
+    }
+
+    while (budget > 0) {
+        const qint64 carried = m_pending.size();
+        m_buffer.resize(carried + kChunkSize);
+        if (carried > 0) {
+            std::memcpy(m_buffer.data(), m_pending.constData(), carried);
+        }
+        qint64 read = m_file.read(m_buffer.data() + carried, kChunkSize);
+        if (read <= 0) {
+            break;
+        }
+        m_offset += read;
+        budget -= read;
+
+        qint64 length = carried + read;
+        const char *data = m_buffer.constData();
+        const char *lastNewline = static_cast<const char *>(memrchr(data, '\n', length));
+        if (!lastNewline) {
+            // سطر أطول من المعقول لا يكتبه dnsmasq؛ يُهمل بدل أن يكبر بلا حد
+            m_pending = length > kMaxLineLength ? QByteArray() : QByteArray(data, length);
+            continue;
+        }
+        qint64 complete = lastNewline - data + 1;
+        queries += consume(m_buffer.data(), complete);
+        m_pending = QByteArray(data + complete, length - complete);
+    }
+    return queries;
+}
+
+int DnsQueryLog::consume(char *data, qsizetype length) {
+    int queries = 0;
+    char *end = data + length;
+    while (data < end) {
+        char *newline = static_cast<char *>(std::memchr(data, '\n', end - data));
+        char *lineEnd = newline ? newline : end;
+
+        const char *client = nullptr;
+        const char *domain = nullptr;
+        int clientLength = 0;
+        int domainLength = 0;
+        if (parseQuery(data, int(lineEnd - data), &client, &clientLength, &domain, &domainLength)) {
+            record(client, clientLength, domain, domainLength);
+            ++queries;
+        }
+        data = lineEnd + 1;
+    }
+    return queries;
+}
+
+bool DnsQueryLog::parseQuery(char *line, int length, const char **client, int *clientLength,
+                             const char **domain, int *domainLength) {
+    // Oct 19 12:00:01 dnsmasq[812]: query[AAAA] example.com from 192.168.1.23
+    // مع log-queries=extra يسبق query[ رقم الطلب وعنوان العميل ومنفذه
+    if (length > 0 && line[length - 1] == '\r') {
+        --length;
+    }
+    char *end = line + length;
+    char *cursor = line;
+    for (;;) {
+        cursor = static_cast<char *>(std::memchr(cursor, 'q', end - cursor));
+        if (!cursor || end - cursor < kQueryMarkerLength) {
+            return false;
+        }
+        if (std::memcmp(cursor, kQueryMarker, kQueryMarkerLength) == 0) {
+            break;
+        }
+        ++cursor;
+    }
+    cursor += kQueryMarkerLength;
+
+    char *typeEnd = static_cast<char *>(std::memchr(cursor, ']', end - cursor));
+    if (!typeEnd || end - typeEnd < 2 || typeEnd[1] != ' ') {
+        return false;
+    }
+    char *name = typeEnd + 2;
+    char *nameEnd = static_cast<char *>(std::memchr(name, ' ', end - name));
+    if (!nameEnd || nameEnd == name || end - nameEnd < 6 || std::memcmp(nameEnd, " from ", 6) != 0) {
+        return false;
+    }
+    char *address = nameEnd + 6;
+    if (address == end) {
+        return false;
+    }
+
+    // Example.COM. و example.com نطاق واحد
+    if (nameEnd - name > 1 && nameEnd[-1] == '.') {
+        --nameEnd;
+    }
+    for (char *c = name; c < nameEnd; ++c) {
+        if (*c >= 'A' && *c <= 'Z') {
+            *c += 'a' - 'A';
+        }
+    }
+
+    *domain = name;
+    *domainLength = int(nameEnd - name);
+    *client = address;
+    *clientLength = int(end - address);
+    return true;
+}
+
+void DnsQueryLog::record(const char *client, int clientLength, const char *domain, int domainLength) {
+    ++m_totalQueries;
+
+    // البحث بمفاتيح تشير إلى المخزن دون نسخ؛ النسخ عند الإدراج فقط
+    const QByteArray clientKey = QByteArray::fromRawData(client, clientLength);
+    auto clientIt = m_clients.find(clientKey);
+    if (clientIt == m_clients.end()) {
+        if (m_clients.size() >= kMaxClients) {
+            // جهاز جديد يحل محل أقدم العملاء استعلاماً، لا يُهمل هو
+            m_clients.remove(m_recentClients.front());
+            m_recentClients.pop_front();
+            if (m_evictedClients++ == 0) {
+                qDebug() << "DNS log: client limit reached, evicting least recent clients";
+            }
+        }
+        QByteArray key(client, clientLength);
+        clientIt = m_clients.insert(key, Client());
+        clientIt->counters.reserve(m_capacity);
+        clientIt->index.reserve(m_capacity);
+        clientIt->recent = m_recentClients.insert(m_recentClients.end(), key);
+    } else {
+        m_recentClients.splice(m_recentClients.end(), m_recentClients, clientIt->recent);
+    }
+    Client &entry = clientIt.value();
+    ++entry.queries;
+
+    const QByteArray domainKey = QByteArray::fromRawData(domain, domainLength);
+    auto found = entry.index.constFind(domainKey);
+    if (found != entry.index.constEnd()) {
+        ++entry.counters[found.value()].count;
+        return;
+    }
+
+    QByteArray name(domain, domainLength);
+    if (static_cast<int>(entry.counters.size()) < m_capacity) {
+        entry.index.insert(name, static_cast<int>(entry.counters.size()));
+        entry.counters.push_back(Counter{name, 1, 0});
+        return;
+    }
+
+    // Space-Saving: النطاق الجديد يرث أصغر عداد مع خطئه
+    auto smallest = std::min_element(entry.counters.begin(), entry.counters.end(),
+                                     [](const Counter &a, const Counter &b) { return a.count < b.count; });
+    int slot = static_cast<int>(smallest - entry.counters.begin());
+    entry.index.remove(smallest->domain);
+    quint64 floor = smallest->count;
+    *smallest = Counter{name, floor + 1, floor};
+    entry.index.insert(name, slot);
+}
+
+std::vector<DomainCount> DnsQueryLog::topDomains(const QString &clientIp, int count) const {
+    std::vector<DomainCount> result;
+    auto it = m_clients.constFind(clientIp.toLatin1());
+    if (it == m_clients.constEnd() || count <= 0) {
+        return result;
+    }
+
+    std::vector<const Counter *> counters;
+    counters.reserve(it->counters.size());
+    for (const Counter &counter : it->counters) {
+        counters.push_back(&counter);
+    }
+    size_t limit = std::min(counters.size(), static_cast<size_t>(count));
+    std::partial_sort(counters.begin(), counters.begin() + limit, counters.end(),
+                      [](const Counter *a, const Counter *b) { return a->count > b->count; });
+
+    result.reserve(limit);
+    for (size_t i = 0; i < limit; ++i) {
+        DomainCount entry;
+        entry.domain = QString::fromUtf8(counters[i]->domain);
+        entry.count = counters[i]->count;
+        entry.error = counters[i]->error;
+        result.push_back(entry);
+    }
+    return result;
+}
+
+quint64 DnsQueryLog::queryCount(const QString &clientIp) const {
+    auto it = m_clients.constFind(clientIp.toLatin1());
+    return it == m_clients.constEnd() ? 0 : it->queries;
+}
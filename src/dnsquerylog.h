@@ -0,0 +1,98 @@
+#ifndef DNSQUERYLOG_H
+#define DNSQUERYLOG_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <list>
+#include <vector>
+
+// نطاق مع عدد طلباته التقريبي: count حد أعلى، و count - error حد أدنى
+struct DomainCount {
+    QString domain;
+    quint64 count = 0;
+    quint64 error = 0;
+};
+
+// متابعة سجل استعلامات dnsmasq (log-queries مع log-facility) عبر inotify
+// وموضع قراءة تراكمي: كل تغيير يقرأ ما أُضيف فقط، وتدوير السجل أو قصه
+// يُكتشف من رقم inode والحجم. الأسطر تُحلل في مكانها دون تعابير نمطية ولا
+// نسخ، وتُنسب الاستعلامات إلى عنوان العميل. أكثر النطاقات طلباً لكل عميل
+// في خوارزمية Space-Saving بعدد عدادات ثابت، والعملاء أنفسهم محدودون بإخراج
+// أقدمهم استعلاماً، فالذاكرة محدودة مهما طال التشغيل.
+class DnsQueryLog : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DnsQueryLog(QObject *parent = nullptr);
+    ~DnsQueryLog();
+
+    // تبدأ المتابعة من نهاية الملف الحالي؛ السجل السابق لا يُعاد عده
+    bool start(const QString &path = QString());
+    void stop();
+    bool isRunning() const { return m_running; }
+    QString logFile() const { return m_path; }
+
+    // عدد العدادات لكل عميل؛ الدقة تكفي لأعلى capacity/4 نطاقاً تقريباً
+    void setCapacity(int domainsPerClient);
+
+    std::vector<DomainCount> topDomains(const QString &clientIp, int count) const;
+    quint64 queryCount(const QString &clientIp) const;
+    quint64 totalQueries() const { return m_totalQueries; }
+    void clear();
+
+    // أسطر كاملة (تنتهي بـ '\n')؛ يُعدل النطاق في مكانه إلى أحرف صغيرة
+    int consume(char *data, qsizetype length);
+
+    static QString defaultLogFile();
+
+signals:
+    // مرة لكل دفعة قراءة، لا لكل استعلام
+    void queriesLogged(int count);
+    // تعذر فتح السجل (صلاحيات غالباً)؛ مرة واحدة حتى ينجح الفتح
+    void errorOccurred(const QString &error);
+
+private slots:
+    void onPathChanged();
+    void readNew();
+
+private:
+    struct Counter {
+        QByteArray domain;
+        quint64 count = 0;
+        quint64 error = 0;
+    };
+
+    struct Client {
+        std::vector<Counter> counters;
+        QHash<QByteArray, int> index;     // نطاق -> موقع في counters
+        quint64 queries = 0;
+        std::list<QByteArray>::iterator recent;   // موقعه في m_recentClients
+    };
+
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_readTimer;
+    QString m_path;
+    QFile m_file;
+    quint64 m_inode = 0;
+    qint64 m_offset = 0;
+    QByteArray m_buffer;                  // يُعاد استخدامه بين الدفعات
+    QByteArray m_pending;                 // بقية سطر لم يكتمل بعد
+    QHash<QByteArray, Client> m_clients;
+    std::list<QByteArray> m_recentClients; // الأقدم استعلاماً أولاً
+    int m_capacity = 64;
+    quint64 m_totalQueries = 0;
+    quint64 m_evictedClients = 0;
+    bool m_running = false;
+    bool m_openFailed = false;
+
+    bool reopen(quint64 inode, bool fromEnd);
+    int readAvailable(qint64 budget);
+    void record(const char *client, int clientLength, const char *domain, int domainLength);
+    static bool parseQuery(char *line, int length, const char **client, int *clientLength,
+                           const char **domain, int *domainLength);
+};
+
+#endif // DNSQUERYLOG_H
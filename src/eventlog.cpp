@@ -0,0 +1,203 @@
+#include "eventlog.h"
+#include <QDebug>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+const char *levelName(LogEvent::Level level) {
+    switch (level) {
+    case LogEvent::Warning: return "WARN ";
+    case LogEvent::Error: return "ERROR";
+    case LogEvent::Info: break;
+    }
+    return "INFO ";
+}
+
+} // namespace
+
+EventLogModel::EventLogModel(QObject *parent)
+    : QAbstractListModel(parent), m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(100);
+    connect(m_flushTimer, &QTimer::timeout, this, &EventLogModel::flush);
+}
+
+EventLogModel::~EventLogModel() {
+    // ما لم يُعرض بعد يُكتب إلى الملف فقط؛ لا داعي لتحديث عرض يُهدم
+    writeRepeatSummary();
+    for (const LogEvent &event : m_pending) {
+        writeEvent(event);
+    }
+}
+
+void EventLogModel::append(LogEvent::Level level, const QString &message, const QString &key) {
+    LogEvent event;
+    event.level = level;
+    event.key = key.isEmpty() ? message : key;
+    event.message = message;
+    event.firstSeen = QDateTime::currentDateTime();
+    event.lastSeen = event.firstSeen;
+
+    if (!m_pending.empty()) {
+        if (coalesce(m_pending.back(), event)) {
+            return;
+        }
+    } else if (!m_events.empty() && coalesce(m_events.back(), event)) {
+        // تحديث السطر الأخير في مكانه بدلاً من إضافة سطر جديد
+        QModelIndex last = index(static_cast<int>(m_events.size()) - 1);
+        emit dataChanged(last, last);
+        return;
+    }
+
+    m_pending.push_back(event);
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+bool EventLogModel::coalesce(LogEvent &target, const LogEvent &event) const {
+    if (target.key != event.key || target.level != event.level ||
+        target.lastSeen.msecsTo(event.firstSeen) > m_coalesceWindowMs) {
+        return false;
+    }
+    target.message = event.message;
+    target.lastSeen = event.lastSeen;
+    ++target.repeat;
+    return true;
+}
+
+void EventLogModel::setCapacity(int maxEvents) {
+    m_capacity = std::max(1, maxEvents);
+}
+
+void EventLogModel::setCoalesceWindow(int ms) {
+    m_coalesceWindowMs = std::max(0, ms);
+}
+
+bool EventLogModel::setLogFile(const QString &path, qint64 maxBytes) {
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_maxFileBytes = std::max<qint64>(4096, maxBytes);
+    if (path.isEmpty()) {
+        return true;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "Event log: cannot open" << path << m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void EventLogModel::flush() {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    writeRepeatSummary();
+
+    int first = static_cast<int>(m_events.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(m_pending.size()) - 1);
+    for (LogEvent &event : m_pending) {
+        writeEvent(event);
+        m_events.push_back(std::move(event));
+    }
+    endInsertRows();
+    m_pending.clear();
+    m_tailRepeatWritten = m_events.back().repeat;
+
+    if (static_cast<int>(m_events.size()) > m_capacity) {
+        int excess = static_cast<int>(m_events.size()) - m_capacity;
+        beginRemoveRows(QModelIndex(), 0, excess - 1);
+        m_events.erase(m_events.begin(), m_events.begin() + excess);
+        endRemoveRows();
+    }
+
+    emit eventsAppended();
+}
+
+void EventLogModel::writeEvent(const LogEvent &event) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    QTextStream out(&m_file);
+    out << event.firstSeen.toString("yyyy-MM-dd hh:mm:ss") << ' ' << levelName(event.level)
+        << ' ' << event.message;
+    if (event.repeat > 1) {
+        out << " (x" << event.repeat << ')';
+    }
+    out << '\n';
+    out.flush();
+    rotateIfNeeded();
+}
+
+void EventLogModel::writeRepeatSummary() {
+    // التكرارات المدمجة في السطر الأخير تُلخص في سطر واحد عند انتهاء السلسلة
+    if (!m_file.isOpen() || m_events.empty() || m_events.back().repeat <= m_tailRepeatWritten) {
+        return;
+    }
+
+    const LogEvent &tail = m_events.back();
+    QTextStream out(&m_file);
+    out << tail.lastSeen.toString("yyyy-MM-dd hh:mm:ss") << ' ' << levelName(tail.level)
+        << ' ' << tail.message << " (x" << tail.repeat - m_tailRepeatWritten
+        << " since " << tail.firstSeen.toString("hh:mm:ss") << ")\n";
+    out.flush();
+    m_tailRepeatWritten = tail.repeat;
+    rotateIfNeeded();
+}
+
+void EventLogModel::rotateIfNeeded() {
+    if (m_file.size() <= m_maxFileBytes) {
+        return;
+    }
+
+    QString path = m_file.fileName();
+    QString rotated = path + ".1";
+    m_file.close();
+    QFile::remove(rotated);
+    QFile::rename(path, rotated);
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qDebug() << "Event log: cannot reopen" << path << m_file.errorString();
+    }
+}
+
+int EventLogModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_events.size());
+}
+
+QVariant EventLogModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= static_cast<int>(m_events.size())) {
+        return QVariant();
+    }
+
+    const LogEvent &event = m_events[index.row()];
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString text = QString("[%1] %2").arg(event.lastSeen.toString("hh:mm:ss"), event.message);
+        if (event.repeat > 1) {
+            text += QString(" (×%1)").arg(event.repeat);
+        }
+        return text;
+    }
+    case LevelRole:
+        return static_cast<int>(event.level);
+    case Qt::ToolTipRole:
+        if (event.repeat > 1) {
+            return QString("تكررت %1 مرة\nأول مرة: %2\nآخر مرة: %3")
+                .arg(event.repeat)
+                .arg(event.firstSeen.toString("yyyy-MM-dd hh:mm:ss"),
+                     event.lastSeen.toString("yyyy-MM-dd hh:mm:ss"));
+        }
+        return event.firstSeen.toString("yyyy-MM-dd hh:mm:ss");
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QFile>
+#include <QTimer>
+#include <deque>
+#include <vector>
+
+struct LogEvent {
+    enum Level {
+        Info,
+        Warning,
+        Error
+    };
+
+    Level level = Info;
+    QString key;          // الرسائل ذات المفتاح نفسه تُدمج في سطر واحد
+    QString message;
+    QDateTime firstSeen;
+    QDateTime lastSeen;
+    int repeat = 1;
+};
+
+// سجل أحداث محدود الحجم: حلقة من آخر الأحداث تُعرض في QListView
+// (يرسم الأسطر الظاهرة فقط)، مع دمج الرسائل المتكررة وتجميع الإضافات
+// في دفعة واحدة كل 100 ms، وتدوير اختياري لملف على القرص.
+class EventLogModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    // مستوى الحدث كرقم؛ الواجهة تختار لونه فلا تحتاج النواة QtGui
+    enum Roles {
+        LevelRole = Qt::UserRole + 1
+    };
+
+    explicit EventLogModel(QObject *parent = nullptr);
+    ~EventLogModel();
+
+    // key فارغ يعني أن نص الرسالة نفسه هو المفتاح
+    void append(LogEvent::Level level, const QString &message, const QString &key = QString());
+
+    void setCapacity(int maxEvents);
+    void setCoalesceWindow(int ms);
+
+    // كتابة الأحداث إلى ملف مع تدويره إلى path.1 عند تجاوز maxBytes
+    bool setLogFile(const QString &path, qint64 maxBytes = 1024 * 1024);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+signals:
+    void eventsAppended();
+
+private slots:
+    void flush();
+
+private:
+    std::deque<LogEvent> m_events;
+    std::vector<LogEvent> m_pending;
+    QTimer *m_flushTimer;
+    QFile m_file;
+    qint64 m_maxFileBytes = 1024 * 1024;
+    int m_capacity = 2000;
+    int m_coalesceWindowMs = 60000;
+    int m_tailRepeatWritten = 0;
+
+    bool coalesce(LogEvent &target, const LogEvent &event) const;
+    void writeEvent(const LogEvent &event);
+    void writeRepeatSummary();
+    void rotateIfNeeded();
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,484 @@
+#include "fingerprinter.h"
+#include <QTcpSocket>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// أدلة سلبية كافية: لا داعي للفحص النشط
+const int kConfident = 60;
+// مهلة قبل أول اتصال حتى تصل DHCP و mDNS أولاً
+const qint64 kProbeDelayMs = 5000;
+const int kPumpIntervalMs = 100;
+const size_t kMaxQueuedHosts = 256;
+const int kMaxCachedDevices = 4096;
+const int kMaxServices = 32;
+const int kMaxModels = 8;
+
+enum class Field {
+    VendorClass,
+    DhcpParameters,   // تطابق كامل للقائمة
+    Service,
+    Model,
+    Hostname,
+    Port
+};
+
+struct Rule {
+    Field field;
+    const char *pattern;
+    DeviceFingerprint::Type type;
+    const char *os;
+    int weight;
+};
+
+using T = DeviceFingerprint;
+
+// الأوزان تقريبية: دليل قاطع (طراز md= أو خدمة طابعة) يكفي وحده، ودليل
+// عام (منفذ 445) يحتاج ما يسانده. القائمة قابلة للتوسيع دون تغيير المنطق.
+const Rule kRules[] = {
+    {Field::VendorClass, "android-dhcp", T::Phone, "Android", 40},
+    {Field::VendorClass, "MSFT", T::Computer, "Windows", 40},
+    {Field::VendorClass, "udhcp", T::Iot, "Linux", 25},
+    {Field::VendorClass, "dhcpcd", T::Unknown, "Linux", 10},
+    {Field::VendorClass, "PS4", T::Console, "", 50},
+    {Field::VendorClass, "PS5", T::Console, "", 50},
+
+    {Field::DhcpParameters, "1,3,6,15,31,33,43,44,46,47,119,121,249,252", T::Computer, "Windows", 35},
+    {Field::DhcpParameters, "1,121,3,6,15,108,114,119,252,95,44,46", T::Phone, "iOS", 35},
+    {Field::DhcpParameters, "1,121,3,6,15,119,252,95,44,46", T::Computer, "macOS", 30},
+    {Field::DhcpParameters, "1,3,6,15,26,28,51,58,59,43", T::Phone, "Android", 35},
+    {Field::DhcpParameters, "1,3,6,15,26,28,51,58,59,43,114,108", T::Phone, "Android", 35},
+    {Field::DhcpParameters, "1,28,2,3,15,6,119,12,44,47,26,121,42", T::Computer, "Linux", 30},
+    {Field::DhcpParameters, "1,3,6,12,15,28,42", T::Iot, "Linux", 20},
+
+    {Field::Service, "_ipp._tcp", T::Printer, "", 50},
+    {Field::Service, "_ipps._tcp", T::Printer, "", 50},
+    {Field::Service, "_printer._tcp", T::Printer, "", 50},
+    {Field::Service, "_pdl-datastream._tcp", T::Printer, "", 50},
+    {Field::Service, "_scanner._tcp", T::Printer, "", 30},
+    {Field::Service, "device:Printer", T::Printer, "", 50},
+    {Field::Service, "_googlecast._tcp", T::Tv, "", 45},
+    {Field::Service, "_androidtvremote", T::Tv, "Android", 45},
+    {Field::Service, "_amzn-wplay._tcp", T::Tv, "", 40},
+    {Field::Service, "dial-multiscreen-org", T::Tv, "", 40},
+    {Field::Service, "device:MediaRenderer", T::Tv, "", 30},
+    {Field::Service, "_airplay._tcp", T::Tv, "", 20},
+    {Field::Service, "_raop._tcp", T::Speaker, "", 20},
+    {Field::Service, "_spotify-connect._tcp", T::Speaker, "", 25},
+    {Field::Service, "_sonos._tcp", T::Speaker, "", 50},
+    {Field::Service, "_apple-mobdev2._tcp", T::Phone, "iOS", 45},
+    {Field::Service, "_companion-link._tcp", T::Unknown, "Apple", 10},
+    {Field::Service, "_hap._tcp", T::Iot, "", 35},
+    {Field::Service, "_rtsp._tcp", T::Camera, "", 35},
+    {Field::Service, "device:MediaServer", T::Nas, "", 25},
+    {Field::Service, "_adisk._tcp", T::Nas, "", 20},
+    {Field::Service, "device:InternetGatewayDevice", T::Router, "", 50},
+    {Field::Service, "_workstation._tcp", T::Computer, "Linux", 25},
+    {Field::Service, "_smb._tcp", T::Computer, "", 15},
+
+    {Field::Model, "iPhone", T::Phone, "iOS", 60},
+    {Field::Model, "iPad", T::Tablet, "iPadOS", 60},
+    {Field::Model, "MacBook", T::Computer, "macOS", 60},
+    {Field::Model, "iMac", T::Computer, "macOS", 60},
+    {Field::Model, "Macmini", T::Computer, "macOS", 60},
+    {Field::Model, "AppleTV", T::Tv, "tvOS", 60},
+    {Field::Model, "Chromecast", T::Tv, "", 60},
+    {Field::Model, "Google Home", T::Speaker, "", 50},
+    {Field::Model, "Nest", T::Speaker, "", 30},
+    {Field::Model, "Roku", T::Tv, "", 50},
+    {Field::Model, "webOS", T::Tv, "webOS", 50},
+    {Field::Model, "Tizen", T::Tv, "Tizen", 40},
+    {Field::Model, "BRAVIA", T::Tv, "", 50},
+    {Field::Model, "Hikvision", T::Camera, "", 50},
+    {Field::Model, "Dahua", T::Camera, "", 50},
+    {Field::Model, "IPCam", T::Camera, "", 50},
+    {Field::Model, "Sonos", T::Speaker, "", 50},
+    {Field::Model, "Synology", T::Nas, "", 60},
+    {Field::Model, "QNAP", T::Nas, "", 60},
+    {Field::Model, "PlayStation", T::Console, "", 60},
+    {Field::Model, "Xbox", T::Console, "", 60},
+    {Field::Model, "Windows", T::Computer, "Windows", 30},
+    {Field::Model, "Android", T::Phone, "Android", 25},
+    {Field::Model, "Linux", T::Unknown, "Linux", 5},
+
+    {Field::Hostname, "iPhone", T::Phone, "iOS", 40},
+    {Field::Hostname, "iPad", T::Tablet, "iPadOS", 40},
+    {Field::Hostname, "android-", T::Phone, "Android", 35},
+    {Field::Hostname, "Galaxy", T::Phone, "Android", 35},
+    {Field::Hostname, "Pixel", T::Phone, "Android", 30},
+    {Field::Hostname, "DESKTOP-", T::Computer, "Windows", 40},
+    {Field::Hostname, "LAPTOP-", T::Computer, "Windows", 40},
+    {Field::Hostname, "MacBook", T::Computer, "macOS", 40},
+    {Field::Hostname, "Chromecast", T::Tv, "", 40},
+    {Field::Hostname, "LGwebOSTV", T::Tv, "webOS", 50},
+    {Field::Hostname, "Roku", T::Tv, "", 40},
+    {Field::Hostname, "EPSON", T::Printer, "", 35},
+    {Field::Hostname, "Canon", T::Printer, "", 30},
+    {Field::Hostname, "BRW", T::Printer, "", 30},
+    {Field::Hostname, "ESP_", T::Iot, "", 35},
+    {Field::Hostname, "ESP-", T::Iot, "", 35},
+    {Field::Hostname, "tasmota", T::Iot, "", 40},
+    {Field::Hostname, "shelly", T::Iot, "", 40},
+    {Field::Hostname, "ipcam", T::Camera, "", 30},
+    {Field::Hostname, "PS4", T::Console, "", 40},
+    {Field::Hostname, "PS5", T::Console, "", 40},
+    {Field::Hostname, "Xbox", T::Console, "", 40},
+    {Field::Hostname, "DiskStation", T::Nas, "", 50},
+
+    {Field::Port, "9100", T::Printer, "", 40},
+    {Field::Port, "515", T::Printer, "", 30},
+    {Field::Port, "631", T::Printer, "", 25},
+    {Field::Port, "554", T::Camera, "", 35},
+    {Field::Port, "8009", T::Tv, "", 35},
+    {Field::Port, "62078", T::Phone, "iOS", 45},
+    {Field::Port, "3389", T::Computer, "Windows", 40},
+    {Field::Port, "445", T::Computer, "Windows", 20},
+    {Field::Port, "548", T::Computer, "macOS", 15},
+    {Field::Port, "22", T::Unknown, "Linux", 5},
+    {Field::Port, "1883", T::Iot, "", 30},
+    {Field::Port, "5001", T::Nas, "", 20},
+};
+
+const char *fieldName(Field field) {
+    switch (field) {
+    case Field::VendorClass: return "dhcp-vendor";
+    case Field::DhcpParameters: return "dhcp-55";
+    case Field::Service: return "service";
+    case Field::Model: return "model";
+    case Field::Hostname: return "hostname";
+    case Field::Port: return "tcp";
+    }
+    return "";
+}
+
+QString parameterList(const QByteArray &parameters) {
+    QStringList codes;
+    for (char code : parameters) {
+        codes << QString::number(quint8(code));
+    }
+    return codes.join(',');
+}
+
+bool addUnique(QStringList &list, const QString &value, int limit) {
+    if (value.isEmpty() || list.contains(value) || list.size() >= limit) {
+        return false;
+    }
+    list.append(value);
+    return true;
+}
+
+} // namespace
+
+QString DeviceFingerprint::typeKey(Type type) {
+    static const char *const keys[] = {"unknown", "phone", "tablet", "computer", "printer", "camera",
+                                       "tv", "speaker", "console", "nas", "router", "iot"};
+    return QString::fromLatin1(keys[type]);
+}
+
+QString DeviceFingerprint::typeLabel(Type type) {
+    switch (type) {
+    case Phone: return "هاتف";
+    case Tablet: return "جهاز لوحي";
+    case Computer: return "حاسوب";
+    case Printer: return "طابعة";
+    case Camera: return "كاميرا";
+    case Tv: return "تلفاز";
+    case Speaker: return "مكبر صوت";
+    case Console: return "جهاز ألعاب";
+    case Nas: return "تخزين شبكي";
+    case Router: return "راوتر";
+    case Iot: return "جهاز ذكي";
+    case Unknown: break;
+    }
+    return "غير معروف";
+}
+
+DeviceFingerprint::Type DeviceFingerprint::typeFromKey(const QString &key) {
+    for (int type = Unknown; type <= Iot; ++type) {
+        if (typeKey(static_cast<Type>(type)) == key) {
+            return static_cast<Type>(type);
+        }
+    }
+    return Unknown;
+}
+
+Fingerprinter::Fingerprinter(QObject *parent)
+    : QObject(parent), m_pumpTimer(new QTimer(this)),
+      m_ports({9100, 631, 515, 554, 8009, 62078, 3389, 445, 548, 22, 1883, 5001})
+{
+    m_pumpTimer->setInterval(kPumpIntervalMs);
+    connect(m_pumpTimer, &QTimer::timeout, this, &Fingerprinter::pump);
+    m_clock.start();
+}
+
+Fingerprinter::~Fingerprinter() = default;
+
+void Fingerprinter::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    if (!enabled) {
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [](const Host &host) { return !host.busy; }),
+                      m_queue.end());
+        for (Evidence &evidence : m_cache) {
+            evidence.queued = false;
+        }
+    }
+}
+
+void Fingerprinter::setProbeLimits(int maxConnections, int hostIntervalMs, int connectTimeoutMs) {
+    m_maxConnections = std::max(1, maxConnections);
+    m_hostIntervalMs = std::max(0, hostIntervalMs);
+    m_connectTimeoutMs = std::max(100, connectTimeoutMs);
+}
+
+Fingerprinter::Evidence &Fingerprinter::evidenceFor(const QString &macAddress) {
+    auto it = m_cache.find(macAddress);
+    if (it == m_cache.end()) {
+        if (m_cache.size() >= kMaxCachedDevices) {
+            evictOldest();
+        }
+        it = m_cache.insert(macAddress, Evidence());
+    }
+    it->lastUsedMs = m_clock.elapsed();
+    return it.value();
+}
+
+void Fingerprinter::evictOldest() {
+    // نادر: عند امتلاء الذاكرة المؤقتة فقط
+    auto oldest = m_cache.begin();
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        if (it->lastUsedMs < oldest->lastUsedMs && !it->queued) {
+            oldest = it;
+        }
+    }
+    if (oldest != m_cache.end()) {
+        m_cache.erase(oldest);
+    }
+}
+
+void Fingerprinter::observe(const PassiveObservation &observation) {
+    if (!m_enabled || observation.macAddress.isEmpty() ||
+        (!observation.hasFingerprint() && observation.hostname.isEmpty())) {
+        return;
+    }
+
+    Evidence &evidence = evidenceFor(observation.macAddress);
+    bool changed = false;
+    if (!observation.dhcpParameters.isEmpty() && observation.dhcpParameters != evidence.dhcpParameters) {
+        evidence.dhcpParameters = observation.dhcpParameters;
+        changed = true;
+    }
+    if (!observation.vendorClass.isEmpty() && observation.vendorClass != evidence.vendorClass) {
+        evidence.vendorClass = observation.vendorClass;
+        changed = true;
+    }
+    if (!observation.hostname.isEmpty() && observation.hostname != evidence.hostname) {
+        evidence.hostname = observation.hostname;
+        changed = true;
+    }
+    for (const QString &service : observation.services) {
+        changed |= addUnique(evidence.services, service, kMaxServices);
+    }
+    changed |= addUnique(evidence.models, observation.model.left(128), kMaxModels);
+
+    // الإعلانات تتكرر؛ لا نعيد التصنيف إلا مع دليل جديد
+    if (changed) {
+        classify(observation.macAddress, evidence);
+    }
+}
+
+void Fingerprinter::noteHostname(const QString &macAddress, const QString &hostname) {
+    if (!m_enabled || macAddress.isEmpty() || hostname.isEmpty()) {
+        return;
+    }
+    Evidence &evidence = evidenceFor(macAddress);
+    if (evidence.hostname != hostname) {
+        evidence.hostname = hostname;
+        classify(macAddress, evidence);
+    }
+}
+
+void Fingerprinter::classify(const QString &macAddress, Evidence &evidence) {
+    const QString parameters = parameterList(evidence.dhcpParameters);
+    QHash<int, int> typeScores;
+    QHash<QString, int> osScores;
+    QStringList reasons;
+
+    for (const Rule &rule : kRules) {
+        const QString pattern = QString::fromLatin1(rule.pattern);
+        bool matched = false;
+        switch (rule.field) {
+        case Field::VendorClass:
+            matched = evidence.vendorClass.contains(pattern, Qt::CaseInsensitive);
+            break;
+        case Field::DhcpParameters:
+            matched = parameters == pattern;
+            break;
+        case Field::Service:
+            matched = std::any_of(evidence.services.cbegin(), evidence.services.cend(),
+                                  [&pattern](const QString &service) { return service.contains(pattern, Qt::CaseInsensitive); });
+            break;
+        case Field::Model:
+            matched = std::any_of(evidence.models.cbegin(), evidence.models.cend(),
+                                  [&pattern](const QString &model) { return model.contains(pattern, Qt::CaseInsensitive); });
+            break;
+        case Field::Hostname:
+            matched = evidence.hostname.startsWith(pattern, Qt::CaseInsensitive);
+            break;
+        case Field::Port:
+            matched = evidence.openPorts.contains(quint16(pattern.toUInt()));
+            break;
+        }
+        if (!matched) {
+            continue;
+        }
+        if (rule.type != DeviceFingerprint::Unknown) {
+            typeScores[rule.type] += rule.weight;
+        }
+        if (*rule.os) {
+            osScores[QString::fromLatin1(rule.os)] += rule.weight;
+        }
+        reasons << QString("%1:%2").arg(QLatin1String(fieldName(rule.field)), pattern);
+    }
+
+    DeviceFingerprint result;
+    int best = 0;
+    for (auto it = typeScores.constBegin(); it != typeScores.constEnd(); ++it) {
+        if (it.value() > best) {
+            best = it.value();
+            result.type = static_cast<DeviceFingerprint::Type>(it.key());
+        }
+    }
+    int bestOs = 0;
+    for (auto it = osScores.constBegin(); it != osScores.constEnd(); ++it) {
+        if (it.value() > bestOs) {
+            bestOs = it.value();
+            result.os = it.key();
+        }
+    }
+    result.confidence = std::min(100, best);
+    result.model = evidence.models.isEmpty() ? QString() : evidence.models.first();
+    result.evidence = reasons;
+    result.openPorts = evidence.openPorts;
+    result.probed = evidence.probed;
+
+    const DeviceFingerprint &previous = evidence.result;
+    bool changed = previous.type != result.type || previous.os != result.os || previous.model != result.model ||
+                   previous.probed != result.probed;
+    evidence.result = result;
+    if (changed) {
+        emit fingerprintChanged(macAddress, result);
+    }
+}
+
+void Fingerprinter::request(const QString &macAddress, const QString &ipAddress) {
+    if (!m_enabled || !m_probing || macAddress.isEmpty() || ipAddress.isEmpty() || ipAddress.contains(':')) {
+        return;
+    }
+    Evidence &evidence = evidenceFor(macAddress);
+    if (evidence.probed || evidence.queued || evidence.result.confidence >= kConfident ||
+        m_queue.size() >= kMaxQueuedHosts) {
+        return;
+    }
+
+    Host host;
+    host.macAddress = macAddress;
+    host.ipAddress = ipAddress;
+    // تُسحب من النهاية: الأكثر دلالة أولاً
+    host.ports.assign(m_ports.crbegin(), m_ports.crend());
+    host.nextAttemptMs = m_clock.elapsed() + kProbeDelayMs;
+    m_queue.push_back(host);
+    evidence.queued = true;
+    if (!m_pumpTimer->isActive()) {
+        m_pumpTimer->start();
+    }
+}
+
+void Fingerprinter::forget(const QString &macAddress) {
+    m_cache.remove(macAddress);
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [&macAddress](const Host &host) {
+        return host.macAddress == macAddress && !host.busy;
+    }), m_queue.end());
+}
+
+DeviceFingerprint Fingerprinter::fingerprint(const QString &macAddress) const {
+    auto it = m_cache.constFind(macAddress);
+    return it == m_cache.constEnd() ? DeviceFingerprint() : it->result;
+}
+
+void Fingerprinter::pump() {
+    const qint64 now = m_clock.elapsed();
+    // بالفهرس: التصنيف يطلق إشارة قد تضيف أجهزة للطابور أثناء المرور
+    for (size_t i = 0; i < m_queue.size();) {
+        Host &host = m_queue[i];
+        if (host.busy) {
+            ++i;
+            continue;
+        }
+        auto cached = m_cache.find(host.macAddress);
+        // انتهت المنافذ، أو كفت أدلة وصلت أثناء الانتظار
+        if (cached == m_cache.end() || host.ports.empty() || cached->result.confidence >= kConfident) {
+            const QString macAddress = host.macAddress;
+            m_queue.erase(m_queue.begin() + i);
+            if (cached != m_cache.end()) {
+                cached->queued = false;
+                cached->probed = true;
+                classify(macAddress, cached.value());
+            }
+            continue;
+        }
+        if (m_active < m_maxConnections && host.nextAttemptMs <= now) {
+            startProbe(host);
+        }
+        ++i;
+    }
+
+    if (m_queue.empty() && m_active == 0) {
+        m_pumpTimer->stop();
+    }
+}
+
+void Fingerprinter::startProbe(Host &host) {
+    const quint16 port = host.ports.back();
+    host.ports.pop_back();
+    host.busy = true;
+    ++m_active;
+
+    // connect() كامل ثم إغلاق فوري: SYN خام يحتاج مقبساً مميزاً لكل جهاز
+    QTcpSocket *socket = new QTcpSocket(this);
+    auto done = std::make_shared<bool>(false);
+    const QString macAddress = host.macAddress;
+    auto finish = [this, socket, done, macAddress, port](bool open) {
+        if (*done) {
+            return;
+        }
+        *done = true;
+        socket->abort();
+        socket->deleteLater();
+        finishProbe(macAddress, port, open);
+    };
+    connect(socket, &QTcpSocket::connected, this, [finish]() { finish(true); });
+    connect(socket, &QTcpSocket::errorOccurred, this, [finish]() { finish(false); });
+    QTimer::singleShot(m_connectTimeoutMs, socket, [finish]() { finish(false); });
+    socket->connectToHost(host.ipAddress, port);
+}
+
+void Fingerprinter::finishProbe(const QString &macAddress, quint16 port, bool open) {
+    --m_active;
+    for (Host &host : m_queue) {
+        if (host.macAddress == macAddress && host.busy) {
+            host.busy = false;
+            host.nextAttemptMs = m_clock.elapsed() + m_hostIntervalMs;
+            break;
+        }
+    }
+    if (!open) {
+        return;
+    }
+    auto it = m_cache.find(macAddress);
+    if (it != m_cache.end() && !it->openPorts.contains(port)) {
+        it->openPorts.append(port);
+        classify(macAddress, it.value());
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef FINGERPRINTER_H
+#define FINGERPRINTER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <deque>
+#include <vector>
+#include "passivediscovery.h"
+
+class QTcpSocket;
+
+// نوع الجهاز ونظامه كما استُنتجا من الأدلة المجمعة
+struct DeviceFingerprint {
+    enum Type {
+        Unknown,
+        Phone,
+        Tablet,
+        Computer,
+        Printer,
+        Camera,
+        Tv,
+        Speaker,
+        Console,
+        Nas,
+        Router,
+        Iot
+    };
+
+    Type type = Unknown;
+    QString os;
+    QString model;
+    int confidence = 0;        // 0-100
+    QStringList evidence;      // ما بُني عليه القرار، للعرض والتصدير
+    QList<quint16> openPorts;
+    bool probed = false;
+
+    static QString typeKey(Type type);     // "phone" ... للتصدير والـ API
+    static QString typeLabel(Type type);   // للواجهة
+    static Type typeFromKey(const QString &key);
+};
+
+// تصنيف الأجهزة من أدلة سلبية (خيار DHCP 55 و 60، خدمات mDNS، إعلانات
+// SSDP، واسم الجهاز) ثم فحص TCP محدود للمنافذ الشائعة عند عدم كفايتها.
+// الفحص على مجمع اتصالات محدود العدد مع فاصل أدنى بين محاولتين على نفس
+// الجهاز، والنتيجة تُحفظ لكل MAC فلا يُفحص الجهاز إلا مرة واحدة.
+class Fingerprinter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Fingerprinter(QObject *parent = nullptr);
+    ~Fingerprinter();
+
+    void setEnabled(bool enabled);
+    void setProbing(bool enabled) { m_probing = enabled; }
+    // maxConnections: اتصالات متزامنة لكل المجمع، hostIntervalMs: بين محاولتين على نفس الجهاز
+    void setProbeLimits(int maxConnections, int hostIntervalMs, int connectTimeoutMs);
+    void setPorts(const QList<quint16> &ports) { m_ports = ports; }
+
+    // أدلة سلبية؛ رخيصة حتى تُستدعى مع كل ملاحظة
+    void observe(const PassiveObservation &observation);
+    void noteHostname(const QString &macAddress, const QString &hostname);
+
+    // فحص نشط إن لم تكف الأدلة؛ يتجاهل الأجهزة المفحوصة أو المنتظرة
+    void request(const QString &macAddress, const QString &ipAddress);
+    void forget(const QString &macAddress);
+
+    DeviceFingerprint fingerprint(const QString &macAddress) const;
+    int pendingProbes() const { return static_cast<int>(m_queue.size()) + m_active; }
+
+signals:
+    void fingerprintChanged(const QString &macAddress, const DeviceFingerprint &fingerprint);
+
+private slots:
+    void pump();
+
+private:
+    struct Evidence {
+        QByteArray dhcpParameters;
+        QString vendorClass;
+        QString hostname;
+        QStringList services;
+        QStringList models;
+        QList<quint16> openPorts;
+        DeviceFingerprint result;
+        qint64 lastUsedMs = 0;
+        bool probed = false;
+        bool queued = false;
+    };
+
+    struct Host {
+        QString macAddress;
+        QString ipAddress;
+        std::vector<quint16> ports;     // المتبقية
+        qint64 nextAttemptMs = 0;
+        bool busy = false;
+    };
+
+    QTimer *m_pumpTimer;
+    QElapsedTimer m_clock;
+    QHash<QString, Evidence> m_cache;
+    std::deque<Host> m_queue;
+    QList<quint16> m_ports;
+    int m_active = 0;
+    int m_maxConnections = 8;
+    int m_hostIntervalMs = 500;
+    int m_connectTimeoutMs = 1500;
+    bool m_enabled = true;
+    bool m_probing = true;
+
+    Evidence &evidenceFor(const QString &macAddress);
+    void classify(const QString &macAddress, Evidence &evidence);
+    void startProbe(Host &host);
+    void finishProbe(const QString &macAddress, quint16 port, bool open);
+    void evictOldest();
+};
+
+#endif // FINGERPRINTER_H
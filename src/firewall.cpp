@@ -0,0 +1,116 @@
+#include "firewall.h"
+#include <QProcess>
+#include <QStandardPaths>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+bool hasTool(const QString &name) {
+    return !QStandardPaths::findExecutable(name).isEmpty() ||
+           !QStandardPaths::findExecutable(name, {"/usr/local/sbin", "/usr/sbin", "/sbin"}).isEmpty();
+}
+
+} // namespace
+
+bool Firewall::isValidMac(const QString &macAddress) {
+    if (macAddress.size() != 17) {
+        return false;
+    }
+    for (int i = 0; i < macAddress.size(); ++i) {
+        const QChar c = macAddress[i];
+        if (i % 3 == 2 ? c != ':' : !((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Firewall::isAvailable() {
+    return hasTool("iptables-save") && hasTool("iptables-restore");
+}
+
+bool Firewall::readBlocked(BlockRules *rules, int timeoutMs) {
+    // قراءة واحدة لكل قواعد الحظر الحالية بدلاً من فحص كل جهاز على حدة
+    QProcess process;
+    process.start("iptables-save", QStringList() << "-t" << "filter");
+    if (!process.waitForFinished(timeoutMs) || process.exitCode() != 0) {
+        process.kill();
+        return false;
+    }
+
+    static const QRegularExpression ruleRegex(
+        "^-A (INPUT|FORWARD) -m mac --mac-source ([0-9A-Fa-f:]{17}) -j DROP$");
+    const QStringList lines = QString::fromUtf8(process.readAllStandardOutput()).split('\n');
+    for (const QString &line : lines) {
+        QRegularExpressionMatch match = ruleRegex.match(line.trimmed());
+        if (!match.hasMatch()) {
+            continue;
+        }
+        QHash<QString, int> &chain = match.captured(1) == "INPUT" ? rules->input : rules->forward;
+        ++chain[match.captured(2).toUpper()];
+    }
+    return true;
+}
+
+QByteArray Firewall::buildTransaction(const QHash<QString, bool> &changes, const BlockRules &current,
+                                      int *operations) {
+    QByteArray script = "*filter\n";
+    *operations = 0;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (!isValidMac(it.key())) {
+            // الدفعة تعمل بصلاحيات الجذر: لا يُلصق فيها نص لم يُتحقق منه
+            qWarning() << "Firewall: skipping invalid MAC" << it.key();
+            continue;
+        }
+        const QByteArray mac = it.key().toUpper().toLatin1();
+        const std::pair<const char *, const QHash<QString, int> *> chains[] = {
+            {"INPUT", &current.input}, {"FORWARD", &current.forward}};
+        for (const auto &chain : chains) {
+            int existing = chain.second->value(it.key());
+            if (it.value() && existing == 0) {
+                script += QByteArray("-A ") + chain.first + " -m mac --mac-source " + mac + " -j DROP\n";
+                ++*operations;
+            } else if (!it.value()) {
+                // حذف كل النسخ، فالإصدارات السابقة كانت تكرر القاعدة مع كل حظر
+                for (int i = 0; i < existing; ++i) {
+                    script += QByteArray("-D ") + chain.first + " -m mac --mac-source " + mac + " -j DROP\n";
+                    ++*operations;
+                }
+            }
+        }
+    }
+    script += "COMMIT\n";
+    return script;
+}
+
+bool Firewall::apply(const QByteArray &script, int timeoutMs, QString *error) {
+    QProcess process;
+    process.start("iptables-restore", QStringList() << "--noflush");
+    process.write(script);
+    process.closeWriteChannel();
+    if (!process.waitForFinished(timeoutMs) || process.exitStatus() != QProcess::NormalExit ||
+        process.exitCode() != 0) {
+        process.kill();
+        if (error) {
+            *error = QString::fromUtf8(process.readAllStandardError()).trimmed();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool Firewall::setBlocked(const QHash<QString, bool> &changes, int timeoutMs, QString *error) {
+    BlockRules current;
+    if (!readBlocked(&current, timeoutMs)) {
+        if (error) {
+            *error = "تعذرت قراءة قواعد iptables الحالية";
+        }
+        return false;
+    }
+    int operations = 0;
+    QByteArray script = buildTransaction(changes, current, &operations);
+    return operations == 0 || apply(script, timeoutMs, error);
+}
@@ -0,0 +1,35 @@
+#ifndef FIREWALL_H
+#define FIREWALL_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+// قواعد الحظر بالـ MAC في جدول filter. القراءة iptables-save واحدة،
+// والتغييرات كلها في دفعة iptables-restore واحدة (كلها أو لا شيء).
+// يُستخدم في التطبيق نفسه عند تشغيله بصلاحيات الجذر، وفي المساعد المميز.
+class Firewall {
+public:
+    // عدد نسخ قاعدة الحظر لكل MAC في كل سلسلة
+    struct BlockRules {
+        QHash<QString, int> input;
+        QHash<QString, int> forward;
+    };
+
+    // XX:XX:XX:XX:XX:XX فقط؛ أي شيء آخر قد يكسر أسطر دفعة iptables-restore
+    static bool isValidMac(const QString &macAddress);
+
+    static bool isAvailable();
+    static bool readBlocked(BlockRules *rules, int timeoutMs);
+
+    // لا نضيف قاعدة موجودة ولا نحذف قاعدة غير موجودة حتى لا تُرفض الدفعة.
+    // المفاتيح غير الصالحة تُتخطى ولا تصل إلى النص أبداً
+    static QByteArray buildTransaction(const QHash<QString, bool> &changes, const BlockRules &current,
+                                       int *operations);
+    static bool apply(const QByteArray &script, int timeoutMs, QString *error);
+
+    // قراءة ثم دفعة واحدة؛ changes: MAC -> حظر (true) أو إلغاء (false)
+    static bool setBlocked(const QHash<QString, bool> &changes, int timeoutMs, QString *error);
+};
+
+#endif // FIREWALL_H
@@ -0,0 +1,202 @@
+#include "fleetagent.h"
+#include "fleetprotocol.h"
+#include <QDateTime>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// دقة وقت آخر ظهور المرسل: تغيير أصغر من هذا لا يستحق تحديثاً
+const qint64 kLastSeenResolutionSecs = 30;
+const qint64 kStatsIntervalMs = 5000;
+// لا نكدس البيانات إذا كان المجمّع بطيئاً؛ الفروق تُحسب لاحقاً من الحالة المرسلة
+const qint64 kMaxQueuedBytes = 256 * 1024;
+
+} // namespace
+
+FleetAgent::FleetAgent(QObject *parent)
+    : QObject(parent),
+      m_socket(new QTcpSocket(this)),
+      m_flushTimer(new QTimer(this)),
+      m_reconnectTimer(new QTimer(this))
+{
+    // تجميع كل ما يتغير خلال ثانية في دفعة واحدة
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(1000);
+    connect(m_flushTimer, &QTimer::timeout, this, &FleetAgent::flush);
+
+    m_reconnectTimer->setSingleShot(true);
+    m_reconnectTimer->setInterval(5000);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &FleetAgent::connectToAggregator);
+
+    connect(m_socket, &QTcpSocket::connected, this, &FleetAgent::onConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &FleetAgent::onDisconnected);
+    connect(m_socket, &QAbstractSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        if (m_running && m_socket->state() == QAbstractSocket::UnconnectedState) {
+            m_reconnectTimer->start();
+        }
+    });
+}
+
+FleetAgent::~FleetAgent() {
+    stop();
+}
+
+void FleetAgent::setUpdateBus(UpdateBus *bus) {
+    m_bus = bus;
+    connect(bus, &UpdateBus::updated, this, &FleetAgent::scheduleFlush);
+}
+
+void FleetAgent::start(const QString &host, quint16 port, const QString &apId, const QString &interface) {
+    m_host = host;
+    m_port = port;
+    m_apId = apId;
+    m_interface = interface;
+    m_running = true;
+    connectToAggregator();
+}
+
+void FleetAgent::stop() {
+    m_running = false;
+    m_flushTimer->stop();
+    m_reconnectTimer->stop();
+    m_socket->disconnectFromHost();
+}
+
+void FleetAgent::connectToAggregator() {
+    if (!m_running || m_socket->state() != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+    m_socket->connectToHost(m_host, m_port);
+}
+
+void FleetAgent::onConnected() {
+    qDebug() << "Fleet agent: connected to" << m_host << m_port << "as" << m_apId;
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    // المجمّع لا يعرف شيئاً عن هذا الاتصال الجديد؛ نرسل الحالة كاملة
+    m_sent.clear();
+    m_sentDevicesVersion = 0;
+    m_sentStatsVersion = 0;
+    m_lastStatsSent.invalidate();
+
+    send(FleetProtocol::encodeHello(m_apId, m_interface, m_token));
+    flush();
+}
+
+void FleetAgent::onDisconnected() {
+    if (m_running) {
+        qDebug() << "Fleet agent: disconnected, retrying in" << m_reconnectTimer->interval() << "ms";
+        m_reconnectTimer->start();
+    }
+}
+
+void FleetAgent::scheduleFlush() {
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void FleetAgent::send(const QByteArray &frame) {
+    m_socket->write(frame);
+    m_bytesSent += static_cast<quint64>(frame.size());
+}
+
+void FleetAgent::flush() {
+    if (!m_bus || m_socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    if (m_socket->bytesToWrite() > kMaxQueuedBytes) {
+        scheduleFlush(); // نعيد المحاولة لاحقاً بالفروق المتراكمة
+        return;
+    }
+
+    UpdateBus::DeviceSnapshot devices = m_bus->devices();
+    if (devices.data && devices.version != m_sentDevicesVersion) {
+        std::vector<FleetDeviceUpdate> updates;
+        QSet<QString> present;
+
+        for (const Device &device : *devices.data) {
+            if (device.macAddress.isEmpty()) {
+                continue;
+            }
+            present.insert(device.macAddress);
+            qint64 lastSeen = device.lastSeen.isValid() ? device.lastSeen.toSecsSinceEpoch() : 0;
+
+            FleetDeviceUpdate update;
+            update.macAddress = device.macAddress;
+            update.ipAddress = device.ipAddress;
+            update.hostname = device.hostname;
+            update.lastSeenSecs = lastSeen;
+            update.isActive = device.isActive;
+
+            auto it = m_sent.find(device.macAddress);
+            if (it == m_sent.end()) {
+                update.fields = FleetDeviceUpdate::Ip | FleetDeviceUpdate::Hostname |
+                                FleetDeviceUpdate::LastSeen | FleetDeviceUpdate::Active;
+                it = m_sent.insert(device.macAddress, SentState());
+            } else {
+                if (it->ipAddress != device.ipAddress) {
+                    update.fields |= FleetDeviceUpdate::Ip;
+                }
+                if (it->hostname != device.hostname) {
+                    update.fields |= FleetDeviceUpdate::Hostname;
+                }
+                if (it->isActive != device.isActive) {
+                    update.fields |= FleetDeviceUpdate::Active | FleetDeviceUpdate::LastSeen;
+                } else if (std::llabs(lastSeen - it->lastSeenSecs) >= kLastSeenResolutionSecs) {
+                    update.fields |= FleetDeviceUpdate::LastSeen;
+                }
+            }
+
+            if (update.fields == 0) {
+                continue;
+            }
+            if (update.fields & FleetDeviceUpdate::Ip) {
+                it->ipAddress = device.ipAddress;
+            }
+            if (update.fields & FleetDeviceUpdate::Hostname) {
+                it->hostname = device.hostname;
+            }
+            if (update.fields & FleetDeviceUpdate::LastSeen) {
+                it->lastSeenSecs = lastSeen;
+            }
+            if (update.fields & FleetDeviceUpdate::Active) {
+                it->isActive = device.isActive;
+            }
+            updates.push_back(update);
+        }
+
+        for (auto it = m_sent.begin(); it != m_sent.end();) {
+            if (!present.contains(it.key())) {
+                FleetDeviceUpdate removed;
+                removed.macAddress = it.key();
+                removed.fields = FleetDeviceUpdate::Removed;
+                updates.push_back(removed);
+                it = m_sent.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (!updates.empty()) {
+            send(FleetProtocol::encodeDevices(updates, QDateTime::currentSecsSinceEpoch()));
+        }
+        m_sentDevicesVersion = devices.version;
+    }
+
+    UpdateBus::StatsSnapshot stats = m_bus->stats();
+    if (stats.data && stats.version != m_sentStatsVersion &&
+        (!m_lastStatsSent.isValid() || m_lastStatsSent.elapsed() >= kStatsIntervalMs)) {
+        FleetStatsUpdate update;
+        update.bytesReceived = stats.data->bytesReceived;
+        update.bytesSent = stats.data->bytesSent;
+        update.downloadBytesPerSec = static_cast<quint32>(std::max(0.0, stats.data->downloadSpeed * 1024.0));
+        update.uploadBytesPerSec = static_cast<quint32>(std::max(0.0, stats.data->uploadSpeed * 1024.0));
+        send(FleetProtocol::encodeStats(update));
+        m_sentStatsVersion = stats.version;
+        m_lastStatsSent.restart();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef FLEETAGENT_H
+#define FLEETAGENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include "updatebus.h"
+
+// وضع الجامع: يرسل تغييرات الأجهزة والإحصائيات لهذه النقطة إلى المجمّع.
+// الحالة المرسلة محفوظة لكل MAC، فكل دفعة تحمل الفروق فقط، وعند انقطاع
+// الاتصال أو امتلاء المقبس لا يضيع شيء: الدفعة التالية تحسب الفرق من جديد.
+class FleetAgent : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FleetAgent(QObject *parent = nullptr);
+    ~FleetAgent();
+
+    void setUpdateBus(UpdateBus *bus);
+    void start(const QString &host, quint16 port, const QString &apId, const QString &interface);
+    void stop();
+    // الرمز المشترك مع المجمّع؛ يُرسل في التحية
+    void setToken(const QString &token) { m_token = token; }
+
+    quint64 bytesSent() const { return m_bytesSent; }
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void connectToAggregator();
+    void flush();
+
+private:
+    struct SentState {
+        QString ipAddress;
+        QString hostname;
+        qint64 lastSeenSecs = 0;
+        bool isActive = false;
+    };
+
+    QTcpSocket *m_socket;
+    QTimer *m_flushTimer;
+    QTimer *m_reconnectTimer;
+    QElapsedTimer m_lastStatsSent;
+    UpdateBus *m_bus = nullptr;
+
+    QString m_host;
+    quint16 m_port = 0;
+    QString m_apId;
+    QString m_interface;
+    QString m_token;
+    bool m_running = false;
+
+    QHash<QString, SentState> m_sent;
+    quint64 m_sentDevicesVersion = 0;
+    quint64 m_sentStatsVersion = 0;
+    quint64 m_bytesSent = 0;
+
+    void scheduleFlush();
+    void send(const QByteArray &frame);
+};
+
+#endif // FLEETAGENT_H
@@ -0,0 +1,338 @@
+#include "fleetaggregator.h"
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+
+// الجهاز الذي لم يُرَ نشطاً على نقطته الحالية خلال هذه المدة لا يُعد انتقاله تجوالاً
+const qint64 kRoamWindowSecs = 300;
+
+// قبل التحية الاتصال مجهول: مهلة قصيرة، وعدد محدود، وتحية لا تتجاوز بضع مئات من البايتات
+const int kHelloTimeoutMs = 10000;
+const int kMaxPendingConnections = 32;
+const int kMaxHelloBytes = 1024;
+
+// مقارنة لا يتوقف زمنها على موضع أول اختلاف
+bool constantTimeEquals(const QByteArray &a, const QByteArray &b) {
+    quint8 difference = a.size() != b.size();
+    for (int i = 0; i < a.size(); ++i) {
+        difference |= quint8(a[i]) ^ (b.isEmpty() ? 0 : quint8(b[i % b.size()]));
+    }
+    return difference == 0;
+}
+
+} // namespace
+
+FleetAggregator::FleetAggregator(QObject *parent)
+    : QObject(parent), m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &FleetAggregator::onNewConnection);
+}
+
+FleetAggregator::~FleetAggregator() {
+    close();
+}
+
+bool FleetAggregator::listen(const QHostAddress &address, quint16 port) {
+    // الوكلاء يرسلون قوائم الأجهزة دون تشفير؛ بلا رمز لا يُقبل إلا الجهاز نفسه
+    if (m_token.isEmpty() && !address.isLoopback()) {
+        qDebug() << "Fleet aggregator: refusing to listen on" << address.toString() << "without a token";
+        return false;
+    }
+    if (!m_server->listen(address, port)) {
+        qDebug() << "Fleet aggregator: cannot listen on" << address.toString() << port
+                 << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void FleetAggregator::close() {
+    m_server->close();
+    const QList<QTcpSocket *> sockets = m_connections.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_connections.clear();
+    m_owners.clear();
+}
+
+quint16 FleetAggregator::port() const {
+    return m_server->serverPort();
+}
+
+std::vector<FleetDevice> FleetAggregator::devices() const {
+    std::vector<FleetDevice> result;
+    result.reserve(m_devices.size());
+    for (const FleetDevice &device : m_devices) {
+        result.push_back(device);
+    }
+    return result;
+}
+
+std::vector<FleetAccessPoint> FleetAggregator::accessPoints() const {
+    std::vector<FleetAccessPoint> result;
+    result.reserve(m_accessPoints.size());
+    for (const FleetAccessPoint &ap : m_accessPoints) {
+        result.push_back(ap);
+    }
+    return result;
+}
+
+void FleetAggregator::onNewConnection() {
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        int pending = 0;
+        for (const Connection &connection : m_connections) {
+            pending += connection.apId.isEmpty();
+        }
+        if (pending >= kMaxPendingConnections) {
+            qDebug() << "Fleet aggregator: too many connections without Hello, dropping"
+                     << socket->peerAddress().toString();
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        m_connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { onSocketClosed(socket); });
+        QTimer::singleShot(kHelloTimeoutMs, socket, [this, socket]() {
+            auto it = m_connections.constFind(socket);
+            if (it != m_connections.constEnd() && it->apId.isEmpty()) {
+                qDebug() << "Fleet aggregator: no Hello from" << socket->peerAddress().toString();
+                socket->abort();
+            }
+        });
+    }
+}
+
+void FleetAggregator::onReadyRead(QTcpSocket *socket) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
+
+    QByteArray data = socket->readAll();
+    m_bytesReceived += static_cast<quint64>(data.size());
+    it->buffer += data;
+
+    FleetProtocol::FrameType type;
+    QByteArray payload;
+    bool error = false;
+    while (FleetProtocol::takeFrame(it->buffer, &type, &payload, &error)) {
+        if (!handleFrame(*it, socket, type, payload)) {
+            error = true;
+            break;
+        }
+    }
+    // التحية صغيرة؛ اتصال مجهول لا يُسمح له بتكديس إطار حتى حد البروتوكول
+    if (!error && it->apId.isEmpty() && it->buffer.size() > kMaxHelloBytes) {
+        error = true;
+    }
+
+    if (error) {
+        qDebug() << "Fleet aggregator: protocol error from" << socket->peerAddress().toString();
+        socket->abort();
+    }
+}
+
+void FleetAggregator::onSocketClosed(QTcpSocket *socket) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
+    QString apId = it->apId;
+    m_connections.erase(it);
+    socket->deleteLater();
+
+    // اتصال قديم حلت محله تحية أحدث من النقطة نفسها لا يمس حالتها
+    if (apId.isEmpty() || m_owners.value(apId) != socket) {
+        return;
+    }
+    m_owners.remove(apId);
+
+    // نقطة الوصول غابت: أجهزتها لم تعد مؤكدة منها، وعدادها يهبط مع كل جهاز يُعاد حله
+    auto ap = m_accessPoints.find(apId);
+    if (ap != m_accessPoints.end()) {
+        ap->connected = false;
+    }
+    QHash<QString, ApDeviceState> &states = m_apDevices[apId];
+    for (auto state = states.begin(); state != states.end(); ++state) {
+        if (state->isActive) {
+            state->isActive = false;
+            resolveOwner(state.key());
+        }
+    }
+    emit accessPointChanged(apId, false);
+}
+
+bool FleetAggregator::handleFrame(Connection &connection, QTcpSocket *socket,
+                                  FleetProtocol::FrameType type, const QByteArray &payload) {
+    if (type == FleetProtocol::Hello) {
+        QString apId;
+        QString interface;
+        QString token;
+        if (!FleetProtocol::decodeHello(payload, &apId, &interface, &token)) {
+            return false;
+        }
+        if (!m_token.isEmpty() && !constantTimeEquals(token.toUtf8(), m_token.toUtf8())) {
+            qDebug() << "Fleet aggregator: wrong token from" << socket->peerAddress().toString();
+            return false;
+        }
+        if (!connection.apId.isEmpty() && connection.apId != apId) {
+            return false; // اتصال واحد لنقطة واحدة
+        }
+        connection.apId = apId;
+
+        // الوكيل أعاد الاتصال قبل أن تنقضي مهلة اتصاله القديم: القديم يُغلق دون أن يمس الحالة
+        // (مؤجل: إغلاقه الآن يحذف من m_connections أثناء معالجة إطار هذا الاتصال)
+        QTcpSocket *previous = m_owners.value(apId);
+        if (previous && previous != socket) {
+            QMetaObject::invokeMethod(previous, &QTcpSocket::abort, Qt::QueuedConnection);
+        }
+        m_owners.insert(apId, socket);
+
+        FleetAccessPoint &ap = m_accessPoints[apId];
+        ap.id = apId;
+        ap.interface = interface;
+        ap.peerAddress = socket->peerAddress().toString();
+        ap.connected = true;
+        // الوكيل يرسل حالته كاملة بعد التحية؛ ما لديه الآن يحل محل القديم
+        const QList<QString> stale = m_apDevices[apId].keys();
+        m_apDevices[apId].clear();
+        for (const QString &mac : stale) {
+            resolveOwner(mac);
+        }
+        emit accessPointChanged(apId, true);
+        return true;
+    }
+
+    if (connection.apId.isEmpty()) {
+        return false; // لا بيانات قبل التحية
+    }
+    if (m_owners.value(connection.apId) != socket) {
+        return false; // اتصال حلت محله تحية أحدث
+    }
+
+    if (type == FleetProtocol::Devices) {
+        std::vector<FleetDeviceUpdate> updates;
+        if (!FleetProtocol::decodeDevices(payload, &updates)) {
+            return false;
+        }
+        for (const FleetDeviceUpdate &update : updates) {
+            applyUpdate(connection.apId, update);
+        }
+        return true;
+    }
+
+    if (type == FleetProtocol::Stats) {
+        FleetStatsUpdate stats;
+        if (!FleetProtocol::decodeStats(payload, &stats)) {
+            return false;
+        }
+        m_accessPoints[connection.apId].stats = stats;
+        return true;
+    }
+
+    // أنواع إطارات أحدث من هذا الإصدار تُتجاهل
+    return true;
+}
+
+void FleetAggregator::applyUpdate(const QString &apId, const FleetDeviceUpdate &update) {
+    QHash<QString, ApDeviceState> &states = m_apDevices[apId];
+
+    if (update.fields & FleetDeviceUpdate::Removed) {
+        states.remove(update.macAddress);
+        resolveOwner(update.macAddress);
+        return;
+    }
+
+    ApDeviceState &state = states[update.macAddress];
+    if (update.fields & FleetDeviceUpdate::Ip) {
+        state.ipAddress = update.ipAddress;
+    }
+    if (update.fields & FleetDeviceUpdate::Hostname) {
+        state.hostname = update.hostname;
+    }
+    if (update.fields & FleetDeviceUpdate::LastSeen) {
+        state.lastSeen = QDateTime::fromSecsSinceEpoch(update.lastSeenSecs);
+    }
+    if (update.fields & FleetDeviceUpdate::Active) {
+        state.isActive = update.isActive;
+    }
+    resolveOwner(update.macAddress);
+}
+
+void FleetAggregator::resolveOwner(const QString &macAddress) {
+    // المالك: النقطة التي رأت الجهاز نشطاً أحدث مرة (عدد النقاط صغير)
+    QString owner;
+    const ApDeviceState *best = nullptr;
+    const ApDeviceState *any = nullptr;
+    QString anyAp;
+    for (auto ap = m_apDevices.constBegin(); ap != m_apDevices.constEnd(); ++ap) {
+        auto state = ap->constFind(macAddress);
+        if (state == ap->constEnd()) {
+            continue;
+        }
+        if (state->isActive && (!best || state->lastSeen > best->lastSeen)) {
+            best = &state.value();
+            owner = ap.key();
+        }
+        if (!any || state->lastSeen > any->lastSeen) {
+            any = &state.value();
+            anyAp = ap.key();
+        }
+    }
+
+    if (!any) {
+        auto removed = m_devices.find(macAddress);
+        if (removed != m_devices.end()) {
+            if (removed->isActive) {
+                adjustActive(removed->accessPoint, -1);
+            }
+            m_devices.erase(removed);
+        }
+        return;
+    }
+
+    FleetDevice &device = m_devices[macAddress];
+    QString previousAp = device.accessPoint;
+    bool wasActive = device.isActive;
+    QDateTime previousSeen = device.lastSeen;
+    if (wasActive) {
+        adjustActive(previousAp, -1);
+    }
+
+    const ApDeviceState *source = best ? best : any;
+    device.macAddress = macAddress;
+    device.ipAddress = source->ipAddress;
+    if (!source->hostname.isEmpty()) {
+        device.hostname = source->hostname;
+    }
+    device.lastSeen = source->lastSeen;
+    device.isActive = best != nullptr;
+    // جهاز غير نشط في كل مكان يبقى منسوباً لآخر نقطة كان نشطاً عليها
+    if (best || previousAp.isEmpty()) {
+        device.accessPoint = best ? owner : anyAp;
+    }
+    if (device.isActive) {
+        adjustActive(device.accessPoint, 1);
+    }
+
+    if (best && !previousAp.isEmpty() && previousAp != owner &&
+        (wasActive || previousSeen.secsTo(device.lastSeen) <= kRoamWindowSecs)) {
+        ++device.roamCount;
+        emit deviceRoamed(macAddress, previousAp, owner, device.lastSeen);
+    }
+    emit deviceUpdated(device);
+}
+
+void FleetAggregator::adjustActive(const QString &apId, int delta) {
+    // عداد جارٍ يتبع كل تغيير ملكية بدل عد الفهرس كله مع كل إطار
+    auto ap = m_accessPoints.find(apId);
+    if (ap != m_accessPoints.end()) {
+        ap->activeDevices = qMax(0, ap->activeDevices + delta);
+    }
+}
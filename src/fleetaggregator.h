@@ -0,0 +1,92 @@
+#ifndef FLEETAGGREGATOR_H
+#define FLEETAGGREGATOR_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDateTime>
+#include <QHash>
+#include <vector>
+#include "fleetprotocol.h"
+
+struct FleetDevice {
+    QString macAddress;
+    QString ipAddress;
+    QString hostname;
+    QString accessPoint;   // نقطة الوصول الحالية للجهاز
+    QDateTime lastSeen;
+    bool isActive = false;
+    int roamCount = 0;
+};
+
+struct FleetAccessPoint {
+    QString id;
+    QString interface;
+    QString peerAddress;
+    FleetStatsUpdate stats;
+    bool connected = false;
+    int activeDevices = 0;
+};
+
+// المجمّع: يستقبل دفعات الفروق من كل نقاط الوصول ويبني فهرساً عاماً للأجهزة.
+// كل نقطة لها نسختها من حالة الجهاز، والنقطة "المالكة" هي التي رأته نشطاً
+// أحدث مرة؛ انتقال الملكية من نقطة إلى أخرى هو حدث تجوال.
+class FleetAggregator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FleetAggregator(QObject *parent = nullptr);
+    ~FleetAggregator();
+
+    // الافتراضي الاستماع محلياً؛ عنوان غير محلي يتطلب رمزاً مشتركاً عبر setToken
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 9106);
+    void close();
+    quint16 port() const;
+    void setToken(const QString &token) { m_token = token; }
+
+    std::vector<FleetDevice> devices() const;
+    std::vector<FleetAccessPoint> accessPoints() const;
+    quint64 bytesReceived() const { return m_bytesReceived; }
+
+signals:
+    void deviceUpdated(const FleetDevice &device);
+    void deviceRoamed(const QString &macAddress, const QString &fromAccessPoint,
+                      const QString &toAccessPoint, const QDateTime &when);
+    void accessPointChanged(const QString &id, bool connected);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct ApDeviceState {
+        QString ipAddress;
+        QString hostname;
+        QDateTime lastSeen;
+        bool isActive = false;
+    };
+
+    struct Connection {
+        QString apId;
+        QByteArray buffer;
+    };
+
+    QTcpServer *m_server;
+    QHash<QTcpSocket *, Connection> m_connections;
+    QHash<QString, QTcpSocket *> m_owners;                     // AP -> اتصاله الحالي
+    QHash<QString, FleetAccessPoint> m_accessPoints;
+    QHash<QString, QHash<QString, ApDeviceState>> m_apDevices; // AP -> MAC -> حالة
+    QHash<QString, FleetDevice> m_devices;                     // الفهرس العام حسب MAC
+    QString m_token;
+    quint64 m_bytesReceived = 0;
+
+    void onReadyRead(QTcpSocket *socket);
+    void onSocketClosed(QTcpSocket *socket);
+    bool handleFrame(Connection &connection, QTcpSocket *socket,
+                     FleetProtocol::FrameType type, const QByteArray &payload);
+    void applyUpdate(const QString &apId, const FleetDeviceUpdate &update);
+    void resolveOwner(const QString &macAddress);
+    void adjustActive(const QString &apId, int delta);
+};
+
+#endif // FLEETAGGREGATOR_H
@@ -0,0 +1,259 @@
+#include "fleetprotocol.h"
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+void writeVarint(QByteArray &out, quint64 value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void writeString(QByteArray &out, const QString &value) {
+    QByteArray utf8 = value.toUtf8().left(255);
+    writeVarint(out, static_cast<quint64>(utf8.size()));
+    out += utf8;
+}
+
+bool writeMac(QByteArray &out, const QString &mac) {
+    QStringList parts = mac.split(':');
+    if (parts.size() != 6) {
+        return false;
+    }
+    char bytes[6];
+    for (int i = 0; i < 6; ++i) {
+        bool ok = false;
+        bytes[i] = static_cast<char>(parts[i].toUInt(&ok, 16));
+        if (!ok) {
+            return false;
+        }
+    }
+    out.append(bytes, 6);
+    return true;
+}
+
+// قارئ متسلسل مع فحص الحدود؛ أي قراءة خارج الحمولة تُفشل فك الترميز كله
+struct Reader {
+    const uchar *data;
+    const uchar *end;
+    bool ok = true;
+
+    explicit Reader(const QByteArray &payload)
+        : data(reinterpret_cast<const uchar *>(payload.constData())),
+          end(data + payload.size()) {}
+
+    quint64 varint() {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data >= end) {
+                ok = false;
+                return 0;
+            }
+            uchar byte = *data++;
+            value |= static_cast<quint64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    const uchar *bytes(int count) {
+        if (end - data < count) {
+            ok = false;
+            return nullptr;
+        }
+        const uchar *start = data;
+        data += count;
+        return start;
+    }
+
+    quint8 byte() {
+        const uchar *b = bytes(1);
+        return b ? *b : 0;
+    }
+
+    QString string() {
+        quint64 length = varint();
+        const uchar *b = ok && length <= 255 ? bytes(static_cast<int>(length)) : nullptr;
+        if (!b) {
+            ok = false;
+            return QString();
+        }
+        return QString::fromUtf8(reinterpret_cast<const char *>(b), static_cast<int>(length));
+    }
+};
+
+QString formatMac(const uchar *mac) {
+    return QString::asprintf("%02X:%02X:%02X:%02X:%02X:%02X",
+                             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+QByteArray frame(FleetProtocol::FrameType type, const QByteArray &payload) {
+    QByteArray out;
+    out.reserve(payload.size() + 6);
+    writeVarint(out, static_cast<quint64>(payload.size()) + 1);
+    out += static_cast<char>(type);
+    out += payload;
+    return out;
+}
+
+} // namespace
+
+QByteArray FleetProtocol::encodeHello(const QString &apId, const QString &interface, const QString &token) {
+    QByteArray payload;
+    payload += static_cast<char>(kVersion);
+    writeString(payload, apId);
+    writeString(payload, interface);
+    writeString(payload, token);
+    return frame(Hello, payload);
+}
+
+QByteArray FleetProtocol::encodeDevices(const std::vector<FleetDeviceUpdate> &updates, qint64 nowSecs) {
+    QByteArray payload;
+    payload.reserve(8 + static_cast<int>(updates.size()) * 12);
+    writeVarint(payload, static_cast<quint64>(std::max<qint64>(0, nowSecs)));
+
+    QByteArray entries;
+    quint64 count = 0;
+    for (const FleetDeviceUpdate &update : updates) {
+        if (!writeMac(entries, update.macAddress)) {
+            continue; // أجهزة بلا MAC لا يمكن تتبعها عبر نقاط الوصول
+        }
+        quint8 fields = update.fields & ~FleetDeviceUpdate::ActiveValue;
+        quint32 ipv4 = 0;
+        if (fields & FleetDeviceUpdate::Ip) {
+            QStringList octets = update.ipAddress.split('.');
+            if (octets.size() == 4) {
+                for (const QString &octet : octets) {
+                    ipv4 = (ipv4 << 8) | (octet.toUInt() & 0xff);
+                }
+            } else {
+                fields &= ~FleetDeviceUpdate::Ip;
+            }
+        }
+        if ((fields & FleetDeviceUpdate::Active) && update.isActive) {
+            fields |= FleetDeviceUpdate::ActiveValue;
+        }
+        entries += static_cast<char>(fields);
+        if (fields & FleetDeviceUpdate::Ip) {
+            entries += static_cast<char>(ipv4 >> 24);
+            entries += static_cast<char>(ipv4 >> 16);
+            entries += static_cast<char>(ipv4 >> 8);
+            entries += static_cast<char>(ipv4);
+        }
+        if (fields & FleetDeviceUpdate::Hostname) {
+            writeString(entries, update.hostname);
+        }
+        if (fields & FleetDeviceUpdate::LastSeen) {
+            writeVarint(entries, static_cast<quint64>(std::max<qint64>(0, nowSecs - update.lastSeenSecs)));
+        }
+        ++count;
+    }
+
+    writeVarint(payload, count);
+    payload += entries;
+    return frame(Devices, payload);
+}
+
+QByteArray FleetProtocol::encodeStats(const FleetStatsUpdate &stats) {
+    QByteArray payload;
+    writeVarint(payload, static_cast<quint64>(std::max<qint64>(0, stats.bytesReceived)));
+    writeVarint(payload, static_cast<quint64>(std::max<qint64>(0, stats.bytesSent)));
+    writeVarint(payload, stats.downloadBytesPerSec);
+    writeVarint(payload, stats.uploadBytesPerSec);
+    return frame(Stats, payload);
+}
+
+bool FleetProtocol::takeFrame(QByteArray &buffer, FrameType *type, QByteArray *payload, bool *error) {
+    *error = false;
+
+    quint64 length = 0;
+    int headerBytes = 0;
+    for (int shift = 0;; shift += 7) {
+        if (headerBytes >= buffer.size()) {
+            return false; // طول الإطار لم يكتمل بعد
+        }
+        if (shift > 28) {
+            *error = true;
+            return false;
+        }
+        uchar byte = static_cast<uchar>(buffer[headerBytes++]);
+        length |= static_cast<quint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    if (length == 0 || length > static_cast<quint64>(kMaxFrameBytes)) {
+        *error = true;
+        return false;
+    }
+    if (static_cast<quint64>(buffer.size() - headerBytes) < length) {
+        return false;
+    }
+
+    *type = static_cast<FrameType>(static_cast<uchar>(buffer[headerBytes]));
+    *payload = buffer.mid(headerBytes + 1, static_cast<int>(length) - 1);
+    buffer.remove(0, headerBytes + static_cast<int>(length));
+    return true;
+}
+
+bool FleetProtocol::decodeHello(const QByteArray &payload, QString *apId, QString *interface, QString *token) {
+    Reader reader(payload);
+    quint8 version = reader.byte();
+    *apId = reader.string();
+    *interface = reader.string();
+    *token = reader.string();
+    return reader.ok && version == kVersion && !apId->isEmpty();
+}
+
+bool FleetProtocol::decodeDevices(const QByteArray &payload, std::vector<FleetDeviceUpdate> *updates) {
+    Reader reader(payload);
+    qint64 baseSecs = static_cast<qint64>(reader.varint());
+    quint64 count = reader.varint();
+    // كل مدخل سبعة بايتات على الأقل؛ يمنع حجز ذاكرة ضخمة من عدد مزيف
+    if (!reader.ok || count > static_cast<quint64>(payload.size()) / 7) {
+        return false;
+    }
+
+    updates->clear();
+    updates->reserve(static_cast<size_t>(count));
+    for (quint64 i = 0; i < count && reader.ok; ++i) {
+        FleetDeviceUpdate update;
+        const uchar *mac = reader.bytes(6);
+        update.fields = reader.byte();
+        if (!reader.ok) {
+            break;
+        }
+        update.macAddress = formatMac(mac);
+        if (update.fields & FleetDeviceUpdate::Ip) {
+            const uchar *ip = reader.bytes(4);
+            if (ip) {
+                update.ipAddress = QString("%1.%2.%3.%4").arg(ip[0]).arg(ip[1]).arg(ip[2]).arg(ip[3]);
+            }
+        }
+        if (update.fields & FleetDeviceUpdate::Hostname) {
+            update.hostname = reader.string();
+        }
+        if (update.fields & FleetDeviceUpdate::LastSeen) {
+            update.lastSeenSecs = baseSecs - static_cast<qint64>(reader.varint());
+        }
+        update.isActive = update.fields & FleetDeviceUpdate::ActiveValue;
+        updates->push_back(update);
+    }
+    return reader.ok;
+}
+
+bool FleetProtocol::decodeStats(const QByteArray &payload, FleetStatsUpdate *stats) {
+    Reader reader(payload);
+    stats->bytesReceived = static_cast<qint64>(reader.varint());
+    stats->bytesSent = static_cast<qint64>(reader.varint());
+    stats->downloadBytesPerSec = static_cast<quint32>(reader.varint());
+    stats->uploadBytesPerSec = static_cast<quint32>(reader.varint());
+    return reader.ok;
+}
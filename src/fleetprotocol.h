@@ -0,0 +1,62 @@
+#ifndef FLEETPROTOCOL_H
+#define FLEETPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+// تحديث جهاز واحد كما يُرسل بين نقطة الوصول والمجمّع: الحقول المتغيرة فقط
+struct FleetDeviceUpdate {
+    enum Field : quint8 {
+        Ip = 0x01,
+        Hostname = 0x02,
+        LastSeen = 0x04,
+        Active = 0x08,       // isActive موجود في هذا التحديث
+        Removed = 0x10,
+        ActiveValue = 0x20   // قيمة isActive عند وجود Active
+    };
+
+    QString macAddress;
+    quint8 fields = 0;
+    QString ipAddress;       // IPv4 فقط
+    QString hostname;
+    qint64 lastSeenSecs = 0; // ثوانٍ منذ epoch
+    bool isActive = false;
+};
+
+struct FleetStatsUpdate {
+    qint64 bytesReceived = 0;
+    qint64 bytesSent = 0;
+    quint32 downloadBytesPerSec = 0;
+    quint32 uploadBytesPerSec = 0;
+};
+
+// بروتوكول ثنائي مضغوط بين وكلاء نقاط الوصول والمجمّع.
+// الإطار: varint (طول النوع + الحمولة)، بايت النوع، الحمولة.
+// الأعداد varint، والـ MAC ستة بايتات خام، وIPv4 أربعة بايتات، ووقت آخر
+// ظهور يُرمّز كفرق عن وقت الدفعة، فجهاز لم يتغير فيه شيء لا يكلف شيئاً.
+class FleetProtocol {
+public:
+    static constexpr quint8 kVersion = 2;
+    static constexpr int kMaxFrameBytes = 1024 * 1024;
+
+    enum FrameType : quint8 {
+        Hello = 1,
+        Devices = 2,
+        Stats = 3
+    };
+
+    // التحية تحمل الرمز المشترك؛ المجمّع يغلق الاتصال إن لم يطابق رمزه
+    static QByteArray encodeHello(const QString &apId, const QString &interface, const QString &token);
+    static QByteArray encodeDevices(const std::vector<FleetDeviceUpdate> &updates, qint64 nowSecs);
+    static QByteArray encodeStats(const FleetStatsUpdate &stats);
+
+    // يقتطع إطاراً كاملاً من بداية buffer إن وُجد؛ error عند إطار تالف أو كبير جداً
+    static bool takeFrame(QByteArray &buffer, FrameType *type, QByteArray *payload, bool *error);
+
+    static bool decodeHello(const QByteArray &payload, QString *apId, QString *interface, QString *token);
+    static bool decodeDevices(const QByteArray &payload, std::vector<FleetDeviceUpdate> *updates);
+    static bool decodeStats(const QByteArray &payload, FleetStatsUpdate *stats);
+};
+
+#endif // FLEETPROTOCOL_H
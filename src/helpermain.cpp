@@ -0,0 +1,351 @@
+// wifimanager-helper: المساعد المميز. يعمل كجذر لكن بمجموعة صلاحيات
+// مقلصة إلى CAP_NET_ADMIN و CAP_NET_RAW، وينفذ للواجهة غير المميزة
+// عمليات الجدار الناري وملفات hostapd والخدمات وفتح المقابس الخام فقط.
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QProcess>
+#include <QDebug>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/capability.h>
+#include <poll.h>
+#include <grp.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "privilegedhelper.h"
+#include "firewall.h"
+#include "hostapdcontrol.h"
+
+namespace {
+
+const int kCommandTimeoutMs = 10000;
+// المساعد يخدم طلباً واحداً في كل مرة، و --no-block يعود فور إدراج المهمة
+const int kServiceTimeoutMs = 3000;
+const int kMaxClients = 16;
+const qint64 kMaxFileBytes = PrivilegedHelper::kMaxMessageBytes / 2;
+
+struct HelperOptions {
+    QString socketPath = PrivilegedHelper::defaultSocketPath();
+    QString group;
+    QStringList allowedPaths = {"/etc/hostapd/", "/etc/hostapd.conf", "/etc/wpa_supplicant/"};
+    QStringList allowedUnits = {"hostapd", "dnsmasq", "networking", "NetworkManager", "wpa_supplicant"};
+    QString hostapdControlDir = "/var/run/hostapd";
+};
+
+HelperOptions parseOptions(const QStringList &arguments) {
+    HelperOptions options;
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments[i];
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--socket" && hasValue) {
+            options.socketPath = arguments[++i];
+        } else if (argument == "--group" && hasValue) {
+            options.group = arguments[++i];
+        } else if (argument == "--allow-path" && hasValue) {
+            options.allowedPaths << arguments[++i];
+        } else if (argument == "--allow-unit" && hasValue) {
+            options.allowedUnits << arguments[++i];
+        } else if (argument == "--hostapd-dir" && hasValue) {
+            options.hostapdControlDir = arguments[++i];
+        } else {
+            std::fprintf(stderr, "خيار غير معروف: %s\n", qPrintable(argument));
+        }
+    }
+    return options;
+}
+
+// المسار مسموح إن طابق مدخلاً، أو وقع تحت مجلد ينتهي مدخله بـ /
+bool isPathAllowed(const HelperOptions &options, const QString &path) {
+    if (!QDir::isAbsolutePath(path) || path.contains("/../") || path.endsWith("/..")) {
+        return false;
+    }
+    const QString clean = QDir::cleanPath(path);
+    for (const QString &allowed : options.allowedPaths) {
+        if (allowed.endsWith('/') ? clean.startsWith(allowed) : clean == allowed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// الإبقاء على CAP_NET_ADMIN و CAP_NET_RAW فقط، في العملية وفي كل ما تشغله
+bool dropCapabilities() {
+    const quint32 keep = (1u << CAP_NET_ADMIN) | (1u << CAP_NET_RAW);
+    for (int cap = 0; prctl(PR_CAPBSET_READ, cap, 0, 0, 0) >= 0; ++cap) {
+        if (cap != CAP_NET_ADMIN && cap != CAP_NET_RAW && prctl(PR_CAPBSET_DROP, cap, 0, 0, 0) < 0) {
+            std::fprintf(stderr, "PR_CAPBSET_DROP %d: %s\n", cap, strerror(errno));
+            return false;
+        }
+    }
+
+    __user_cap_header_struct header;
+    __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3];
+    std::memset(&header, 0, sizeof(header));
+    std::memset(data, 0, sizeof(data));
+    header.version = _LINUX_CAPABILITY_VERSION_3;
+    data[0].effective = keep;
+    data[0].permitted = keep;
+    if (syscall(SYS_capset, &header, data) < 0) {
+        std::fprintf(stderr, "capset: %s\n", strerror(errno));
+        return false;
+    }
+    return prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0;
+}
+
+int listenOn(const HelperOptions &options) {
+    QByteArray path = options.socketPath.toLocal8Bit();
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= int(sizeof(address.sun_path))) {
+        std::fprintf(stderr, "مسار المقبس طويل جداً\n");
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.constData(), path.size());
+
+    QDir().mkpath(QFileInfo(options.socketPath).absolutePath());
+    ::unlink(path.constData());
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    // لا أحد غير المالك والمجموعة يتصل بالمقبس
+    mode_t previous = ::umask(0117);
+    int bound = ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    ::umask(previous);
+    if (bound < 0 || ::listen(fd, kMaxClients) < 0) {
+        std::fprintf(stderr, "%s: %s\n", path.constData(), strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    if (!options.group.isEmpty()) {
+        group *entry = ::getgrnam(options.group.toLocal8Bit().constData());
+        if (!entry || ::chown(path.constData(), 0, entry->gr_gid) < 0) {
+            std::fprintf(stderr, "تعذر منح المجموعة %s المقبس\n", qPrintable(options.group));
+            ::close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+PrivilegedHelper::Result failure(PrivilegedHelper::Status status, const QString &message) {
+    PrivilegedHelper::Result result;
+    result.status = status;
+    result.payload = message.toUtf8();
+    return result;
+}
+
+PrivilegedHelper::Result execute(const HelperOptions &options, const PrivilegedHelper::Request &request) {
+    using PH = PrivilegedHelper;
+    PH::Result result;
+    result.status = PH::Ok;
+    int offset = 0;
+
+    switch (request.operation) {
+    case PH::ListBlocked: {
+        Firewall::BlockRules rules;
+        if (!Firewall::readBlocked(&rules, kCommandTimeoutMs)) {
+            return failure(PH::Failed, "تعذرت قراءة قواعد iptables الحالية");
+        }
+        result.payload = PH::encodeBlockRules(rules);
+        return result;
+    }
+    case PH::SetBlocked: {
+        QHash<QString, bool> changes;
+        if (!PH::decodeBlockChanges(request.payload, &changes)) {
+            return failure(PH::BadRequest, "طلب حظر غير صالح");
+        }
+        QString error;
+        if (!Firewall::setBlocked(changes, kCommandTimeoutMs, &error)) {
+            return failure(PH::Failed, error);
+        }
+        return result;
+    }
+    case PH::ReadFile: {
+        QString path;
+        if (!PH::decodeString(request.payload, &offset, &path)) {
+            return failure(PH::BadRequest, "مسار غير صالح");
+        }
+        if (!isPathAllowed(options, path)) {
+            return failure(PH::Denied, path);
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly) || file.size() > kMaxFileBytes) {
+            return failure(PH::Failed, file.errorString());
+        }
+        result.payload = file.readAll();
+        return result;
+    }
+    case PH::WriteFile: {
+        QString path;
+        QByteArray contents;
+        if (!PH::decodeString(request.payload, &offset, &path) ||
+            !PH::decodeBytes(request.payload, &offset, &contents)) {
+            return failure(PH::BadRequest, "طلب كتابة غير صالح");
+        }
+        if (!isPathAllowed(options, path)) {
+            return failure(PH::Denied, path);
+        }
+        // QSaveFile يحتفظ بصلاحيات الملف الأصلي ويستبدله ذرياً
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size() || !file.commit()) {
+            return failure(PH::Failed, file.errorString());
+        }
+        return result;
+    }
+    case PH::RestartService: {
+        QString unit;
+        if (!PH::decodeString(request.payload, &offset, &unit)) {
+            return failure(PH::BadRequest, "اسم خدمة غير صالح");
+        }
+        if (!options.allowedUnits.contains(unit)) {
+            return failure(PH::Denied, unit);
+        }
+        // لا ننتظر اكتمال البدء هنا؛ العميل يتحقق من جاهزية الخدمة نفسها
+        QProcess process;
+        process.start("systemctl", QStringList() << "restart" << "--no-block" << unit);
+        if (!process.waitForFinished(kServiceTimeoutMs)) {
+            process.kill();
+            process.waitForFinished(1000);
+            return failure(PH::Failed, QString("systemctl لم يرد خلال %1 ms").arg(kServiceTimeoutMs));
+        }
+        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            return failure(PH::Failed, QString::fromUtf8(process.readAllStandardError()).trimmed());
+        }
+        return result;
+    }
+    case PH::OpenSocket: {
+        if (request.payload.size() != 1) {
+            return failure(PH::BadRequest, "نوع مقبس غير صالح");
+        }
+        result.fd = PH::openSocketLocally(static_cast<PH::SocketKind>(quint8(request.payload[0])));
+        if (result.fd < 0) {
+            return failure(PH::Failed, QString::fromLocal8Bit(strerror(errno)));
+        }
+        return result;
+    }
+    case PH::HostapdCommand: {
+        QString interface;
+        QByteArray command;
+        if (!PH::decodeString(request.payload, &offset, &interface) ||
+            !PH::decodeBytes(request.payload, &offset, &command) || interface.contains('/')) {
+            return failure(PH::BadRequest, "أمر hostapd غير صالح");
+        }
+        // أوامر لا تغير الحالة إلا من الملف الذي كتبه المساعد نفسه
+        if (command != "RELOAD" && command != "PING") {
+            return failure(PH::Denied, QString::fromUtf8(command));
+        }
+        QString path = HostapdControl::socketPath(options.hostapdControlDir, interface);
+        if (!HostapdControl::request(path, command, &result.payload)) {
+            return failure(PH::Failed, "لا يستجيب مقبس تحكم hostapd");
+        }
+        return result;
+    }
+    }
+    return failure(PH::BadRequest, "عملية غير معروفة");
+}
+
+// false يعني إغلاق اتصال العميل
+bool serve(const HelperOptions &options, int client) {
+    QByteArray message;
+    std::vector<int> received;
+    if (!PrivilegedHelper::receiveMessage(client, &message, &received)) {
+        return false;
+    }
+    // العميل لا يرسل واصفات؛ لا نحتفظ بما لم نطلبه
+    for (int fd : received) {
+        ::close(fd);
+    }
+
+    std::vector<PrivilegedHelper::Request> requests;
+    if (!PrivilegedHelper::decodeRequests(message, &requests)) {
+        qWarning() << "Helper: malformed request, closing client";
+        return false;
+    }
+
+    std::vector<PrivilegedHelper::Result> results;
+    std::vector<int> fds;
+    results.reserve(requests.size());
+    for (const PrivilegedHelper::Request &request : requests) {
+        results.push_back(execute(options, request));
+        if (results.back().fd >= 0) {
+            fds.push_back(results.back().fd);
+        }
+    }
+
+    bool sent = PrivilegedHelper::sendMessage(client, PrivilegedHelper::encodeResults(results), fds);
+    // الواصفات صارت عند العميل
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    return sent;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    HelperOptions options = parseOptions(app.arguments());
+
+    if (geteuid() != 0) {
+        std::fprintf(stderr, "المساعد المميز يتطلب التشغيل كجذر.\n");
+        return 1;
+    }
+
+    int listener = listenOn(options);
+    if (listener < 0 || !dropCapabilities()) {
+        return 1;
+    }
+    qInfo() << "Helper: listening on" << options.socketPath;
+
+    std::vector<pollfd> fds = {{listener, POLLIN, 0}};
+    for (;;) {
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (size_t i = fds.size(); i-- > 1;) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if ((fds[i].revents & (POLLHUP | POLLERR)) || !serve(options, fds[i].fd)) {
+                ::close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0 && int(fds.size()) > kMaxClients) {
+                ::close(client);
+            } else if (client >= 0) {
+                ucred peer;
+                socklen_t length = sizeof(peer);
+                if (::getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &length) == 0) {
+                    qInfo() << "Helper: client pid" << peer.pid << "uid" << peer.uid;
+                }
+                fds.push_back({client, POLLIN, 0});
+            }
+        }
+    }
+
+    ::close(listener);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "hostapdcontrol.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QAtomicInt>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace {
+
+QAtomicInt g_requestCounter;
+
+bool fillAddress(sockaddr_un *address, const QByteArray &path) {
+    std::memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (path.size() >= int(sizeof(address->sun_path))) {
+        return false;
+    }
+    std::memcpy(address->sun_path, path.constData(), path.size());
+    return true;
+}
+
+} // namespace
+
+QString HostapdControl::socketPath(const QString &controlDir, const QString &interface) {
+    QDir directory(controlDir);
+    if (!interface.isEmpty() && QFileInfo(directory.filePath(interface)).exists()) {
+        return directory.filePath(interface);
+    }
+    const QStringList entries = directory.entryList(QDir::System | QDir::NoDotAndDotDot, QDir::Name);
+    return entries.isEmpty() ? QString() : directory.filePath(entries.first());
+}
+
+bool HostapdControl::request(const QString &socketPath, const QByteArray &command, QByteArray *reply,
+                             int timeoutMs) {
+    if (socketPath.isEmpty()) {
+        return false;
+    }
+
+    // hostapd يرد على عنوان المرسل؛ مسار محلي فريد لكل طلب
+    QByteArray localPath = QFile::encodeName(QDir::temp().filePath(
+        QString("wifimanager-ctrl-%1-%2").arg(getpid()).arg(g_requestCounter.fetchAndAddRelaxed(1))));
+    sockaddr_un local;
+    sockaddr_un remote;
+    if (!fillAddress(&local, localPath) || !fillAddress(&remote, QFile::encodeName(socketPath))) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    ::unlink(localPath.constData());
+
+    bool ok = false;
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) == 0 &&
+        ::connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) == 0) {
+        timeval timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (::send(fd, command.constData(), size_t(command.size()), 0) == command.size()) {
+            char buffer[4096];
+            // الأحداث غير المطلوبة تبدأ بـ "<"؛ لم نرسل ATTACH فلا نتوقعها، لكن نتخطاها احتياطاً
+            for (;;) {
+                ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (length <= 0) {
+                    break;
+                }
+                if (buffer[0] != '<') {
+                    if (reply) {
+                        *reply = QByteArray(buffer, int(length));
+                    }
+                    ok = true;
+                    break;
+                }
+            }
+        }
+    }
+    ::close(fd);
+    ::unlink(localPath.constData());
+    return ok;
+}
+
+bool HostapdControl::reload(const QString &controlDir, const QString &interface) {
+    QByteArray reply;
+    return request(socketPath(controlDir, interface), "RELOAD", &reply) && reply.startsWith("OK");
+}
+
+bool HostapdControl::ping(const QString &controlDir, const QString &interface) {
+    QByteArray reply;
+    return request(socketPath(controlDir, interface), "PING", &reply, 500) && reply.startsWith("PONG");
+}
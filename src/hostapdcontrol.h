@@ -0,0 +1,23 @@
+#ifndef HOSTAPDCONTROL_H
+#define HOSTAPDCONTROL_H
+
+#include <QByteArray>
+#include <QString>
+
+// أوامر لمرة واحدة على مقبس تحكم hostapd (ctrl_interface): RELOAD بعد
+// تعديل الملف بدلاً من إعادة تشغيل الخدمة، و PING لمعرفة جاهزيتها.
+// متابعة الأحداث المستمرة في AssociationTracker.
+class HostapdControl {
+public:
+    // مقبس الواجهة إن وُجد، وإلا أول مقبس في المجلد
+    static QString socketPath(const QString &controlDir, const QString &interface);
+
+    static bool request(const QString &socketPath, const QByteArray &command, QByteArray *reply,
+                        int timeoutMs = 1000);
+
+    // ردود OK / PONG
+    static bool reload(const QString &controlDir, const QString &interface);
+    static bool ping(const QString &controlDir, const QString &interface);
+};
+
+#endif // HOSTAPDCONTROL_H
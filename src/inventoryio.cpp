@@ -0,0 +1,604 @@
+#include "inventoryio.h"
+#include "wifimanager.h"
+#include "traffichistory.h"
+#include "columnarfile.h"
+#include "firewall.h"
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <functional>
+
+namespace {
+
+// مواقع أعمدة جدول الحركة في ملف معين؛ الأعمدة الناقصة تُقرأ أصفاراً
+struct TrafficColumns {
+    int timestamp = -1;
+    int mac = -1;
+    int received = -1;
+    int sent = -1;
+    int signal = -1;
+
+    explicit TrafficColumns(const std::vector<Columnar::Column> &columns)
+        : timestamp(ColumnarReader::columnIndex(columns, "timestamp_ms", Columnar::Int64)),
+          mac(ColumnarReader::columnIndex(columns, "mac", Columnar::String)),
+          received(ColumnarReader::columnIndex(columns, "bytes_received", Columnar::Int64)),
+          sent(ColumnarReader::columnIndex(columns, "bytes_sent", Columnar::Int64)),
+          signal(ColumnarReader::columnIndex(columns, "signal_dbm", Columnar::Double)) {}
+
+    bool valid() const { return timestamp >= 0 && mac >= 0; }
+
+    TrafficHistory::Sample sample(const Columnar::Chunk &chunk, int row) const {
+        TrafficHistory::Sample sample;
+        sample.timestampMs = chunk.columns[timestamp].ints[row];
+        sample.macAddress = chunk.columns[mac].strings[row];
+        sample.bytesReceived = received >= 0 ? chunk.columns[received].ints[row] : 0;
+        sample.bytesSent = sent >= 0 ? chunk.columns[sent].ints[row] : 0;
+        sample.signalDbm = signal >= 0 ? chunk.columns[signal].doubles[row] : 0.0;
+        return sample;
+    }
+};
+
+const std::vector<Columnar::Column> &deviceColumns() {
+    static const std::vector<Columnar::Column> schema = {
+        {"mac", Columnar::String},
+        {"ip", Columnar::String},
+        {"ipv4", Columnar::String},
+        {"ipv6", Columnar::String},
+        {"hostname", Columnar::String},
+        {"manufacturer", Columnar::String},
+        {"last_seen_ms", Columnar::Int64},
+        {"bytes_received", Columnar::Int64},
+        {"bytes_sent", Columnar::Int64},
+        {"signal_dbm", Columnar::Double},
+        {"blocked", Columnar::Int64},
+    };
+    return schema;
+}
+
+// تمرير جداول الحركة من ملفات التاريخ كتلة كتلة
+bool forEachTrafficChunk(const QStringList &files, QString *error,
+                         const std::function<bool(const Columnar::Chunk &, const TrafficColumns &)> &callback) {
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = QString("تعذر فتح %1: %2").arg(path, file.errorString());
+            return false;
+        }
+        ColumnarReader reader(&file);
+        if (!reader.open()) {
+            continue; // ملف فارغ أو من إصدار آخر: لا نوقف التصدير بسببه
+        }
+        QString table;
+        std::vector<Columnar::Column> columns;
+        while (reader.nextTable(&table, &columns)) {
+            TrafficColumns indexes(columns);
+            if (table != "traffic" || !indexes.valid()) {
+                continue;
+            }
+            Columnar::Chunk chunk;
+            while (reader.nextChunk(&chunk)) {
+                if (!callback(chunk, indexes)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+QByteArray csvField(const QString &value) {
+    QByteArray utf8 = value.toUtf8();
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n')) {
+        utf8.replace("\"", "\"\"");
+        return '"' + utf8 + '"';
+    }
+    return utf8;
+}
+
+// سجل CSV كامل: الحقل المقتبس قد يمتد عبر عدة أسطر (اسم مضيف أو مُصنِّع فيه سطر جديد)
+QStringList readCsvRecord(QIODevice *device) {
+    QByteArray utf8 = device->readLine();
+    while (utf8.count('"') % 2 != 0 && !device->atEnd()) {
+        utf8 += device->readLine();
+    }
+    if (utf8.endsWith('\n')) {
+        utf8.chop(1);
+    }
+    if (utf8.endsWith('\r')) {
+        utf8.chop(1);
+    }
+
+    const QString record = QString::fromUtf8(utf8);
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (int i = 0; i < record.size(); ++i) {
+        QChar c = record[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < record.size() && record[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.append(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.append(field);
+    return fields;
+}
+
+// عناوين MAC المستوردة بصيغة واحدة (أحرف كبيرة ونقطتان) كما يسجلها الماسح؛
+// يبقى الفارغ فارغاً لأجهزة لا يُعرف منها إلا IP، وأي نص آخر يُرفض
+bool normalizeMac(QString *mac) {
+    if (mac->isEmpty()) {
+        return true;
+    }
+    QString normalized = mac->trimmed().toUpper();
+    normalized.replace('-', ':');
+    if (!Firewall::isValidMac(normalized)) {
+        return false;
+    }
+    *mac = normalized;
+    return true;
+}
+
+QByteArray trafficJsonLine(const TrafficHistory::Sample &sample) {
+    // تنسيق يدوي: الحقول أرقام وعنوان MAC، والأسطر قد تبلغ الملايين
+    return "{\"type\":\"traffic\",\"ts\":" + QByteArray::number(sample.timestampMs) +
+           ",\"mac\":\"" + sample.macAddress.toLatin1() +
+           "\",\"rx\":" + QByteArray::number(sample.bytesReceived) +
+           ",\"tx\":" + QByteArray::number(sample.bytesSent) +
+           ",\"signal\":" + QByteArray::number(sample.signalDbm) + "}\n";
+}
+
+} // namespace
+
+QJsonObject InventoryIO::deviceToJson(const Device &device) {
+    QJsonObject object;
+    object["type"] = "device";
+    object["mac"] = device.macAddress;
+    object["ip"] = device.ipAddress;
+    object["ipv4"] = QJsonArray::fromStringList(device.ipv4Addresses);
+    object["ipv6"] = QJsonArray::fromStringList(device.ipv6Addresses);
+    object["hostname"] = device.hostname;
+    object["manufacturer"] = device.manufacturer;
+    if (!device.deviceType.isEmpty()) {
+        object["deviceType"] = device.deviceType;
+    }
+    object["lastSeen"] = device.lastSeen.toString(Qt::ISODate);
+    object["rx"] = device.bytesReceived;
+    object["tx"] = device.bytesSent;
+    object["signal"] = device.signalStrength;
+    object["blocked"] = device.isBlocked;
+    object["active"] = device.isActive;
+    object["weak"] = device.weakLink;
+    return object;
+}
+
+namespace {
+
+Device deviceFromJson(const QJsonObject &object) {
+    Device device;
+    device.macAddress = object["mac"].toString();
+    device.ipAddress = object["ip"].toString();
+    for (const QJsonValue &address : object["ipv4"].toArray()) {
+        device.ipv4Addresses.append(address.toString());
+    }
+    for (const QJsonValue &address : object["ipv6"].toArray()) {
+        device.ipv6Addresses.append(address.toString());
+    }
+    device.hostname = object["hostname"].toString();
+    device.manufacturer = object["manufacturer"].toString();
+    device.deviceType = object["deviceType"].toString();
+    device.lastSeen = QDateTime::fromString(object["lastSeen"].toString(), Qt::ISODate);
+    device.bytesReceived = static_cast<qint64>(object["rx"].toDouble());
+    device.bytesSent = static_cast<qint64>(object["tx"].toDouble());
+    device.signalStrength = object["signal"].toDouble();
+    return device;
+}
+
+bool exportCsv(const std::vector<Device> &devices, const QStringList &historyFiles,
+               const QString &path, QString *error) {
+    QSaveFile devicesFile(path);
+    if (!devicesFile.open(QIODevice::WriteOnly)) {
+        *error = devicesFile.errorString();
+        return false;
+    }
+    devicesFile.write("mac,ip,ipv4,ipv6,hostname,manufacturer,last_seen,bytes_received,bytes_sent,signal_dbm,blocked\n");
+    for (const Device &device : devices) {
+        QByteArray line;
+        line += csvField(device.macAddress) + ',';
+        line += csvField(device.ipAddress) + ',';
+        line += csvField(device.ipv4Addresses.join(' ')) + ',';
+        line += csvField(device.ipv6Addresses.join(' ')) + ',';
+        line += csvField(device.hostname) + ',';
+        line += csvField(device.manufacturer) + ',';
+        line += device.lastSeen.toString(Qt::ISODate).toLatin1() + ',';
+        line += QByteArray::number(device.bytesReceived) + ',';
+        line += QByteArray::number(device.bytesSent) + ',';
+        line += QByteArray::number(device.signalStrength) + ',';
+        line += device.isBlocked ? "1\n" : "0\n";
+        devicesFile.write(line);
+    }
+
+    QSaveFile trafficFile(InventoryIO::trafficCsvPath(path));
+    if (!trafficFile.open(QIODevice::WriteOnly)) {
+        *error = trafficFile.errorString();
+        return false;
+    }
+    trafficFile.write("timestamp_ms,mac,bytes_received,bytes_sent,signal_dbm\n");
+    bool ok = forEachTrafficChunk(historyFiles, error,
+                                  [&trafficFile](const Columnar::Chunk &chunk, const TrafficColumns &columns) {
+        QByteArray block;
+        block.reserve(chunk.rows * 64);
+        for (int row = 0; row < chunk.rows; ++row) {
+            TrafficHistory::Sample sample = columns.sample(chunk, row);
+            block += QByteArray::number(sample.timestampMs) + ',' + sample.macAddress.toLatin1() + ',' +
+                     QByteArray::number(sample.bytesReceived) + ',' + QByteArray::number(sample.bytesSent) + ',' +
+                     QByteArray::number(sample.signalDbm) + '\n';
+        }
+        return trafficFile.write(block) == block.size();
+    });
+
+    if (!ok || !devicesFile.commit() || !trafficFile.commit()) {
+        if (error->isEmpty()) {
+            *error = trafficFile.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool exportJsonLines(const std::vector<Device> &devices, const QStringList &historyFiles,
+                     const QString &path, QString *error) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    for (const Device &device : devices) {
+        file.write(QJsonDocument(InventoryIO::deviceToJson(device)).toJson(QJsonDocument::Compact) + '\n');
+    }
+
+    bool ok = forEachTrafficChunk(historyFiles, error,
+                                  [&file](const Columnar::Chunk &chunk, const TrafficColumns &columns) {
+        QByteArray block;
+        block.reserve(chunk.rows * 96);
+        for (int row = 0; row < chunk.rows; ++row) {
+            block += trafficJsonLine(columns.sample(chunk, row));
+        }
+        return file.write(block) == block.size();
+    });
+
+    if (!ok || !file.commit()) {
+        if (error->isEmpty()) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool exportColumnar(const std::vector<Device> &devices, const QStringList &historyFiles,
+                    const QString &path, QString *error) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    ColumnarWriter writer(&file);
+    writer.writeFileHeader();
+    writer.beginTable("devices", deviceColumns());
+    for (const Device &device : devices) {
+        writer.addString(device.macAddress);
+        writer.addString(device.ipAddress);
+        writer.addString(device.ipv4Addresses.join(' '));
+        writer.addString(device.ipv6Addresses.join(' '));
+        writer.addString(device.hostname);
+        writer.addString(device.manufacturer);
+        writer.addInt(device.lastSeen.isValid() ? device.lastSeen.toMSecsSinceEpoch() : 0);
+        writer.addInt(device.bytesReceived);
+        writer.addInt(device.bytesSent);
+        writer.addDouble(device.signalStrength);
+        writer.addInt(device.isBlocked ? 1 : 0);
+        writer.endRow();
+    }
+    writer.endTable();
+
+    writer.beginTable("traffic", TrafficHistory::columns());
+    bool ok = forEachTrafficChunk(historyFiles, error,
+                                  [&writer](const Columnar::Chunk &chunk, const TrafficColumns &columns) {
+        for (int row = 0; row < chunk.rows; ++row) {
+            TrafficHistory::Sample sample = columns.sample(chunk, row);
+            writer.addInt(sample.timestampMs);
+            writer.addString(sample.macAddress);
+            writer.addInt(sample.bytesReceived);
+            writer.addInt(sample.bytesSent);
+            writer.addDouble(sample.signalDbm);
+            if (!writer.endRow()) {
+                return false;
+            }
+        }
+        return true;
+    });
+    ok = ok && writer.endTable();
+
+    if (!ok || !file.commit()) {
+        if (error->isEmpty()) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool importColumnar(const QString &path, std::vector<Device> *devices, TrafficHistory *history,
+                    qint64 *samples, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+    ColumnarReader reader(&file);
+    if (!reader.open()) {
+        *error = "ليس ملفاً عمودياً صالحاً";
+        return false;
+    }
+
+    QString table;
+    std::vector<Columnar::Column> columns;
+    int badRows = 0;
+    while (reader.nextTable(&table, &columns)) {
+        Columnar::Chunk chunk;
+        if (table == "traffic") {
+            TrafficColumns indexes(columns);
+            while (indexes.valid() && reader.nextChunk(&chunk)) {
+                for (int row = 0; row < chunk.rows; ++row) {
+                    TrafficHistory::Sample sample = indexes.sample(chunk, row);
+                    if (sample.macAddress.isEmpty() || !normalizeMac(&sample.macAddress)) {
+                        ++badRows;
+                        continue;
+                    }
+                    if (history) {
+                        history->append(sample);
+                    }
+                    ++*samples;
+                }
+            }
+        } else if (table == "devices") {
+            auto text = [&columns](const char *name) {
+                return ColumnarReader::columnIndex(columns, name, Columnar::String);
+            };
+            auto number = [&columns](const char *name) {
+                return ColumnarReader::columnIndex(columns, name, Columnar::Int64);
+            };
+            int mac = text("mac"), ip = text("ip"), ipv4 = text("ipv4"), ipv6 = text("ipv6");
+            int hostname = text("hostname"), manufacturer = text("manufacturer");
+            int lastSeen = number("last_seen_ms"), received = number("bytes_received");
+            int sent = number("bytes_sent");
+            int signal = ColumnarReader::columnIndex(columns, "signal_dbm", Columnar::Double);
+            if (mac < 0) {
+                continue;
+            }
+            while (reader.nextChunk(&chunk)) {
+                for (int row = 0; row < chunk.rows; ++row) {
+                    auto textAt = [&chunk, row](int index) {
+                        return index >= 0 ? chunk.columns[index].strings[row] : QString();
+                    };
+                    auto numberAt = [&chunk, row](int index) {
+                        return index >= 0 ? chunk.columns[index].ints[row] : qint64(0);
+                    };
+                    Device device;
+                    device.macAddress = textAt(mac);
+                    device.ipAddress = textAt(ip);
+                    device.ipv4Addresses = textAt(ipv4).split(' ', Qt::SkipEmptyParts);
+                    device.ipv6Addresses = textAt(ipv6).split(' ', Qt::SkipEmptyParts);
+                    device.hostname = textAt(hostname);
+                    device.manufacturer = textAt(manufacturer);
+                    qint64 seen = numberAt(lastSeen);
+                    if (seen > 0) {
+                        device.lastSeen = QDateTime::fromMSecsSinceEpoch(seen);
+                    }
+                    device.bytesReceived = numberAt(received);
+                    device.bytesSent = numberAt(sent);
+                    device.signalStrength = signal >= 0 ? chunk.columns[signal].doubles[row] : 0.0;
+                    if (!normalizeMac(&device.macAddress)) {
+                        ++badRows;
+                        continue;
+                    }
+                    devices->push_back(device);
+                }
+            }
+        }
+    }
+
+    if (reader.hasError()) {
+        *error = "الملف تالف؛ استُورد ما قبل موضع التلف فقط";
+        return false;
+    }
+    if (badRows > 0) {
+        *error = QString("تم تجاهل %1 سطر غير صالح").arg(badRows);
+    }
+    return true;
+}
+
+bool importJsonLines(const QString &path, std::vector<Device> *devices, TrafficHistory *history,
+                     qint64 *samples, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    int badLines = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonObject object = QJsonDocument::fromJson(line).object();
+        QString type = object["type"].toString();
+        if (type == "traffic") {
+            TrafficHistory::Sample sample;
+            sample.timestampMs = static_cast<qint64>(object["ts"].toDouble());
+            sample.macAddress = object["mac"].toString();
+            sample.bytesReceived = static_cast<qint64>(object["rx"].toDouble());
+            sample.bytesSent = static_cast<qint64>(object["tx"].toDouble());
+            sample.signalDbm = object["signal"].toDouble();
+            if (!normalizeMac(&sample.macAddress)) {
+                ++badLines;
+                continue;
+            }
+            if (history) {
+                history->append(sample);
+            }
+            ++*samples;
+        } else if (type == "device") {
+            Device device = deviceFromJson(object);
+            if (!normalizeMac(&device.macAddress)) {
+                ++badLines;
+                continue;
+            }
+            devices->push_back(device);
+        } else {
+            ++badLines;
+        }
+    }
+    if (badLines > 0) {
+        *error = QString("تم تجاهل %1 سطر غير صالح").arg(badLines);
+    }
+    return true;
+}
+
+bool importCsv(const QString &path, std::vector<Device> *devices, TrafficHistory *history,
+               qint64 *samples, QString *error) {
+    QFile devicesFile(path);
+    if (!devicesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = devicesFile.errorString();
+        return false;
+    }
+    QStringList header = readCsvRecord(&devicesFile);
+    auto column = [&header](const char *name) { return header.indexOf(name); };
+    int mac = column("mac"), ip = column("ip"), ipv4 = column("ipv4"), ipv6 = column("ipv6");
+    int hostname = column("hostname"), manufacturer = column("manufacturer"), lastSeen = column("last_seen");
+    if (mac < 0) {
+        *error = "لا يوجد عمود mac في الملف";
+        return false;
+    }
+    int badRecords = 0;
+    while (!devicesFile.atEnd()) {
+        QStringList fields = readCsvRecord(&devicesFile);
+        auto field = [&fields](int index) { return index >= 0 && index < fields.size() ? fields[index] : QString(); };
+        Device device;
+        device.macAddress = field(mac);
+        device.ipAddress = field(ip);
+        device.ipv4Addresses = field(ipv4).split(' ', Qt::SkipEmptyParts);
+        device.ipv6Addresses = field(ipv6).split(' ', Qt::SkipEmptyParts);
+        device.hostname = field(hostname);
+        device.manufacturer = field(manufacturer);
+        device.lastSeen = QDateTime::fromString(field(lastSeen), Qt::ISODate);
+        if (!normalizeMac(&device.macAddress)) {
+            ++badRecords;
+        } else if (!device.macAddress.isEmpty() || !device.ipAddress.isEmpty()) {
+            devices->push_back(device);
+        }
+    }
+
+    // ملف الحركة المرافق اختياري
+    QFile trafficFile(InventoryIO::trafficCsvPath(path));
+    if (!trafficFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (badRecords > 0) {
+            *error = QString("تم تجاهل %1 سطر غير صالح").arg(badRecords);
+        }
+        return true;
+    }
+    readCsvRecord(&trafficFile); // الترويسة بالترتيب الثابت الذي يكتبه التصدير
+    while (!trafficFile.atEnd()) {
+        QStringList fields = readCsvRecord(&trafficFile);
+        if (fields.size() < 5) {
+            continue;
+        }
+        TrafficHistory::Sample sample;
+        sample.timestampMs = fields[0].toLongLong();
+        sample.macAddress = fields[1];
+        sample.bytesReceived = fields[2].toLongLong();
+        sample.bytesSent = fields[3].toLongLong();
+        sample.signalDbm = fields[4].toDouble();
+        if (sample.macAddress.isEmpty() || !normalizeMac(&sample.macAddress)) {
+            ++badRecords;
+            continue;
+        }
+        if (history) {
+            history->append(sample);
+        }
+        ++*samples;
+    }
+    if (badRecords > 0) {
+        *error = QString("تم تجاهل %1 سطر غير صالح").arg(badRecords);
+    }
+    return true;
+}
+
+} // namespace
+
+InventoryIO::Format InventoryIO::formatForPath(const QString &path) {
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "csv") {
+        return Csv;
+    }
+    if (suffix == "jsonl" || suffix == "ndjson") {
+        return JsonLines;
+    }
+    return Columnar;
+}
+
+QString InventoryIO::trafficCsvPath(const QString &devicesPath) {
+    QFileInfo info(devicesPath);
+    return info.dir().filePath(info.completeBaseName() + "-traffic.csv");
+}
+
+bool InventoryIO::exportInventory(const std::vector<Device> &devices, const QStringList &historyFiles,
+                                  const QString &path, Format format, QString *error) {
+    error->clear();
+    switch (format) {
+    case Csv: return exportCsv(devices, historyFiles, path, error);
+    case JsonLines: return exportJsonLines(devices, historyFiles, path, error);
+    case Columnar: return exportColumnar(devices, historyFiles, path, error);
+    }
+    return false;
+}
+
+bool InventoryIO::importInventory(const QString &path, std::vector<Device> *devices,
+                                  TrafficHistory *history, qint64 *samples, QString *error) {
+    error->clear();
+    qint64 ignored = 0;
+    if (!samples) {
+        samples = &ignored;
+    }
+    *samples = 0;
+
+    bool ok;
+    switch (formatForPath(path)) {
+    case Csv: ok = importCsv(path, devices, history, samples, error); break;
+    case JsonLines: ok = importJsonLines(path, devices, history, samples, error); break;
+    default: ok = importColumnar(path, devices, history, samples, error); break;
+    }
+    if (history) {
+        history->flush();
+    }
+    return ok;
+}
@@ -0,0 +1,36 @@
+#ifndef INVENTORYIO_H
+#define INVENTORYIO_H
+
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <vector>
+
+struct Device;
+class TrafficHistory;
+
+// تصدير واستيراد قائمة الأجهزة وتاريخ حركتها. التاريخ يُقرأ ويُكتب كتلة
+// كتلة من ملفات TrafficHistory فلا يُحمل كاملاً في الذاكرة مهما كبر.
+class InventoryIO {
+public:
+    enum Format {
+        Csv,        // ملفان: path للأجهزة و <اسم>-traffic.csv للحركة
+        JsonLines,  // ملف واحد، سطر لكل جهاز أو عينة مع الحقل "type"
+        Columnar    // ملف .wmc واحد بجدولين: devices و traffic
+    };
+
+    // تمثيل الجهاز المشترك بين التصدير وواجهة التحكم عن بعد
+    static QJsonObject deviceToJson(const Device &device);
+
+    static Format formatForPath(const QString &path);
+    static QString trafficCsvPath(const QString &devicesPath);
+
+    static bool exportInventory(const std::vector<Device> &devices, const QStringList &historyFiles,
+                                const QString &path, Format format, QString *error);
+
+    // الأجهزة تُعاد للمستدعي ليدمجها، والعينات تُلحق بـ history مباشرة أثناء القراءة
+    static bool importInventory(const QString &path, std::vector<Device> *devices,
+                                TrafficHistory *history, qint64 *samples, QString *error);
+};
+
+#endif // INVENTORYIO_H
@@ -0,0 +1,193 @@
+#include "livenesstracker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+// الأجهزة غير المتصلة تُفحص ببطء لفترة ثم تُترك للمصادر السلبية
+const qint64 kInactiveProbeIntervalMs = 60000;
+const int kInactiveProbeLimit = 10;
+
+// لا نعيد الجدولة إذا تحرك الموعد أقل من 5 ثوانٍ، لتقليل المراجع المكررة في العجلة
+const qint64 kRescheduleSlackTicks = 5;
+
+} // namespace
+
+LivenessTracker::LivenessTracker(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this)), m_wheel(kWheelSlots)
+{
+    m_timer->setInterval(kTickMs);
+    connect(m_timer, &QTimer::timeout, this, &LivenessTracker::onTick);
+    m_clock.start();
+}
+
+void LivenessTracker::start() {
+    m_currentTick = nowMs() / kTickMs;
+    m_timer->start();
+}
+
+void LivenessTracker::stop() {
+    m_timer->stop();
+}
+
+void LivenessTracker::setTimeouts(int probeAfterMs, int probeIntervalMs, int missesBeforeInactive) {
+    m_probeAfterMs = std::max(kTickMs, probeAfterMs);
+    m_probeIntervalMs = std::max(kTickMs, probeIntervalMs);
+    m_missesBeforeInactive = std::max(1, missesBeforeInactive);
+}
+
+bool LivenessTracker::noteReply(const QString &macAddress, const QString &ipAddress, const QDateTime &when) {
+    if (macAddress.isEmpty() || !when.isValid()) {
+        auto it = m_index.constFind(macAddress);
+        return it != m_index.constEnd() && m_entries[it.value()].active;
+    }
+
+    int id;
+    auto it = m_index.constFind(macAddress);
+    if (it == m_index.constEnd()) {
+        if (!m_freeEntries.empty()) {
+            id = m_freeEntries.back();
+            m_freeEntries.pop_back();
+            m_entries[id] = Entry();
+        } else {
+            id = static_cast<int>(m_entries.size());
+            m_entries.emplace_back();
+        }
+        m_entries[id].macAddress = macAddress;
+        m_entries[id].lastReplyMs = std::numeric_limits<qint64>::min() / 2; // لم يُسجل أي رد بعد
+        m_index.insert(macAddress, id);
+    } else {
+        id = it.value();
+    }
+
+    Entry &entry = m_entries[id];
+    qint64 age = std::max<qint64>(0, when.msecsTo(QDateTime::currentDateTime()));
+    qint64 replyMs = nowMs() - age;
+
+    if (!ipAddress.isEmpty() && !ipAddress.contains(':')) {
+        entry.ipAddress = ipAddress;
+    }
+    if (replyMs <= entry.lastReplyMs && entry.deadlineTick >= 0) {
+        return entry.active; // دليل أقدم مما نعرفه
+    }
+
+    entry.lastReplyMs = std::max(entry.lastReplyMs, replyMs);
+    if (age < m_probeAfterMs) {
+        // رد حديث واحد يكفي لإعادة الجهاز متصلاً؛ الهبوط وحده يحتاج عدة إخفاقات
+        entry.misses = 0;
+        entry.active = true;
+    }
+
+    qint64 delay = m_probeAfterMs - (nowMs() - entry.lastReplyMs);
+    qint64 newDeadline = (nowMs() + std::max<qint64>(delay, 0)) / kTickMs + 1;
+    if (entry.deadlineTick < 0 || std::abs(newDeadline - entry.deadlineTick) >= kRescheduleSlackTicks) {
+        schedule(id, std::max<qint64>(delay, 0));
+    }
+    return entry.active;
+}
+
+void LivenessTracker::forget(const QString &macAddress) {
+    auto it = m_index.find(macAddress);
+    if (it == m_index.end()) {
+        return;
+    }
+    int id = it.value();
+    m_index.erase(it);
+
+    // المراجع المتبقية في العجلة وطابور الفحص تُتجاهل لأن الموعد أصبح -1
+    m_entries[id].deadlineTick = -1;
+    m_entries[id].queued = false;
+    m_entries[id].macAddress.clear();
+    m_freeEntries.push_back(id);
+}
+
+void LivenessTracker::schedule(int id, qint64 delayMs) {
+    Entry &entry = m_entries[id];
+    entry.deadlineTick = (nowMs() + delayMs) / kTickMs + 1;
+    m_wheel[entry.deadlineTick % kWheelSlots].push_back(id);
+}
+
+void LivenessTracker::onTick() {
+    qint64 targetTick = nowMs() / kTickMs;
+    int newlyDue = 0;
+
+    // إذا تأخرت الحلقة الرئيسية نعالج كل الخانات الفائتة
+    while (m_currentTick < targetTick) {
+        ++m_currentTick;
+        // نفرغ الخانة أولاً لأن إعادة الجدولة قد تضيف إليها أثناء المعالجة
+        std::vector<int> current;
+        current.swap(m_wheel[m_currentTick % kWheelSlots]);
+
+        for (int id : current) {
+            Entry &entry = m_entries[id];
+            if (entry.macAddress.isEmpty() || entry.deadlineTick < 0) {
+                continue; // محذوف أو عولج عبر مرجع آخر
+            }
+            if (entry.deadlineTick > m_currentTick) {
+                if (entry.deadlineTick % kWheelSlots == m_currentTick % kWheelSlots) {
+                    m_wheel[m_currentTick % kWheelSlots].push_back(id); // دورة لاحقة من العجلة
+                }
+                continue;
+            }
+            if (entry.deadlineTick < m_currentTick) {
+                continue; // مرجع قديم بعد إعادة الجدولة
+            }
+
+            entry.deadlineTick = -1;
+
+            // بدون فحوصات (مثلاً بسبب الميزانية) يسقط الجهاز بعد مهلة صمت أطول
+            qint64 silence = nowMs() - entry.lastReplyMs;
+            bool expired = silence > m_probeAfterMs + 2LL * m_missesBeforeInactive * m_probeIntervalMs;
+
+            if (entry.active && (entry.misses >= m_missesBeforeInactive || expired)) {
+                entry.active = false;
+                emit livenessChanged(entry.macAddress, false);
+            }
+
+            if (!entry.active && entry.misses >= m_missesBeforeInactive + kInactiveProbeLimit) {
+                continue; // نتوقف عن الفحص؛ أي ظهور جديد سيعيده
+            }
+
+            if (!entry.queued && !entry.ipAddress.isEmpty()) {
+                entry.queued = true;
+                m_due.push_back(id);
+                ++newlyDue;
+            }
+
+            // موعد مراجعة حتى لو بقي الفحص في الطابور دون إرسال
+            schedule(id, entry.active ? m_probeIntervalMs : kInactiveProbeIntervalMs);
+        }
+    }
+
+    if (newlyDue > 0) {
+        emit probesDue(static_cast<int>(m_due.size()));
+    }
+}
+
+std::vector<LivenessTracker::Probe> LivenessTracker::takeDueProbes(int limit) {
+    std::vector<Probe> probes;
+    qint64 now = nowMs();
+
+    while (!m_due.empty() && static_cast<int>(probes.size()) < limit) {
+        int id = m_due.front();
+        m_due.pop_front();
+        Entry &entry = m_entries[id];
+        if (!entry.queued || entry.macAddress.isEmpty()) {
+            continue;
+        }
+        entry.queued = false;
+
+        // وصل رد أثناء الانتظار في الطابور
+        if (now - entry.lastReplyMs < m_probeAfterMs) {
+            schedule(id, m_probeAfterMs - (now - entry.lastReplyMs));
+            continue;
+        }
+
+        ++entry.misses;
+        schedule(id, entry.active ? m_probeIntervalMs : kInactiveProbeIntervalMs);
+        probes.push_back({entry.macAddress, entry.ipAddress});
+    }
+
+    return probes;
+}
@@ -0,0 +1,82 @@
+#ifndef LIVENESSTRACKER_H
+#define LIVENESSTRACKER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QHash>
+#include <deque>
+#include <vector>
+
+// تتبع بقاء الأجهزة المعروفة: آخر رد لكل جهاز، وفحص موجه فقط للأجهزة
+// القريبة من انتهاء مهلتها. كل المواعيد في عجلة توقيت واحدة (tick كل ثانية)
+// بدلاً من QTimer لكل جهاز، فتكلفة كل tick تتناسب مع الأجهزة المستحقة فقط.
+class LivenessTracker : public QObject {
+    Q_OBJECT
+
+public:
+    struct Probe {
+        QString macAddress;
+        QString ipAddress;
+    };
+
+    explicit LivenessTracker(QObject *parent = nullptr);
+
+    void start();
+    void stop();
+
+    // probeAfterMs: مدة الصمت قبل أول فحص، probeIntervalMs: بين الفحوصات المتتالية،
+    // missesBeforeInactive: عدد الفحوصات الفاشلة المتتالية قبل اعتبار الجهاز غير متصل
+    void setTimeouts(int probeAfterMs, int probeIntervalMs, int missesBeforeInactive);
+
+    // أي دليل على أن الجهاز حي (رد ARP، عقد DHCP، تأكيد من النواة...).
+    // يعيد حالة الجهاز بعد تطبيق الدليل.
+    bool noteReply(const QString &macAddress, const QString &ipAddress, const QDateTime &when);
+    void forget(const QString &macAddress);
+
+    // سحب الفحوصات المستحقة؛ كل فحص مسحوب يُحسب محاولة حتى يصل رد
+    std::vector<Probe> takeDueProbes(int limit);
+    int dueCount() const { return static_cast<int>(m_due.size()); }
+    int trackedCount() const { return m_index.size(); }
+
+signals:
+    void probesDue(int count);
+    void livenessChanged(const QString &macAddress, bool isActive);
+
+private slots:
+    void onTick();
+
+private:
+    struct Entry {
+        QString macAddress;
+        QString ipAddress;
+        qint64 lastReplyMs = 0;
+        qint64 deadlineTick = -1; // -1 = غير مجدول
+        int misses = 0;
+        bool active = false;
+        bool queued = false;
+    };
+
+    static constexpr int kWheelSlots = 64;
+    static constexpr int kTickMs = 1000;
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_currentTick = 0;
+
+    std::vector<Entry> m_entries;
+    std::vector<int> m_freeEntries;
+    QHash<QString, int> m_index;
+    std::vector<std::vector<int>> m_wheel;
+    std::deque<int> m_due;
+
+    int m_probeAfterMs = 30000;
+    int m_probeIntervalMs = 5000;
+    int m_missesBeforeInactive = 3;
+
+    qint64 nowMs() const { return m_clock.elapsed(); }
+    void schedule(int id, qint64 delayMs);
+};
+
+#endif // LIVENESSTRACKER_H
@@ -1,24 +1,230 @@
 #include <QApplication>
+#include <QCoreApplication>
 #include <QStyleFactory>
 #include <QMessageBox>
+#include <QHostInfo>
+#include <QDebug>
+#include <cstdio>
+#include <cstring>
+#include <memory>
 #include <unistd.h>
 #include "mainwindow.h"
+#include "profiler.h"
+#include "wifimanager.h"
+#include "networkstats.h"
+#include "updatebus.h"
+#include "fleetagent.h"
+#include "fleetaggregator.h"
+#include "arpguard.h"
+#include "appconfig.h"
+#include "controlserver.h"
+#include "privilegedhelper.h"
+
+namespace {
+
+struct HeadlessOptions {
+    bool headless = false;
+    QString collectorHost;       // --collector host:port
+    quint16 collectorPort = 9106;
+    QString apId;                // --ap-id
+    bool aggregator = false;     // --aggregator [port]
+    quint16 aggregatorPort = 9106;
+    QHostAddress aggregatorAddress = QHostAddress::LocalHost; // --listen address
+    QString replayArp;           // --replay-arp capture.pcap
+    QString gateway;             // --gateway ip (مع --replay-arp)
+};
+
+// تُقرأ الوسائط قبل إنشاء التطبيق لاختيار QCoreApplication في الوضع بلا واجهة
+HeadlessOptions parseHeadlessOptions(int argc, char *argv[]) {
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        QString next = i + 1 < argc ? QString::fromLocal8Bit(argv[i + 1]) : QString();
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--collector" && !next.isEmpty()) {
+            int colon = next.lastIndexOf(':');
+            options.collectorHost = colon > 0 ? next.left(colon) : next;
+            if (colon > 0) {
+                options.collectorPort = next.mid(colon + 1).toUShort();
+            }
+            ++i;
+        } else if (arg == "--ap-id" && !next.isEmpty()) {
+            options.apId = next;
+            ++i;
+        } else if (arg == "--aggregator") {
+            options.aggregator = true;
+            bool ok = false;
+            quint16 port = next.toUShort(&ok);
+            if (ok) {
+                options.aggregatorPort = port;
+                ++i;
+            }
+        } else if (arg == "--listen" && !next.isEmpty()) {
+            options.aggregatorAddress = QHostAddress(next);
+            ++i;
+        } else if (arg == "--replay-arp" && !next.isEmpty()) {
+            // فحص التقاط مسجل لا يحتاج واجهة ولا صلاحيات
+            options.headless = true;
+            options.replayArp = next;
+            ++i;
+        } else if (arg == "--gateway" && !next.isEmpty()) {
+            options.gateway = next;
+            ++i;
+        }
+    }
+    return options;
+}
+
+// إعادة تشغيل التقاط ARP عبر كاشف الانتحال؛ رمز الخروج 2 عند وجود تنبيهات
+int replayArpCapture(const HeadlessOptions &options) {
+    ArpGuard guard;
+    if (!options.gateway.isEmpty()) {
+        guard.watchAddress(options.gateway, QString(), "البوابة");
+    }
+    int alerts = 0;
+    QObject::connect(&guard, &ArpGuard::alertRaised, [&alerts](const TrafficAlert &alert) {
+        ++alerts;
+        std::printf("%s\t%s\t%s\n", qPrintable(alert.when.toString(Qt::ISODateWithMs)),
+                    qPrintable(alert.macAddress), qPrintable(alert.message));
+    });
+
+    QString error;
+    int frames = guard.replayCapture(options.replayArp, &error);
+    if (frames < 0) {
+        std::fprintf(stderr, "تعذر قراءة %s: %s\n", qPrintable(options.replayArp), qPrintable(error));
+        return 1;
+    }
+    std::fprintf(stderr, "%d ARP frames, %d alerts\n", frames, alerts);
+    return alerts > 0 ? 2 : 0;
+}
+
+int runHeadless(QCoreApplication &app, const HeadlessOptions &options) {
+    if (!options.replayArp.isEmpty()) {
+        return replayArpCapture(options);
+    }
+    if (options.collectorHost.isEmpty() && !options.aggregator) {
+        std::fprintf(stderr, "--headless يتطلب --collector host:port أو --aggregator [port]\n");
+        return 1;
+    }
+
+    // الرمز المشترك بين المجمّع والجامعين من البيئة حتى لا يظهر في قائمة العمليات
+    const QString fleetToken = qEnvironmentVariable("WIFIMANAGER_FLEET_TOKEN");
+
+    std::unique_ptr<FleetAggregator> aggregator;
+    if (options.aggregator) {
+        if (options.aggregatorAddress.isNull()) {
+            std::fprintf(stderr, "عنوان --listen غير صالح\n");
+            return 1;
+        }
+        aggregator = std::make_unique<FleetAggregator>();
+        aggregator->setToken(fleetToken);
+        if (!aggregator->listen(options.aggregatorAddress, options.aggregatorPort)) {
+            if (fleetToken.isEmpty() && !options.aggregatorAddress.isLoopback()) {
+                std::fprintf(stderr, "الاستماع على عنوان غير محلي يتطلب WIFIMANAGER_FLEET_TOKEN\n");
+            }
+            return 1;
+        }
+        QObject::connect(aggregator.get(), &FleetAggregator::accessPointChanged,
+                         [](const QString &id, bool connected) {
+            qInfo() << "Fleet: access point" << id << (connected ? "connected" : "disconnected");
+        });
+        QObject::connect(aggregator.get(), &FleetAggregator::deviceRoamed,
+                         [](const QString &mac, const QString &from, const QString &to, const QDateTime &when) {
+            qInfo() << "Fleet: roam" << mac << from << "->" << to << when.toString(Qt::ISODate);
+        });
+        qInfo() << "Fleet aggregator listening on" << options.aggregatorAddress.toString() << aggregator->port();
+    }
+
+    // الجامع يحتاج صلاحيات الجذر للمسح والجدار الناري، المجمّع لا يحتاجها
+    std::unique_ptr<UpdateBus> bus;
+    std::unique_ptr<WifiManager> wifiManager;
+    std::unique_ptr<NetworkStatsManager> statsManager;
+    std::unique_ptr<FleetAgent> agent;
+    std::unique_ptr<ConfigManager> config;
+    std::unique_ptr<ControlServer> controlServer;
+    if (!options.collectorHost.isEmpty()) {
+        if (geteuid() != 0 && !PrivilegedHelper::connectTo()) {
+            std::fprintf(stderr, "وضع الجامع يتطلب صلاحيات الجذر (root) أو المساعد wifimanager-helper.\n");
+            return 1;
+        }
+        bus = std::make_unique<UpdateBus>();
+        bus->setMinimumInterval(1000); // لا شاشة هنا؛ الوكيل يجمع على ثانية أصلاً
+        wifiManager = std::make_unique<WifiManager>();
+        statsManager = std::make_unique<NetworkStatsManager>();
+        wifiManager->setUpdateBus(bus.get());
+        statsManager->setUpdateBus(bus.get());
+
+        agent = std::make_unique<FleetAgent>();
+        agent->setUpdateBus(bus.get());
+        agent->setToken(fleetToken);
+
+        // نفس ملف الإعدادات وإعادة التحميل الحية كما في الواجهة
+        // واجهة التحكم عن بعد تغني عن الوصول للشاشة على نقاط الوصول
+        controlServer = std::make_unique<ControlServer>(wifiManager.get());
+        controlServer->setUpdateBus(bus.get());
+        QObject::connect(controlServer.get(), &ControlServer::actionPerformed,
+                         [](const QString &description, bool success) {
+            qInfo() << "API:" << description << (success ? "ok" : "failed");
+        });
+
+        config = std::make_unique<ConfigManager>();
+        auto apply = [&wifiManager, &statsManager, &controlServer](const AppConfig &current) {
+            wifiManager->applyConfig(current);
+            statsManager->setUpdateInterval(current.statsIntervalMs);
+            controlServer->applyConfig(current);
+        };
+        QObject::connect(config.get(), &ConfigManager::errorOccurred,
+                         [](const QString &error) { qWarning() << "Config:" << error; });
+        QObject::connect(config.get(), &ConfigManager::configChanged, apply);
+        config->load();
+        apply(config->config());
+
+        wifiManager->loadDeviceCache();
+        wifiManager->startMonitoring();
+        statsManager->startMonitoring();
+
+        QString apId = options.apId.isEmpty() ? QHostInfo::localHostName() : options.apId;
+        agent->start(options.collectorHost, options.collectorPort, apId,
+                     wifiManager->getCurrentNetwork().interface);
+        qInfo() << "Fleet collector" << apId << "reporting to"
+                << options.collectorHost << options.collectorPort;
+    }
+
+    return app.exec();
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    HeadlessOptions headless = parseHeadlessOptions(argc, argv);
+    if (headless.headless) {
+        QCoreApplication app(argc, argv);
+        if (qEnvironmentVariableIntValue("WIFIMANAGER_PROFILE") > 0) {
+            Profiler::setEnabled(true);
+        }
+        return runHeadless(app, headless);
+    }
+
     QApplication app(argc, argv);
     
     // تعيين النمط
     app.setStyle(QStyleFactory::create("Fusion"));
     
-    // التحقق من صلاحيات المستخدم الجذر
-    if (geteuid() != 0) {
+    // التحقق من صلاحيات المستخدم الجذر، أو وجود المساعد المميز الذي ينفذ عنا
+    if (geteuid() != 0 && !PrivilegedHelper::connectTo()) {
         QMessageBox::critical(nullptr, "خطأ", 
-            "يتطلب هذا التطبيق صلاحيات المستخدم الجذر (root).\n"
-            "الرجاء تشغيل التطبيق باستخدام sudo.");
+            "يتطلب هذا التطبيق صلاحيات المستخدم الجذر (root) أو تشغيل wifimanager-helper.\n"
+            "الرجاء تشغيل المساعد أو تشغيل التطبيق باستخدام sudo.");
         return 1;
     }
     
+    // القياس معطل افتراضياً؛ يمكن تفعيله من لوحة الأداء أو من البداية بهذا المتغير
+    if (qEnvironmentVariableIntValue("WIFIMANAGER_PROFILE") > 0) {
+        Profiler::setEnabled(true);
+    }
+    
     // تعيين اللغة العربية
     app.setLayoutDirection(Qt::RightToLeft);
     
@@ -1,4 +1,7 @@
 #include "mainwindow.h"
+#include "profiler.h"
+#include "profilerdialog.h"
+#include "inventoryio.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QSplitter>
@@ -8,48 +11,205 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QLineEdit>
-#include <QTextEdit>
+#include <QListView>
+#include <QIdentityProxyModel>
+#include <QColor>
+#include <QScrollBar>
 #include <QMenuBar>
 #include <QMenu>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QApplication>
 #include <QInputDialog>
 #include <QProgressBar>
 #include <QTimer>
+#include <QEvent>
+#include <QScreen>
+#include <QDebug>
 #include <QtCharts/QChart>
 #include <QtCharts/QChartView>
 #include <QtCharts/QPieSeries>
 #include <QtCharts/QPieSlice>
+#include <algorithm>
 
 QT_CHARTS_USE_NAMESPACE
 
+namespace {
+
+// ألوان سجل الأحداث من مستوى الحدث الذي يعيده النموذج
+class EventLogColors : public QIdentityProxyModel {
+public:
+    using QIdentityProxyModel::QIdentityProxyModel;
+
+    QVariant data(const QModelIndex &index, int role) const override {
+        if (role != Qt::ForegroundRole) {
+            return QIdentityProxyModel::data(index, role);
+        }
+        switch (QIdentityProxyModel::data(index, EventLogModel::LevelRole).toInt()) {
+        case LogEvent::Error:
+            return QColor(Qt::red);
+        case LogEvent::Warning:
+            return QColor(230, 126, 34);
+        default:
+            return QVariant();
+        }
+    }
+};
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), 
+      m_config(std::make_unique<ConfigManager>(this)),
+      m_updateBus(std::make_unique<UpdateBus>(this)),
       m_wifiManager(std::make_unique<WifiManager>(this)),
-      m_statsManager(std::make_unique<NetworkStatsManager>(this))
+      m_statsManager(std::make_unique<NetworkStatsManager>(this)),
+      m_metricsExporter(std::make_unique<MetricsExporter>(this)),
+      m_controlServer(std::make_unique<ControlServer>(m_wifiManager.get(), this)),
+      m_eventLog(std::make_unique<EventLogModel>(this)),
+      m_networkTimer(std::make_unique<QTimer>(this))
 {
+    QString eventLogFile = qEnvironmentVariable("WIFIMANAGER_EVENT_LOG");
+    if (!eventLogFile.isEmpty()) {
+        m_eventLog->setLogFile(eventLogFile);
+    }
+    
     setupUi();
     
+    // الأجهزة والإحصائيات تصل كلقطات عبر الناقل، بإشعار واحد لكل إطار على الأكثر
+    m_wifiManager->setUpdateBus(m_updateBus.get());
+    m_statsManager->setUpdateBus(m_updateBus.get());
+    connect(m_updateBus.get(), &UpdateBus::updated, this, &MainWindow::onBusUpdated);
+    
+    // الإعدادات قبل أي مؤقت؛ التعديلات اللاحقة على الملف تُطبق دون إعادة تشغيل
+    connect(m_config.get(), &ConfigManager::errorOccurred,
+            [this](const QString &error) { showMessage(error, true, "config"); });
+    connect(m_config.get(), &ConfigManager::configChanged, this, [this](const AppConfig &config) {
+        applyConfig(config);
+        showMessage(QString("أعيد تحميل الإعدادات من %1").arg(m_config->path()), false, "config");
+    });
+    m_config->load();
+    applyConfig(m_config->config());
+    
     // توصيل الإشارات
-    connect(m_wifiManager.get(), &WifiManager::devicesUpdated, 
-            this, &MainWindow::onDevicesUpdated);
     connect(m_wifiManager.get(), &WifiManager::errorOccurred,
             [this](const QString &error) { showMessage(error, true); });
+    connect(m_wifiManager.get(), &WifiManager::servicesRestarted, this, [this](bool success, qint64 elapsedMs) {
+        if (success) {
+            showMessage(QString("خدمات الشبكة جاهزة بعد %1 ث").arg(elapsedMs / 1000.0, 0, 'f', 1), false, "services");
+        } else {
+            showMessage("لم تكتمل إعادة تشغيل بعض خدمات الشبكة", true, "services");
+        }
+    });
     
-    connect(m_statsManager.get(), &NetworkStatsManager::statsUpdated,
-            this, &MainWindow::onStatsUpdated);
+    // الانقطاعات القصيرة لا تظهر في الجدول؛ نسجلها في السجل مجمعة لكل جهاز
+    connect(m_wifiManager->associationTracker(), &AssociationTracker::stationDisconnected, this,
+            [this](const QString &mac, quint16 reasonCode, qint64) {
+        showMessage(QString("انفصل الجهاز %1 (%2)").arg(mac, AssociationTracker::reasonText(reasonCode)),
+                    false, "assoc-" + mac);
+    });
+    
+    // تنبيهات الحركة الشاذة: مفتاح لكل نوع وجهاز حتى تتجمع التكرارات في سطر واحد
+    connect(m_wifiManager.get(), &WifiManager::trafficAlert, this, [this](const TrafficAlert &alert) {
+        m_eventLog->append(LogEvent::Warning, alert.message,
+                           QString("anomaly-%1-%2").arg(int(alert.kind)).arg(alert.macAddress));
+    });
+    
+    // نقطة مقاييس Prometheus على localhost:9105
+    m_metricsExporter->setUpdateBus(m_updateBus.get());
+    connect(m_updateBus.get(), &UpdateBus::updated, m_metricsExporter.get(), [this](quint32 topics) {
+        if (topics & UpdateBus::Stats) {
+            m_metricsExporter->updateScanCounters(m_wifiManager->scanCounters());
+        }
+    });
+    m_metricsExporter->listen();
+    
+    // واجهة التحكم عن بعد؛ العنوان والمنفذ والرمز من الإعدادات (api)
+    m_controlServer->setUpdateBus(m_updateBus.get());
+    connect(m_controlServer.get(), &ControlServer::actionPerformed, this,
+            [this](const QString &description, bool success) { showMessage(description, !success, "api"); });
     
-    // فحص متطلبات النظام
-    checkSystemRequirements();
+    // عرض آخر قائمة محفوظة فوراً؛ كل ما يشغل عمليات خارجية يبدأ بعد أول إطار
+    if (m_wifiManager->loadDeviceCache()) {
+        showMessage("عرض آخر قائمة أجهزة محفوظة حتى اكتمال المسح");
+    }
+}
+
+bool MainWindow::event(QEvent *event) {
+    bool handled = QMainWindow::event(event);
+    
+    if (event->type() == QEvent::Paint && !m_startupFinished) {
+        m_startupFinished = true;
+        // الزمن من تحميل البرنامج حتى رسم أول إطار
+        qint64 firstFrameNs = Profiler::nowNs();
+        Profiler::record(Profiler::StartupFirstFrame, 0, firstFrameNs);
+        m_metricsExporter->updateStartupTime(firstFrameNs / 1000000);
+        // حد الإشعارات = إطار واحد بمعدل تحديث الشاشة الفعلي
+        if (screen() && screen()->refreshRate() > 0) {
+            m_updateBus->setMinimumInterval(qRound(1000.0 / screen()->refreshRate()));
+        }
+        QTimer::singleShot(0, this, &MainWindow::startBackgroundWork);
+    }
+    
+    return handled;
+}
+
+void MainWindow::changeEvent(QEvent *event) {
+    QMainWindow::changeEvent(event);
+    
+    // عند الاستعادة من التصغير نعرض أحدث لقطة فقط
+    if (event->type() == QEvent::WindowStateChange && !isMinimized()) {
+        onBusUpdated(UpdateBus::Devices | UpdateBus::Stats);
+    }
+}
+
+void MainWindow::onBusUpdated(quint32 topics) {
+    // لا رسم أثناء التصغير؛ الإصدارات غير المعروضة تُسحب عند الاستعادة
+    if (isMinimized()) {
+        return;
+    }
+    
+    if (topics & UpdateBus::Devices) {
+        UpdateBus::DeviceSnapshot devices = m_updateBus->devices();
+        if (devices.data && devices.version != m_shownDevicesVersion) {
+            m_shownDevicesVersion = devices.version;
+            onDevicesUpdated(*devices.data);
+        }
+    }
+    
+    if (topics & UpdateBus::Stats) {
+        UpdateBus::StatsSnapshot stats = m_updateBus->stats();
+        if (stats.data && stats.version != m_shownStatsVersion) {
+            m_shownStatsVersion = stats.version;
+            onStatsUpdated(*stats.data);
+        }
+    }
+}
+
+void MainWindow::startBackgroundWork() {
+    // فحص الأدوات بدون نافذة منبثقة ولا انتظار؛ الفحص التفاعلي متاح من القائمة
+    connect(m_wifiManager.get(), &WifiManager::toolsChecked, this, [this](const QStringList &missing) {
+        if (!missing.isEmpty()) {
+            m_eventLog->append(LogEvent::Warning,
+                               QString("أدوات مفقودة: %1 (أدوات > فحص المتطلبات للتفاصيل)").arg(missing.join(", ")));
+        }
+    });
     
     // بدء المراقبة
     m_wifiManager->startMonitoring();
     m_statsManager->startMonitoring();
     updateNetworkInfo();
     
-    // تحديث معلومات الشبكة كل 10 ثواني
-    QTimer *networkTimer = new QTimer(this);
-    connect(networkTimer, &QTimer::timeout, this, &MainWindow::updateNetworkInfo);
-    networkTimer->start(10000);
+    // تحديث معلومات الشبكة دورياً (networkInfoMs في الإعدادات)
+    connect(m_networkTimer.get(), &QTimer::timeout, this, &MainWindow::updateNetworkInfo);
+    m_networkTimer->start();
+}
+
+void MainWindow::applyConfig(const AppConfig &config) {
+    m_wifiManager->applyConfig(config);
+    m_statsManager->setUpdateInterval(config.statsIntervalMs);
+    m_networkTimer->setInterval(config.networkInfoIntervalMs);
+    m_controlServer->applyConfig(config);
 }
 
 MainWindow::~MainWindow() = default;
@@ -122,6 +282,7 @@ void MainWindow::setupUi() {
         << "الشركة المصنعة" << "آخر ظهور" << "الحالة");
     m_deviceTable->horizontalHeader()->setStretchLastSection(true);
     m_deviceTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_deviceTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_deviceTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     m_deviceTable->setSortingEnabled(true);
     m_deviceTable->setAlternatingRowColors(true);
@@ -143,10 +304,26 @@ void MainWindow::setupUi() {
     QGroupBox *logBox = new QGroupBox("سجل الأحداث", this);
     QVBoxLayout *logLayout = new QVBoxLayout(logBox);
     
-    m_logWidget = new QTextEdit(this);
-    m_logWidget->setReadOnly(true);
+    m_logWidget = new QListView(this);
+    EventLogColors *logColors = new EventLogColors(m_logWidget);
+    logColors->setSourceModel(m_eventLog.get());
+    m_logWidget->setModel(logColors);
+    m_logWidget->setUniformItemSizes(true);
+    m_logWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_logWidget->setMaximumHeight(120);
     
+    // التمرير التلقائي فقط إذا كان المستخدم في آخر السجل
+    connect(m_eventLog.get(), &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *bar = m_logWidget->verticalScrollBar();
+        m_logFollowTail = bar->value() >= bar->maximum();
+    });
+    connect(m_eventLog.get(), &EventLogModel::eventsAppended, this, [this]() {
+        if (m_logFollowTail) {
+            m_logWidget->scrollToBottom();
+        }
+    });
+    
     logLayout->addWidget(m_logWidget);
     
     // إضافة جميع العناصر للتخطيط الرئيسي
@@ -163,7 +340,8 @@ void MainWindow::setupUi() {
     connect(changePasswordBtn, &QPushButton::clicked, this, &MainWindow::onChangePasswordClicked);
     connect(restartBtn, &QPushButton::clicked, this, &MainWindow::onRestartRouterClicked);
     connect(requirementsBtn, &QPushButton::clicked, this, &MainWindow::checkSystemRequirements);
-    connect(m_deviceTable, &QTableWidget::cellClicked, this, &MainWindow::showDeviceDetails);
+    // نقرة واحدة للتحديد (مع Ctrl/Shift لعدة أجهزة) ونقرتان للتفاصيل
+    connect(m_deviceTable, &QTableWidget::cellDoubleClicked, this, &MainWindow::showDeviceDetails);
     
     createMenuBar();
 }
@@ -194,6 +372,11 @@ void MainWindow::createMenuBar() {
     
     // قائمة ملف
     QMenu *fileMenu = menuBar->addMenu("ملف");
+    QAction *exportAction = fileMenu->addAction("تصدير الأجهزة وتاريخ الحركة...");
+    QAction *importAction = fileMenu->addAction("استيراد الأجهزة وتاريخ الحركة...");
+    fileMenu->addSeparator();
+    connect(exportAction, &QAction::triggered, this, &MainWindow::onExportClicked);
+    connect(importAction, &QAction::triggered, this, &MainWindow::onImportClicked);
     QAction *exitAction = fileMenu->addAction("خروج");
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
     
@@ -201,9 +384,18 @@ void MainWindow::createMenuBar() {
     QMenu *toolsMenu = menuBar->addMenu("أدوات");
     QAction *scanAction = toolsMenu->addAction("فحص الشبكة");
     QAction *requirementsAction = toolsMenu->addAction("فحص المتطلبات");
+    QAction *profilerAction = toolsMenu->addAction("لوحة الأداء");
     
     connect(scanAction, &QAction::triggered, this, &MainWindow::onRefreshClicked);
     connect(requirementsAction, &QAction::triggered, this, &MainWindow::checkSystemRequirements);
+    connect(profilerAction, &QAction::triggered, this, [this]() {
+        if (!m_profilerDialog) {
+            m_profilerDialog = new ProfilerDialog(this);
+        }
+        m_profilerDialog->show();
+        m_profilerDialog->raise();
+        m_profilerDialog->activateWindow();
+    });
     
     // قائمة مساعدة
     QMenu *helpMenu = menuBar->addMenu("مساعدة");
@@ -217,6 +409,53 @@ void MainWindow::createMenuBar() {
     });
 }
 
+void MainWindow::onExportClicked() {
+    QString path = QFileDialog::getSaveFileName(this, "تصدير الأجهزة وتاريخ الحركة", "wifimanager-inventory.wmc",
+                                                "ملف عمودي (*.wmc);;JSON Lines (*.jsonl);;CSV (*.csv)");
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    // القائمة من آخر لقطة منشورة، والتاريخ يُقرأ من القرص كتلة كتلة
+    UpdateBus::DeviceSnapshot snapshot = m_updateBus->devices();
+    static const std::vector<Device> noDevices;
+    TrafficHistory *history = m_wifiManager->trafficHistory();
+    history->flush();
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QString error;
+    bool ok = InventoryIO::exportInventory(snapshot.data ? *snapshot.data : noDevices, history->files(),
+                                           path, InventoryIO::formatForPath(path), &error);
+    QApplication::restoreOverrideCursor();
+    
+    if (ok) {
+        showMessage(QString("تم التصدير إلى %1").arg(path));
+    } else {
+        showMessage(QString("فشل التصدير: %1").arg(error), true);
+    }
+}
+
+void MainWindow::onImportClicked() {
+    QString path = QFileDialog::getOpenFileName(this, "استيراد الأجهزة وتاريخ الحركة", QString(),
+                                                "كل الصيغ المدعومة (*.wmc *.jsonl *.csv)");
+    if (path.isEmpty()) {
+        return;
+    }
+    
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    std::vector<Device> devices;
+    qint64 samples = 0;
+    QString error;
+    bool ok = InventoryIO::importInventory(path, &devices, m_wifiManager->trafficHistory(), &samples, &error);
+    m_wifiManager->importDevices(devices);
+    QApplication::restoreOverrideCursor();
+    
+    showMessage(QString("تم استيراد %1 جهاز و %2 عينة حركة").arg(devices.size()).arg(samples));
+    if (!ok || !error.isEmpty()) {
+        showMessage(QString("الاستيراد: %1").arg(error), !ok);
+    }
+}
+
 void MainWindow::checkSystemRequirements() {
     QStringList missing = m_wifiManager->getMissingTools();
     
@@ -237,34 +476,114 @@ void MainWindow::checkSystemRequirements() {
 
 void MainWindow::onDevicesUpdated(const std::vector<Device> &devices) {
     updateDeviceTable(devices);
-    m_devicesCountLabel->setText(QString("الأجهزة المتصلة: %1").arg(devices.size()));
-    showMessage(QString("تم العثور على %1 جهاز متصل").arg(devices.size()));
+    
+    // الأجهزة الغائبة تبقى في الجدول كغير متصلة ولا تُحسب هنا
+    int activeCount = std::count_if(devices.begin(), devices.end(),
+                                    [](const Device &device) { return device.isActive; });
+    m_devicesCountLabel->setText(QString("الأجهزة المتصلة: %1").arg(activeCount));
+    // يتكرر مع كل دورة مسح، فيُدمج في سطر واحد يُحدّث في مكانه
+    showMessage(QString("تم العثور على %1 جهاز متصل").arg(devices.size()), false, "devices-found");
 }
 
 void MainWindow::updateDeviceTable(const std::vector<Device> &devices) {
-    m_deviceTable->setRowCount(devices.size());
+    PROFILE_SCOPE(UpdateDeviceTable);
     
-    for (size_t i = 0; i < devices.size(); ++i) {
-        const Device &device = devices[i];
+    // تحديث الصفوف في مكانها حسب MAC بدلاً من إعادة بناء الجدول، فيبقى
+    // التحديد والتمرير كما هما. الترتيب يُوقف مؤقتاً حتى لا تتحرك الصفوف أثناء الكتابة
+    bool sorting = m_deviceTable->isSortingEnabled();
+    m_deviceTable->setSortingEnabled(false);
+    
+    QHash<QString, int> rows;
+    for (int row = 0; row < m_deviceTable->rowCount(); ++row) {
+        if (QTableWidgetItem *item = m_deviceTable->item(row, 1)) {
+            rows.insert(item->data(Qt::UserRole).toString(), row);
+        }
+    }
+    
+    std::vector<bool> used(m_deviceTable->rowCount(), false);
+    bool added = false;
+    for (const Device &device : devices) {
+        QString key = device.macAddress.isEmpty() ? device.ipAddress : device.macAddress;
+        int row = rows.value(key, -1);
+        if (row < 0) {
+            row = m_deviceTable->rowCount();
+            m_deviceTable->insertRow(row);
+            used.push_back(false);
+            added = true;
+        }
+        used[row] = true;
         
-        m_deviceTable->setItem(i, 0, new QTableWidgetItem(device.ipAddress));
-        m_deviceTable->setItem(i, 1, new QTableWidgetItem(device.macAddress));
-        m_deviceTable->setItem(i, 2, new QTableWidgetItem(device.hostname.isEmpty() ? "غير معروف" : device.hostname));
-        m_deviceTable->setItem(i, 3, new QTableWidgetItem(device.manufacturer));
-        m_deviceTable->setItem(i, 4, new QTableWidgetItem(device.lastSeen.toString("yyyy-MM-dd hh:mm:ss")));
+        // الأجهزة التي تعمل بـ IPv6 فقط تُعرض بأول عنوان IPv6 لها
+        QString primaryAddress = device.ipAddress;
+        if (primaryAddress.isEmpty() && !device.ipv6Addresses.isEmpty()) {
+            primaryAddress = device.ipv6Addresses.first();
+        }
+        setTableCell(row, 0, primaryAddress)->setToolTip((device.ipv4Addresses + device.ipv6Addresses).join("\n"));
+        setTableCell(row, 1, device.macAddress)->setData(Qt::UserRole, key);
+        setTableCell(row, 2, device.hostname.isEmpty() ? "غير معروف" : device.hostname);
+        // النوع بعد الصانع حين يُعرف: "Apple — هاتف"
+        DeviceFingerprint::Type type = DeviceFingerprint::typeFromKey(device.deviceType);
+        setTableCell(row, 3, type == DeviceFingerprint::Unknown
+                                 ? device.manufacturer
+                                 : QString("%1 — %2").arg(device.manufacturer, DeviceFingerprint::typeLabel(type)));
+        setTableCell(row, 4, device.lastSeen.toString("yyyy-MM-dd hh:mm:ss"));
         
-        QTableWidgetItem *statusItem = new QTableWidgetItem(device.isActive ? "متصل" : "غير متصل");
-        if (device.isActive) {
+        QTableWidgetItem *statusItem;
+        if (device.isBlocked) {
+            statusItem = setTableCell(row, 5, "محظور");
+            statusItem->setBackground(QBrush(QColor(52, 73, 94, 100)));
+            statusItem->setForeground(QBrush(QColor(44, 62, 80)));
+        } else if (device.isActive && device.weakLink) {
+            statusItem = setTableCell(row, 5, "متصل (رابط ضعيف)");
+            statusItem->setBackground(QBrush(QColor(241, 196, 15, 100)));
+            statusItem->setForeground(QBrush(QColor(183, 149, 11)));
+        } else if (device.isActive) {
+            statusItem = setTableCell(row, 5, "متصل");
             statusItem->setBackground(QBrush(QColor(46, 204, 113, 100)));
             statusItem->setForeground(QBrush(QColor(39, 174, 96)));
         } else {
+            statusItem = setTableCell(row, 5, "غير متصل");
             statusItem->setBackground(QBrush(QColor(231, 76, 60, 100)));
             statusItem->setForeground(QBrush(QColor(192, 57, 43)));
         }
-        m_deviceTable->setItem(i, 5, statusItem);
+        statusItem->setToolTip(device.signalStrength != 0.0
+                               ? QString("الإشارة: %1 dBm").arg(device.signalStrength) : QString());
+    }
+    
+    // حذف الأجهزة التي خرجت من القائمة، من الأسفل حتى لا تتغير أرقام الصفوف الباقية
+    for (int row = static_cast<int>(used.size()) - 1; row >= 0; --row) {
+        if (!used[row]) {
+            m_deviceTable->removeRow(row);
+        }
     }
     
-    m_deviceTable->resizeColumnsToContents();
+    m_deviceTable->setSortingEnabled(sorting);
+    if (added) {
+        m_deviceTable->resizeColumnsToContents();
+    }
+}
+
+QTableWidgetItem *MainWindow::setTableCell(int row, int column, const QString &text) {
+    QTableWidgetItem *item = m_deviceTable->item(row, column);
+    if (!item) {
+        item = new QTableWidgetItem(text);
+        m_deviceTable->setItem(row, column, item);
+    } else if (item->text() != text) {
+        item->setText(text);
+    }
+    return item;
+}
+
+QStringList MainWindow::selectedDeviceMacs() const {
+    QStringList macs;
+    const QModelIndexList selected = m_deviceTable->selectionModel()->selectedRows(1);
+    for (const QModelIndex &index : selected) {
+        QString mac = index.data().toString();
+        if (!mac.isEmpty() && !macs.contains(mac)) {
+            macs.append(mac);
+        }
+    }
+    return macs;
 }
 
 void MainWindow::onStatsUpdated(const NetworkStats &stats) {
@@ -278,6 +597,7 @@ void MainWindow::onStatsUpdated(const NetworkStats &stats) {
 }
 
 void MainWindow::updateChart(const NetworkStats &stats) {
+    PROFILE_SCOPE(UpdateChart);
     m_pieSeries->clear();
     
     double downloadMB = stats.bytesReceived / (1024.0 * 1024.0);
@@ -297,44 +617,57 @@ void MainWindow::updateChart(const NetworkStats &stats) {
 }
 
 void MainWindow::onBlockDeviceClicked() {
-    int currentRow = m_deviceTable->currentRow();
-    if (currentRow < 0) {
+    QStringList macs = selectedDeviceMacs();
+    if (macs.isEmpty()) {
         QMessageBox::warning(this, "تحذير", "الرجاء اختيار جهاز أولاً");
         return;
     }
     
-    QString macAddress = m_deviceTable->item(currentRow, 1)->text();
-    QString deviceName = m_deviceTable->item(currentRow, 2)->text();
+    // تأكيد واحد لكل الأجهزة المحددة، مع عرض أول عشرة منها
+    QStringList names;
+    for (int row = 0; row < m_deviceTable->rowCount() && names.size() < 10; ++row) {
+        QTableWidgetItem *macItem = m_deviceTable->item(row, 1);
+        if (macItem && macs.contains(macItem->text())) {
+            QString name = m_deviceTable->item(row, 2)->text();
+            names.append(name == "غير معروف" ? macItem->text() : QString("%1 (%2)").arg(name, macItem->text()));
+        }
+    }
+    if (macs.size() > names.size()) {
+        names.append(QString("... و%1 أجهزة أخرى").arg(macs.size() - names.size()));
+    }
     
     int ret = QMessageBox::question(this, "تأكيد", 
-        QString("هل أنت متأكد من حظر الجهاز %1؟\n\n"
+        QString("هل أنت متأكد من حظر %1 جهاز؟\n\n%2\n\n"
                 "ملاحظة: يتطلب صلاحيات root")
-                .arg(deviceName.isEmpty() || deviceName == "غير معروف" ? macAddress : deviceName));
+                .arg(macs.size()).arg(names.join("\n")));
     
     if (ret == QMessageBox::Yes) {
-        if (m_wifiManager->blockDevice(macAddress)) {
-            showMessage(QString("تم حظر الجهاز %1").arg(macAddress));
-            onRefreshClicked();
+        for (const QString &mac : macs) {
+            m_wifiManager->queueBlock(mac);
+        }
+        // دفعة واحدة للجدار الناري؛ الصفوف تتحدث في مكانها دون إعادة مسح
+        if (m_wifiManager->commitFirewallChanges()) {
+            showMessage(QString("تم حظر %1 جهاز: %2").arg(macs.size()).arg(macs.join(", ")));
         } else {
-            showMessage("فشل حظر الجهاز - تأكد من صلاحيات root", true);
+            showMessage("فشل حظر الأجهزة - تأكد من صلاحيات root", true);
         }
     }
 }
 
 void MainWindow::onUnblockDeviceClicked() {
-    int currentRow = m_deviceTable->currentRow();
-    if (currentRow < 0) {
+    QStringList macs = selectedDeviceMacs();
+    if (macs.isEmpty()) {
         QMessageBox::warning(this, "تحذير", "الرجاء اختيار جهاز أولاً");
         return;
     }
     
-    QString macAddress = m_deviceTable->item(currentRow, 1)->text();
-    
-    if (m_wifiManager->unblockDevice(macAddress)) {
-        showMessage(QString("تم إلغاء حظر الجهاز %1").arg(macAddress));
-        onRefreshClicked();
+    for (const QString &mac : macs) {
+        m_wifiManager->queueUnblock(mac);
+    }
+    if (m_wifiManager->commitFirewallChanges()) {
+        showMessage(QString("تم إلغاء حظر %1 جهاز: %2").arg(macs.size()).arg(macs.join(", ")));
     } else {
-        showMessage("فشل إلغاء حظر الجهاز", true);
+        showMessage("فشل إلغاء حظر الأجهزة", true);
     }
 }
 
@@ -384,7 +717,7 @@ void MainWindow::onRestartRouterClicked() {
     
     if (ret == QMessageBox::Yes) {
         if (m_wifiManager->restartRouter()) {
-            showMessage("تمت محاولة إعادة تشغيل خدمات الشبكة");
+            showMessage("جارٍ إعادة تشغيل خدمات الشبكة...", false, "services");
         } else {
             showMessage("فشلت إعادة تشغيل خدمات الشبكة", true);
         }
@@ -438,7 +771,10 @@ void MainWindow::showDeviceDetails(int row, int column) {
         return;
     }
     
-    QString ip = m_deviceTable->item(row, 0)->text();
+    QString ip = m_deviceTable->item(row, 0)->toolTip();
+    if (ip.isEmpty()) {
+        ip = m_deviceTable->item(row, 0)->text();
+    }
     QString mac = m_deviceTable->item(row, 1)->text();
     QString name = m_deviceTable->item(row, 2)->text();
     QString manufacturer = m_deviceTable->item(row, 3)->text();
@@ -446,7 +782,7 @@ void MainWindow::showDeviceDetails(int row, int column) {
     QString status = m_deviceTable->item(row, 5)->text();
     
     QString details = QString("تفاصيل الجهاز:\n\n"
-                             "عنوان IP: %1\n"
+                             "عناوين IP:\n%1\n"
                              "عنوان MAC: %2\n"
                              "اسم الجهاز: %3\n"
                              "الشركة المصنعة: %4\n"
@@ -454,23 +790,68 @@ void MainWindow::showDeviceDetails(int row, int column) {
                              "الحالة: %6")
                              .arg(ip, mac, name, manufacturer, lastSeen, status);
     
-    QMessageBox::information(this, "تفاصيل الجهاز", details);
-}
-
-void MainWindow::showMessage(const QString &message, bool isError) {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-    QString formattedMessage = QString("[%1] %2").arg(timestamp, message);
+    const StationTelemetry *telemetry = m_wifiManager->stationTelemetry();
+    if (telemetry->contains(mac)) {
+        StationLink link = telemetry->link(mac);
+        details += QString("\n\nالإشارة: %1 dBm (المتوسط %2 dBm)\n"
+                           "معدل الإرسال/الاستقبال: %3 / %4 Mbps\n"
+                           "الإنتاجية المتوقعة: %5 Mbps\n"
+                           "إعادات الإرسال: %6%  الإطارات الفاشلة: %7%")
+                           .arg(link.signalDbm)
+                           .arg(link.signalAvgDbm)
+                           .arg(link.txBitrateKbps / 1000.0, 0, 'f', 1)
+                           .arg(link.rxBitrateKbps / 1000.0, 0, 'f', 1)
+                           .arg(link.expectedThroughputKbps / 1000.0, 0, 'f', 1)
+                           .arg(link.retryRate * 100.0, 0, 'f', 1)
+                           .arg(link.failureRate * 100.0, 0, 'f', 1);
+        if (link.weak) {
+            details += "\nتنبيه: رابط ضعيف يبطئ الشبكة لبقية الأجهزة";
+        }
+    }
     
-    if (isError) {
-        m_logWidget->setTextColor(Qt::red);
-    } else {
-        m_logWidget->setTextColor(Qt::black);
+    DeviceFingerprint fingerprint = m_wifiManager->fingerprinter()->fingerprint(mac);
+    if (fingerprint.type != DeviceFingerprint::Unknown || !fingerprint.os.isEmpty()) {
+        details += QString("\n\nالنوع: %1 (ثقة %2%)").arg(DeviceFingerprint::typeLabel(fingerprint.type))
+                       .arg(fingerprint.confidence);
+        if (!fingerprint.os.isEmpty()) {
+            details += QString("\nالنظام: %1").arg(fingerprint.os);
+        }
+        if (!fingerprint.model.isEmpty()) {
+            details += QString("\nالطراز: %1").arg(fingerprint.model);
+        }
+        details += QString("\nالأدلة: %1").arg(fingerprint.evidence.join("، "));
     }
     
-    m_logWidget->append(formattedMessage);
+    std::vector<DomainCount> domains = m_wifiManager->topDomains(mac, 5);
+    if (!domains.empty()) {
+        QStringList names;
+        for (const DomainCount &entry : domains) {
+            names << QString("%1 (%2)").arg(entry.domain).arg(entry.count);
+        }
+        details += QString("\n\nأكثر النطاقات طلباً:\n%1").arg(names.join("\n"));
+    }
     
-    // التمرير إلى الأسفل تلقائياً
-    QTextCursor cursor = m_logWidget->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    m_logWidget->setTextCursor(cursor);
+    StationSessions sessions = m_wifiManager->associationTracker()->sessions(mac);
+    if (sessions.sessionCount > 0) {
+        qint64 totalSecs = sessions.totalConnectedUs / 1000000;
+        if (sessions.connectedSinceUs != 0) {
+            totalSecs += QDateTime::currentMSecsSinceEpoch() / 1000 - sessions.connectedSinceUs / 1000000;
+        }
+        details += QString("\n\nالجلسات: %1\n"
+                           "مدة الاتصال الكلية: %2 دقيقة\n"
+                           "انقطاعات مع عودة سريعة: %3")
+                           .arg(sessions.sessionCount)
+                           .arg(totalSecs / 60)
+                           .arg(sessions.quickReconnects);
+        if (sessions.disconnectCount > 0) {
+            details += QString("\nآخر سبب انفصال: %1")
+                           .arg(AssociationTracker::reasonText(sessions.lastReasonCode));
+        }
+    }
+    
+    QMessageBox::information(this, "تفاصيل الجهاز", details);
+}
+
+void MainWindow::showMessage(const QString &message, bool isError, const QString &key) {
+    m_eventLog->append(isError ? LogEvent::Error : LogEvent::Info, message, key);
 }
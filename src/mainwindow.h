@@ -2,9 +2,15 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
 #include <memory>
 #include "wifimanager.h"
 #include "networkstats.h"
+#include "metricsexporter.h"
+#include "eventlog.h"
+#include "updatebus.h"
+#include "appconfig.h"
+#include "controlserver.h"
 
 QT_BEGIN_NAMESPACE
 class QListWidget;
@@ -12,13 +18,16 @@ class QLabel;
 class QPushButton;
 class QLineEdit;
 class QTableWidget;
-class QTextEdit;
+class QTableWidgetItem;
+class QListView;
 class QProgressBar;
 class QChartView;
 class QChart;
 class QPieSeries;
 QT_END_NAMESPACE
 
+class ProfilerDialog;
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -38,17 +47,34 @@ private slots:
     void showDeviceDetails(int row, int column);
     void onStatsUpdated(const NetworkStats &stats);
     void checkSystemRequirements();
+    void startBackgroundWork();
+    void onBusUpdated(quint32 topics);
+    void onExportClicked();
+    void onImportClicked();
+
+protected:
+    bool event(QEvent *event) override;
+    void changeEvent(QEvent *event) override;
 
 private:
     void setupUi();
     void createMenuBar();
     void createChart();
     void updateDeviceTable(const std::vector<Device> &devices);
+    QTableWidgetItem *setTableCell(int row, int column, const QString &text);
+    QStringList selectedDeviceMacs() const;
     void updateChart(const NetworkStats &stats);
-    void showMessage(const QString &message, bool isError = false);
+    void showMessage(const QString &message, bool isError = false, const QString &key = QString());
+    void applyConfig(const AppConfig &config);
     
+    std::unique_ptr<ConfigManager> m_config;
+    std::unique_ptr<UpdateBus> m_updateBus;
     std::unique_ptr<WifiManager> m_wifiManager;
     std::unique_ptr<NetworkStatsManager> m_statsManager;
+    std::unique_ptr<MetricsExporter> m_metricsExporter;
+    std::unique_ptr<ControlServer> m_controlServer;
+    std::unique_ptr<EventLogModel> m_eventLog;
+    std::unique_ptr<QTimer> m_networkTimer;
     
     // UI Elements
     QTableWidget *m_deviceTable;
@@ -61,11 +87,16 @@ private:
     QPushButton *m_blockBtn;
     QPushButton *m_unblockBtn;
     QPushButton *m_refreshBtn;
-    QTextEdit *m_logWidget;
+    QListView *m_logWidget;
+    bool m_logFollowTail = true;
+    bool m_startupFinished = false;
+    quint64 m_shownDevicesVersion = 0;
+    quint64 m_shownStatsVersion = 0;
     QChartView *m_chartView;
     QChart *m_chart;
     QPieSeries *m_pieSeries;
     QProgressBar *m_signalProgressBar;
+    ProfilerDialog *m_profilerDialog = nullptr;
 };
 
 #endif // MAINWINDOW_H
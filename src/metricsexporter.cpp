@@ -0,0 +1,235 @@
+#include "metricsexporter.h"
+#include <QTcpSocket>
+#include <QDebug>
+
+namespace {
+
+const QByteArray kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+// تهريب قيم التسميات حسب صيغة Prometheus: \ و " وسطر جديد
+void appendLabelValue(QByteArray &out, const QString &value) {
+    const QByteArray utf8 = value.toUtf8();
+    for (char c : utf8) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '"': out += "\\\""; break;
+        case '\n': out += "\\n"; break;
+        default: out += c; break;
+        }
+    }
+}
+
+void appendHeader(QByteArray &out, const char *name, const char *type, const char *help) {
+    out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+    out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+}
+
+void appendSample(QByteArray &out, const char *name, qint64 value) {
+    out += name; out += ' '; out += QByteArray::number(value); out += '\n';
+}
+
+void appendSample(QByteArray &out, const char *name, double value) {
+    out += name; out += ' '; out += QByteArray::number(value, 'g', 12); out += '\n';
+}
+
+void appendDeviceSample(QByteArray &out, const char *name, const Device &device, qint64 value) {
+    out += name;
+    out += "{mac=\""; appendLabelValue(out, device.macAddress);
+    out += "\",ip=\""; appendLabelValue(out, device.ipAddress);
+    out += "\",hostname=\""; appendLabelValue(out, device.hostname);
+    out += "\"} ";
+    out += QByteArray::number(value);
+    out += '\n';
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent),
+      m_server(new QTcpServer(this)),
+      m_rebuildTimer(new QTimer(this))
+{
+    // تجميع التحديثات المتلاحقة في إعادة بناء واحدة
+    m_rebuildTimer->setSingleShot(true);
+    m_rebuildTimer->setInterval(200);
+    connect(m_rebuildTimer, &QTimer::timeout, this, &MetricsExporter::rebuild);
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+
+    rebuild();
+}
+
+MetricsExporter::~MetricsExporter() {
+    close();
+}
+
+bool MetricsExporter::listen(const QHostAddress &address, quint16 port) {
+    if (!m_server->listen(address, port)) {
+        qDebug() << "Metrics exporter: cannot listen on" << address.toString() << port
+                 << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::close() {
+    m_server->close();
+}
+
+quint16 MetricsExporter::port() const {
+    return m_server->serverPort();
+}
+
+void MetricsExporter::setUpdateBus(UpdateBus *bus) {
+    connect(bus, &UpdateBus::updated, this, [this, bus](quint32 topics) {
+        if (topics & UpdateBus::Devices) {
+            updateDevices(bus->devices().data);
+        }
+        if (topics & UpdateBus::Stats) {
+            UpdateBus::StatsSnapshot stats = bus->stats();
+            if (stats.data) {
+                updateStats(*stats.data);
+            }
+        }
+    });
+}
+
+void MetricsExporter::updateDevices(std::shared_ptr<const std::vector<Device>> devices) {
+    // اللقطة مشتركة وثابتة، فلا حاجة لنسخ القائمة
+    m_devices = std::move(devices);
+    scheduleRebuild();
+}
+
+void MetricsExporter::updateStats(const NetworkStats &stats) {
+    m_stats = stats;
+    scheduleRebuild();
+}
+
+void MetricsExporter::updateScanCounters(const ScanScheduler::Counters &counters) {
+    m_counters = counters;
+    scheduleRebuild();
+}
+
+void MetricsExporter::updateStartupTime(qint64 firstFrameMs) {
+    m_firstFrameMs = firstFrameMs;
+    scheduleRebuild();
+}
+
+void MetricsExporter::scheduleRebuild() {
+    if (!m_rebuildTimer->isActive()) {
+        m_rebuildTimer->start();
+    }
+}
+
+void MetricsExporter::rebuild() {
+    static const std::vector<Device> noDevices;
+    const std::vector<Device> &devices = m_devices ? *m_devices : noDevices;
+
+    QByteArray out;
+    // تقدير تقريبي: ~300 بايت لكل جهاز لتفادي إعادة التخصيص
+    out.reserve(2048 + static_cast<int>(devices.size()) * 320);
+
+    // إحصائيات الواجهة
+    QByteArray iface = "{interface=\"";
+    appendLabelValue(iface, m_stats.interface);
+    iface += "\"}";
+
+    appendHeader(out, "wifimanager_interface_receive_bytes_total", "counter", "Bytes received on the monitored interface.");
+    appendSample(out, QByteArray("wifimanager_interface_receive_bytes_total" + iface).constData(), m_stats.bytesReceived);
+    appendHeader(out, "wifimanager_interface_transmit_bytes_total", "counter", "Bytes sent on the monitored interface.");
+    appendSample(out, QByteArray("wifimanager_interface_transmit_bytes_total" + iface).constData(), m_stats.bytesSent);
+    appendHeader(out, "wifimanager_interface_download_bytes_per_second", "gauge", "Current download rate.");
+    appendSample(out, QByteArray("wifimanager_interface_download_bytes_per_second" + iface).constData(), m_stats.downloadSpeed * 1024.0);
+    appendHeader(out, "wifimanager_interface_upload_bytes_per_second", "gauge", "Current upload rate.");
+    appendSample(out, QByteArray("wifimanager_interface_upload_bytes_per_second" + iface).constData(), m_stats.uploadSpeed * 1024.0);
+
+    // الأجهزة
+    qint64 active = 0;
+    for (const Device &device : devices) {
+        if (device.isActive) {
+            ++active;
+        }
+    }
+    appendHeader(out, "wifimanager_devices", "gauge", "Known devices by connection state.");
+    appendSample(out, "wifimanager_devices{state=\"active\"}", active);
+    appendSample(out, "wifimanager_devices{state=\"inactive\"}", static_cast<qint64>(devices.size()) - active);
+
+    appendHeader(out, "wifimanager_device_up", "gauge", "Whether the device is currently considered connected.");
+    for (const Device &device : devices) {
+        appendDeviceSample(out, "wifimanager_device_up", device, device.isActive ? 1 : 0);
+    }
+    appendHeader(out, "wifimanager_device_receive_bytes_total", "counter", "Bytes received by the device.");
+    for (const Device &device : devices) {
+        appendDeviceSample(out, "wifimanager_device_receive_bytes_total", device, device.bytesReceived);
+    }
+    appendHeader(out, "wifimanager_device_transmit_bytes_total", "counter", "Bytes sent by the device.");
+    for (const Device &device : devices) {
+        appendDeviceSample(out, "wifimanager_device_transmit_bytes_total", device, device.bytesSent);
+    }
+    appendHeader(out, "wifimanager_device_last_seen_timestamp_seconds", "gauge", "Last time any source saw the device.");
+    for (const Device &device : devices) {
+        appendDeviceSample(out, "wifimanager_device_last_seen_timestamp_seconds", device,
+                           device.lastSeen.isValid() ? device.lastSeen.toSecsSinceEpoch() : 0);
+    }
+    appendHeader(out, "wifimanager_device_signal_dbm", "gauge", "Station signal strength reported by the access point.");
+    for (const Device &device : devices) {
+        if (device.signalStrength != 0.0) {
+            appendDeviceSample(out, "wifimanager_device_signal_dbm", device,
+                               static_cast<qint64>(device.signalStrength));
+        }
+    }
+
+    // المسح
+    appendHeader(out, "wifimanager_scans_total", "counter", "Scan cycles by depth.");
+    appendSample(out, "wifimanager_scans_total{depth=\"neighbor_read\"}", static_cast<qint64>(m_counters.neighborReads));
+    appendSample(out, "wifimanager_scans_total{depth=\"reprobe\"}", static_cast<qint64>(m_counters.reprobes));
+    appendSample(out, "wifimanager_scans_total{depth=\"full_sweep\"}", static_cast<qint64>(m_counters.fullSweeps));
+    appendHeader(out, "wifimanager_scan_seconds_total", "counter", "Total wall time spent scanning.");
+    appendSample(out, "wifimanager_scan_seconds_total", m_counters.totalScanMs / 1000.0);
+    appendHeader(out, "wifimanager_last_full_sweep_seconds", "gauge", "Duration of the last full sweep.");
+    appendSample(out, "wifimanager_last_full_sweep_seconds", m_counters.lastFullSweepMs / 1000.0);
+    appendHeader(out, "wifimanager_scan_packets_total", "counter", "Estimated packets sent by scans and probes.");
+    appendSample(out, "wifimanager_scan_packets_total", static_cast<qint64>(m_counters.packetsSent));
+    appendHeader(out, "wifimanager_scan_budget_downgrades_total", "counter", "Full sweeps deferred by the scan budget.");
+    appendSample(out, "wifimanager_scan_budget_downgrades_total", static_cast<qint64>(m_counters.budgetDowngrades));
+    appendHeader(out, "wifimanager_scan_interval_seconds", "gauge", "Current adaptive scan interval.");
+    appendSample(out, "wifimanager_scan_interval_seconds", m_counters.currentIntervalMs / 1000.0);
+
+    appendHeader(out, "wifimanager_startup_first_frame_seconds", "gauge", "Time from process start to the first painted frame.");
+    appendSample(out, "wifimanager_startup_first_frame_seconds", m_firstFrameMs / 1000.0);
+
+    m_snapshot = out;
+}
+
+void MetricsExporter::onNewConnection() {
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+            // ننتظر نهاية الترويسات فقط؛ لا يوجد جسم في طلبات GET
+            QByteArray request = socket->peek(8192);
+            if (!request.contains("\r\n\r\n")) {
+                if (request.size() >= 8192) {
+                    socket->abort();
+                }
+                return;
+            }
+            socket->readAll();
+
+            QByteArray response;
+            if (request.startsWith("GET /metrics ") || request.startsWith("GET /metrics?")) {
+                // QByteArray مشترك ضمنياً: لا نسخ للقطة هنا
+                const QByteArray body = m_snapshot;
+                response.reserve(128);
+                response += "HTTP/1.1 200 OK\r\nContent-Type: ";
+                response += kContentType;
+                response += "\r\nContent-Length: ";
+                response += QByteArray::number(body.size());
+                response += "\r\nConnection: close\r\n\r\n";
+                socket->write(response);
+                socket->write(body);
+            } else {
+                socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            }
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTimer>
+#include <QHostAddress>
+#include <memory>
+#include <vector>
+#include "wifimanager.h"
+#include "networkstats.h"
+#include "updatebus.h"
+
+// نقطة /metrics بصيغة Prometheus/OpenMetrics النصية.
+// النص يُبنى مسبقاً عند وصول بيانات جديدة، فطلب الجمع لا يشغل أي مسح
+// ولا أي عملية، بل ينسخ آخر لقطة جاهزة إلى المقبس فقط.
+class MetricsExporter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsExporter(QObject *parent = nullptr);
+    ~MetricsExporter();
+
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 9105);
+    void close();
+    quint16 port() const;
+
+    QByteArray snapshot() const { return m_snapshot; }
+
+    // يسحب أحدث لقطة أجهزة وإحصائيات من الناقل عند كل إشعار
+    void setUpdateBus(UpdateBus *bus);
+
+public slots:
+    void updateDevices(std::shared_ptr<const std::vector<Device>> devices);
+    void updateStats(const NetworkStats &stats);
+    void updateScanCounters(const ScanScheduler::Counters &counters);
+    void updateStartupTime(qint64 firstFrameMs);
+
+private slots:
+    void onNewConnection();
+    void rebuild();
+
+private:
+    QTcpServer *m_server;
+    QTimer *m_rebuildTimer;
+    QByteArray m_snapshot;
+
+    std::shared_ptr<const std::vector<Device>> m_devices;
+    NetworkStats m_stats;
+    ScanScheduler::Counters m_counters;
+    qint64 m_firstFrameMs = 0;
+
+    void scheduleRebuild();
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,381 @@
+#include "neighbortable.h"
+#include "privilegedhelper.h"
+#include <QDebug>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QNetworkInterface>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/icmp6.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+namespace {
+
+QString formatMac(const unsigned char *mac) {
+    static const char hex[] = "0123456789ABCDEF";
+    char buffer[17];
+    for (int i = 0; i < 6; ++i) {
+        buffer[i * 3] = hex[mac[i] >> 4];
+        buffer[i * 3 + 1] = hex[mac[i] & 0x0f];
+        if (i < 5) {
+            buffer[i * 3 + 2] = ':';
+        }
+    }
+    return QString::fromLatin1(buffer, 17);
+}
+
+bool parseMac(const QString &text, unsigned char *mac) {
+    QStringList parts = text.split(':');
+    if (parts.size() != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i) {
+        bool ok = false;
+        mac[i] = static_cast<unsigned char>(parts[i].toUInt(&ok, 16));
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qint64 clockTicksToMs(quint32 ticks) {
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? qint64(ticks) * 1000 / ticksPerSecond : qint64(ticks) * 10;
+}
+
+} // namespace
+
+bool NeighborTable::dump(const QString &interface, std::vector<NeighborEntry> *entries) {
+    int ifindex = static_cast<int>(if_nametoindex(interface.toLocal8Bit().constData()));
+    if (ifindex == 0) {
+        return false;
+    }
+
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        qDebug() << "Neighbor table: cannot open netlink socket:" << strerror(errno);
+        return false;
+    }
+
+    struct {
+        nlmsghdr header;
+        ndmsg message;
+    } request;
+    std::memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = 1;
+    request.message.ndm_family = AF_UNSPEC; // IPv4 و IPv6 في تفريغ واحد
+
+    if (::send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    alignas(nlmsghdr) char buffer[32768];
+    bool done = false;
+    bool ok = true;
+
+    while (!done) {
+        int length = static_cast<int>(::recv(fd, buffer, sizeof(buffer), 0));
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_DONE) {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                ok = false;
+                break;
+            }
+            if (header->nlmsg_type != RTM_NEWNEIGH) {
+                continue;
+            }
+
+            auto *neighbor = static_cast<ndmsg *>(NLMSG_DATA(header));
+            if (neighbor->ndm_ifindex != ifindex ||
+                (neighbor->ndm_state & (NUD_INCOMPLETE | NUD_FAILED | NUD_NOARP)) ||
+                (neighbor->ndm_family != AF_INET && neighbor->ndm_family != AF_INET6)) {
+                continue;
+            }
+
+            const unsigned char *address = nullptr;
+            const unsigned char *lladdr = nullptr;
+            const nda_cacheinfo *cacheInfo = nullptr;
+            int attributesLength = static_cast<int>(RTM_PAYLOAD(header));
+            for (rtattr *attribute = RTM_RTA(neighbor); RTA_OK(attribute, attributesLength);
+                 attribute = RTA_NEXT(attribute, attributesLength)) {
+                if (attribute->rta_type == NDA_DST) {
+                    address = static_cast<const unsigned char *>(RTA_DATA(attribute));
+                } else if (attribute->rta_type == NDA_LLADDR && RTA_PAYLOAD(attribute) == 6) {
+                    lladdr = static_cast<const unsigned char *>(RTA_DATA(attribute));
+                } else if (attribute->rta_type == NDA_CACHEINFO && RTA_PAYLOAD(attribute) >= sizeof(nda_cacheinfo)) {
+                    cacheInfo = static_cast<const nda_cacheinfo *>(RTA_DATA(attribute));
+                }
+            }
+            if (!address || !lladdr) {
+                continue;
+            }
+
+            NeighborEntry entry;
+            entry.family = neighbor->ndm_family;
+            entry.state = neighbor->ndm_state;
+            entry.macAddress = formatMac(lladdr);
+            entry.confirmedMsAgo = cacheInfo ? clockTicksToMs(cacheInfo->ndm_confirmed) : 0;
+            if (entry.family == AF_INET) {
+                quint32 ip = (quint32(address[0]) << 24) | (quint32(address[1]) << 16) |
+                             (quint32(address[2]) << 8) | address[3];
+                entry.ipAddress = QHostAddress(ip).toString();
+            } else {
+                entry.ipAddress = QHostAddress(address).toString();
+            }
+            entries->push_back(entry);
+        }
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+bool NeighborTable::probeIpv6AllNodes(const QString &interface) {
+    unsigned int ifindex = if_nametoindex(interface.toLocal8Bit().constData());
+    if (ifindex == 0) {
+        return false;
+    }
+
+    // مقبس ping غير مميز أولاً، ثم RAW إذا لم يسمح النظام بذلك
+    int fd = ::socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMPV6);
+    if (fd < 0) {
+        fd = PrivilegedHelper::openSocket(PrivilegedHelper::Icmpv6Raw);
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    int hops = 1;
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_IF, &ifindex, sizeof(ifindex));
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(hops));
+
+    sockaddr_in6 destination;
+    std::memset(&destination, 0, sizeof(destination));
+    destination.sin6_family = AF_INET6;
+    destination.sin6_scope_id = ifindex;
+    inet_pton(AF_INET6, "ff02::1", &destination.sin6_addr);
+
+    icmp6_hdr echo;
+    std::memset(&echo, 0, sizeof(echo));
+    echo.icmp6_type = ICMP6_ECHO_REQUEST;
+    echo.icmp6_id = htons(static_cast<uint16_t>(getpid()));
+    echo.icmp6_seq = htons(1);
+
+    // الردود نفسها لا تهمنا: يكفي أن تسجل النواة الجيران في ذاكرة NDP
+    ssize_t sent = ::sendto(fd, &echo, sizeof(echo), 0,
+                            reinterpret_cast<sockaddr *>(&destination), sizeof(destination));
+    ::close(fd);
+    return sent == static_cast<ssize_t>(sizeof(echo));
+}
+
+int NeighborTable::probeUnicast(const QStringList &addresses) {
+    int fd4 = -1;
+    int fd6 = -1;
+    int sent = 0;
+
+    for (const QString &text : addresses) {
+        QHostAddress address(text);
+        char payload = 0;
+
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            if (fd4 < 0) {
+                fd4 = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            }
+            sockaddr_in destination;
+            std::memset(&destination, 0, sizeof(destination));
+            destination.sin_family = AF_INET;
+            destination.sin_port = htons(9); // discard
+            destination.sin_addr.s_addr = htonl(address.toIPv4Address());
+            if (fd4 >= 0 && ::sendto(fd4, &payload, 1, 0, reinterpret_cast<sockaddr *>(&destination), sizeof(destination)) >= 0) {
+                ++sent;
+            }
+        } else if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+            if (fd6 < 0) {
+                fd6 = ::socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            }
+            sockaddr_in6 destination;
+            std::memset(&destination, 0, sizeof(destination));
+            destination.sin6_family = AF_INET6;
+            destination.sin6_port = htons(9);
+            Q_IPV6ADDR ip6 = address.toIPv6Address();
+            std::memcpy(&destination.sin6_addr, ip6.c, 16);
+            destination.sin6_scope_id = if_nametoindex(address.scopeId().toLocal8Bit().constData());
+            if (fd6 >= 0 && ::sendto(fd6, &payload, 1, 0, reinterpret_cast<sockaddr *>(&destination), sizeof(destination)) >= 0) {
+                ++sent;
+            }
+        }
+    }
+
+    if (fd4 >= 0) {
+        ::close(fd4);
+    }
+    if (fd6 >= 0) {
+        ::close(fd6);
+    }
+    return sent;
+}
+
+int NeighborTable::probeArp(const QString &interface, const std::vector<std::pair<QString, QString>> &targets) {
+    QNetworkInterface local = QNetworkInterface::interfaceFromName(interface);
+    unsigned char ownMac[6];
+    if (!local.isValid() || !parseMac(local.hardwareAddress(), ownMac)) {
+        return 0;
+    }
+
+    quint32 ownIp = 0;
+    for (const QNetworkAddressEntry &entry : local.addressEntries()) {
+        if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+            ownIp = entry.ip().toIPv4Address();
+            break;
+        }
+    }
+    if (ownIp == 0) {
+        return 0;
+    }
+
+    int fd = PrivilegedHelper::openSocket(PrivilegedHelper::PacketArp);
+    if (fd < 0) {
+        return 0;
+    }
+
+    sockaddr_ll destination;
+    std::memset(&destination, 0, sizeof(destination));
+    destination.sll_family = AF_PACKET;
+    destination.sll_protocol = htons(ETH_P_ARP);
+    destination.sll_ifindex = local.index();
+    destination.sll_halen = 6;
+
+    unsigned char packet[28];
+    packet[0] = 0; packet[1] = 1;          // Ethernet
+    packet[2] = 0x08; packet[3] = 0x00;    // IPv4
+    packet[4] = 6; packet[5] = 4;
+    packet[6] = 0; packet[7] = 1;          // request
+    std::memcpy(packet + 8, ownMac, 6);
+    quint32 ownIpNet = htonl(ownIp);
+    std::memcpy(packet + 14, &ownIpNet, 4);
+
+    int sent = 0;
+    for (const auto &target : targets) {
+        QHostAddress address(target.second);
+        if (address.protocol() != QAbstractSocket::IPv4Protocol ||
+            !parseMac(target.first, destination.sll_addr)) {
+            continue;
+        }
+        std::memcpy(packet + 18, destination.sll_addr, 6);
+        quint32 targetIp = htonl(address.toIPv4Address());
+        std::memcpy(packet + 24, &targetIp, 4);
+
+        if (::sendto(fd, packet, sizeof(packet), 0,
+                     reinterpret_cast<sockaddr *>(&destination), sizeof(destination)) == sizeof(packet)) {
+            ++sent;
+        }
+    }
+
+    ::close(fd);
+    return sent;
+}
+
+NeighborMonitor::NeighborMonitor(QObject *parent)
+    : QObject(parent)
+{
+}
+
+NeighborMonitor::~NeighborMonitor() {
+    stop();
+}
+
+bool NeighborMonitor::start(const QString &interface) {
+    stop();
+
+    m_ifindex = static_cast<int>(if_nametoindex(interface.toLocal8Bit().constData()));
+    if (m_ifindex == 0) {
+        return false;
+    }
+
+    m_socket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (m_socket < 0) {
+        return false;
+    }
+
+    sockaddr_nl address;
+    std::memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_NEIGH;
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        qDebug() << "Neighbor monitor: cannot subscribe to RTMGRP_NEIGH:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NeighborMonitor::onReadable);
+    return true;
+}
+
+void NeighborMonitor::stop() {
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+}
+
+void NeighborMonitor::onReadable() {
+    alignas(nlmsghdr) char buffer[16384];
+    bool relevant = false;
+
+    // تفريغ كل الرسائل المتراكمة ثم إشارة واحدة فقط
+    for (;;) {
+        int length = static_cast<int>(::recv(m_socket, buffer, sizeof(buffer), 0));
+        if (length <= 0) {
+            break;
+        }
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type != RTM_NEWNEIGH && header->nlmsg_type != RTM_DELNEIGH) {
+                continue;
+            }
+            auto *neighbor = static_cast<ndmsg *>(NLMSG_DATA(header));
+            if (neighbor->ndm_ifindex == m_ifindex) {
+                relevant = true;
+            }
+        }
+    }
+
+    if (relevant) {
+        emit neighborChanged();
+    }
+}
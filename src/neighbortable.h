@@ -0,0 +1,58 @@
+#ifndef NEIGHBORTABLE_H
+#define NEIGHBORTABLE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSocketNotifier>
+#include <vector>
+#include <utility>
+
+struct NeighborEntry {
+    QString macAddress;
+    QString ipAddress;
+    int family = 0;      // AF_INET أو AF_INET6
+    quint16 state = 0;   // NUD_*
+    qint64 confirmedMsAgo = 0; // منذ متى أكدت النواة أن الجار حي
+};
+
+// قراءة جدول الجيران في النواة (ARP + NDP) مباشرة عبر netlink بدلاً من تشغيل arp
+class NeighborTable {
+public:
+    // تفريغ جدول الجيران لكلا العائلتين في طلب واحد؛ يعيد false عند فشل netlink
+    static bool dump(const QString &interface, std::vector<NeighborEntry> *entries);
+
+    // إرسال ping متعدد البث إلى ff02::1 لتعبئة ذاكرة NDP بكل أجهزة IPv6 على الرابط
+    static bool probeIpv6AllNodes(const QString &interface);
+
+    // إرسال datagram صغير لكل عنوان يجبر النواة على التحقق من الجار (ARP/NS أحادي)
+    static int probeUnicast(const QStringList &addresses);
+
+    // طلبات ARP أحادية مباشرة (MAC, IPv4) عبر AF_PACKET؛ الردود يلتقطها الاكتشاف السلبي
+    static int probeArp(const QString &interface, const std::vector<std::pair<QString, QString>> &targets);
+};
+
+// الاشتراك في أحداث جدول الجيران (RTMGRP_NEIGH) لمعرفة متى تتغير الشبكة فعلاً
+class NeighborMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit NeighborMonitor(QObject *parent = nullptr);
+    ~NeighborMonitor();
+
+    bool start(const QString &interface);
+    void stop();
+
+signals:
+    void neighborChanged();
+
+private slots:
+    void onReadable();
+
+private:
+    int m_socket = -1;
+    int m_ifindex = 0;
+    QSocketNotifier *m_notifier = nullptr;
+};
+
+#endif // NEIGHBORTABLE_H
@@ -1,4 +1,6 @@
 #include "networkstats.h"
+#include "profiler.h"
+#include "updatebus.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
@@ -50,6 +52,7 @@ QString NetworkStatsManager::getDefaultInterface() const {
 }
 
 NetworkStats NetworkStatsManager::readInterfaceStats(const QString &interface) const {
+    PROFILE_SCOPE(ReadInterfaceStats);
     NetworkStats stats;
     stats.interface = interface;
     
@@ -85,16 +88,24 @@ void NetworkStatsManager::updateStats() {
         qint64 downloadDiff = newStats.bytesReceived - m_previousStats.bytesReceived;
         qint64 uploadDiff = newStats.bytesSent - m_previousStats.bytesSent;
         
-        newStats.downloadSpeed = downloadDiff / 1024.0; // KB/s
-        newStats.uploadSpeed = uploadDiff / 1024.0;     // KB/s
+        double seconds = m_intervalMs / 1000.0;
+        newStats.downloadSpeed = downloadDiff / 1024.0 / seconds; // KB/s
+        newStats.uploadSpeed = uploadDiff / 1024.0 / seconds;     // KB/s
     }
     
     m_previousStats = m_currentStats;
     m_currentStats = newStats;
     
+    if (m_updateBus) {
+        m_updateBus->publishStats(m_currentStats);
+    }
     emit statsUpdated(m_currentStats);
 }
 
+void NetworkStatsManager::setUpdateBus(UpdateBus *bus) {
+    m_updateBus = bus;
+}
+
 NetworkStats NetworkStatsManager::getCurrentStats() const {
     return m_currentStats;
 }
@@ -104,7 +115,14 @@ void NetworkStatsManager::startMonitoring() {
     m_currentStats = readInterfaceStats(m_interface);
     m_previousStats = m_currentStats;
     
-    m_timer->start(1000); // تحديث كل ثانية
+    m_timer->start(m_intervalMs);
+}
+
+void NetworkStatsManager::setUpdateInterval(int intervalMs) {
+    m_intervalMs = intervalMs;
+    if (m_timer->isActive()) {
+        m_timer->setInterval(m_intervalMs);
+    }
 }
 
 void NetworkStatsManager::stopMonitoring() {
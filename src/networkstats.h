@@ -13,6 +13,8 @@ struct NetworkStats {
     QString interface;
 };
 
+class UpdateBus;
+
 class NetworkStatsManager : public QObject {
     Q_OBJECT
 
@@ -24,6 +26,8 @@ public:
     void startMonitoring();
     void stopMonitoring();
     void setInterface(const QString &interface);
+    void setUpdateBus(UpdateBus *bus);
+    void setUpdateInterval(int intervalMs);
 
 signals:
     void statsUpdated(const NetworkStats &stats);
@@ -36,6 +40,8 @@ private:
     NetworkStats m_currentStats;
     NetworkStats m_previousStats;
     QString m_interface;
+    UpdateBus *m_updateBus = nullptr;
+    int m_intervalMs = 1000;
     
     NetworkStats readInterfaceStats(const QString &interface) const;
     QString getDefaultInterface() const;
@@ -0,0 +1,314 @@
+#include "nl80211.h"
+#include <QDebug>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+namespace {
+
+QString formatMac(const quint8 *mac) {
+    static const char hex[] = "0123456789ABCDEF";
+    char buffer[17];
+    for (int i = 0; i < 6; ++i) {
+        buffer[i * 3] = hex[mac[i] >> 4];
+        buffer[i * 3 + 1] = hex[mac[i] & 0x0f];
+        if (i < 5) {
+            buffer[i * 3 + 2] = ':';
+        }
+    }
+    return QString::fromLatin1(buffer, 17);
+}
+
+int appendAttribute(char *buffer, int offset, quint16 type, const void *data, int length) {
+    nlattr *attribute = reinterpret_cast<nlattr *>(buffer + offset);
+    attribute->nla_type = type;
+    attribute->nla_len = static_cast<quint16>(NLA_HDRLEN + length);
+    std::memcpy(buffer + offset + NLA_HDRLEN, data, length);
+    return offset + NLA_ALIGN(attribute->nla_len);
+}
+
+quint64 attributeU64(const nlattr *attribute) {
+    quint64 value = 0;
+    if (attribute && Nl80211::attributeLength(attribute) >= 8) {
+        std::memcpy(&value, Nl80211::attributeData(attribute), 8);
+    }
+    return value;
+}
+
+int attributeS8(const nlattr *attribute) {
+    if (!attribute || Nl80211::attributeLength(attribute) < 1) {
+        return 0;
+    }
+    return *static_cast<const qint8 *>(Nl80211::attributeData(attribute));
+}
+
+// معدل البت من NL80211_RATE_INFO_* بوحدة 100 kbps؛ BITRATE32 للمعدلات فوق 6.5 Gbps
+quint32 bitrateKbps(const nlattr *rate) {
+    if (!rate) {
+        return 0;
+    }
+    const nlattr *fields[NL80211_RATE_INFO_MAX + 1];
+    Nl80211::parseAttributes(Nl80211::attributeData(rate), Nl80211::attributeLength(rate),
+                             fields, NL80211_RATE_INFO_MAX);
+    quint32 units = Nl80211::attributeU32(fields[NL80211_RATE_INFO_BITRATE32]);
+    if (units == 0) {
+        units = Nl80211::attributeU16(fields[NL80211_RATE_INFO_BITRATE]);
+    }
+    return units * 100;
+}
+
+// معرف العائلة لا يتغير طوال عمر النواة؛ يُحل مرة واحدة
+int cachedFamily = 0;
+
+} // namespace
+
+void Nl80211::parseAttributes(const void *data, int length, const nlattr **table, int maxType) {
+    std::memset(table, 0, sizeof(nlattr *) * (maxType + 1));
+    const char *cursor = static_cast<const char *>(data);
+    while (length >= NLA_HDRLEN) {
+        const nlattr *attribute = reinterpret_cast<const nlattr *>(cursor);
+        if (attribute->nla_len < NLA_HDRLEN || attribute->nla_len > length) {
+            break;
+        }
+        int type = attribute->nla_type & NLA_TYPE_MASK;
+        if (type <= maxType) {
+            table[type] = attribute;
+        }
+        int step = NLA_ALIGN(attribute->nla_len);
+        cursor += step;
+        length -= step;
+    }
+}
+
+const void *Nl80211::attributeData(const nlattr *attribute) {
+    return reinterpret_cast<const char *>(attribute) + NLA_HDRLEN;
+}
+
+int Nl80211::attributeLength(const nlattr *attribute) {
+    return attribute->nla_len - NLA_HDRLEN;
+}
+
+quint32 Nl80211::attributeU32(const nlattr *attribute) {
+    quint32 value = 0;
+    if (attribute && attributeLength(attribute) >= 4) {
+        std::memcpy(&value, attributeData(attribute), 4);
+    }
+    return value;
+}
+
+quint16 Nl80211::attributeU16(const nlattr *attribute) {
+    quint16 value = 0;
+    if (attribute && attributeLength(attribute) >= 2) {
+        std::memcpy(&value, attributeData(attribute), 2);
+    }
+    return value;
+}
+
+bool Nl80211::resolve(int fd, int *family, quint32 *mlmeGroup) {
+    alignas(nlmsghdr) char request[128];
+    std::memset(request, 0, sizeof(request));
+    nlmsghdr *header = reinterpret_cast<nlmsghdr *>(request);
+    genlmsghdr *genl = static_cast<genlmsghdr *>(NLMSG_DATA(header));
+    genl->cmd = CTRL_CMD_GETFAMILY;
+    genl->version = 1;
+
+    static const char name[] = "nl80211";
+    int offset = NLMSG_LENGTH(GENL_HDRLEN);
+    offset = appendAttribute(request, offset, CTRL_ATTR_FAMILY_NAME, name, sizeof(name));
+    header->nlmsg_len = offset;
+    header->nlmsg_type = GENL_ID_CTRL;
+    header->nlmsg_flags = NLM_F_REQUEST;
+    header->nlmsg_seq = 1;
+
+    if (::send(fd, request, header->nlmsg_len, 0) < 0) {
+        return false;
+    }
+
+    alignas(nlmsghdr) char buffer[8192];
+    int length = static_cast<int>(::recv(fd, buffer, sizeof(buffer), 0));
+    if (length <= 0) {
+        return false;
+    }
+
+    *family = 0;
+    if (mlmeGroup) {
+        *mlmeGroup = 0;
+    }
+    for (nlmsghdr *reply = reinterpret_cast<nlmsghdr *>(buffer);
+         NLMSG_OK(reply, length);
+         reply = NLMSG_NEXT(reply, length)) {
+        if (reply->nlmsg_type != GENL_ID_CTRL) {
+            continue;
+        }
+        const char *payload = static_cast<const char *>(NLMSG_DATA(reply)) + GENL_HDRLEN;
+        int payloadLength = static_cast<int>(reply->nlmsg_len) - NLMSG_LENGTH(GENL_HDRLEN);
+        const nlattr *attributes[CTRL_ATTR_MAX + 1];
+        parseAttributes(payload, payloadLength, attributes, CTRL_ATTR_MAX);
+
+        *family = attributeU16(attributes[CTRL_ATTR_FAMILY_ID]);
+        const nlattr *groups = attributes[CTRL_ATTR_MCAST_GROUPS];
+        if (!groups || !mlmeGroup) {
+            continue;
+        }
+
+        // كل مجموعة سمة متداخلة بداخلها الاسم والمعرف
+        const char *cursor = static_cast<const char *>(attributeData(groups));
+        int remaining = attributeLength(groups);
+        while (remaining >= NLA_HDRLEN) {
+            const nlattr *group = reinterpret_cast<const nlattr *>(cursor);
+            if (group->nla_len < NLA_HDRLEN || group->nla_len > remaining) {
+                break;
+            }
+            const nlattr *fields[CTRL_ATTR_MCAST_GRP_MAX + 1];
+            parseAttributes(attributeData(group), attributeLength(group), fields, CTRL_ATTR_MCAST_GRP_MAX);
+            const nlattr *groupName = fields[CTRL_ATTR_MCAST_GRP_NAME];
+            if (groupName && std::strncmp(static_cast<const char *>(attributeData(groupName)),
+                                          "mlme", attributeLength(groupName)) == 0) {
+                *mlmeGroup = attributeU32(fields[CTRL_ATTR_MCAST_GRP_ID]);
+            }
+            int step = NLA_ALIGN(group->nla_len);
+            cursor += step;
+            remaining -= step;
+        }
+    }
+    if (*family != 0) {
+        cachedFamily = *family;
+    }
+    return *family != 0 && (!mlmeGroup || *mlmeGroup != 0);
+}
+
+bool Nl80211::sendStationDump(int fd, int family, int ifindex, quint32 seq) {
+    alignas(nlmsghdr) char request[64];
+    std::memset(request, 0, sizeof(request));
+    nlmsghdr *header = reinterpret_cast<nlmsghdr *>(request);
+    genlmsghdr *genl = static_cast<genlmsghdr *>(NLMSG_DATA(header));
+    genl->cmd = NL80211_CMD_GET_STATION;
+
+    quint32 index = static_cast<quint32>(ifindex);
+    int offset = appendAttribute(request, NLMSG_LENGTH(GENL_HDRLEN), NL80211_ATTR_IFINDEX,
+                                 &index, sizeof(index));
+    header->nlmsg_len = offset;
+    header->nlmsg_type = static_cast<quint16>(family);
+    header->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    header->nlmsg_seq = seq;
+
+    return ::send(fd, request, header->nlmsg_len, 0) >= 0;
+}
+
+bool Nl80211::parseStation(const void *attributes, int length, StationInfo *station) {
+    const nlattr *top[NL80211_ATTR_MAX + 1];
+    parseAttributes(attributes, length, top, NL80211_ATTR_MAX);
+
+    const nlattr *mac = top[NL80211_ATTR_MAC];
+    const nlattr *info = top[NL80211_ATTR_STA_INFO];
+    if (!mac || attributeLength(mac) < 6 || !info) {
+        return false;
+    }
+    station->macAddress = formatMac(static_cast<const quint8 *>(attributeData(mac)));
+
+    const nlattr *fields[NL80211_STA_INFO_MAX + 1];
+    parseAttributes(attributeData(info), attributeLength(info), fields, NL80211_STA_INFO_MAX);
+
+    station->signalDbm = attributeS8(fields[NL80211_STA_INFO_SIGNAL]);
+    station->signalAvgDbm = attributeS8(fields[NL80211_STA_INFO_SIGNAL_AVG]);
+    station->txBitrateKbps = bitrateKbps(fields[NL80211_STA_INFO_TX_BITRATE]);
+    station->rxBitrateKbps = bitrateKbps(fields[NL80211_STA_INFO_RX_BITRATE]);
+    station->expectedThroughputKbps = attributeU32(fields[NL80211_STA_INFO_EXPECTED_THROUGHPUT]);
+    station->txPackets = attributeU32(fields[NL80211_STA_INFO_TX_PACKETS]);
+    station->rxPackets = attributeU32(fields[NL80211_STA_INFO_RX_PACKETS]);
+    station->txRetries = attributeU32(fields[NL80211_STA_INFO_TX_RETRIES]);
+    station->txFailed = attributeU32(fields[NL80211_STA_INFO_TX_FAILED]);
+    station->inactiveMs = attributeU32(fields[NL80211_STA_INFO_INACTIVE_TIME]);
+    station->connectedSecs = attributeU32(fields[NL80211_STA_INFO_CONNECTED_TIME]);
+
+    // عدادات 64 بت إن توفرت، وإلا عدادات 32 بت القديمة
+    station->txBytes = fields[NL80211_STA_INFO_TX_BYTES64]
+        ? attributeU64(fields[NL80211_STA_INFO_TX_BYTES64])
+        : attributeU32(fields[NL80211_STA_INFO_TX_BYTES]);
+    station->rxBytes = fields[NL80211_STA_INFO_RX_BYTES64]
+        ? attributeU64(fields[NL80211_STA_INFO_RX_BYTES64])
+        : attributeU32(fields[NL80211_STA_INFO_RX_BYTES]);
+    return true;
+}
+
+int Nl80211::openSocket(int receiveTimeoutMs) {
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (fd < 0) {
+        qDebug() << "nl80211: cannot open generic netlink socket:" << strerror(errno);
+        return -1;
+    }
+    timeval timeout;
+    timeout.tv_sec = receiveTimeoutMs / 1000;
+    timeout.tv_usec = (receiveTimeoutMs % 1000) * 1000;
+    if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        qDebug() << "nl80211: cannot set receive timeout:" << strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool Nl80211::dumpStations(int fd, const QString &interface, quint32 seq, std::vector<StationInfo> *stations) {
+    int ifindex = static_cast<int>(if_nametoindex(interface.toLocal8Bit().constData()));
+    if (ifindex == 0) {
+        return false;
+    }
+
+    int family = cachedFamily;
+    if ((family == 0 && !resolve(fd, &family)) || !sendStationDump(fd, family, ifindex, seq)) {
+        return false;
+    }
+
+    alignas(nlmsghdr) char buffer[32768];
+    bool done = false;
+    bool ok = true;
+
+    while (!done) {
+        int length = static_cast<int>(::recv(fd, buffer, sizeof(buffer), 0));
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                qDebug() << "nl80211: station dump timed out on" << interface;
+            }
+            ok = false;
+            break;
+        }
+
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, length);
+             header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_seq != seq) {
+                continue; // بقايا تفريغ سابق انقضت مهلته
+            }
+            if (header->nlmsg_type == NLMSG_DONE) {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                // EOPNOTSUPP مثلاً: الواجهة ليست نقطة وصول
+                done = true;
+                ok = false;
+                break;
+            }
+            if (header->nlmsg_type != family) {
+                continue;
+            }
+
+            StationInfo station;
+            const char *payload = static_cast<const char *>(NLMSG_DATA(header)) + GENL_HDRLEN;
+            int payloadLength = static_cast<int>(header->nlmsg_len) - NLMSG_LENGTH(GENL_HDRLEN);
+            if (parseStation(payload, payloadLength, &station)) {
+                stations->push_back(station);
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,54 @@
+#ifndef NL80211_H
+#define NL80211_H
+
+#include <QString>
+#include <vector>
+
+struct nlattr;
+
+// قياسات محطة واحدة كما يعيدها NL80211_CMD_GET_STATION
+struct StationInfo {
+    QString macAddress;
+    int signalDbm = 0;              // 0 = لم يبلغ عنه المشغل
+    int signalAvgDbm = 0;
+    quint32 txBitrateKbps = 0;
+    quint32 rxBitrateKbps = 0;
+    quint32 expectedThroughputKbps = 0;
+    quint32 txPackets = 0;
+    quint32 rxPackets = 0;
+    quint32 txRetries = 0;
+    quint32 txFailed = 0;
+    quint64 txBytes = 0;            // من نقطة الوصول إلى المحطة
+    quint64 rxBytes = 0;            // من المحطة إلى نقطة الوصول
+    quint32 inactiveMs = 0;
+    quint32 connectedSecs = 0;
+};
+
+// وصول مباشر إلى nl80211 عبر generic netlink دون iw أو libnl
+class Nl80211 {
+public:
+    // معرف عائلة nl80211 (ومجموعة mlme اختيارياً) عبر مقبس NETLINK_GENERIC مربوط
+    static bool resolve(int fd, int *family, quint32 *mlmeGroup = nullptr);
+
+    // مقبس NETLINK_GENERIC يبقى مفتوحاً بين التفريغات؛ المهلة تمنع تجميد الحلقة إن لم يجب المشغل
+    static int openSocket(int receiveTimeoutMs);
+
+    // كل المحطات المرتبطة بالواجهة في تفريغ واحد على مقبس openSocket؛ يعيد false
+    // عند فشل netlink أو انقضاء المهلة، وتُهمل ردود تفريغ سابق برقم تسلسل مختلف
+    static bool dumpStations(int fd, const QString &interface, quint32 seq, std::vector<StationInfo> *stations);
+
+    // طلب تفريغ المحطات على مقبس قائم (للمستخدمين غير المتزامنين)
+    static bool sendStationDump(int fd, int family, int ifindex, quint32 seq);
+
+    // تحليل سمات رسالة NEW_STATION (بعد ترويسة genl)
+    static bool parseStation(const void *attributes, int length, StationInfo *station);
+
+    // أدوات السمات المشتركة بين مستخدمي nl80211
+    static void parseAttributes(const void *data, int length, const nlattr **table, int maxType);
+    static const void *attributeData(const nlattr *attribute);
+    static int attributeLength(const nlattr *attribute);
+    static quint32 attributeU32(const nlattr *attribute);
+    static quint16 attributeU16(const nlattr *attribute);
+};
+
+#endif // NL80211_H
@@ -0,0 +1,626 @@
+#include "passivediscovery.h"
+#include "privilegedhelper.h"
+#include <QDebug>
+#include <QHostAddress>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+namespace {
+
+// نافذة إزالة التكرار: لا نعيد الإبلاغ عن نفس الزوج خلال هذه المدة
+const qint64 kDuplicateWindowMs = 10000;
+
+inline quint16 readU16(const uchar *p) {
+    return static_cast<quint16>((p[0] << 8) | p[1]);
+}
+
+QString formatMac(const uchar *mac) {
+    static const char hex[] = "0123456789ABCDEF";
+    QChar buffer[17];
+    for (int i = 0; i < 6; ++i) {
+        buffer[i * 3] = QLatin1Char(hex[mac[i] >> 4]);
+        buffer[i * 3 + 1] = QLatin1Char(hex[mac[i] & 0x0f]);
+        if (i < 5) {
+            buffer[i * 3 + 2] = QLatin1Char(':');
+        }
+    }
+    return QString(buffer, 17);
+}
+
+bool isUsableMac(const uchar *mac) {
+    static const uchar zero[6] = {0, 0, 0, 0, 0, 0};
+    // تجاهل العناوين الصفرية وعناوين البث المتعدد
+    return std::memcmp(mac, zero, 6) != 0 && (mac[0] & 0x01) == 0;
+}
+
+// قراءة اسم DNS مع دعم مؤشرات الضغط
+bool readDnsName(const uchar *msg, unsigned int length, unsigned int &offset, QString *name) {
+    unsigned int pos = offset;
+    bool jumped = false;
+    int hops = 0;
+    QString result;
+
+    while (pos < length) {
+        uchar labelLength = msg[pos];
+        if (labelLength == 0) {
+            if (!jumped) {
+                offset = pos + 1;
+            }
+            if (name) {
+                *name = result;
+            }
+            return true;
+        }
+        if ((labelLength & 0xc0) == 0xc0) {
+            if (pos + 1 >= length || ++hops > 16) {
+                return false;
+            }
+            if (!jumped) {
+                offset = pos + 2;
+            }
+            pos = ((labelLength & 0x3f) << 8) | msg[pos + 1];
+            jumped = true;
+            continue;
+        }
+        if (pos + 1 + labelLength > length) {
+            return false;
+        }
+        if (name) {
+            if (!result.isEmpty()) {
+                result += QLatin1Char('.');
+            }
+            result += QString::fromUtf8(reinterpret_cast<const char *>(msg + pos + 1), labelLength);
+        }
+        pos += 1 + labelLength;
+    }
+    return false;
+}
+
+// مرشح BPF يقبل: ARP، و UDP/IPv4 على المنافذ 67/68/5353/1900،
+// و ICMPv6 من نوع RS/RA/NS/NA/Redirect، و mDNS على UDP/IPv6
+struct sock_filter kDiscoveryFilter[] = {
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),                 // 0: ethertype
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_ARP, 24, 0),  // 1
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 12),   // 2
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),                 // 3: IPv4 protocol
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 17, 0, 22),         // 4: UDP
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),                 // 5: fragment offset
+    BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 20, 0),    // 6
+    BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),                // 7: X = IPv4 header length
+    BPF_STMT(BPF_LD | BPF_H | BPF_IND, 14),                 // 8: source port
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 5353, 16, 0),       // 9
+    BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),                 // 10: destination port
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 67, 14, 0),         // 11
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 68, 13, 0),         // 12
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 5353, 12, 0),       // 13
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 1900, 11, 12),      // 14: SSDP NOTIFY / M-SEARCH
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 11), // 15
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 20),                 // 16: IPv6 next header
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 58, 0, 3),          // 17: ICMPv6
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 54),                 // 18: ICMPv6 type
+    BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, 133, 0, 7),         // 19
+    BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, 137, 6, 5),         // 20
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 17, 0, 5),          // 21: UDP
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 54),                 // 22: source port
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 5353, 2, 0),        // 23
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 56),                 // 24: destination port
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 5353, 0, 1),        // 25
+    BPF_STMT(BPF_RET | BPF_K, 0x40000),                     // 26: قبول
+    BPF_STMT(BPF_RET | BPF_K, 0),                           // 27: رفض
+};
+
+} // namespace
+
+PassiveDiscovery::PassiveDiscovery(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PassiveDiscovery::~PassiveDiscovery() {
+    stop();
+}
+
+bool PassiveDiscovery::start(const QString &interface) {
+    stop();
+
+    unsigned int ifindex = if_nametoindex(interface.toLocal8Bit().constData());
+    if (ifindex == 0) {
+        qDebug() << "Passive discovery: unknown interface" << interface;
+        return false;
+    }
+
+    // عبر المساعد المميز عند تشغيل الواجهة دون صلاحيات الجذر
+    m_socket = PrivilegedHelper::openSocket(PrivilegedHelper::PacketAll);
+    if (m_socket < 0) {
+        qDebug() << "Passive discovery: cannot open AF_PACKET socket:" << strerror(errno);
+        return false;
+    }
+
+    // المرشح قبل الربط حتى لا تتسرب حزم غير مرغوبة إلى الحلقة
+    if (!attachFilter() || !setupRing()) {
+        stop();
+        return false;
+    }
+
+    sockaddr_ll address;
+    std::memset(&address, 0, sizeof(address));
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = static_cast<int>(ifindex);
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        qDebug() << "Passive discovery: bind failed:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &PassiveDiscovery::onReadable);
+    return true;
+}
+
+void PassiveDiscovery::stop() {
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    if (m_ring) {
+        ::munmap(m_ring, m_ringSize);
+        m_ring = nullptr;
+        m_ringSize = 0;
+    }
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+    m_currentBlock = 0;
+    m_recent.clear();
+}
+
+bool PassiveDiscovery::isRunning() const {
+    return m_socket >= 0 && m_ring != nullptr;
+}
+
+bool PassiveDiscovery::attachFilter() {
+    sock_fprog program;
+    program.len = sizeof(kDiscoveryFilter) / sizeof(kDiscoveryFilter[0]);
+    program.filter = kDiscoveryFilter;
+
+    if (::setsockopt(m_socket, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0) {
+        qDebug() << "Passive discovery: cannot attach BPF filter:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool PassiveDiscovery::setupRing() {
+    int version = TPACKET_V3;
+    if (::setsockopt(m_socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        qDebug() << "Passive discovery: TPACKET_V3 not supported:" << strerror(errno);
+        return false;
+    }
+
+    // 16 كتلة × 64KB تكفي بسهولة لحركة الاكتشاف حتى على شبكات مزدحمة
+    tpacket_req3 request;
+    std::memset(&request, 0, sizeof(request));
+    request.tp_block_size = 1 << 16;
+    request.tp_block_nr = 16;
+    request.tp_frame_size = 2048;
+    request.tp_frame_nr = (request.tp_block_size * request.tp_block_nr) / request.tp_frame_size;
+    request.tp_retire_blk_tov = 100; // مللي ثانية قبل تسليم كتلة غير ممتلئة
+
+    if (::setsockopt(m_socket, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0) {
+        qDebug() << "Passive discovery: cannot create RX ring:" << strerror(errno);
+        return false;
+    }
+
+    m_blockSize = request.tp_block_size;
+    m_blockCount = request.tp_block_nr;
+    m_ringSize = static_cast<size_t>(m_blockSize) * m_blockCount;
+
+    void *ring = ::mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, m_socket, 0);
+    if (ring == MAP_FAILED) {
+        // MAP_LOCKED قد يفشل بسبب RLIMIT_MEMLOCK، نعيد المحاولة بدونه
+        ring = ::mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_socket, 0);
+    }
+    if (ring == MAP_FAILED) {
+        qDebug() << "Passive discovery: mmap failed:" << strerror(errno);
+        m_ringSize = 0;
+        return false;
+    }
+
+    m_ring = static_cast<uchar *>(ring);
+    m_currentBlock = 0;
+    return true;
+}
+
+void PassiveDiscovery::onReadable() {
+    if (!m_ring) {
+        return;
+    }
+
+    // معالجة كل الكتل التي سلمتها النواة دون أي نسخ للبيانات
+    for (;;) {
+        auto *block = reinterpret_cast<tpacket_block_desc *>(m_ring + static_cast<size_t>(m_currentBlock) * m_blockSize);
+        if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+            break;
+        }
+
+        unsigned int count = block->hdr.bh1.num_pkts;
+        auto *packet = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uchar *>(block) + block->hdr.bh1.offset_to_first_pkt);
+
+        for (unsigned int i = 0; i < count; ++i) {
+            handleFrame(reinterpret_cast<const uchar *>(packet) + packet->tp_mac, packet->tp_snaplen);
+            packet = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uchar *>(packet) + packet->tp_next_offset);
+        }
+        m_packetsSeen += count;
+
+        __sync_synchronize();
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        m_currentBlock = (m_currentBlock + 1) % m_blockCount;
+    }
+}
+
+void PassiveDiscovery::handleFrame(const uchar *data, unsigned int length) {
+    if (length < ETH_HLEN) {
+        return;
+    }
+
+    switch (readU16(data + 12)) {
+    case ETH_P_ARP:
+        handleArp(data, length);
+        break;
+    case ETH_P_IP:
+        handleIpv4(data, length);
+        break;
+    case ETH_P_IPV6:
+        handleIpv6(data, length);
+        break;
+    default:
+        break;
+    }
+}
+
+bool PassiveDiscovery::decodeArp(const uchar *frame, unsigned int length, const uchar **senderMac,
+                                 quint32 *senderIp, bool *gratuitous) {
+    // Ethernet/IPv4 فقط: 14 + 28 بايت
+    if (length < ETH_HLEN + 28 || readU16(frame + 12) != ETH_P_ARP) {
+        return false;
+    }
+    const uchar *arp = frame + ETH_HLEN;
+    if (readU16(arp) != 1 || readU16(arp + 2) != ETH_P_IP || arp[4] != 6 || arp[5] != 4) {
+        return false;
+    }
+
+    const uchar *sourceIp = arp + 14;
+    const uchar *targetIp = arp + 24;
+    quint32 sender = (quint32(sourceIp[0]) << 24) | (quint32(sourceIp[1]) << 16) |
+                     (quint32(sourceIp[2]) << 8) | sourceIp[3];
+    if (sender == 0) {
+        return false; // ARP probe من جهاز لم يحصل على عنوان بعد
+    }
+
+    *senderMac = arp + 8;
+    *senderIp = sender;
+    *gratuitous = std::memcmp(sourceIp, targetIp, 4) == 0;
+    return isUsableMac(*senderMac);
+}
+
+void PassiveDiscovery::handleArp(const uchar *data, unsigned int length) {
+    const uchar *senderMac = nullptr;
+    quint32 sender = 0;
+    bool gratuitous = false;
+    if (decodeArp(data, length, &senderMac, &sender, &gratuitous)) {
+        report(PassiveObservation::Arp, senderMac, QHostAddress(sender).toString(), QString(), gratuitous);
+    }
+}
+
+void PassiveDiscovery::handleIpv4(const uchar *data, unsigned int length) {
+    if (length < ETH_HLEN + 20) {
+        return;
+    }
+    const uchar *ip = data + ETH_HLEN;
+    unsigned int headerLength = (ip[0] & 0x0f) * 4;
+    if (headerLength < 20 || ip[9] != 17 || length < ETH_HLEN + headerLength + 8) {
+        return;
+    }
+
+    const uchar *udp = ip + headerLength;
+    quint16 sourcePort = readU16(udp);
+    quint16 destinationPort = readU16(udp + 2);
+    const uchar *payload = udp + 8;
+    unsigned int payloadLength = length - ETH_HLEN - headerLength - 8;
+
+    quint32 source = (quint32(ip[12]) << 24) | (quint32(ip[13]) << 16) | (quint32(ip[14]) << 8) | ip[15];
+    if (destinationPort == 67 || destinationPort == 68) {
+        handleDhcp(payload, payloadLength);
+    } else if (source == 0) {
+        return;
+    } else if (sourcePort == 5353 || destinationPort == 5353) {
+        handleMdns(data + 6, QHostAddress(source).toString(), payload, payloadLength);
+    } else if (destinationPort == 1900) {
+        handleSsdp(data + 6, QHostAddress(source).toString(), payload, payloadLength);
+    }
+}
+
+void PassiveDiscovery::handleIpv6(const uchar *data, unsigned int length) {
+    if (length < ETH_HLEN + 40) {
+        return;
+    }
+    const uchar *ip = data + ETH_HLEN;
+    const uchar *sourceMac = data + 6;
+    Q_IPV6ADDR source;
+    std::memcpy(source.c, ip + 8, 16);
+    QHostAddress sourceAddress(source);
+
+    if (ip[6] == 17 && length >= ETH_HLEN + 48) {
+        const uchar *udp = ip + 40;
+        if (readU16(udp) == 5353 || readU16(udp + 2) == 5353) {
+            handleMdns(sourceMac, sourceAddress.toString(), udp + 8, length - ETH_HLEN - 48);
+        }
+        return;
+    }
+
+    if (ip[6] != 58 || length < ETH_HLEN + 44) {
+        return;
+    }
+
+    const uchar *icmp = ip + 40;
+    unsigned int icmpLength = length - ETH_HLEN - 40;
+    uchar type = icmp[0];
+
+    if (type == 136 && icmpLength >= 24) {
+        // Neighbor Advertisement: العنوان الهدف يخص المرسل
+        Q_IPV6ADDR target;
+        std::memcpy(target.c, icmp + 8, 16);
+        const uchar *mac = sourceMac;
+        // خيار Target Link-Layer Address إن وجد
+        for (unsigned int offset = 24; offset + 8 <= icmpLength; ) {
+            unsigned int optionLength = icmp[offset + 1] * 8;
+            if (optionLength == 0) {
+                break;
+            }
+            if (icmp[offset] == 2 && optionLength >= 8) {
+                mac = icmp + offset + 2;
+                break;
+            }
+            offset += optionLength;
+        }
+        report(PassiveObservation::Ndp, mac, QHostAddress(target).toString());
+        return;
+    }
+
+    // RS / RA / NS: المصدر هو الجهاز نفسه ما لم يكن :: (DAD)
+    if (!sourceAddress.isNull() && sourceAddress != QHostAddress(QHostAddress::AnyIPv6)) {
+        report(PassiveObservation::Ndp, sourceMac, sourceAddress.toString());
+    }
+}
+
+void PassiveDiscovery::handleDhcp(const uchar *data, unsigned int length) {
+    // ترويسة BOOTP الثابتة 236 بايت + magic cookie
+    if (length < 240 || data[1] != 1 || data[2] != 6) {
+        return;
+    }
+    if (data[236] != 99 || data[237] != 130 || data[238] != 83 || data[239] != 99) {
+        return;
+    }
+
+    const uchar op = data[0];
+    const uchar *clientMac = data + 28;
+    quint32 clientIp = (quint32(data[12]) << 24) | (quint32(data[13]) << 16) | (quint32(data[14]) << 8) | data[15];
+    quint32 yourIp = (quint32(data[16]) << 24) | (quint32(data[17]) << 16) | (quint32(data[18]) << 8) | data[19];
+    quint32 requestedIp = 0;
+    uchar messageType = 0;
+    QString hostname;
+    PassiveObservation fingerprint;
+
+    for (unsigned int offset = 240; offset < length; ) {
+        uchar code = data[offset];
+        if (code == 255) {
+            break;
+        }
+        if (code == 0) {
+            ++offset;
+            continue;
+        }
+        if (offset + 1 >= length) {
+            break;
+        }
+        uchar optionLength = data[offset + 1];
+        const uchar *value = data + offset + 2;
+        if (offset + 2 + optionLength > length) {
+            break;
+        }
+
+        switch (code) {
+        case 12: // Host Name
+            hostname = QString::fromUtf8(reinterpret_cast<const char *>(value), optionLength);
+            break;
+        case 50: // Requested IP Address
+            if (optionLength == 4) {
+                requestedIp = (quint32(value[0]) << 24) | (quint32(value[1]) << 16) | (quint32(value[2]) << 8) | value[3];
+            }
+            break;
+        case 53: // DHCP Message Type
+            if (optionLength == 1) {
+                messageType = value[0];
+            }
+            break;
+        case 55: // Parameter Request List: ترتيبها يميز نظام التشغيل
+            fingerprint.dhcpParameters = QByteArray(reinterpret_cast<const char *>(value), optionLength);
+            break;
+        case 60: // Vendor Class Identifier
+            fingerprint.vendorClass = QString::fromLatin1(reinterpret_cast<const char *>(value), optionLength);
+            break;
+        default:
+            break;
+        }
+        offset += 2 + optionLength;
+    }
+
+    // نثق بـ yiaddr فقط في DHCPACK القادم من الخادم
+    quint32 address = clientIp;
+    if (op == 2 && messageType == 5 && yourIp != 0) {
+        address = yourIp;
+    } else if (address == 0) {
+        address = requestedIp;
+    }
+
+    // الخياران 55 و 60 يرسلهما العميل فقط؛ ردود الخادم لا تصف الجهاز
+    report(PassiveObservation::Dhcp, clientMac, address ? QHostAddress(address).toString() : QString(), hostname,
+           false, op == 1 ? &fingerprint : nullptr);
+}
+
+void PassiveDiscovery::handleMdns(const uchar *src, const QString &sourceIp, const uchar *data, unsigned int length) {
+    if (length < 12) {
+        return;
+    }
+
+    // نهتم بالردود فقط لأنها تحمل سجلات A/AAAA لاسم الجهاز، وسجلات
+    // PTR/TXT للخدمات التي يعلنها (للبصمة)
+    QString hostname;
+    PassiveObservation fingerprint;
+    if (data[2] & 0x80) {
+        unsigned int questions = readU16(data + 4);
+        unsigned int records = readU16(data + 6) + readU16(data + 8) + readU16(data + 10);
+        unsigned int offset = 12;
+
+        for (unsigned int i = 0; i < questions; ++i) {
+            if (!readDnsName(data, length, offset, nullptr) || offset + 4 > length) {
+                return;
+            }
+            offset += 4;
+        }
+
+        for (unsigned int i = 0; i < records; ++i) {
+            QString name;
+            if (!readDnsName(data, length, offset, &name) || offset + 10 > length) {
+                break;
+            }
+            quint16 type = readU16(data + offset);
+            quint16 dataLength = readU16(data + offset + 8);
+            offset += 10;
+            if (offset + dataLength > length) {
+                break;
+            }
+
+            QString address;
+            if (type == 1 && dataLength == 4) {
+                address = QHostAddress(readU16(data + offset) * 65536u + readU16(data + offset + 2)).toString();
+            } else if (type == 28 && dataLength == 16) {
+                Q_IPV6ADDR v6;
+                std::memcpy(v6.c, data + offset, 16);
+                address = QHostAddress(v6).toString();
+            }
+
+            if (hostname.isEmpty() && !address.isEmpty() && address == sourceIp &&
+                name.endsWith(QLatin1String(".local"))) {
+                hostname = name.left(name.size() - 6);
+            } else if (type == 12 && name.startsWith(QLatin1Char('_')) && name.endsWith(QLatin1String(".local")) &&
+                       !name.startsWith(QLatin1String("_services.")) && fingerprint.services.size() < 16) {
+                // PTR: "_ipp._tcp.local" -> "_ipp._tcp"
+                QString service = name.left(name.size() - 6);
+                int subtype = service.indexOf(QLatin1String("._sub."));
+                if (subtype >= 0) {
+                    service = service.mid(subtype + 6);
+                }
+                if (!fingerprint.services.contains(service)) {
+                    fingerprint.services.append(service);
+                }
+            } else if (type == 16 && fingerprint.model.isEmpty()) {
+                // TXT: سلاسل key=value بطول يسبقها
+                for (unsigned int pos = offset; pos < offset + dataLength;) {
+                    unsigned int entryLength = data[pos];
+                    if (pos + 1 + entryLength > offset + dataLength) {
+                        break;
+                    }
+                    QByteArray entry(reinterpret_cast<const char *>(data + pos + 1), int(entryLength));
+                    if (entry.startsWith("md=") || entry.startsWith("model=") || entry.startsWith("ty=")) {
+                        fingerprint.model = QString::fromUtf8(entry.mid(entry.indexOf('=') + 1));
+                        break;
+                    }
+                    pos += 1 + entryLength;
+                }
+            }
+            offset += dataLength;
+        }
+    }
+
+    report(PassiveObservation::Mdns, src, sourceIp, hostname, false, &fingerprint);
+}
+
+void PassiveDiscovery::handleSsdp(const uchar *src, const QString &sourceIp, const uchar *data, unsigned int length) {
+    // NOTIFY يعلن نوع الجهاز (NT) وخادمه (SERVER). M-SEARCH بحث عن أجهزة غيره:
+    // ST فيه ما يبحث عنه لا ما هو، فلا يؤخذ منه إلا USER-AGENT تلميحاً للطراز
+    QByteArray message(reinterpret_cast<const char *>(data), int(qMin(length, 2048u)));
+    const bool notify = message.startsWith("NOTIFY");
+    if (!notify && !message.startsWith("M-SEARCH")) {
+        return;
+    }
+
+    PassiveObservation fingerprint;
+    const QList<QByteArray> lines = message.split('\n');
+    for (const QByteArray &line : lines) {
+        int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        QByteArray name = line.left(colon).trimmed().toUpper();
+        QString value = QString::fromUtf8(line.mid(colon + 1).trimmed());
+        if (value.isEmpty()) {
+            continue;
+        }
+        if (notify && name == "NT" && value.startsWith(QLatin1String("urn:")) &&
+            !fingerprint.services.contains(value)) {
+            fingerprint.services.append(value);
+        } else if (name == (notify ? "SERVER" : "USER-AGENT")) {
+            fingerprint.model = value;
+        }
+    }
+    report(PassiveObservation::Ssdp, src, sourceIp, QString(), false, &fingerprint);
+}
+
+void PassiveDiscovery::report(PassiveObservation::Source source, const uchar *mac, const QString &ip,
+                              const QString &hostname, bool gratuitous, const PassiveObservation *fingerprint) {
+    if (!isUsableMac(mac)) {
+        return;
+    }
+
+    // ARP المجاني يُمرر دائماً لأن تكراره بحد ذاته معلومة مفيدة
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!gratuitous && hostname.isEmpty() && !(fingerprint && fingerprint->hasFingerprint())) {
+        QByteArray key(reinterpret_cast<const char *>(mac), 6);
+        key += ip.toLatin1();
+        auto it = m_recent.find(key);
+        if (it != m_recent.end() && now - it.value() < kDuplicateWindowMs) {
+            return;
+        }
+        m_recent.insert(key, now);
+        if (m_recent.size() > 4096) {
+            m_recent.clear();
+        }
+    }
+
+    PassiveObservation observation;
+    observation.source = source;
+    observation.macAddress = formatMac(mac);
+    observation.ipAddress = ip;
+    observation.hostname = hostname;
+    observation.isGratuitous = gratuitous;
+    observation.timestamp = QDateTime::fromMSecsSinceEpoch(now);
+    if (fingerprint) {
+        observation.dhcpParameters = fingerprint->dhcpParameters;
+        observation.vendorClass = fingerprint->vendorClass;
+        observation.services = fingerprint->services;
+        observation.model = fingerprint->model;
+    }
+    emit observed(observation);
+}
@@ -0,0 +1,85 @@
+#ifndef PASSIVEDISCOVERY_H
+#define PASSIVEDISCOVERY_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+
+// ملاحظة واحدة مستخلصة من حزمة ملتقطة (ARP / DHCP / mDNS / NDP / SSDP)
+struct PassiveObservation {
+    enum Source { Arp, Dhcp, Mdns, Ndp, Ssdp };
+
+    Source source = Arp;
+    QString macAddress;
+    QString ipAddress;
+    QString hostname;
+    bool isGratuitous = false;
+    QDateTime timestamp;
+
+    // أدلة البصمة عند توفرها (انظر Fingerprinter)
+    QByteArray dhcpParameters;   // قائمة الخيار 55 بترتيبها
+    QString vendorClass;         // الخيار 60
+    QStringList services;        // أنواع خدمات mDNS، أو NT من SSDP NOTIFY
+    QString model;               // md= / model= في TXT، أو SERVER (USER-AGENT في M-SEARCH)
+
+    bool hasFingerprint() const {
+        return !dhcpParameters.isEmpty() || !vendorClass.isEmpty() || !services.isEmpty() || !model.isEmpty();
+    }
+};
+
+// اكتشاف الأجهزة بشكل سلبي عبر الاستماع لحركة الشبكة دون إرسال أي حزم.
+// تُقرأ الحزم من حلقة PACKET_MMAP (TPACKET_V3) مع مرشح BPF في النواة
+// بحيث لا يصل إلى التطبيق إلا ARP و DHCP و mDNS و SSDP و NDP.
+class PassiveDiscovery : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PassiveDiscovery(QObject *parent = nullptr);
+    ~PassiveDiscovery();
+
+    bool start(const QString &interface);
+    void stop();
+    bool isRunning() const;
+
+    quint64 packetsSeen() const { return m_packetsSeen; }
+
+    // فك إطار ARP (Ethernet/IPv4)؛ يُستخدم أيضاً لإعادة تشغيل الالتقاطات المسجلة
+    static bool decodeArp(const uchar *frame, unsigned int length, const uchar **senderMac,
+                          quint32 *senderIp, bool *gratuitous);
+
+signals:
+    void observed(const PassiveObservation &observation);
+
+private slots:
+    void onReadable();
+
+private:
+    int m_socket = -1;
+    uchar *m_ring = nullptr;
+    size_t m_ringSize = 0;
+    unsigned int m_blockSize = 0;
+    unsigned int m_blockCount = 0;
+    unsigned int m_currentBlock = 0;
+    QSocketNotifier *m_notifier = nullptr;
+    quint64 m_packetsSeen = 0;
+
+    // آخر مرة أُبلغ فيها عن كل زوج MAC/IP لتجنب تكرار الإشارات
+    QHash<QByteArray, qint64> m_recent;
+
+    bool attachFilter();
+    bool setupRing();
+    void handleFrame(const uchar *data, unsigned int length);
+    void handleArp(const uchar *data, unsigned int length);
+    void handleIpv4(const uchar *data, unsigned int length);
+    void handleIpv6(const uchar *data, unsigned int length);
+    void handleDhcp(const uchar *data, unsigned int length);
+    void handleMdns(const uchar *src, const QString &sourceIp, const uchar *data, unsigned int length);
+    void handleSsdp(const uchar *src, const QString &sourceIp, const uchar *data, unsigned int length);
+    void report(PassiveObservation::Source source, const uchar *mac, const QString &ip,
+                const QString &hostname = QString(), bool gratuitous = false,
+                const PassiveObservation *fingerprint = nullptr);
+};
+
+#endif // PASSIVEDISCOVERY_H
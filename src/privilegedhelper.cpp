@@ -0,0 +1,465 @@
+#include "privilegedhelper.h"
+#include <QDebug>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// مقبس واحد للعملية كلها؛ الطلبات متزامنة من الخيط الرئيسي
+int g_socket = -1;
+
+const int kMaxFds = 8;
+
+void appendVarint(QByteArray &out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+bool readVarint(const QByteArray &in, int *offset, quint64 *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *offset < in.size(); shift += 7) {
+        quint8 byte = quint8(in[(*offset)++]);
+        *value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool appendMac(QByteArray &out, const QString &mac) {
+    QByteArray bytes = QByteArray::fromHex(mac.toLatin1().replace(':', "").replace('-', ""));
+    if (bytes.size() != 6) {
+        return false;
+    }
+    out += bytes;
+    return true;
+}
+
+bool readMac(const QByteArray &in, int *offset, QString *mac) {
+    if (*offset + 6 > in.size()) {
+        return false;
+    }
+    *mac = QString::fromLatin1(in.mid(*offset, 6).toHex(':').toUpper());
+    *offset += 6;
+    return true;
+}
+
+} // namespace
+
+QString PrivilegedHelper::defaultSocketPath() {
+    QString path = qEnvironmentVariable("WIFIMANAGER_HELPER");
+    return path.isEmpty() ? QString("/run/wifimanager/helper.sock") : path;
+}
+
+bool PrivilegedHelper::connectTo(const QString &path) {
+    disconnect();
+    QByteArray socketPath = (path.isEmpty() ? defaultSocketPath() : path).toLocal8Bit();
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= int(sizeof(address.sun_path))) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.constData(), socketPath.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return false;
+    }
+    g_socket = fd;
+    return true;
+}
+
+bool PrivilegedHelper::isConnected() {
+    return g_socket >= 0;
+}
+
+void PrivilegedHelper::disconnect() {
+    if (g_socket >= 0) {
+        ::close(g_socket);
+        g_socket = -1;
+    }
+}
+
+int PrivilegedHelper::openSocket(SocketKind kind) {
+    if (!isConnected()) {
+        return openSocketLocally(kind);
+    }
+    Batch batch;
+    batch.openSocket(kind);
+    std::vector<Result> results;
+    if (!batch.submit(&results) || results.front().status != Ok) {
+        return -1;
+    }
+    return results.front().fd;
+}
+
+int PrivilegedHelper::openSocketLocally(SocketKind kind) {
+    switch (kind) {
+    case PacketAll:
+        return ::socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    case PacketArp:
+        return ::socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, htons(ETH_P_ARP));
+    case Icmpv6Raw:
+        return ::socket(AF_INET6, SOCK_RAW | SOCK_CLOEXEC, IPPROTO_ICMPV6);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+// --- الدفعات ---
+
+int PrivilegedHelper::Batch::add(Operation operation, const QByteArray &payload) {
+    m_requests.push_back({operation, payload});
+    return static_cast<int>(m_requests.size()) - 1;
+}
+
+int PrivilegedHelper::Batch::listBlocked() {
+    return add(ListBlocked, QByteArray());
+}
+
+int PrivilegedHelper::Batch::setBlocked(const QHash<QString, bool> &changes) {
+    QByteArray payload;
+    QByteArray entries;
+    quint64 count = 0;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (appendMac(entries, it.key())) {
+            entries.append(char(it.value() ? 1 : 0));
+            ++count;
+        }
+    }
+    appendVarint(payload, count);
+    payload += entries;
+    return add(SetBlocked, payload);
+}
+
+int PrivilegedHelper::Batch::readFile(const QString &path) {
+    QByteArray payload;
+    appendBytes(payload, path.toUtf8());
+    return add(ReadFile, payload);
+}
+
+int PrivilegedHelper::Batch::writeFile(const QString &path, const QByteArray &contents) {
+    QByteArray payload;
+    appendBytes(payload, path.toUtf8());
+    appendBytes(payload, contents);
+    return add(WriteFile, payload);
+}
+
+int PrivilegedHelper::Batch::restartService(const QString &unit) {
+    QByteArray payload;
+    appendBytes(payload, unit.toUtf8());
+    return add(RestartService, payload);
+}
+
+int PrivilegedHelper::Batch::openSocket(SocketKind kind) {
+    return add(OpenSocket, QByteArray(1, char(kind)));
+}
+
+int PrivilegedHelper::Batch::hostapdCommand(const QString &interface, const QByteArray &command) {
+    QByteArray payload;
+    appendBytes(payload, interface.toUtf8());
+    appendBytes(payload, command);
+    return add(HostapdCommand, payload);
+}
+
+bool PrivilegedHelper::Batch::submit(std::vector<Result> *results) {
+    results->clear();
+    if (m_requests.empty()) {
+        return true;
+    }
+    if (!isConnected()) {
+        return false;
+    }
+
+    QByteArray request = encodeRequests(m_requests);
+    if (!sendMessage(g_socket, request, {})) {
+        // المساعد أُعيد تشغيله: محاولة واحدة على اتصال جديد
+        if (!connectTo() || !sendMessage(g_socket, request, {})) {
+            disconnect();
+            return false;
+        }
+    }
+
+    QByteArray reply;
+    std::vector<int> fds;
+    if (!receiveMessage(g_socket, &reply, &fds) || !decodeResults(reply, results) ||
+        results->size() != m_requests.size()) {
+        for (int fd : fds) {
+            ::close(fd);
+        }
+        results->clear();
+        qDebug() << "Privileged helper: bad reply, disconnecting";
+        disconnect();
+        return false;
+    }
+
+    size_t nextFd = 0;
+    for (size_t i = 0; i < results->size(); ++i) {
+        Result &result = (*results)[i];
+        if (m_requests[i].operation == OpenSocket && result.status == Ok) {
+            if (nextFd < fds.size()) {
+                result.fd = fds[nextFd++];
+            } else {
+                result.status = Failed;
+            }
+        }
+    }
+    for (; nextFd < fds.size(); ++nextFd) {
+        ::close(fds[nextFd]);
+    }
+    return true;
+}
+
+// --- الترميز ---
+
+void PrivilegedHelper::appendBytes(QByteArray &out, const QByteArray &value) {
+    appendVarint(out, quint64(value.size()));
+    out += value;
+}
+
+bool PrivilegedHelper::decodeBytes(const QByteArray &payload, int *offset, QByteArray *value) {
+    quint64 length = 0;
+    if (!readVarint(payload, offset, &length) || length > quint64(payload.size() - *offset)) {
+        return false;
+    }
+    *value = payload.mid(*offset, int(length));
+    *offset += int(length);
+    return true;
+}
+
+bool PrivilegedHelper::decodeString(const QByteArray &payload, int *offset, QString *value) {
+    QByteArray bytes;
+    if (!decodeBytes(payload, offset, &bytes)) {
+        return false;
+    }
+    *value = QString::fromUtf8(bytes);
+    return true;
+}
+
+QByteArray PrivilegedHelper::encodeRequests(const std::vector<Request> &requests) {
+    QByteArray message;
+    message.append(char(kVersion));
+    appendVarint(message, requests.size());
+    for (const Request &request : requests) {
+        message.append(char(request.operation));
+        appendBytes(message, request.payload);
+    }
+    return message;
+}
+
+bool PrivilegedHelper::decodeRequests(const QByteArray &message, std::vector<Request> *requests) {
+    if (message.isEmpty() || quint8(message[0]) != kVersion) {
+        return false;
+    }
+    int offset = 1;
+    quint64 count = 0;
+    if (!readVarint(message, &offset, &count) || count > quint64(kMaxOperations)) {
+        return false;
+    }
+    requests->clear();
+    requests->reserve(count);
+    for (quint64 i = 0; i < count; ++i) {
+        if (offset >= message.size()) {
+            return false;
+        }
+        Request request;
+        request.operation = static_cast<Operation>(quint8(message[offset++]));
+        if (!decodeBytes(message, &offset, &request.payload)) {
+            return false;
+        }
+        requests->push_back(request);
+    }
+    return offset == message.size();
+}
+
+QByteArray PrivilegedHelper::encodeResults(const std::vector<Result> &results) {
+    QByteArray message;
+    message.append(char(kVersion));
+    appendVarint(message, results.size());
+    for (const Result &result : results) {
+        message.append(char(result.status));
+        appendBytes(message, result.payload);
+    }
+    return message;
+}
+
+bool PrivilegedHelper::decodeResults(const QByteArray &message, std::vector<Result> *results) {
+    if (message.isEmpty() || quint8(message[0]) != kVersion) {
+        return false;
+    }
+    int offset = 1;
+    quint64 count = 0;
+    if (!readVarint(message, &offset, &count) || count > quint64(kMaxOperations)) {
+        return false;
+    }
+    results->clear();
+    results->reserve(count);
+    for (quint64 i = 0; i < count; ++i) {
+        if (offset >= message.size()) {
+            return false;
+        }
+        Result result;
+        result.status = static_cast<Status>(quint8(message[offset++]));
+        if (!decodeBytes(message, &offset, &result.payload)) {
+            return false;
+        }
+        results->push_back(result);
+    }
+    return offset == message.size();
+}
+
+QByteArray PrivilegedHelper::encodeBlockRules(const Firewall::BlockRules &rules) {
+    QHash<QString, std::pair<int, int>> merged;
+    for (auto it = rules.input.constBegin(); it != rules.input.constEnd(); ++it) {
+        merged[it.key()].first = it.value();
+    }
+    for (auto it = rules.forward.constBegin(); it != rules.forward.constEnd(); ++it) {
+        merged[it.key()].second = it.value();
+    }
+
+    QByteArray entries;
+    quint64 count = 0;
+    for (auto it = merged.constBegin(); it != merged.constEnd(); ++it) {
+        if (appendMac(entries, it.key())) {
+            appendVarint(entries, quint64(it.value().first));
+            appendVarint(entries, quint64(it.value().second));
+            ++count;
+        }
+    }
+    QByteArray payload;
+    appendVarint(payload, count);
+    return payload + entries;
+}
+
+bool PrivilegedHelper::decodeBlockRules(const QByteArray &payload, Firewall::BlockRules *rules) {
+    int offset = 0;
+    quint64 count = 0;
+    if (!readVarint(payload, &offset, &count)) {
+        return false;
+    }
+    for (quint64 i = 0; i < count; ++i) {
+        QString mac;
+        quint64 input = 0;
+        quint64 forward = 0;
+        if (!readMac(payload, &offset, &mac) || !readVarint(payload, &offset, &input) ||
+            !readVarint(payload, &offset, &forward)) {
+            return false;
+        }
+        if (input > 0) {
+            rules->input.insert(mac, int(input));
+        }
+        if (forward > 0) {
+            rules->forward.insert(mac, int(forward));
+        }
+    }
+    return true;
+}
+
+bool PrivilegedHelper::decodeBlockChanges(const QByteArray &payload, QHash<QString, bool> *changes) {
+    int offset = 0;
+    quint64 count = 0;
+    if (!readVarint(payload, &offset, &count)) {
+        return false;
+    }
+    for (quint64 i = 0; i < count; ++i) {
+        QString mac;
+        if (!readMac(payload, &offset, &mac) || offset >= payload.size()) {
+            return false;
+        }
+        changes->insert(mac, payload[offset++] != 0);
+    }
+    return offset == payload.size();
+}
+
+// --- النقل ---
+
+bool PrivilegedHelper::sendMessage(int fd, const QByteArray &message, const std::vector<int> &fds) {
+    if (message.size() > kMaxMessageBytes) {
+        qDebug() << "Privileged helper: message too large" << message.size();
+        return false;
+    }
+    iovec iov;
+    iov.iov_base = const_cast<char *>(message.constData());
+    iov.iov_len = size_t(message.size());
+
+    msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    if (!fds.empty()) {
+        size_t count = std::min(fds.size(), size_t(kMaxFds));
+        std::memset(control, 0, sizeof(control));
+        header.msg_control = control;
+        header.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * count);
+    }
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &header, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == message.size();
+}
+
+bool PrivilegedHelper::receiveMessage(int fd, QByteArray *message, std::vector<int> *fds) {
+    message->resize(kMaxMessageBytes);
+    iovec iov;
+    iov.iov_base = message->data();
+    iov.iov_len = size_t(message->size());
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &header, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        message->clear();
+        return false;
+    }
+    message->resize(int(received));
+
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = int((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            const int *received = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            for (int i = 0; i < count; ++i) {
+                if (fds) {
+                    fds->push_back(received[i]);
+                } else {
+                    ::close(received[i]);
+                }
+            }
+        }
+    }
+    // رسالة مقطوعة أكبر من الحد تُرفض كاملة
+    return !(header.msg_flags & (MSG_TRUNC | MSG_CTRUNC));
+}
@@ -0,0 +1,113 @@
+#ifndef PRIVILEGEDHELPER_H
+#define PRIVILEGEDHELPER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include <vector>
+#include "firewall.h"
+
+// عميل المساعد المميز (wifimanager-helper) وبروتوكوله. المساعد وحده يحمل
+// CAP_NET_ADMIN و CAP_NET_RAW ويستمع على مقبس UNIX من نوع SOCK_SEQPACKET،
+// فتبقى الواجهة بصلاحيات مستخدم عادي.
+//
+// الرسالة دفعة من العمليات في اتجاه واحد ورد واحد بالترتيب نفسه:
+//   الطلب: بايت الإصدار، varint العدد، ثم لكل عملية: بايت النوع، varint الطول، الحمولة
+//   الرد:  بايت الإصدار، varint العدد، ثم لكل عملية: بايت الحالة، varint الطول، الحمولة
+// المقابس المفتوحة تعود في بيانات SCM_RIGHTS بترتيب عمليات OpenSocket الناجحة.
+// النصوص varint طول + UTF-8، والـ MAC ستة بايتات خام.
+//
+// دون مساعد متصل تُنفذ العمليات نفسها داخل العملية (تشغيل التطبيق كجذر).
+class PrivilegedHelper {
+public:
+    static constexpr quint8 kVersion = 1;
+    // أقل من SO_SNDBUF الافتراضي (net.core.wmem_default ≈ 208 KB) بهامش كافٍ،
+    // فرسالة SOCK_SEQPACKET واحدة لا تفشل بـ EMSGSIZE؛ ملفات الإعداد أصغر بكثير
+    static constexpr int kMaxMessageBytes = 64 * 1024;
+    static constexpr int kMaxOperations = 64;
+
+    enum Operation : quint8 {
+        ListBlocked = 1,     // -> varint n، ثم (MAC، varint نسخ INPUT، varint نسخ FORWARD)
+        SetBlocked = 2,      // varint n، ثم (MAC، بايت حظر/إلغاء)
+        ReadFile = 3,        // مسار -> المحتوى
+        WriteFile = 4,       // مسار، محتوى (كتابة ذرية مع الحفاظ على الصلاحيات)
+        RestartService = 5,  // اسم الوحدة
+        OpenSocket = 6,      // بايت SocketKind -> واصف عبر SCM_RIGHTS
+        HostapdCommand = 7   // واجهة، أمر (RELOAD أو PING) -> رد hostapd
+    };
+
+    enum Status : quint8 {
+        Ok = 0,
+        Denied = 1,          // خارج القائمة المسموحة للمساعد
+        Failed = 2,
+        BadRequest = 3
+    };
+
+    enum SocketKind : quint8 {
+        PacketAll = 1,       // AF_PACKET/SOCK_RAW/ETH_P_ALL للاكتشاف السلبي
+        PacketArp = 2,       // AF_PACKET/SOCK_DGRAM/ETH_P_ARP لفحوص ARP الأحادية
+        Icmpv6Raw = 3        // ICMPv6 خام لطلب صدى all-nodes
+    };
+
+    struct Request {
+        Operation operation;
+        QByteArray payload;
+    };
+
+    struct Result {
+        Status status = Failed;
+        QByteArray payload;  // البيانات عند النجاح، أو رسالة الخطأ
+        int fd = -1;         // لعمليات OpenSocket
+    };
+
+    // دفعة عمليات تُرسل في رسالة واحدة؛ عمليات مستقلة لا تنتظر بعضها
+    class Batch {
+    public:
+        int listBlocked();
+        int setBlocked(const QHash<QString, bool> &changes);
+        int readFile(const QString &path);
+        int writeFile(const QString &path, const QByteArray &contents);
+        int restartService(const QString &unit);
+        int openSocket(SocketKind kind);
+        int hostapdCommand(const QString &interface, const QByteArray &command);
+
+        int size() const { return static_cast<int>(m_requests.size()); }
+
+        // false عند فشل النقل؛ فشل عملية واحدة يظهر في حالتها فقط
+        bool submit(std::vector<Result> *results);
+
+    private:
+        std::vector<Request> m_requests;
+        int add(Operation operation, const QByteArray &payload);
+    };
+
+    static QString defaultSocketPath();
+    static bool connectTo(const QString &path = QString());
+    static bool isConnected();
+    static void disconnect();
+
+    // مقبس خام عبر المساعد إن وُجد، وإلا مباشرة (يتطلب الجذر)
+    static int openSocket(SocketKind kind);
+
+    // ترميز مشترك بين العميل والمساعد
+    static QByteArray encodeRequests(const std::vector<Request> &requests);
+    static bool decodeRequests(const QByteArray &message, std::vector<Request> *requests);
+    static QByteArray encodeResults(const std::vector<Result> &results);
+    static bool decodeResults(const QByteArray &message, std::vector<Result> *results);
+
+    static QByteArray encodeBlockRules(const Firewall::BlockRules &rules);
+    static bool decodeBlockRules(const QByteArray &payload, Firewall::BlockRules *rules);
+    static bool decodeBlockChanges(const QByteArray &payload, QHash<QString, bool> *changes);
+    static bool decodeString(const QByteArray &payload, int *offset, QString *value);
+    static bool decodeBytes(const QByteArray &payload, int *offset, QByteArray *value);
+    static void appendBytes(QByteArray &out, const QByteArray &value);
+
+    // فتح المقبس محلياً بنفس الأعلام في الحالتين
+    static int openSocketLocally(SocketKind kind);
+
+    // إرسال واستقبال رسالة مع واصفات SCM_RIGHTS
+    static bool sendMessage(int fd, const QByteArray &message, const std::vector<int> &fds);
+    static bool receiveMessage(int fd, QByteArray *message, std::vector<int> *fds);
+};
+
+#endif // PRIVILEGEDHELPER_H
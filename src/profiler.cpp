@@ -0,0 +1,290 @@
+#include "profiler.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+// مدرج لوغاريتمي-خطي: 4 خانات لكل قوة من 2، أي خطأ تقديري أقل من 12.5%
+const int kSubBuckets = 4;
+const int kBuckets = 62 * kSubBuckets;
+const int kTraceEvents = 4096;
+
+struct ProbeStats {
+    std::atomic<quint64> count;
+    std::atomic<qint64> totalNs;
+    std::atomic<qint64> maxNs;
+    std::atomic<quint64> buckets[kBuckets];
+};
+
+struct TraceEvent {
+    std::atomic<qint64> startNs;
+    std::atomic<qint64> durationNs;
+    std::atomic<int> probe;
+};
+
+// يكتب فيها خيط واحد فقط، فالتحديث تحميل ثم تخزين بدلاً من fetch_add.
+// القارئ قد يرى قيمة متأخرة بحدث أو اثنين، وهذا مقبول للتشخيص.
+struct ThreadData {
+    int index;
+    QString name;
+    std::atomic<quint64> epoch;
+    std::atomic<quint64> traceHead;
+    ProbeStats probes[Profiler::ProbeCount];
+    TraceEvent trace[kTraceEvents];
+};
+
+std::mutex g_registryMutex;
+std::vector<std::unique_ptr<ThreadData>> g_threads;
+std::atomic<quint64> g_epoch{1};
+const auto g_origin = std::chrono::steady_clock::now();
+
+thread_local ThreadData *t_data = nullptr;
+
+template <typename T>
+inline void bump(std::atomic<T> &value, T delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline int bucketFor(qint64 ns) {
+    quint64 value = ns > 0 ? static_cast<quint64>(ns) : 0;
+    if (value < kSubBuckets) {
+        return static_cast<int>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int sub = static_cast<int>((value >> (msb - 2)) & (kSubBuckets - 1));
+    return std::min(kBuckets - 1, (msb - 1) * kSubBuckets + sub);
+}
+
+// منتصف مدى الخانة بالنانوثانية
+qint64 bucketMidpoint(int bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int msb = bucket / kSubBuckets + 1;
+    qint64 sub = bucket % kSubBuckets;
+    qint64 lower = (kSubBuckets + sub) << (msb - 2);
+    qint64 width = qint64(1) << (msb - 2);
+    return lower + width / 2;
+}
+
+void clearThreadData(ThreadData *data) {
+    for (ProbeStats &stats : data->probes) {
+        stats.count.store(0, std::memory_order_relaxed);
+        stats.totalNs.store(0, std::memory_order_relaxed);
+        stats.maxNs.store(0, std::memory_order_relaxed);
+        for (auto &bucket : stats.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    data->traceHead.store(0, std::memory_order_release);
+}
+
+ThreadData *registerThread() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    auto data = std::make_unique<ThreadData>();
+    data->index = static_cast<int>(g_threads.size());
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        data->name = "main";
+    } else if (thread && !thread->objectName().isEmpty()) {
+        data->name = thread->objectName();
+    } else {
+        data->name = QString("thread-%1").arg(data->index);
+    }
+    data->epoch.store(g_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // البيانات تبقى بعد انتهاء الخيط حتى تظهر في التصدير
+    g_threads.push_back(std::move(data));
+    return g_threads.back().get();
+}
+
+double toUs(qint64 ns) {
+    return ns / 1000.0;
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::s_enabled{false};
+
+void Profiler::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Profiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_origin).count();
+}
+
+void Profiler::record(Probe probe, qint64 startNs, qint64 durationNs) {
+    ThreadData *data = t_data;
+    if (!data) {
+        data = t_data = registerThread();
+    }
+
+    // التصفير يتم من الخيط المالك نفسه عند أول تسجيل بعد reset()
+    quint64 epoch = g_epoch.load(std::memory_order_relaxed);
+    if (data->epoch.load(std::memory_order_relaxed) != epoch) {
+        clearThreadData(data);
+        data->epoch.store(epoch, std::memory_order_relaxed);
+    }
+
+    ProbeStats &stats = data->probes[probe];
+    bump<quint64>(stats.count, 1);
+    bump<qint64>(stats.totalNs, durationNs);
+    if (durationNs > stats.maxNs.load(std::memory_order_relaxed)) {
+        stats.maxNs.store(durationNs, std::memory_order_relaxed);
+    }
+    bump<quint64>(stats.buckets[bucketFor(durationNs)], 1);
+
+    quint64 head = data->traceHead.load(std::memory_order_relaxed);
+    TraceEvent &event = data->trace[head % kTraceEvents];
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.durationNs.store(durationNs, std::memory_order_relaxed);
+    event.probe.store(probe, std::memory_order_relaxed);
+    data->traceHead.store(head + 1, std::memory_order_release);
+}
+
+const char *Profiler::probeName(Probe probe) {
+    switch (probe) {
+    case ExecuteCommand: return "executeCommand";
+    case ScanNmap: return "scanWithNmap";
+    case ScanArpScan: return "scanWithArpScan";
+    case ScanArpTable: return "scanWithArpTable";
+    case GetHostname: return "getHostname";
+    case ReadInterfaceStats: return "readInterfaceStats";
+    case UpdateDeviceTable: return "updateDeviceTable";
+    case UpdateChart: return "updateChart";
+    case StartupFirstFrame: return "startupFirstFrame";
+    case StationDump: return "nl80211StationDump";
+    case DnsLogRead: return "dnsLogRead";
+    case ProbeCount: break;
+    }
+    return "unknown";
+}
+
+std::vector<Profiler::Summary> Profiler::summaries() {
+    std::vector<Summary> result(ProbeCount);
+    std::vector<std::vector<quint64>> buckets(ProbeCount, std::vector<quint64>(kBuckets, 0));
+    quint64 epoch = g_epoch.load(std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        for (const auto &data : g_threads) {
+            if (data->epoch.load(std::memory_order_relaxed) != epoch) {
+                continue; // لم يسجل شيئاً منذ آخر تصفير
+            }
+            for (int p = 0; p < ProbeCount; ++p) {
+                const ProbeStats &stats = data->probes[p];
+                result[p].count += stats.count.load(std::memory_order_relaxed);
+                result[p].totalNs += stats.totalNs.load(std::memory_order_relaxed);
+                result[p].maxNs = std::max(result[p].maxNs, stats.maxNs.load(std::memory_order_relaxed));
+                for (int b = 0; b < kBuckets; ++b) {
+                    buckets[p][b] += stats.buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    for (int p = 0; p < ProbeCount; ++p) {
+        Summary &summary = result[p];
+        summary.probe = static_cast<Probe>(p);
+
+        quint64 total = 0;
+        for (quint64 n : buckets[p]) {
+            total += n;
+        }
+        if (total == 0) {
+            continue;
+        }
+
+        const double quantiles[] = {0.50, 0.95, 0.99};
+        qint64 *targets[] = {&summary.p50Ns, &summary.p95Ns, &summary.p99Ns};
+        for (int q = 0; q < 3; ++q) {
+            quint64 rank = static_cast<quint64>(quantiles[q] * (total - 1)) + 1;
+            quint64 seen = 0;
+            for (int b = 0; b < kBuckets; ++b) {
+                seen += buckets[p][b];
+                if (seen >= rank) {
+                    *targets[q] = std::min(bucketMidpoint(b), summary.maxNs);
+                    break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void Profiler::reset() {
+    g_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+QByteArray Profiler::toJson() {
+    QJsonArray probes;
+    for (const Summary &summary : summaries()) {
+        QJsonObject object;
+        object["name"] = probeName(summary.probe);
+        object["count"] = static_cast<qint64>(summary.count);
+        object["total_ms"] = summary.totalNs / 1e6;
+        object["mean_us"] = summary.count ? toUs(summary.totalNs) / summary.count : 0.0;
+        object["p50_us"] = toUs(summary.p50Ns);
+        object["p95_us"] = toUs(summary.p95Ns);
+        object["p99_us"] = toUs(summary.p99Ns);
+        object["max_us"] = toUs(summary.maxNs);
+        probes.append(object);
+    }
+
+    QJsonObject root;
+    root["enabled"] = isEnabled();
+    root["uptime_ms"] = nowNs() / 1e6;
+    root["probes"] = probes;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+QByteArray Profiler::toChromeTrace() {
+    QJsonArray events;
+    const qint64 pid = getpid();
+    quint64 epoch = g_epoch.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    for (const auto &data : g_threads) {
+        if (data->epoch.load(std::memory_order_relaxed) != epoch) {
+            continue;
+        }
+
+        QJsonObject threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = pid;
+        threadName["tid"] = data->index;
+        threadName["args"] = QJsonObject{{"name", data->name}};
+        events.append(threadName);
+
+        quint64 head = data->traceHead.load(std::memory_order_acquire);
+        quint64 first = head > static_cast<quint64>(kTraceEvents) ? head - kTraceEvents : 0;
+        for (quint64 i = first; i < head; ++i) {
+            const TraceEvent &event = data->trace[i % kTraceEvents];
+            QJsonObject object;
+            object["name"] = probeName(static_cast<Probe>(event.probe.load(std::memory_order_relaxed)));
+            object["cat"] = "wifimanager";
+            object["ph"] = "X";
+            object["ts"] = toUs(event.startNs.load(std::memory_order_relaxed));
+            object["dur"] = toUs(event.durationNs.load(std::memory_order_relaxed));
+            object["pid"] = pid;
+            object["tid"] = data->index;
+            events.append(object);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
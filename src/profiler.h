@@ -0,0 +1,87 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+// قياس زمني خفيف للمسارات الساخنة (تشغيل الأوامر، المسح، DNS، قراءة
+// الإحصائيات، تحديث الجدول والرسم). كل خيط يكتب في مدرج تكراري خاص به
+// دون أقفال، والقراءة تجمع الخيوط عند الطلب فقط.
+// عند التعطيل تكلفة ScopedTimer قراءة ذرية واحدة وتفرع.
+class Profiler {
+public:
+    enum Probe {
+        ExecuteCommand,
+        ScanNmap,
+        ScanArpScan,
+        ScanArpTable,
+        GetHostname,
+        ReadInterfaceStats,
+        UpdateDeviceTable,
+        UpdateChart,
+        StartupFirstFrame,
+        StationDump,
+        DnsLogRead,
+        ProbeCount
+    };
+
+    struct Summary {
+        Probe probe;
+        quint64 count = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        qint64 p50Ns = 0;
+        qint64 p95Ns = 0;
+        qint64 p99Ns = 0;
+    };
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    static qint64 nowNs();
+    static void record(Probe probe, qint64 startNs, qint64 durationNs);
+
+    static const char *probeName(Probe probe);
+    static std::vector<Summary> summaries();
+    static void reset();
+
+    // ملخص المدرجات بصيغة JSON، وآخر الأحداث بصيغة Chrome trace
+    // (تُفتح في chrome://tracing أو Perfetto)
+    static QByteArray toJson();
+    static QByteArray toChromeTrace();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Profiler::Probe probe)
+        : m_probe(probe), m_startNs(Profiler::isEnabled() ? Profiler::nowNs() : -1) {}
+
+    ~ScopedTimer() {
+        if (m_startNs >= 0) {
+            Profiler::record(m_probe, m_startNs, Profiler::nowNs() - m_startNs);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Profiler::Probe m_probe;
+    qint64 m_startNs;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#ifdef WIFIMANAGER_NO_PROFILING
+#define PROFILE_SCOPE(probe) do { } while (0)
+#else
+#define PROFILE_SCOPE(probe) ScopedTimer PROFILER_CONCAT(profileScope_, __LINE__)(Profiler::probe)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,138 @@
+#include "profilerdialog.h"
+#include "profiler.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+
+namespace {
+
+// عرض المدة بوحدة مناسبة (ميكروثانية أو ملي ثانية أو ثانية)
+QString formatDuration(qint64 ns) {
+    if (ns < 1000000) {
+        return QString("%1 µs").arg(ns / 1000.0, 0, 'f', 1);
+    }
+    if (ns < 1000000000) {
+        return QString("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+    }
+    return QString("%1 s").arg(ns / 1e9, 0, 'f', 2);
+}
+
+} // namespace
+
+ProfilerDialog::ProfilerDialog(QWidget *parent)
+    : QDialog(parent), m_refreshTimer(new QTimer(this))
+{
+    setWindowTitle("لوحة الأداء");
+    resize(760, 360);
+
+    m_enabledBox = new QCheckBox("تفعيل القياس", this);
+    m_enabledBox->setChecked(Profiler::isEnabled());
+
+    m_table = new QTableWidget(0, 8, this);
+    m_table->setHorizontalHeaderLabels({"المسار", "العدد", "المتوسط", "p50", "p95", "p99", "الأقصى", "الإجمالي"});
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+
+    QPushButton *resetBtn = new QPushButton("تصفير", this);
+    QPushButton *jsonBtn = new QPushButton("تصدير JSON", this);
+    QPushButton *traceBtn = new QPushButton("تصدير Chrome trace", this);
+    QPushButton *closeBtn = new QPushButton("إغلاق", this);
+
+    QHBoxLayout *buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addWidget(m_enabledBox);
+    buttonsLayout->addStretch();
+    buttonsLayout->addWidget(resetBtn);
+    buttonsLayout->addWidget(jsonBtn);
+    buttonsLayout->addWidget(traceBtn);
+    buttonsLayout->addWidget(closeBtn);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addLayout(buttonsLayout);
+
+    connect(m_enabledBox, &QCheckBox::toggled, this, [](bool checked) {
+        Profiler::setEnabled(checked);
+    });
+    connect(resetBtn, &QPushButton::clicked, this, [this]() {
+        Profiler::reset();
+        refresh();
+    });
+    connect(jsonBtn, &QPushButton::clicked, this, &ProfilerDialog::exportJson);
+    connect(traceBtn, &QPushButton::clicked, this, &ProfilerDialog::exportChromeTrace);
+    connect(closeBtn, &QPushButton::clicked, this, &QDialog::close);
+
+    // التحديث فقط أثناء ظهور النافذة
+    m_refreshTimer->setInterval(1000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &ProfilerDialog::refresh);
+}
+
+void ProfilerDialog::showEvent(QShowEvent *event) {
+    QDialog::showEvent(event);
+    m_enabledBox->setChecked(Profiler::isEnabled());
+    refresh();
+    m_refreshTimer->start();
+}
+
+void ProfilerDialog::hideEvent(QHideEvent *event) {
+    m_refreshTimer->stop();
+    QDialog::hideEvent(event);
+}
+
+void ProfilerDialog::refresh() {
+    std::vector<Profiler::Summary> summaries = Profiler::summaries();
+    m_table->setRowCount(static_cast<int>(summaries.size()));
+
+    for (size_t i = 0; i < summaries.size(); ++i) {
+        const Profiler::Summary &summary = summaries[i];
+        qint64 mean = summary.count ? summary.totalNs / static_cast<qint64>(summary.count) : 0;
+        QStringList cells = {
+            Profiler::probeName(summary.probe),
+            QString::number(summary.count),
+            formatDuration(mean),
+            formatDuration(summary.p50Ns),
+            formatDuration(summary.p95Ns),
+            formatDuration(summary.p99Ns),
+            formatDuration(summary.maxNs),
+            formatDuration(summary.totalNs)
+        };
+        for (int column = 0; column < cells.size(); ++column) {
+            QTableWidgetItem *item = m_table->item(static_cast<int>(i), column);
+            if (!item) {
+                item = new QTableWidgetItem();
+                m_table->setItem(static_cast<int>(i), column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
+
+void ProfilerDialog::exportJson() {
+    saveToFile("تصدير JSON", "wifimanager-profile.json", "JSON (*.json)", Profiler::toJson());
+}
+
+void ProfilerDialog::exportChromeTrace() {
+    saveToFile("تصدير Chrome trace", "wifimanager-trace.json", "Chrome trace (*.json)",
+               Profiler::toChromeTrace());
+}
+
+void ProfilerDialog::saveToFile(const QString &title, const QString &defaultName,
+                                const QString &filter, const QByteArray &data) {
+    QString path = QFileDialog::getSaveFileName(this, title, defaultName, filter);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size()) {
+        QMessageBox::warning(this, "خطأ", QString("فشل حفظ الملف:\n%1").arg(file.errorString()));
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PROFILERDIALOG_H
+#define PROFILERDIALOG_H
+
+#include <QDialog>
+
+QT_BEGIN_NAMESPACE
+class QTableWidget;
+class QCheckBox;
+class QTimer;
+QT_END_NAMESPACE
+
+// لوحة تشخيص الأداء: زمن كل مسار ساخن (العدد، المتوسط، المئينات، الأقصى)
+// مع التصدير إلى JSON أو Chrome trace
+class ProfilerDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ProfilerDialog(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void exportJson();
+    void exportChromeTrace();
+
+private:
+    QTableWidget *m_table;
+    QCheckBox *m_enabledBox;
+    QTimer *m_refreshTimer;
+
+    void saveToFile(const QString &title, const QString &defaultName,
+                    const QString &filter, const QByteArray &data);
+};
+
+#endif // PROFILERDIALOG_H
@@ -0,0 +1,183 @@
+#include "scanscheduler.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const qint64 kBudgetWindowMs = 60000;
+
+// تغيير أكثر من 3 أجهزة في الدورة بشكل مستمر يبرر مسحاً كاملاً مبكراً
+const double kChurnSweepThreshold = 3.0;
+const qint64 kChurnSweepMinGapMs = 60000;
+
+} // namespace
+
+ScanScheduler::ScanScheduler(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ScanScheduler::onTick);
+    m_clock.start();
+}
+
+void ScanScheduler::start(int initialDelayMs) {
+    m_running = true;
+    m_interval = m_minInterval;
+    m_counters.currentIntervalMs = m_interval;
+    // أول دورة ستختار مسحاً كاملاً لأنه لم يحدث أي مسح بعد
+    m_timer->start(std::max(0, initialDelayMs));
+}
+
+void ScanScheduler::stop() {
+    m_running = false;
+    m_timer->stop();
+}
+
+bool ScanScheduler::isRunning() const {
+    return m_running;
+}
+
+void ScanScheduler::setBudget(const Budget &budget) {
+    m_budget = budget;
+}
+
+void ScanScheduler::setIntervalRange(int minMs, int maxMs) {
+    m_minInterval = std::max(100, minMs);
+    m_maxInterval = std::max(m_minInterval, maxMs);
+    m_interval = std::clamp(m_interval, m_minInterval, m_maxInterval);
+}
+
+void ScanScheduler::setFullSweepInterval(int ms) {
+    m_fullSweepInterval = ms;
+}
+
+void ScanScheduler::setReprobeCandidates(int count) {
+    m_reprobeCandidates = count;
+
+    // فحوصات مستحقة لا تنتظر الفاصل الطويل
+    if (count > 0 && m_timer->isActive() && m_timer->remainingTime() > m_minInterval) {
+        reschedule(m_minInterval);
+    }
+}
+
+void ScanScheduler::noteNetworkEvent() {
+    ++m_pendingEvents;
+
+    // حدث في جدول الجيران: نقدم الدورة التالية بدلاً من انتظار الفاصل الطويل
+    if (m_timer->isActive() && m_timer->remainingTime() > m_minInterval) {
+        reschedule(m_minInterval);
+    }
+}
+
+void ScanScheduler::requestFullSweep() {
+    m_fullSweepRequested = true;
+    if (m_timer->isActive()) {
+        reschedule(0);
+    }
+}
+
+void ScanScheduler::onTick() {
+    Depth depth = chooseDepth();
+    m_pendingEvents = 0;
+    emit scanRequested(depth);
+}
+
+ScanScheduler::Depth ScanScheduler::chooseDepth() {
+    expireWindow();
+    qint64 now = m_clock.elapsed();
+    qint64 sinceSweep = m_lastFullSweep < 0 ? std::numeric_limits<qint64>::max() : now - m_lastFullSweep;
+
+    bool sweepDue = m_fullSweepRequested ||
+                    sinceSweep >= m_fullSweepInterval ||
+                    (m_churn >= kChurnSweepThreshold && sinceSweep >= kChurnSweepMinGapMs);
+
+    if (sweepDue) {
+        // الطلب الصريح من المستخدم يتجاوز الميزانية
+        if (m_fullSweepRequested ||
+            fitsBudget(static_cast<int>(m_counters.lastFullSweepMs), m_expectedSweepPackets)) {
+            return FullSweep;
+        }
+        ++m_counters.budgetDowngrades;
+    }
+
+    // WifiManager يرسل 64 فحصاً كحد أقصى في الدورة
+    if (m_reprobeCandidates > 0 && fitsBudget(0, std::min(m_reprobeCandidates, 64))) {
+        return Reprobe;
+    }
+
+    return NeighborRead;
+}
+
+void ScanScheduler::reportScan(Depth depth, int changes, qint64 durationMs, int packets) {
+    qint64 now = m_clock.elapsed();
+
+    switch (depth) {
+    case NeighborRead:
+        ++m_counters.neighborReads;
+        break;
+    case Reprobe:
+        ++m_counters.reprobes;
+        break;
+    case FullSweep:
+        ++m_counters.fullSweeps;
+        m_counters.lastFullSweepMs = durationMs;
+        m_lastFullSweep = now;
+        m_fullSweepRequested = false;
+        m_expectedSweepPackets = std::max(packets, 1);
+        break;
+    }
+
+    m_counters.packetsSent += static_cast<quint64>(packets);
+    m_counters.totalScanMs += durationMs;
+    m_window.push_back({now, static_cast<int>(durationMs), packets});
+
+    // الفاصل يتقلص عند وجود تغييرات ويتمدد تدريجياً عند الهدوء
+    m_churn = 0.7 * m_churn + 0.3 * changes;
+    if (changes > 0 || m_pendingEvents > 0) {
+        m_interval = std::max(m_minInterval, m_interval / 2);
+    } else {
+        m_interval = std::min(m_maxInterval, m_interval * 3 / 2);
+    }
+    m_counters.currentIntervalMs = m_interval;
+
+    reschedule(m_fullSweepRequested ? 0 : m_interval);
+}
+
+bool ScanScheduler::fitsBudget(int scanMs, int packets) {
+    int usedMs = 0;
+    int usedPackets = 0;
+    for (const Sample &sample : m_window) {
+        usedMs += sample.scanMs;
+        usedPackets += sample.packets;
+    }
+    return usedMs + scanMs <= m_budget.scanMsPerMinute &&
+           usedPackets + packets <= m_budget.packetsPerMinute;
+}
+
+void ScanScheduler::expireWindow() {
+    qint64 cutoff = m_clock.elapsed() - kBudgetWindowMs;
+    while (!m_window.empty() && m_window.front().timestamp < cutoff) {
+        m_window.pop_front();
+    }
+}
+
+void ScanScheduler::reschedule(int intervalMs) {
+    if (!m_running) {
+        return;
+    }
+    m_timer->start(std::max(0, intervalMs));
+}
+
+ScanScheduler::Counters ScanScheduler::counters() const {
+    Counters counters = m_counters;
+    qint64 cutoff = m_clock.elapsed() - kBudgetWindowMs;
+    counters.scanMsLastMinute = 0;
+    counters.packetsLastMinute = 0;
+    for (const Sample &sample : m_window) {
+        if (sample.timestamp >= cutoff) {
+            counters.scanMsLastMinute += sample.scanMs;
+            counters.packetsLastMinute += sample.packets;
+        }
+    }
+    return counters;
+}
@@ -0,0 +1,100 @@
+#ifndef SCANSCHEDULER_H
+#define SCANSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <deque>
+
+// جدولة المسح حسب معدل تغير الشبكة بدلاً من مسح كامل كل 5 ثواني.
+// الوضع الطبيعي قراءة رخيصة لجدول الجيران، مع إعادة فحص موجهة للأجهزة
+// القريبة من انتهاء صلاحيتها، ومسح كامل نادر أو عند الطلب، ضمن ميزانية
+// للوقت والحزم في الدقيقة.
+class ScanScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    enum Depth {
+        NeighborRead,  // قراءة جدول الجيران فقط، بدون حزم تقريباً
+        Reprobe,       // فحص موجه للأجهزة المشكوك في بقائها
+        FullSweep      // مسح كامل للشبكة الفرعية (nmap / arp-scan)
+    };
+    Q_ENUM(Depth)
+
+    struct Counters {
+        quint64 neighborReads = 0;
+        quint64 reprobes = 0;
+        quint64 fullSweeps = 0;
+        quint64 budgetDowngrades = 0;  // مسوح كاملة أُجلت بسبب الميزانية
+        quint64 packetsSent = 0;
+        qint64 totalScanMs = 0;
+        qint64 lastFullSweepMs = 0;
+        int currentIntervalMs = 0;
+        int scanMsLastMinute = 0;
+        int packetsLastMinute = 0;
+    };
+
+    struct Budget {
+        int scanMsPerMinute = 6000;
+        int packetsPerMinute = 2000;
+    };
+
+    explicit ScanScheduler(QObject *parent = nullptr);
+
+    // initialDelayMs: تأخير أول دورة (مسح كامل) بعد البدء
+    void start(int initialDelayMs = 0);
+    void stop();
+    bool isRunning() const;
+
+    void setBudget(const Budget &budget);
+    void setIntervalRange(int minMs, int maxMs);
+    void setFullSweepInterval(int ms);
+
+    // يجب استدعاؤها بعد كل عملية مسح لتغذية قرارات الجدولة
+    void reportScan(Depth depth, int changes, qint64 durationMs, int packets);
+
+    Counters counters() const;
+
+public slots:
+    void setReprobeCandidates(int count);
+    void noteNetworkEvent();
+    void requestFullSweep();
+
+signals:
+    void scanRequested(ScanScheduler::Depth depth);
+
+private slots:
+    void onTick();
+
+private:
+    struct Sample {
+        qint64 timestamp;
+        int scanMs;
+        int packets;
+    };
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    Budget m_budget;
+    Counters m_counters;
+    std::deque<Sample> m_window;
+
+    int m_minInterval = 2000;
+    int m_maxInterval = 30000;
+    int m_interval = 5000;
+    int m_fullSweepInterval = 600000;
+    qint64 m_lastFullSweep = -1;
+    int m_expectedSweepPackets = 512; // /24 تقريباً حتى نقيس أول مسح فعلي
+    int m_reprobeCandidates = 0;
+    int m_pendingEvents = 0;
+    double m_churn = 0.0;              // متوسط متحرك للتغييرات لكل دورة
+    bool m_fullSweepRequested = false;
+    bool m_running = false;
+
+    Depth chooseDepth();
+    bool fitsBudget(int scanMs, int packets);
+    void expireWindow();
+    void reschedule(int intervalMs);
+};
+
+#endif // SCANSCHEDULER_H
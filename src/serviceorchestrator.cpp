@@ -0,0 +1,408 @@
+#include "serviceorchestrator.h"
+#include "hostapdcontrol.h"
+#include "privilegedhelper.h"
+#include <QProcess>
+#include <QUdpSocket>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const int kPollIntervalMs = 250;
+const int kCommandTimeoutMs = 5000;
+// PING على الخيط الرئيسي: مهلة قصيرة حتى لا تتجمد الواجهة أثناء بدء hostapd
+const int kPingTimeoutMs = 200;
+
+QString unitName(const QString &service) {
+    return service.endsWith(".service") ? service.chopped(8) : service;
+}
+
+// قيم خاصية من مخرجات systemctl show، بترتيب الوحدات المطلوبة
+QList<QByteArray> propertyValues(const QByteArray &output, const QByteArray &property) {
+    QList<QByteArray> values;
+    const QByteArray prefix = property + '=';
+    const QList<QByteArray> lines = output.split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(prefix)) {
+            values << line.mid(prefix.size()).trimmed();
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+ServiceOrchestrator::ServiceOrchestrator(QObject *parent)
+    : QObject(parent), m_pollTimer(new QTimer(this)), m_dnsSocket(new QUdpSocket(this))
+{
+    // نسخة وهمية من systemctl للتجربة دون المساس بخدمات النظام
+    m_systemctl = qEnvironmentVariable("WIFIMANAGER_SYSTEMCTL", "systemctl");
+    m_pollTimer->setInterval(kPollIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &ServiceOrchestrator::onPoll);
+    connect(m_dnsSocket, &QUdpSocket::readyRead, this, &ServiceOrchestrator::onDnsReply);
+}
+
+void ServiceOrchestrator::setServices(const QStringList &units) {
+    QStringList services;
+    for (const QString &unit : units) {
+        services << unitName(unit);
+    }
+    if (services != m_services) {
+        m_services = services;
+        m_installedKnown = false;
+    }
+}
+
+void ServiceOrchestrator::setHostapd(const QString &controlDir, const QString &interface) {
+    m_hostapdControlDir = controlDir;
+    m_interface = interface;
+}
+
+void ServiceOrchestrator::setDnsAddresses(const QList<QHostAddress> &addresses) {
+    m_dnsAddresses = addresses;
+}
+
+QStringList ServiceOrchestrator::installedUnits() {
+    if (m_installedKnown) {
+        return m_installed;
+    }
+    m_installed.clear();
+    m_installedKnown = true;
+
+    // أمر واحد لكل الوحدات بدلاً من فحص كل واحدة على حدة
+    QStringList arguments = {"list-unit-files", "--no-legend", "--no-pager", "--type=service"};
+    for (const QString &unit : m_services) {
+        arguments << unit + ".service";
+    }
+    QProcess process;
+    process.start(m_systemctl, arguments);
+    if (!process.waitForFinished(kCommandTimeoutMs)) {
+        process.kill();
+        qDebug() << "Services: cannot list unit files";
+        return m_installed;
+    }
+
+    QSet<QString> present;
+    const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+    for (const QByteArray &line : lines) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        // الوحدة المحجوبة (masked) لا تبدأ أبداً
+        if (fields.size() >= 2 && fields[1] != "masked") {
+            present.insert(unitName(QString::fromUtf8(fields[0])));
+        }
+    }
+    for (const QString &unit : m_services) {
+        if (present.contains(unit)) {
+            m_installed << unit;
+        }
+    }
+    qDebug() << "Services: installed" << m_installed;
+    return m_installed;
+}
+
+int ServiceOrchestrator::stageFor(const QString &unit) {
+    if (unit == "networking" || unit == "NetworkManager" || unit == "systemd-networkd") {
+        return 0;
+    }
+    // dnsmasq يرتبط بعنوان واجهة نقطة الوصول بعد أن يرفعها hostapd
+    if (unit == "dnsmasq") {
+        return 2;
+    }
+    return 1;
+}
+
+int ServiceOrchestrator::changesFor(const QString &unit) {
+    if (unit == "hostapd") {
+        return AccessPointConfig;
+    }
+    if (unit == "wpa_supplicant") {
+        return SupplicantConfig;
+    }
+    if (unit == "dnsmasq") {
+        return DhcpConfig;
+    }
+    if (stageFor(unit) == 0) {
+        return NetworkConfig;
+    }
+    return 0; // وحدة إضافية من الإعدادات: مع إعادة التشغيل الكاملة فقط
+}
+
+bool ServiceOrchestrator::restart(int changes) {
+    if (isBusy()) {
+        return false;
+    }
+    for (const QString &unit : installedUnits()) {
+        if (changes == AllServices || (changesFor(unit) & changes)) {
+            Job job;
+            job.unit = unit;
+            job.stage = stageFor(unit);
+            m_jobs.push_back(job);
+        }
+    }
+    if (m_jobs.empty()) {
+        return false;
+    }
+    std::stable_sort(m_jobs.begin(), m_jobs.end(),
+                     [](const Job &a, const Job &b) { return a.stage < b.stage; });
+
+    m_success = true;
+    m_stage = -1;
+    m_started.start();
+    startStage();
+    return true;
+}
+
+void ServiceOrchestrator::startStage() {
+    std::vector<int> indices;
+    for (int i = 0; i < static_cast<int>(m_jobs.size()); ++i) {
+        if (m_jobs[i].state != State::Pending) {
+            continue;
+        }
+        if (indices.empty()) {
+            m_stage = m_jobs[i].stage;
+        }
+        if (m_jobs[i].stage == m_stage) {
+            indices.push_back(i);
+        }
+    }
+
+    if (indices.empty()) {
+        m_pollTimer->stop();
+        qint64 elapsed = m_started.elapsed();
+        m_jobs.clear();
+        ++m_generation;
+        emit finished(m_success, elapsed);
+        return;
+    }
+
+    // وحدات المرحلة الواحدة مستقلة فتُطلب معاً؛ ترتيب المراحل هو ترتيب الاعتماد
+    m_stageStarted.start();
+    for (int index : indices) {
+        m_jobs[index].state = State::Restarting;
+    }
+    recordInvocations(indices);
+    m_pollTimer->start();
+}
+
+void ServiceOrchestrator::recordInvocations(const std::vector<int> &indices) {
+    QStringList arguments = {"show", "-p", "InvocationID"};
+    for (int index : indices) {
+        arguments << m_jobs[index].unit;
+    }
+
+    QProcess *process = new QProcess(this);
+    const quint64 generation = m_generation;
+    auto proceed = [this, process, indices, generation]() {
+        process->deleteLater();
+        if (generation != m_generation) {
+            return;
+        }
+        // وحدة متوقفة قيمتها فارغة، فأي معرف بعد الطلب يكفي
+        const QList<QByteArray> values = propertyValues(process->readAllStandardOutput(), "InvocationID");
+        std::vector<int> pending;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            Job &job = m_jobs[indices[i]];
+            job.invocation = i < size_t(values.size()) ? values[int(i)] : QByteArray();
+            if (job.state == State::Restarting) {
+                pending.push_back(indices[i]);
+            }
+        }
+        requestRestart(pending);
+    };
+    connect(process, &QProcess::finished, this, proceed);
+    connect(process, &QProcess::errorOccurred, this, [proceed](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            proceed();
+        }
+    });
+    process->start(m_systemctl, arguments);
+}
+
+void ServiceOrchestrator::requestRestart(const std::vector<int> &indices) {
+    if (PrivilegedHelper::isConnected()) {
+        // المرحلة كلها في رسالة واحدة للمساعد
+        PrivilegedHelper::Batch batch;
+        for (int index : indices) {
+            batch.restartService(m_jobs[index].unit);
+        }
+        std::vector<PrivilegedHelper::Result> results;
+        bool sent = batch.submit(&results);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (!sent) {
+                markFailed(indices[i], "انقطع الاتصال بالمساعد المميز");
+            } else if (results[i].status != PrivilegedHelper::Ok) {
+                markFailed(indices[i], QString::fromUtf8(results[i].payload));
+            } else {
+                m_jobs[indices[i]].state = State::Waiting;
+            }
+        }
+        return;
+    }
+
+    for (int index : indices) {
+        m_jobs[index].state = State::Restarting;
+        QProcess *process = new QProcess(this);
+        const quint64 generation = m_generation;
+        connect(process, &QProcess::finished, this,
+                [this, process, index, generation](int exitCode, QProcess::ExitStatus status) {
+            process->deleteLater();
+            if (generation != m_generation || m_jobs[index].state != State::Restarting) {
+                return;
+            }
+            if (status == QProcess::NormalExit && exitCode == 0) {
+                m_jobs[index].state = State::Waiting;
+            } else {
+                markFailed(index, QString::fromUtf8(process->readAllStandardError()).trimmed());
+                finishIfDone();
+            }
+        });
+        connect(process, &QProcess::errorOccurred, this,
+                [this, process, index, generation](QProcess::ProcessError error) {
+            if (error != QProcess::FailedToStart) {
+                return;
+            }
+            process->deleteLater();
+            if (generation == m_generation && m_jobs[index].state == State::Restarting) {
+                markFailed(index, QString("تعذر تشغيل %1").arg(m_systemctl));
+                finishIfDone();
+            }
+        });
+        process->start(m_systemctl, QStringList() << "restart" << "--no-block" << m_jobs[index].unit);
+    }
+}
+
+void ServiceOrchestrator::onPoll() {
+    const bool expired = m_stageStarted.elapsed() > m_readyTimeoutMs;
+    for (int i = 0; i < static_cast<int>(m_jobs.size()); ++i) {
+        Job &job = m_jobs[i];
+        if (job.stage != m_stage || (job.state != State::Waiting && job.state != State::Restarting)) {
+            continue;
+        }
+        if (expired) {
+            markFailed(i, QString("لم تصبح جاهزة خلال %1 ث").arg(m_readyTimeoutMs / 1000));
+        } else if (job.state == State::Waiting) {
+            checkReadiness(i);
+        }
+    }
+    finishIfDone();
+}
+
+void ServiceOrchestrator::checkReadiness(int index) {
+    Job &job = m_jobs[index];
+    if (job.checking) {
+        return;
+    }
+    job.checking = true;
+
+    QProcess *process = new QProcess(this);
+    const quint64 generation = m_generation;
+    connect(process, &QProcess::finished, this, [this, process, index, generation]() {
+        process->deleteLater();
+        if (generation != m_generation) {
+            return;
+        }
+        Job &job = m_jobs[index];
+        job.checking = false;
+        if (job.state != State::Waiting) {
+            return;
+        }
+
+        const QByteArray output = process->readAllStandardOutput();
+        const QList<QByteArray> states = propertyValues(output, "ActiveState");
+        const QList<QByteArray> invocations = propertyValues(output, "InvocationID");
+        const QByteArray state = states.value(0);
+        const QByteArray invocation = invocations.value(0);
+        if (invocation.isEmpty() || invocation == job.invocation) {
+            return; // ما زالت النسخة السابقة هي التي تجيب
+        }
+        if (state == "failed") {
+            markFailed(index, "systemctl: failed");
+        } else if (state != "active") {
+            return; // activating: ننتظر الدورة التالية
+        } else if (job.unit == "hostapd") {
+            // الخدمة تعمل لا يعني أن الواجهة جاهزة؛ PONG من hostapd نفسه يعني ذلك
+            QByteArray reply;
+            if (PrivilegedHelper::isConnected()) {
+                PrivilegedHelper::Batch batch;
+                batch.hostapdCommand(m_interface, "PING");
+                std::vector<PrivilegedHelper::Result> results;
+                if (batch.submit(&results) && results.front().status == PrivilegedHelper::Ok) {
+                    reply = results.front().payload;
+                }
+            } else {
+                HostapdControl::request(HostapdControl::socketPath(m_hostapdControlDir, m_interface), "PING",
+                                        &reply, kPingTimeoutMs);
+            }
+            if (reply.startsWith("PONG")) {
+                markReady(index);
+            }
+        } else if (job.unit == "dnsmasq") {
+            sendDnsQuery(); // الجاهزية عند وصول الرد
+        } else {
+            markReady(index);
+        }
+        finishIfDone();
+    });
+    process->start(m_systemctl, QStringList() << "show" << "-p" << "ActiveState" << "-p" << "InvocationID"
+                                              << job.unit);
+}
+
+void ServiceOrchestrator::sendDnsQuery() {
+    // استعلام A عن localhost؛ أي رد (حتى REFUSED) يعني أن dnsmasq يستمع
+    m_dnsQueryId = static_cast<quint16>(QRandomGenerator::global()->generate());
+    QByteArray query(12, '\0');
+    qToBigEndian<quint16>(m_dnsQueryId, query.data());
+    query[2] = 0x01;  // RD
+    query[5] = 0x01;  // QDCOUNT = 1
+    query += QByteArray("\x09localhost\x00", 11);
+    query += QByteArray("\x00\x01\x00\x01", 4);  // A, IN
+    for (const QHostAddress &address : m_dnsAddresses) {
+        m_dnsSocket->writeDatagram(query, address, 53);
+    }
+}
+
+void ServiceOrchestrator::onDnsReply() {
+    bool answered = false;
+    while (m_dnsSocket->hasPendingDatagrams()) {
+        QNetworkDatagram datagram = m_dnsSocket->receiveDatagram(512);
+        const QByteArray data = datagram.data();
+        if (data.size() >= 12 && qFromBigEndian<quint16>(data.constData()) == m_dnsQueryId) {
+            answered = true;
+        }
+    }
+    if (!answered) {
+        return;
+    }
+    for (int i = 0; i < static_cast<int>(m_jobs.size()); ++i) {
+        if (m_jobs[i].unit == "dnsmasq" && m_jobs[i].state == State::Waiting) {
+            markReady(i);
+        }
+    }
+    finishIfDone();
+}
+
+void ServiceOrchestrator::markReady(int index) {
+    m_jobs[index].state = State::Ready;
+    emit unitReady(m_jobs[index].unit, m_started.elapsed());
+}
+
+void ServiceOrchestrator::markFailed(int index, const QString &reason) {
+    m_jobs[index].state = State::Failed;
+    m_success = false;
+    qDebug() << "Services:" << m_jobs[index].unit << "failed:" << reason;
+    emit unitFailed(m_jobs[index].unit, reason);
+}
+
+void ServiceOrchestrator::finishIfDone() {
+    for (const Job &job : m_jobs) {
+        if (job.stage == m_stage && job.state != State::Ready && job.state != State::Failed) {
+            return;
+        }
+    }
+    if (!m_jobs.empty()) {
+        startStage();
+    }
+}
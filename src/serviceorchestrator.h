@@ -0,0 +1,105 @@
+#ifndef SERVICEORCHESTRATOR_H
+#define SERVICEORCHESTRATOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QStringList>
+#include <QSet>
+#include <vector>
+
+class QProcess;
+class QUdpSocket;
+
+// إعادة تشغيل خدمات نقطة الوصول بترتيب الاعتماد: الشبكة أولاً، ثم hostapd
+// و wpa_supplicant معاً، ثم dnsmasq. الوحدات غير المثبتة تُستبعد، ولا يُعاد
+// تشغيل إلا ما يتأثر بالتغيير. الطلب لـ systemctl لا ينتظر (--no-block)،
+// فالنسخة القديمة قد تبقى active لحظة بعده: الوحدة لا تُعد جاهزة قبل أن
+// يتغير InvocationID عما سُجل قبل الطلب. بعدها الجاهزية من الخدمة نفسها:
+// PONG من مقبس تحكم hostapd، ورد DNS من dnsmasq، و "active" لغيرهما.
+class ServiceOrchestrator : public QObject {
+    Q_OBJECT
+
+public:
+    enum Change {
+        AccessPointConfig = 0x1,   // hostapd.conf
+        SupplicantConfig = 0x2,    // wpa_supplicant.conf
+        DhcpConfig = 0x4,          // dnsmasq
+        NetworkConfig = 0x8,       // networking / NetworkManager
+        AllServices = 0xff
+    };
+
+    explicit ServiceOrchestrator(QObject *parent = nullptr);
+
+    // الوحدات المرشحة من الإعدادات؛ يُعاد فحص المثبت منها عند التغيير
+    void setServices(const QStringList &units);
+    void setHostapd(const QString &controlDir, const QString &interface);
+    void setDnsAddresses(const QList<QHostAddress> &addresses);
+    void setReadyTimeout(int timeoutMs) { m_readyTimeoutMs = timeoutMs; }
+
+    // الوحدات الموجودة فعلاً على النظام (systemctl list-unit-files، مرة واحدة)
+    QStringList installedUnits();
+
+    // غير متزامن؛ false إن لم تتأثر أي وحدة مثبتة أو كانت عملية سابقة جارية
+    bool restart(int changes);
+    bool isBusy() const { return !m_jobs.empty(); }
+
+signals:
+    void unitReady(const QString &unit, qint64 elapsedMs);
+    void unitFailed(const QString &unit, const QString &reason);
+    void finished(bool success, qint64 elapsedMs);
+
+private slots:
+    void onPoll();
+    void onDnsReply();
+
+private:
+    enum class State {
+        Pending,
+        Restarting,
+        Waiting,
+        Ready,
+        Failed
+    };
+
+    struct Job {
+        QString unit;
+        int stage = 0;
+        State state = State::Pending;
+        bool checking = false;     // فحص الحالة جارٍ
+        QByteArray invocation;     // InvocationID قبل طلب إعادة التشغيل
+    };
+
+    QTimer *m_pollTimer;
+    QUdpSocket *m_dnsSocket;
+    QElapsedTimer m_started;
+    QElapsedTimer m_stageStarted;
+    QString m_systemctl;
+    QStringList m_services;
+    QStringList m_installed;
+    bool m_installedKnown = false;
+    QString m_hostapdControlDir = "/var/run/hostapd";
+    QString m_interface;
+    QList<QHostAddress> m_dnsAddresses = {QHostAddress::LocalHost};
+    quint16 m_dnsQueryId = 0;
+    int m_readyTimeoutMs = 20000;
+    std::vector<Job> m_jobs;
+    int m_stage = -1;
+    quint64 m_generation = 0;      // ردود عمليات قديمة تُهمل
+    bool m_success = true;
+
+    static int stageFor(const QString &unit);
+    static int changesFor(const QString &unit);
+
+    void startStage();
+    void recordInvocations(const std::vector<int> &jobs);
+    void requestRestart(const std::vector<int> &jobs);
+    void checkReadiness(int index);
+    void markReady(int index);
+    void markFailed(int index, const QString &reason);
+    void finishIfDone();
+    void sendDnsQuery();
+};
+
+#endif // SERVICEORCHESTRATOR_H
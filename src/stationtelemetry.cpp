@@ -0,0 +1,191 @@
+#include "stationtelemetry.h"
+#include "profiler.h"
+#include <QDateTime>
+#include <QDebug>
+#include <unistd.h>
+
+namespace {
+
+// محطة غابت عن التفريغ هذا العدد من الدورات تُحذف مع تاريخها
+const qint64 kStaleTicks = 150;
+// الواجهة ليست نقطة وصول (أو المشغل لا يدعم GET_STATION): نبطئ المحاولة
+const int kFailureIntervalMs = 30000;
+// التفريغ يجري في خيط الواجهة: مشغل عالق لا يجمدها أكثر من هذا
+const int kReceiveTimeoutMs = 500;
+
+// فرق عداد تراكمي؛ تراجعه يعني إعادة ارتباط فصار العد من الصفر
+quint32 counterDelta(quint32 current, quint32 previous) {
+    return current >= previous ? current - previous : current;
+}
+
+} // namespace
+
+StationTelemetry::StationTelemetry(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this))
+{
+    connect(m_timer, &QTimer::timeout, this, &StationTelemetry::onTick);
+}
+
+StationTelemetry::~StationTelemetry() {
+    closeSocket();
+}
+
+void StationTelemetry::closeSocket() {
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+}
+
+void StationTelemetry::start(const QString &interface, int intervalMs) {
+    m_interface = interface;
+    m_intervalMs = intervalMs;
+    m_timer->start(m_intervalMs);
+    onTick();
+}
+
+void StationTelemetry::stop() {
+    m_timer->stop();
+    closeSocket();
+}
+
+void StationTelemetry::setInterval(int intervalMs) {
+    m_intervalMs = intervalMs;
+    // أثناء التراجع بعد فشل يبقى الفاصل الطويل حتى أول تفريغ ناجح
+    if (m_timer->isActive() && m_timer->interval() != kFailureIntervalMs) {
+        m_timer->setInterval(m_intervalMs);
+    }
+}
+
+void StationTelemetry::setWeakThresholds(int signalDbm, double retryRate, quint32 expectedThroughputKbps) {
+    m_weakSignalDbm = signalDbm;
+    m_weakRetryRate = retryRate;
+    m_weakThroughputKbps = expectedThroughputKbps;
+}
+
+void StationTelemetry::onTick() {
+    if (m_socket < 0) {
+        m_socket = Nl80211::openSocket(kReceiveTimeoutMs);
+    }
+    std::vector<StationInfo> stations;
+    bool ok = false;
+    if (m_socket >= 0) {
+        PROFILE_SCOPE(StationDump);
+        // 1 محجوز لطلب حل معرف العائلة
+        m_seq = m_seq == 0xffffffff ? 2 : m_seq + 1;
+        ok = Nl80211::dumpStations(m_socket, m_interface, m_seq, &stations);
+    }
+    if (!ok) {
+        if (m_timer->interval() != kFailureIntervalMs) {
+            qDebug() << "Station telemetry: no station dump on" << m_interface << "- backing off";
+            m_timer->setInterval(kFailureIntervalMs);
+        }
+        return;
+    }
+    if (m_timer->interval() != m_intervalMs) {
+        m_timer->setInterval(m_intervalMs);
+    }
+
+    ++m_tick;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const StationInfo &station : stations) {
+        auto it = m_stations.find(station.macAddress);
+        bool fresh = it == m_stations.end();
+        if (fresh) {
+            it = m_stations.insert(station.macAddress, Ring());
+        }
+        Ring &ring = it.value();
+
+        StationSample &sample = ring.samples[ring.next];
+        sample.timestampMs = now;
+        sample.signalDbm = static_cast<qint8>(station.signalDbm);
+        sample.txBitrateKbps = station.txBitrateKbps;
+        sample.rxBitrateKbps = station.rxBitrateKbps;
+        sample.expectedThroughputKbps = station.expectedThroughputKbps;
+        // أول عينة بلا سابقة: الفروق صفر حتى لا يُنسب تاريخ الجلسة كله لدورة واحدة
+        sample.txPackets = fresh ? 0 : counterDelta(station.txPackets, ring.last.txPackets);
+        sample.txRetries = fresh ? 0 : counterDelta(station.txRetries, ring.last.txRetries);
+        sample.txFailed = fresh ? 0 : counterDelta(station.txFailed, ring.last.txFailed);
+
+        ring.next = (ring.next + 1) % kRingSize;
+        ring.count = qMin(ring.count + 1, kRingSize);
+        ring.last = station;
+        ring.lastSeenTick = m_tick;
+    }
+
+    for (auto it = m_stations.begin(); it != m_stations.end();) {
+        if (m_tick - it->lastSeenTick > kStaleTicks) {
+            it = m_stations.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    emit sampled();
+}
+
+StationLink StationTelemetry::summarize(const Ring &ring) const {
+    StationLink link;
+    link.macAddress = ring.last.macAddress;
+    link.signalDbm = ring.last.signalDbm;
+    link.txBitrateKbps = ring.last.txBitrateKbps;
+    link.rxBitrateKbps = ring.last.rxBitrateKbps;
+    link.expectedThroughputKbps = ring.last.expectedThroughputKbps;
+    link.txBytes = ring.last.txBytes;
+    link.rxBytes = ring.last.rxBytes;
+
+    qint64 signalSum = 0;
+    int signalCount = 0;
+    quint64 packets = 0;
+    quint64 retries = 0;
+    quint64 failed = 0;
+    for (int i = 0; i < ring.count; ++i) {
+        const StationSample &sample = ring.samples[i];
+        if (sample.signalDbm != 0) {
+            signalSum += sample.signalDbm;
+            ++signalCount;
+        }
+        packets += sample.txPackets;
+        retries += sample.txRetries;
+        failed += sample.txFailed;
+    }
+    link.signalAvgDbm = signalCount > 0 ? static_cast<int>(signalSum / signalCount) : ring.last.signalAvgDbm;
+    if (packets > 0) {
+        link.retryRate = double(retries) / double(packets);
+        link.failureRate = double(failed) / double(packets);
+    }
+
+    link.weak = (link.signalAvgDbm != 0 && link.signalAvgDbm < m_weakSignalDbm) ||
+                (packets >= 50 && link.retryRate > m_weakRetryRate) ||
+                (link.expectedThroughputKbps != 0 && link.expectedThroughputKbps < m_weakThroughputKbps);
+    return link;
+}
+
+StationLink StationTelemetry::link(const QString &macAddress) const {
+    auto it = m_stations.constFind(macAddress);
+    return it == m_stations.constEnd() ? StationLink() : summarize(it.value());
+}
+
+std::vector<StationLink> StationTelemetry::links() const {
+    std::vector<StationLink> result;
+    result.reserve(m_stations.size());
+    for (const Ring &ring : m_stations) {
+        result.push_back(summarize(ring));
+    }
+    return result;
+}
+
+std::vector<StationSample> StationTelemetry::history(const QString &macAddress) const {
+    std::vector<StationSample> result;
+    auto it = m_stations.constFind(macAddress);
+    if (it == m_stations.constEnd()) {
+        return result;
+    }
+    const Ring &ring = it.value();
+    result.reserve(ring.count);
+    int start = ring.count < kRingSize ? 0 : ring.next;
+    for (int i = 0; i < ring.count; ++i) {
+        result.push_back(ring.samples[(start + i) % kRingSize]);
+    }
+    return result;
+}
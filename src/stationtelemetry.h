@@ -0,0 +1,93 @@
+#ifndef STATIONTELEMETRY_H
+#define STATIONTELEMETRY_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <array>
+#include <vector>
+#include "nl80211.h"
+
+// عينة واحدة لمحطة في دورة واحدة؛ العدادات هنا فروق منذ العينة السابقة
+struct StationSample {
+    qint64 timestampMs = 0;
+    qint8 signalDbm = 0;
+    quint32 txBitrateKbps = 0;
+    quint32 rxBitrateKbps = 0;
+    quint32 expectedThroughputKbps = 0;
+    quint32 txPackets = 0;
+    quint32 txRetries = 0;
+    quint32 txFailed = 0;
+};
+
+// حالة رابط المحطة ملخصة على نافذة الحلقة كلها
+struct StationLink {
+    QString macAddress;
+    int signalDbm = 0;
+    int signalAvgDbm = 0;
+    quint32 txBitrateKbps = 0;
+    quint32 rxBitrateKbps = 0;
+    quint32 expectedThroughputKbps = 0;
+    double retryRate = 0.0;     // إعادات الإرسال / الحزم المرسلة
+    double failureRate = 0.0;
+    quint64 txBytes = 0;
+    quint64 rxBytes = 0;
+    bool weak = false;          // رابط ضعيف يستهلك وقت البث على حساب الآخرين
+};
+
+// قياسات الرابط لكل العملاء المرتبطين: تفريغ nl80211 واحد لكل دورة لكل
+// المحطات، والعينات في حلقة ثابتة الحجم لكل جهاز فلا تنمو الذاكرة مع الوقت.
+class StationTelemetry : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kRingSize = 64;
+
+    explicit StationTelemetry(QObject *parent = nullptr);
+    ~StationTelemetry() override;
+
+    void start(const QString &interface, int intervalMs = 2000);
+    void stop();
+    // تغيير الفاصل أثناء التشغيل دون إعادة البدء
+    void setInterval(int intervalMs);
+
+    // حدود الرابط الضعيف: متوسط إشارة أقل من، أو نسبة إعادة أعلى من، أو إنتاجية متوقعة أقل من
+    void setWeakThresholds(int signalDbm, double retryRate, quint32 expectedThroughputKbps);
+
+    bool contains(const QString &macAddress) const { return m_stations.contains(macAddress); }
+    StationLink link(const QString &macAddress) const;
+    std::vector<StationLink> links() const;
+    std::vector<StationSample> history(const QString &macAddress) const;
+
+signals:
+    void sampled();
+
+private slots:
+    void onTick();
+
+private:
+    struct Ring {
+        std::array<StationSample, kRingSize> samples;
+        int next = 0;
+        int count = 0;
+        StationInfo last;       // العدادات التراكمية من آخر تفريغ
+        qint64 lastSeenTick = 0;
+    };
+
+    QTimer *m_timer;
+    int m_socket = -1;          // مقبس nl80211 واحد طوال التشغيل
+    quint32 m_seq = 1;
+    QString m_interface;
+    int m_intervalMs = 2000;
+    qint64 m_tick = 0;
+    QHash<QString, Ring> m_stations;
+
+    int m_weakSignalDbm = -75;
+    double m_weakRetryRate = 0.2;
+    quint32 m_weakThroughputKbps = 10000;
+
+    StationLink summarize(const Ring &ring) const;
+    void closeSocket();
+};
+
+#endif // STATIONTELEMETRY_H
@@ -0,0 +1,167 @@
+#include "traffichistory.h"
+#include "wifimanager.h"
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+namespace {
+
+// كتلة صغيرة نسبياً: ما يضيع عند انقطاع مفاجئ لا يتجاوز دقائق من العينات
+const int kChunkRows = 1024;
+const int kFlushIntervalMs = 10 * 60 * 1000;
+
+// نهاية آخر كتلة مكتملة؛ ما بعدها بقايا كتابة انقطعت ولا يصح الإلحاق خلفها
+qint64 validLength(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    ColumnarReader reader(&file);
+    if (!reader.open()) {
+        return 0;
+    }
+    QString table;
+    std::vector<Columnar::Column> columns;
+    Columnar::Chunk chunk;
+    while (reader.nextTable(&table, &columns)) {
+        while (reader.nextChunk(&chunk)) {
+        }
+    }
+    return reader.validLength();
+}
+
+} // namespace
+
+const std::vector<Columnar::Column> &TrafficHistory::columns() {
+    static const std::vector<Columnar::Column> schema = {
+        {"timestamp_ms", Columnar::Int64},
+        {"mac", Columnar::String},
+        {"bytes_received", Columnar::Int64},
+        {"bytes_sent", Columnar::Int64},
+        {"signal_dbm", Columnar::Double},
+    };
+    return schema;
+}
+
+TrafficHistory::TrafficHistory(QObject *parent)
+    : QObject(parent), m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setInterval(kFlushIntervalMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &TrafficHistory::flush);
+}
+
+TrafficHistory::~TrafficHistory() {
+    close();
+}
+
+bool TrafficHistory::open(const QString &path, qint64 maxBytes) {
+    close();
+
+    QString filePath = path;
+    if (filePath.isEmpty()) {
+        filePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/traffic.wmc";
+    }
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    if (QFileInfo(filePath).size() > maxBytes) {
+        QFile::remove(filePath + ".1");
+        QFile::rename(filePath, filePath + ".1");
+    }
+
+    m_file.setFileName(filePath);
+    qint64 size = m_file.exists() ? QFileInfo(filePath).size() : 0;
+    qint64 valid = size > 0 ? validLength(filePath) : 0;
+    if (valid < size) {
+        qDebug() << "Traffic history: truncating" << filePath << "from" << size << "to" << valid;
+        if (!QFile::resize(filePath, valid)) {
+            qDebug() << "Traffic history: cannot truncate" << filePath;
+            return false;
+        }
+    }
+    bool fresh = valid == 0;
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Traffic history: cannot open" << filePath << m_file.errorString();
+        return false;
+    }
+
+    m_writer = std::make_unique<ColumnarWriter>(&m_file);
+    if ((fresh && !m_writer->writeFileHeader()) ||
+        !m_writer->beginTable("traffic", columns(), kChunkRows)) {
+        qDebug() << "Traffic history: write failed" << m_file.errorString();
+        close();
+        return false;
+    }
+    m_flushTimer->start();
+    return true;
+}
+
+void TrafficHistory::close() {
+    m_flushTimer->stop();
+    if (m_writer) {
+        m_writer->endTable();
+        m_writer.reset();
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+void TrafficHistory::record(const std::vector<Device> &devices) {
+    if (!m_writer || (m_lastSample.isValid() && m_lastSample.elapsed() < m_sampleIntervalMs)) {
+        return;
+    }
+    m_lastSample.restart();
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const Device &device : devices) {
+        // جهاز بلا MAC لا يمكن ربط تاريخه عبر الجلسات
+        if (device.macAddress.isEmpty() || (!device.isActive && device.bytesReceived == 0)) {
+            continue;
+        }
+        Sample sample;
+        sample.timestampMs = now;
+        sample.macAddress = device.macAddress;
+        sample.bytesReceived = device.bytesReceived;
+        sample.bytesSent = device.bytesSent;
+        sample.signalDbm = device.signalStrength;
+        append(sample);
+    }
+}
+
+void TrafficHistory::append(const Sample &sample) {
+    if (!m_writer) {
+        return;
+    }
+    m_writer->addInt(sample.timestampMs);
+    m_writer->addString(sample.macAddress);
+    m_writer->addInt(sample.bytesReceived);
+    m_writer->addInt(sample.bytesSent);
+    m_writer->addDouble(sample.signalDbm);
+    if (!m_writer->endRow()) {
+        qDebug() << "Traffic history: write failed" << m_writer->errorString();
+    }
+}
+
+void TrafficHistory::flush() {
+    if (m_writer) {
+        m_writer->flushChunk();
+        m_file.flush();
+    }
+}
+
+QStringList TrafficHistory::files() const {
+    QStringList result;
+    QString path = m_file.fileName();
+    if (path.isEmpty()) {
+        return result;
+    }
+    if (QFile::exists(path + ".1")) {
+        result.append(path + ".1");
+    }
+    if (QFile::exists(path)) {
+        result.append(path);
+    }
+    return result;
+}
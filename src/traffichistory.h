@@ -0,0 +1,58 @@
+#ifndef TRAFFICHISTORY_H
+#define TRAFFICHISTORY_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <memory>
+#include <vector>
+#include "columnarfile.h"
+
+struct Device;
+
+// السلسلة الزمنية لحركة كل جهاز على القرص: عينة لكل جهاز كل دقيقة في ملف
+// عمودي يُلحق به (جدول لكل جلسة)، فلا يُحمل التاريخ في الذاكرة أبداً.
+class TrafficHistory : public QObject {
+    Q_OBJECT
+
+public:
+    struct Sample {
+        qint64 timestampMs = 0;
+        QString macAddress;
+        qint64 bytesReceived = 0;
+        qint64 bytesSent = 0;
+        double signalDbm = 0.0;
+    };
+
+    static const std::vector<Columnar::Column> &columns();
+
+    explicit TrafficHistory(QObject *parent = nullptr);
+    ~TrafficHistory();
+
+    // المسار الافتراضي في AppDataLocation؛ الملف الأكبر من maxBytes يُدور إلى path.1
+    bool open(const QString &path = QString(), qint64 maxBytes = 32 * 1024 * 1024);
+    void close();
+
+    void setSampleInterval(int ms) { m_sampleIntervalMs = ms; }
+
+    // تُستدعى مع كل نشر للأجهزة؛ تسجل فعلياً مرة كل فترة عينة
+    void record(const std::vector<Device> &devices);
+    void append(const Sample &sample);
+
+    // كتابة الكتلة الجارية حتى يراها القارئ (قبل التصدير مثلاً)
+    void flush();
+
+    // ملفات التاريخ بالترتيب الزمني (المدور أولاً)
+    QStringList files() const;
+
+private:
+    QFile m_file;
+    std::unique_ptr<ColumnarWriter> m_writer;
+    QTimer *m_flushTimer;
+    QElapsedTimer m_lastSample;
+    int m_sampleIntervalMs = 60000;
+};
+
+#endif // TRAFFICHISTORY_H
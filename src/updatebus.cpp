@@ -0,0 +1,85 @@
+#include "updatebus.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <algorithm>
+
+UpdateBus::UpdateBus(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &UpdateBus::deliver);
+}
+
+void UpdateBus::setMinimumInterval(int ms) {
+    m_minimumIntervalMs = std::max(0, ms);
+}
+
+void UpdateBus::publishDevices(std::vector<Device> devices) {
+    // النسخة الوحيدة تحدث عند استدعاء هذه الدالة؛ المستهلكون يتشاركون اللقطة
+    auto snapshot = std::make_shared<const std::vector<Device>>(std::move(devices));
+    {
+        QMutexLocker locker(&m_mutex);
+        m_devices.data = std::move(snapshot);
+        ++m_devices.version;
+    }
+    markDirty(Devices);
+}
+
+void UpdateBus::publishStats(const NetworkStats &stats) {
+    auto snapshot = std::make_shared<const NetworkStats>(stats);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.data = std::move(snapshot);
+        ++m_stats.version;
+    }
+    markDirty(Stats);
+}
+
+UpdateBus::DeviceSnapshot UpdateBus::devices() const {
+    QMutexLocker locker(&m_mutex);
+    return m_devices;
+}
+
+UpdateBus::StatsSnapshot UpdateBus::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void UpdateBus::markDirty(Topic topic) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingTopics |= topic;
+        if (m_deliveryScheduled) {
+            return; // إشعار واحد يغطي كل ما يُنشر قبل موعده
+        }
+        m_deliveryScheduled = true;
+    }
+
+    if (QThread::currentThread() == thread()) {
+        scheduleDelivery();
+    } else {
+        QMetaObject::invokeMethod(this, &UpdateBus::scheduleDelivery, Qt::QueuedConnection);
+    }
+}
+
+void UpdateBus::scheduleDelivery() {
+    // أول تحديث بعد فترة هدوء يُسلّم فوراً، والدفعات المتلاحقة تُحدّ بمعدل الإطارات
+    qint64 sinceLast = m_lastDelivery.isValid() ? m_lastDelivery.elapsed() : m_minimumIntervalMs;
+    int delay = static_cast<int>(std::max<qint64>(0, m_minimumIntervalMs - sinceLast));
+    m_timer->start(delay);
+}
+
+void UpdateBus::deliver() {
+    quint32 topics;
+    {
+        QMutexLocker locker(&m_mutex);
+        topics = m_pendingTopics;
+        m_pendingTopics = 0;
+        m_deliveryScheduled = false;
+    }
+
+    m_lastDelivery.restart();
+    if (topics != 0) {
+        emit updated(topics);
+    }
+}
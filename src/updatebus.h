@@ -0,0 +1,67 @@
+#ifndef UPDATEBUS_H
+#define UPDATEBUS_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <memory>
+#include <vector>
+#include "wifimanager.h"
+#include "networkstats.h"
+
+// نشر الحالة بين المديرين والواجهة كلقطات ثابتة مشتركة (shared_ptr إلى const)
+// مع رقم إصدار. النشر آمن من أي خيط ولا ينسخ القائمة إلا مرة واحدة، والإشعار
+// يُجمع بمعدل تحديث الشاشة: المستهلك يسحب أحدث لقطة فقط ويتجاهل ما بينها.
+class UpdateBus : public QObject {
+    Q_OBJECT
+
+public:
+    enum Topic : quint32 {
+        Devices = 0x1,
+        Stats = 0x2
+    };
+
+    template <typename T>
+    struct Snapshot {
+        quint64 version = 0;
+        std::shared_ptr<const T> data;
+    };
+
+    using DeviceSnapshot = Snapshot<std::vector<Device>>;
+    using StatsSnapshot = Snapshot<NetworkStats>;
+
+    explicit UpdateBus(QObject *parent = nullptr);
+
+    // الحد الأدنى بين إشعارين (افتراضياً إطار واحد عند 60 Hz)
+    void setMinimumInterval(int ms);
+
+    void publishDevices(std::vector<Device> devices);
+    void publishStats(const NetworkStats &stats);
+
+    DeviceSnapshot devices() const;
+    StatsSnapshot stats() const;
+
+signals:
+    // topics: مجموعة Topic التي تغيرت منذ الإشعار السابق
+    void updated(quint32 topics);
+
+private slots:
+    void deliver();
+
+private:
+    mutable QMutex m_mutex;
+    DeviceSnapshot m_devices;
+    StatsSnapshot m_stats;
+    quint32 m_pendingTopics = 0;
+    bool m_deliveryScheduled = false;
+
+    QTimer *m_timer;
+    QElapsedTimer m_lastDelivery;
+    int m_minimumIntervalMs = 16;
+
+    void markDirty(Topic topic);
+    void scheduleDelivery();
+};
+
+#endif // UPDATEBUS_H
@@ -7,23 +7,129 @@
 #include <QNetworkInterface>
 #include <QHostInfo>
 #include <QStandardPaths>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <sys/socket.h>
+#include <linux/neighbour.h>
+#include "neighbortable.h"
+#include "devicesweeper.h"
+#include "profiler.h"
+#include "updatebus.h"
+#include "privilegedhelper.h"
+#include "apconfigfile.h"
+#include "hostapdcontrol.h"
+
+namespace {
+
+// الحد الأقصى للعناوين المحفوظة لكل عائلة (عناوين IPv6 المؤقتة تتبدل باستمرار)
+const int kMaxAddressesPerFamily = 8;
+
+// ping متعدد البث إلى ff02::1 يوقظ كل أجهزة الشبكة: مرة كل بضع دقائق، وأبكر قليلاً
+// فقط إن ظهرت في الجدول عناوين IPv6 لم تُحل بعد
+const qint64 kIpv6ProbeIntervalMs = 5 * 60 * 1000;
+const qint64 kIpv6UnresolvedProbeIntervalMs = 30 * 1000;
+
+// الأدوات التي يُفحص توفرها عند البدء؛ أدوات الخدمات تُذكر فقط في قائمة المفقود
+const QStringList kRequiredTools = {"ip", "arp"};
+const QStringList kOptionalTools = {"nmap", "arp-scan", "iwconfig", "iw", "nmcli", "iptables"};
+const QStringList kServiceTools = {"hostapd", "dnsmasq"};
+
+bool addAddress(QStringList &addresses, const QString &address) {
+    if (address.isEmpty() || addresses.contains(address)) {
+        return false;
+    }
+    addresses.append(address);
+    if (addresses.size() > kMaxAddressesPerFamily) {
+        addresses.removeFirst();
+    }
+    return true;
+}
+
+} // namespace
 
 WifiManager::WifiManager(QObject *parent) 
     : QObject(parent), 
       m_process(std::make_unique<QProcess>(this)),
-      m_refreshTimer(std::make_unique<QTimer>(this))
+      m_publishTimer(std::make_unique<QTimer>(this)),
+      m_scheduler(std::make_unique<ScanScheduler>(this)),
+      m_neighborMonitor(std::make_unique<NeighborMonitor>(this)),
+      m_liveness(std::make_unique<LivenessTracker>(this)),
+      m_passiveDiscovery(std::make_unique<PassiveDiscovery>(this)),
+      m_leaseWatcher(std::make_unique<DhcpLeaseWatcher>(this)),
+      m_associations(std::make_unique<AssociationTracker>(this)),
+      m_telemetry(std::make_unique<StationTelemetry>(this)),
+      m_history(std::make_unique<TrafficHistory>(this)),
+      m_anomalies(std::make_unique<AnomalyDetector>(this)),
+      m_arpGuard(std::make_unique<ArpGuard>(this)),
+      m_services(std::make_unique<ServiceOrchestrator>(this)),
+      m_fingerprinter(std::make_unique<Fingerprinter>(this)),
+      m_dnsLog(std::make_unique<DnsQueryLog>(this)),
+      m_sweeper(std::make_unique<DeviceSweeper>(this))
 {
-    connect(m_refreshTimer.get(), &QTimer::timeout, this, &WifiManager::refreshDevices);
+    connect(m_scheduler.get(), &ScanScheduler::scanRequested, this, &WifiManager::runScan);
+    connect(m_sweeper.get(), &DeviceSweeper::sweepFinished, this, &WifiManager::onSweepFinished);
+    connect(m_sweeper.get(), &DeviceSweeper::startupProbed, this, &WifiManager::onStartupProbed);
+    connect(m_sweeper.get(), &DeviceSweeper::arpTableRead, this, &WifiManager::mergeNeighborDevices);
+    connect(m_neighborMonitor.get(), &NeighborMonitor::neighborChanged, this, [this]() {
+        // تجاهل الأحداث الناتجة عن فحوصاتنا نحن في الثانيتين التاليتين للمسح
+        if (!m_lastScanFinished.isValid() || m_lastScanFinished.elapsed() > 2000) {
+            m_scheduler->noteNetworkEvent();
+        }
+    });
+    
+    // تجميع تحديثات الاكتشاف السلبي في إشارة واحدة بدلاً من إشارة لكل حزمة
+    m_publishTimer->setSingleShot(true);
+    m_publishTimer->setInterval(250);
+    connect(m_publishTimer.get(), &QTimer::timeout, this, &WifiManager::publishDevices);
+    
+    connect(m_liveness.get(), &LivenessTracker::probesDue,
+            m_scheduler.get(), &ScanScheduler::setReprobeCandidates);
+    connect(m_liveness.get(), &LivenessTracker::livenessChanged,
+            this, &WifiManager::onLivenessChanged);
+    
+    connect(m_passiveDiscovery.get(), &PassiveDiscovery::observed,
+            this, &WifiManager::onPassiveObservation);
+    connect(m_leaseWatcher.get(), &DhcpLeaseWatcher::leaseUpdated,
+            this, &WifiManager::onLeaseUpdated);
+    connect(m_leaseWatcher.get(), &DhcpLeaseWatcher::leaseRemoved,
+            this, &WifiManager::onLeaseRemoved);
+    connect(m_associations.get(), &AssociationTracker::stationConnected,
+            this, &WifiManager::onStationConnected);
+    connect(m_associations.get(), &AssociationTracker::stationDisconnected,
+            this, &WifiManager::onStationDisconnected);
+    connect(m_telemetry.get(), &StationTelemetry::sampled,
+            this, &WifiManager::onStationsSampled);
+    connect(m_anomalies.get(), &AnomalyDetector::alertRaised,
+            this, &WifiManager::trafficAlert);
+    connect(m_arpGuard.get(), &ArpGuard::alertRaised,
+            this, &WifiManager::trafficAlert);
+    connect(m_services.get(), &ServiceOrchestrator::unitFailed, this,
+            [this](const QString &unit, const QString &reason) {
+        emit errorOccurred(QString("تعذرت إعادة تشغيل %1: %2").arg(unit, reason));
+    });
+    connect(m_services.get(), &ServiceOrchestrator::finished,
+            this, &WifiManager::servicesRestarted);
+    connect(m_fingerprinter.get(), &Fingerprinter::fingerprintChanged,
+            this, &WifiManager::onFingerprintChanged);
+    connect(m_dnsLog.get(), &DnsQueryLog::errorOccurred,
+            this, &WifiManager::errorOccurred);
+    
     m_activeInterface = getActiveWifiInterface();
+    m_services->setServices(m_config.services);
 }
 
 WifiManager::~WifiManager() {
     stopMonitoring();
+    saveDeviceCache();
 }
 
 QString WifiManager::executeCommand(const QString &command) {
+    PROFILE_SCOPE(ExecuteCommand);
     m_process->start("bash", QStringList() << "-c" << command);
-    if (!m_process->waitForFinished(10000)) { // timeout 10 seconds
+    if (!m_process->waitForFinished(m_config.commandTimeoutMs)) {
         m_process->kill();
         return QString();
     }
@@ -39,10 +145,15 @@ QString WifiManager::executeCommand(const QString &command) {
 }
 
 bool WifiManager::isCommandAvailable(const QString &command) const {
-    QProcess process;
-    process.start("which", QStringList() << command);
-    process.waitForFinished(3000);
-    return process.exitCode() == 0;
+    // النتيجة تُحفظ لأن الأدوات لا تتغير أثناء التشغيل؛ فحص البدء يعبئها مسبقاً من خيط المسح
+    auto cached = m_toolCache.constFind(command);
+    if (cached != m_toolCache.constEnd()) {
+        return cached.value();
+    }
+    
+    bool available = DeviceSweeper::findTool(command);
+    m_toolCache.insert(command, available);
+    return available;
 }
 
 QString WifiManager::getActiveWifiInterface() const {
@@ -138,294 +249,791 @@ QString WifiManager::getManufacturer(const QString &macAddress) const {
     return vendors.value(prefix, "غير معروف");
 }
 
-QString WifiManager::getHostname(const QString &ipAddress) const {
-    // محاولة الحصول على hostname
-    if (isCommandAvailable("nslookup")) {
-        QString output = const_cast<WifiManager*>(this)->executeCommand(
-            QString("nslookup %1 2>/dev/null | grep 'name =' | head -1").arg(ipAddress));
-        QRegularExpression hostnameRegex("name = (.+)\\.");
-        QRegularExpressionMatch match = hostnameRegex.match(output);
-        if (match.hasMatch()) {
-            return match.captured(1);
-        }
+void WifiManager::refreshIpv6Neighbors(const std::vector<NeighborEntry> &neighbors) {
+    // ping واحد إلى ff02::1 يعبئ ذاكرة NDP، ونقرأ ما تراكم منذ التحديث السابق
+    bool unresolved = false;
+    for (const NeighborEntry &entry : neighbors) {
+        unresolved |= entry.family == AF_INET6 && (entry.state & (NUD_INCOMPLETE | NUD_FAILED));
+    }
+    qint64 interval = unresolved ? kIpv6UnresolvedProbeIntervalMs : kIpv6ProbeIntervalMs;
+    if (!m_lastIpv6Probe.isValid() || m_lastIpv6Probe.elapsed() >= interval) {
+        NeighborTable::probeIpv6AllNodes(m_activeInterface);
+        m_lastIpv6Probe.start();
     }
     
-    if (isCommandAvailable("host")) {
-        QString output = const_cast<WifiManager*>(this)->executeCommand(
-            QString("host %1 2>/dev/null | head -1").arg(ipAddress));
-        QRegularExpression hostnameRegex("pointer (.+)\\.");
-        QRegularExpressionMatch match = hostnameRegex.match(output);
-        if (match.hasMatch()) {
-            return match.captured(1);
+    QDateTime now = QDateTime::currentDateTime();
+    for (const NeighborEntry &entry : neighbors) {
+        if (entry.family != AF_INET6) {
+            continue;
         }
+        Device device;
+        device.macAddress = entry.macAddress;
+        device.ipv6Addresses.append(entry.ipAddress);
+        // STALE يبقى في الجدول دقائق بعد مغادرة الجهاز؛ العنوان يُحفظ دون أن يُعد اتصالاً
+        device.isActive = entry.state & (NUD_REACHABLE | NUD_DELAY | NUD_PROBE);
+        device.lastSeen = now.addMSecs(-entry.confirmedMsAgo);
+        mergeDevice(device);
     }
-    
-    return QString();
 }
 
-std::vector<Device> WifiManager::scanWithNmap() {
-    std::vector<Device> devices;
-    
-    if (!isCommandAvailable("nmap")) {
-        return devices;
+bool WifiManager::startFullSweep() {
+    SweepRequest request;
+    request.interface = m_activeInterface;
+    request.subnetPrefix = m_config.subnetPrefix;
+    request.commandTimeoutMs = m_config.commandTimeoutMs;
+    for (const Device &device : m_devices) {
+        if (!device.hostname.isEmpty()) {
+            request.knownHostnames.insert(deviceKey(device), device.hostname);
+        }
     }
-    
-    // الحصول على نطاق الشبكة
-    QString gateway = executeCommand("ip route | grep default | awk '{print $3}' | head -1").trimmed();
-    if (gateway.isEmpty()) {
-        return devices;
+    if (!m_sweeper->sweep(request)) {
+        return false;
     }
+    m_sweepStarted.start();
+    return true;
+}
+
+void WifiManager::onSweepFinished(const SweepResult &result) {
+    quint64 changesBefore = m_changeCount;
+    m_lastSweepPackets = result.packets;
     
-    // تحويل عنوان البوابة إلى نطاق الشبكة
-    QStringList parts = gateway.split('.');
-    if (parts.size() != 4) {
-        return devices;
+    // دمج نتائج المسح مع ما تعلمناه من الاكتشاف السلبي
+    for (Device device : result.devices) {
+        if (device.manufacturer == "غير معروف") {
+            device.manufacturer = getManufacturer(device.macAddress);
+        }
+        m_arpGuard->observe(device.macAddress, device.ipAddress, device.lastSeen.toMSecsSinceEpoch(),
+                            false, ArpGuard::Scan);
+        mergeDevice(device);
     }
     
-    QString network = QString("%1.%2.%3.0/24").arg(parts[0], parts[1], parts[2]);
+    refreshIpv6Neighbors(result.neighbors);
     
-    QString output = executeCommand(QString("nmap -sn %1 2>/dev/null").arg(network));
+    // الأجهزة الغائبة تبقى كغير متصلة حتى يعود الجهاز نفسه؛ نحذفها فقط بعد يوم كامل
+    pruneStaleDevices(QDateTime::currentDateTime().addDays(-1));
     
-    QStringList lines = output.split('\n');
-    Device currentDevice;
+    publishDevices();
     
-    for (const QString &line : lines) {
-        if (line.startsWith("Nmap scan report for")) {
-            if (!currentDevice.ipAddress.isEmpty()) {
-                devices.push_back(currentDevice);
-            }
-            currentDevice = Device();
-            
-            QRegularExpression ipRegex("(\\d+\\.\\d+\\.\\d+\\.\\d+)");
-            QRegularExpressionMatch match = ipRegex.match(line);
-            if (match.hasMatch()) {
-                currentDevice.ipAddress = match.captured(1);
-                currentDevice.isActive = true;
-                currentDevice.lastSeen = QDateTime::currentDateTime();
-            }
-            
-            // استخراج hostname إذا كان موجوداً
-            if (line.contains('(') && line.contains(')')) {
-                QRegularExpression hostnameRegex("\\(([^)]+)\\)");
-                QRegularExpressionMatch hostnameMatch = hostnameRegex.match(line);
-                if (hostnameMatch.hasMatch()) {
-                    QString hostname = hostnameMatch.captured(1);
-                    if (!hostname.contains('.') || hostname.split('.').size() == 4) {
-                        currentDevice.ipAddress = hostname;
-                    } else {
-                        currentDevice.hostname = hostname;
-                    }
-                }
+    m_scheduler->setReprobeCandidates(m_liveness->dueCount());
+    m_scheduler->reportScan(ScanScheduler::FullSweep, static_cast<int>(m_changeCount - changesBefore),
+                            m_sweepStarted.elapsed(), m_lastSweepPackets + 1);
+    m_lastScanFinished.restart();
+    emit sweepFinished();
+}
+
+QString WifiManager::deviceKey(const Device &device) const {
+    return device.macAddress.isEmpty() ? device.ipAddress : device.macAddress;
+}
+
+bool WifiManager::mergeDevice(const Device &device) {
+    QString key = deviceKey(device);
+    if (key.isEmpty()) {
+        return false;
+    }
+    
+    auto it = m_deviceIndex.constFind(key);
+    bool rekeyed = false;
+    // جهاز رُئي أولاً بعنوانه فقط ثم عُرف عنوانه الفيزيائي: يبقى سجلاً واحداً بمفتاح MAC
+    if (it == m_deviceIndex.constEnd() && !device.macAddress.isEmpty() && !device.ipAddress.isEmpty()) {
+        auto byIp = m_deviceIndex.find(device.ipAddress);
+        if (byIp != m_deviceIndex.end() && m_devices[byIp.value()].macAddress.isEmpty()) {
+            size_t index = byIp.value();
+            m_deviceIndex.erase(byIp);
+            Device &promoted = m_devices[index];
+            promoted.macAddress = device.macAddress;
+            promoted.isBlocked = m_blockedMacs.contains(promoted.macAddress);
+            if (promoted.manufacturer.isEmpty() || promoted.manufacturer == "غير معروف") {
+                promoted.manufacturer = getManufacturer(promoted.macAddress);
             }
-        } else if (line.contains("MAC Address:")) {
-            QRegularExpression macRegex("([0-9A-Fa-f]{2}[:-]){5}([0-9A-Fa-f]{2})");
-            QRegularExpressionMatch match = macRegex.match(line);
-            if (match.hasMatch()) {
-                currentDevice.macAddress = match.captured(0).toUpper();
-                currentDevice.manufacturer = getManufacturer(currentDevice.macAddress);
+            m_deviceIndex.insert(key, index);
+            it = m_deviceIndex.constFind(key);
+            rekeyed = true;
+        }
+    }
+    if (it == m_deviceIndex.constEnd()) {
+        Device added = device;
+        addAddress(added.ipv4Addresses, added.ipAddress);
+        if (added.ipAddress.isEmpty() && !added.ipv4Addresses.isEmpty()) {
+            added.ipAddress = added.ipv4Addresses.first();
+        }
+        if (added.manufacturer.isEmpty()) {
+            added.manufacturer = getManufacturer(added.macAddress);
+        }
+        added.isBlocked = m_blockedMacs.contains(added.macAddress);
+        if (!added.macAddress.isEmpty()) {
+            added.isActive = m_liveness->noteReply(added.macAddress, added.ipAddress,
+                                                   device.isActive ? device.lastSeen : QDateTime());
+            if (added.deviceType.isEmpty()) {
+                m_fingerprinter->noteHostname(added.macAddress, added.hostname);
+                m_fingerprinter->request(added.macAddress, added.ipAddress);
             }
         }
+        m_deviceIndex.insert(key, m_devices.size());
+        m_devices.push_back(added);
+        ++m_changeCount;
+        return true;
     }
     
-    if (!currentDevice.ipAddress.isEmpty()) {
-        devices.push_back(currentDevice);
+    Device &existing = m_devices[it.value()];
+    bool changed = rekeyed;
+    
+    if (!device.ipAddress.isEmpty() && device.ipAddress != existing.ipAddress) {
+        existing.ipAddress = device.ipAddress;
+        changed = true;
+    }
+    changed |= addAddress(existing.ipv4Addresses, device.ipAddress);
+    for (const QString &address : device.ipv4Addresses) {
+        changed |= addAddress(existing.ipv4Addresses, address);
+    }
+    for (const QString &address : device.ipv6Addresses) {
+        changed |= addAddress(existing.ipv6Addresses, address);
+    }
+    if (!device.hostname.isEmpty() && device.hostname != existing.hostname) {
+        existing.hostname = device.hostname;
+        m_fingerprinter->noteHostname(existing.macAddress, existing.hostname);
+        changed = true;
+    }
+    if (!device.manufacturer.isEmpty() && device.manufacturer != "غير معروف" &&
+        device.manufacturer != existing.manufacturer) {
+        existing.manufacturer = device.manufacturer;
+        changed = true;
+    }
+    if (!device.deviceType.isEmpty() && device.deviceType != existing.deviceType) {
+        existing.deviceType = device.deviceType;
+        changed = true;
+    }
+    // أول عنوان IPv4 معروف لجهاز لم يُصنف بعد (مصنفو الذاكرة المحفوظة لا يُفحصون)
+    if (existing.deviceType.isEmpty() && !existing.macAddress.isEmpty()) {
+        m_fingerprinter->request(existing.macAddress, existing.ipAddress);
+    }
+    // حالة الاتصال يحددها متتبع البقاء (مع التخلف) وليس مجرد الظهور في مسح واحد
+    bool alive = device.isActive;
+    if (!existing.macAddress.isEmpty()) {
+        alive = m_liveness->noteReply(existing.macAddress, existing.ipAddress,
+                                      device.isActive ? device.lastSeen : QDateTime());
+    }
+    if (alive && !existing.isActive) {
+        existing.isActive = true;
+        changed = true;
+    }
+    if (device.lastSeen > existing.lastSeen) {
+        existing.lastSeen = device.lastSeen;
     }
     
-    return devices;
+    if (changed) {
+        ++m_changeCount;
+    }
+    return changed;
 }
 
-std::vector<Device> WifiManager::scanWithArpScan() {
-    std::vector<Device> devices;
+void WifiManager::pruneStaleDevices(const QDateTime &cutoff) {
+    std::vector<Device> kept;
+    kept.reserve(m_devices.size());
+    m_deviceIndex.clear();
     
-    if (!isCommandAvailable("arp-scan")) {
-        return devices;
+    for (Device &device : m_devices) {
+        if (device.isActive || device.lastSeen >= cutoff) {
+            m_deviceIndex.insert(deviceKey(device), kept.size());
+            kept.push_back(std::move(device));
+        } else {
+            m_liveness->forget(device.macAddress);
+        }
     }
     
-    QString output = executeCommand("arp-scan --local 2>/dev/null");
+    m_devices.swap(kept);
+}
+
+void WifiManager::onPassiveObservation(const PassiveObservation &observation) {
+    m_arpGuard->observe(observation);
+    m_fingerprinter->observe(observation);
     
-    QStringList lines = output.split('\n');
-    QRegularExpression deviceRegex("(\\d+\\.\\d+\\.\\d+\\.\\d+)\\s+([0-9a-fA-F:]+)\\s+(.*)");
+    Device device;
+    device.macAddress = observation.macAddress;
+    // عناوين IPv6 من NDP/mDNS لا تحل محل عنوان IPv4 للجهاز
+    if (observation.ipAddress.contains(':')) {
+        device.ipv6Addresses.append(observation.ipAddress);
+    } else {
+        device.ipAddress = observation.ipAddress;
+        m_anomalies->observeAddress(observation.macAddress, observation.ipAddress);
+    }
+    device.hostname = observation.hostname;
+    device.isActive = true;
+    device.lastSeen = observation.timestamp;
     
-    for (const QString &line : lines) {
-        QRegularExpressionMatch match = deviceRegex.match(line);
-        if (match.hasMatch()) {
-            Device device;
-            device.ipAddress = match.captured(1);
-            device.macAddress = match.captured(2).toUpper();
-            device.manufacturer = match.captured(3);
-            device.isActive = true;
-            device.lastSeen = QDateTime::currentDateTime();
-            device.hostname = getHostname(device.ipAddress);
-            
-            devices.push_back(device);
-        }
+    bool isNew = !m_deviceIndex.contains(deviceKey(device));
+    if (mergeDevice(device) || isNew) {
+        schedulePublish();
     }
     
-    return devices;
+    // جهاز جديد ظهر على الشبكة: نطلب من المجدول دورة مبكرة
+    if (isNew) {
+        m_scheduler->noteNetworkEvent();
+    }
 }
 
-std::vector<Device> WifiManager::scanWithArpTable() {
-    std::vector<Device> devices;
-    
-    QString output = executeCommand("arp -a 2>/dev/null");
-    
-    QStringList lines = output.split('\n');
-    QRegularExpression arpRegex("([^\\s]+)\\s+\\((\\d+\\.\\d+\\.\\d+\\.\\d+)\\)\\s+at\\s+([0-9a-fA-F:]+)");
+void WifiManager::onFingerprintChanged(const QString &macAddress, const DeviceFingerprint &fingerprint) {
+    // جهاز فُحص دون نتيجة يُحفظ كـ "unknown" حتى لا يُفحص ثانية بعد إعادة التشغيل
+    if (fingerprint.type == DeviceFingerprint::Unknown && !fingerprint.probed) {
+        return;
+    }
+    auto it = m_deviceIndex.constFind(macAddress);
+    if (it == m_deviceIndex.constEnd()) {
+        return;
+    }
+    Device &device = m_devices[it.value()];
+    QString type = DeviceFingerprint::typeKey(fingerprint.type);
+    if (device.deviceType != type) {
+        device.deviceType = type;
+        ++m_changeCount;
+        schedulePublish();
+    }
+}
+
+std::vector<DomainCount> WifiManager::topDomains(const QString &macAddress, int count) const {
+    auto it = m_deviceIndex.constFind(macAddress.toUpper());
+    if (it == m_deviceIndex.constEnd()) {
+        return {};
+    }
+    const Device &device = m_devices[it.value()];
+    QStringList addresses = device.ipv4Addresses + device.ipv6Addresses;
+    if (!device.ipAddress.isEmpty() && !addresses.contains(device.ipAddress)) {
+        addresses.prepend(device.ipAddress);
+    }
+    if (addresses.size() == 1) {
+        return m_dnsLog->topDomains(addresses.first(), count);
+    }
     
-    for (const QString &line : lines) {
-        QRegularExpressionMatch match = arpRegex.match(line);
-        if (match.hasMatch()) {
-            Device device;
-            device.hostname = match.captured(1);
-            device.ipAddress = match.captured(2);
-            device.macAddress = match.captured(3).toUpper();
-            device.manufacturer = getManufacturer(device.macAddress);
-            device.isActive = true;
-            device.lastSeen = QDateTime::currentDateTime();
-            
-            devices.push_back(device);
+    // الجهاز يستعلم من IPv4 و IPv6 معاً: جمع أعلى القوائم من كل عنوان
+    QHash<QString, DomainCount> merged;
+    for (const QString &address : addresses) {
+        for (const DomainCount &entry : m_dnsLog->topDomains(address, count)) {
+            DomainCount &total = merged[entry.domain];
+            total.domain = entry.domain;
+            total.count += entry.count;
+            total.error += entry.error;
         }
     }
-    
-    return devices;
+    std::vector<DomainCount> result(merged.cbegin(), merged.cend());
+    std::sort(result.begin(), result.end(),
+              [](const DomainCount &a, const DomainCount &b) { return a.count > b.count; });
+    if (static_cast<int>(result.size()) > count) {
+        result.resize(count);
+    }
+    return result;
 }
 
-std::vector<Device> WifiManager::getConnectedDevices() {
-    std::vector<Device> devices;
+void WifiManager::onLeaseUpdated(const DhcpLease &lease) {
+    QDateTime now = QDateTime::currentDateTime();
+    // عقد منتهٍ بقي في الملف ليس دليلاً على وجود الجهاز الآن
+    if (lease.expiry.isValid() && lease.expiry <= now) {
+        return;
+    }
     
-    // محاولة استخدام طرق متعددة للحصول على الأجهزة
-    devices = scanWithNmap();
+    Device device;
+    device.macAddress = lease.macAddress;
+    device.ipAddress = lease.ipAddress;
+    device.hostname = lease.hostname;
+    device.isActive = true;
+    device.lastSeen = now;
+    m_anomalies->observeAddress(lease.macAddress, lease.ipAddress);
     
-    if (devices.empty()) {
-        devices = scanWithArpScan();
+    bool isNew = !m_deviceIndex.contains(deviceKey(device));
+    if (mergeDevice(device) || isNew) {
+        schedulePublish();
     }
-    
-    if (devices.empty()) {
-        devices = scanWithArpTable();
+}
+
+void WifiManager::onLeaseRemoved(const QString &macAddress) {
+    auto it = m_deviceIndex.constFind(macAddress);
+    if (it != m_deviceIndex.constEnd() && m_devices[it.value()].isActive) {
+        m_devices[it.value()].isActive = false;
+        ++m_changeCount;
+        schedulePublish();
     }
-    
-    // إضافة معلومات إضافية للأجهزة
-    for (Device &device : devices) {
-        if (device.hostname.isEmpty()) {
-            device.hostname = getHostname(device.ipAddress);
+}
+
+void WifiManager::onLivenessChanged(const QString &macAddress, bool isActive) {
+    auto it = m_deviceIndex.constFind(macAddress);
+    if (it != m_deviceIndex.constEnd() && m_devices[it.value()].isActive != isActive) {
+        m_devices[it.value()].isActive = isActive;
+        ++m_changeCount;
+        schedulePublish();
+    }
+}
+
+void WifiManager::onStationConnected(const QString &macAddress, qint64 timestampUs) {
+    auto it = m_deviceIndex.constFind(macAddress);
+    if (it == m_deviceIndex.constEnd()) {
+        // جهاز جديد ارتبط للتو؛ عنوانه يظهر مع DHCP أو المسح التالي
+        m_scheduler->noteNetworkEvent();
+        return;
+    }
+    Device &device = m_devices[it.value()];
+    device.lastSeen = QDateTime::fromMSecsSinceEpoch(timestampUs / 1000);
+    m_liveness->noteReply(device.macAddress, device.ipAddress, device.lastSeen);
+    if (!device.isActive) {
+        device.isActive = true;
+        ++m_changeCount;
+    }
+    schedulePublish();
+}
+
+void WifiManager::onStationDisconnected(const QString &macAddress, quint16 reasonCode, qint64 timestampUs) {
+    Q_UNUSED(reasonCode);
+    Q_UNUSED(timestampUs);
+    // الانفصال من نقطة الوصول مؤكد، لا داعي لانتظار فشل الفحوصات
+    auto it = m_deviceIndex.constFind(macAddress);
+    if (it != m_deviceIndex.constEnd() && m_devices[it.value()].isActive) {
+        m_devices[it.value()].isActive = false;
+        ++m_changeCount;
+        schedulePublish();
+    }
+}
+
+void WifiManager::onStationsSampled() {
+    bool changed = false;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QHash<QString, QPair<quint64, quint64>> stationBytes;
+    for (const StationLink &link : m_telemetry->links()) {
+        // العدادات من جهة نقطة الوصول: ما أرسلته للمحطة استقبله الجهاز
+        qint64 received = static_cast<qint64>(link.txBytes);
+        qint64 sent = static_cast<qint64>(link.rxBytes);
+        m_anomalies->observeTraffic(link.macAddress, received, sent, now);
+
+        // عدادات المحطة تبدأ من الصفر مع كل ارتباط؛ عدادات الجهاز تراكمية عبر الجلسات
+        // (من الذاكرة المؤقتة أو الاستيراد) فيُضاف إليها الفرق فقط ولا تُستبدل
+        auto delta = [](quint64 current, quint64 last) {
+            return static_cast<qint64>(current >= last ? current - last : current);
+        };
+        auto previous = m_stationBytes.constFind(link.macAddress);
+        qint64 receivedDelta = 0;
+        qint64 sentDelta = 0;
+        if (previous != m_stationBytes.constEnd()) {
+            receivedDelta = delta(link.txBytes, previous->first);
+            sentDelta = delta(link.rxBytes, previous->second);
         }
+        stationBytes.insert(link.macAddress, qMakePair(link.txBytes, link.rxBytes));
         
-        if (device.manufacturer == "غير معروف") {
-            device.manufacturer = getManufacturer(device.macAddress);
+        auto it = m_deviceIndex.constFind(link.macAddress);
+        if (it == m_deviceIndex.constEnd()) {
+            continue;
+        }
+        Device &device = m_devices[it.value()];
+        // تذبذب الإشارة بأقل من 1 dBm لا يستحق إعادة نشر القائمة
+        if (qAbs(device.signalStrength - link.signalDbm) >= 1.0 || device.weakLink != link.weak) {
+            device.signalStrength = link.signalDbm;
+            device.weakLink = link.weak;
+            changed = true;
         }
+        if (receivedDelta > 0 || sentDelta > 0) {
+            device.bytesReceived += receivedDelta;
+            device.bytesSent += sentDelta;
+            changed = true;
+        }
+    }
+    m_stationBytes.swap(stationBytes);
+    if (changed) {
+        schedulePublish();
     }
+}
+
+void WifiManager::schedulePublish() {
+    if (!m_publishTimer->isActive()) {
+        m_publishTimer->start();
+    }
+}
+
+void WifiManager::publishDevices() {
+    m_publishTimer->stop();
+    if (m_updateBus) {
+        m_updateBus->publishDevices(m_devices);
+    }
+    emit devicesUpdated(m_devices);
+    m_history->record(m_devices);
     
-    m_devices = devices;
-    emit devicesUpdated(devices);
-    return devices;
+    // حفظ القائمة للبدء التالي، مرة في الدقيقة على الأكثر
+    if (!m_lastCacheSave.isValid() || m_lastCacheSave.elapsed() > 60000) {
+        saveDeviceCache();
+    }
 }
 
-bool WifiManager::blockDevice(const QString &macAddress) {
-    if (!isCommandAvailable("iptables")) {
-        emit errorOccurred("iptables غير متوفر على النظام");
+QString WifiManager::deviceCachePath() const {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/devices.json";
+}
+
+bool WifiManager::loadDeviceCache() {
+    QFile file(deviceCachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
         return false;
     }
     
-    // حظر جهاز باستخدام iptables
-    QString command = QString("iptables -A INPUT -m mac --mac-source %1 -j DROP").arg(macAddress);
-    QString output = executeCommand(command);
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isArray()) {
+        return false;
+    }
     
-    command = QString("iptables -A FORWARD -m mac --mac-source %1 -j DROP").arg(macAddress);
-    output += executeCommand(command);
+    std::vector<Device> devices;
+    for (const QJsonValue &value : doc.array()) {
+        const QJsonObject object = value.toObject();
+        Device device;
+        device.macAddress = object["mac"].toString();
+        device.ipAddress = object["ip"].toString();
+        for (const QJsonValue &address : object["ipv4"].toArray()) {
+            device.ipv4Addresses.append(address.toString());
+        }
+        for (const QJsonValue &address : object["ipv6"].toArray()) {
+            device.ipv6Addresses.append(address.toString());
+        }
+        device.hostname = object["hostname"].toString();
+        device.manufacturer = object["manufacturer"].toString();
+        device.deviceType = object["deviceType"].toString();
+        device.lastSeen = QDateTime::fromString(object["lastSeen"].toString(), Qt::ISODate);
+        devices.push_back(device);
+    }
+    restoreDevices(devices);
     
-    return m_process->exitCode() == 0;
+    if (m_devices.empty()) {
+        return false;
+    }
+    if (m_updateBus) {
+        m_updateBus->publishDevices(m_devices);
+    }
+    emit devicesUpdated(m_devices);
+    return true;
 }
 
-bool WifiManager::unblockDevice(const QString &macAddress) {
-    if (!isCommandAvailable("iptables")) {
-        emit errorOccurred("iptables غير متوفر على النظام");
-        return false;
+void WifiManager::restoreDevices(const std::vector<Device> &devices) {
+    for (Device device : devices) {
+        // غير متصل حتى يؤكده مصدر حي؛ متتبع البقاء يفحصه في أول دورة
+        device.isActive = false;
+        
+        mergeDevice(device);
+        if (!device.macAddress.isEmpty() && !device.ipAddress.isEmpty() && device.lastSeen.isValid()) {
+            m_liveness->noteReply(device.macAddress, device.ipAddress, device.lastSeen);
+        }
+    }
+}
+
+void WifiManager::importDevices(const std::vector<Device> &devices) {
+    restoreDevices(devices);
+    publishDevices();
+    saveDeviceCache();
+}
+
+void WifiManager::saveDeviceCache() {
+    m_lastCacheSave.restart();
+    if (m_devices.empty()) {
+        return;
     }
     
-    // إلغاء حظر جهاز
-    QString command = QString("iptables -D INPUT -m mac --mac-source %1 -j DROP 2>/dev/null").arg(macAddress);
-    executeCommand(command);
+    QJsonArray array;
+    for (const Device &device : m_devices) {
+        QJsonObject object;
+        object["mac"] = device.macAddress;
+        object["ip"] = device.ipAddress;
+        object["ipv4"] = QJsonArray::fromStringList(device.ipv4Addresses);
+        object["ipv6"] = QJsonArray::fromStringList(device.ipv6Addresses);
+        object["hostname"] = device.hostname;
+        object["manufacturer"] = device.manufacturer;
+        if (!device.deviceType.isEmpty()) {
+            object["deviceType"] = device.deviceType;
+        }
+        object["lastSeen"] = device.lastSeen.toString(Qt::ISODate);
+        array.append(object);
+    }
     
-    command = QString("iptables -D FORWARD -m mac --mac-source %1 -j DROP 2>/dev/null").arg(macAddress);
-    executeCommand(command);
+    QString path = deviceCachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Device cache: cannot write" << path << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qDebug() << "Device cache: commit failed" << path << file.errorString();
+    }
+}
+
+bool WifiManager::blockDevice(const QString &macAddress) {
+    return queueBlock(macAddress) && commitFirewallChanges();
+}
+
+bool WifiManager::unblockDevice(const QString &macAddress) {
+    return queueUnblock(macAddress) && commitFirewallChanges();
+}
+
+bool WifiManager::queueBlock(const QString &macAddress) {
+    // المفتاح يصل إلى نص iptables-restore: يُرفض هنا أياً كانت الواجهة التي أرسلته
+    if (!Firewall::isValidMac(macAddress)) {
+        emit errorOccurred(QString("عنوان MAC غير صالح: %1").arg(macAddress));
+        return false;
+    }
+    m_pendingFirewall.insert(macAddress.toUpper(), true); // آخر طلب للجهاز نفسه هو المعتمد
+    return true;
+}
+
+bool WifiManager::queueUnblock(const QString &macAddress) {
+    if (!Firewall::isValidMac(macAddress)) {
+        emit errorOccurred(QString("عنوان MAC غير صالح: %1").arg(macAddress));
+        return false;
+    }
+    m_pendingFirewall.insert(macAddress.toUpper(), false);
+    return true;
+}
+
+int WifiManager::pendingFirewallChanges() const {
+    return m_pendingFirewall.size();
+}
+
+void WifiManager::discardFirewallChanges() {
+    m_pendingFirewall.clear();
+}
+
+QSet<QString> WifiManager::blockedDevices() const {
+    return m_blockedMacs;
+}
+
+void WifiManager::loadBlockedDevices() {
+    Firewall::BlockRules rules;
+    if (readFirewallState(&rules)) {
+        applyBlockRules(rules);
+    }
+}
+
+void WifiManager::applyBlockRules(const Firewall::BlockRules &rules) {
+    m_blockedMacs.clear();
+    for (auto it = rules.input.constBegin(); it != rules.input.constEnd(); ++it) {
+        m_blockedMacs.insert(it.key());
+    }
+    for (auto it = rules.forward.constBegin(); it != rules.forward.constEnd(); ++it) {
+        m_blockedMacs.insert(it.key());
+    }
     
-    return true; // iptables -D لا يفشل حتى لو لم تكن القاعدة موجودة
+    bool changed = false;
+    for (Device &device : m_devices) {
+        bool blocked = m_blockedMacs.contains(device.macAddress);
+        if (device.isBlocked != blocked) {
+            device.isBlocked = blocked;
+            changed = true;
+        }
+    }
+    if (changed) {
+        schedulePublish();
+    }
 }
 
-bool WifiManager::changeSSID(const QString &newSSID) {
-    // هذه الوظيفة تتطلب إعداد Access Point
-    // سنحاول تغيير SSID في ملفات التكوين المختلفة
+bool WifiManager::readFirewallState(Firewall::BlockRules *rules) {
+    if (PrivilegedHelper::isConnected()) {
+        PrivilegedHelper::Batch batch;
+        batch.listBlocked();
+        std::vector<PrivilegedHelper::Result> results;
+        return batch.submit(&results) && results.front().status == PrivilegedHelper::Ok &&
+               PrivilegedHelper::decodeBlockRules(results.front().payload, rules);
+    }
+    return Firewall::isAvailable() && Firewall::readBlocked(rules, m_config.commandTimeoutMs);
+}
+
+bool WifiManager::commitFirewallChanges() {
+    if (m_pendingFirewall.isEmpty()) {
+        return true;
+    }
     
-    QStringList configPaths = {
-        "/etc/hostapd/hostapd.conf",
-        "/etc/hostapd.conf",
-        "/etc/wpa_supplicant/wpa_supplicant.conf"
-    };
+    QHash<QString, bool> changes;
+    changes.swap(m_pendingFirewall);
     
-    bool found = false;
-    for (const QString &path : configPaths) {
-        if (QFile::exists(path)) {
-            QString command = QString("sed -i 's/^ssid=.*/ssid=%1/' %2").arg(newSSID, path);
-            executeCommand(command);
-            found = true;
+    // المساعد يقرأ ويطبق في دفعة iptables-restore واحدة كما في الوضع المحلي
+    QString error;
+    bool applied = false;
+    if (PrivilegedHelper::isConnected()) {
+        PrivilegedHelper::Batch batch;
+        batch.setBlocked(changes);
+        std::vector<PrivilegedHelper::Result> results;
+        if (!batch.submit(&results)) {
+            emit errorOccurred("انقطع الاتصال بالمساعد المميز");
+            return false;
         }
+        applied = results.front().status == PrivilegedHelper::Ok;
+        error = QString::fromUtf8(results.front().payload);
+    } else {
+        if (!Firewall::isAvailable()) {
+            emit errorOccurred("iptables غير متوفر على النظام");
+            return false;
+        }
+        applied = Firewall::setBlocked(changes, m_config.commandTimeoutMs, &error);
     }
-    
-    if (!found) {
-        emit errorOccurred("لم يتم العثور على ملفات تكوين Access Point");
+    if (!applied) {
+        qDebug() << "Firewall transaction failed:" << error;
+        emit errorOccurred(QString("فشل تطبيق %1 تغيير على الجدار الناري؛ لم يُطبق أي منها").arg(changes.size()));
         return false;
     }
     
-    return restartRouter();
+    // تحديث حالة الأجهزة في مكانها دون إعادة مسح
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        if (it.value()) {
+            m_blockedMacs.insert(it.key());
+        } else {
+            m_blockedMacs.remove(it.key());
+        }
+        auto index = m_deviceIndex.constFind(it.key());
+        if (index != m_deviceIndex.constEnd() && m_devices[index.value()].isBlocked != it.value()) {
+            m_devices[index.value()].isBlocked = it.value();
+            ++m_changeCount;
+        }
+    }
+    schedulePublish();
+    return true;
+}
+
+bool WifiManager::changeSSID(const QString &newSSID) {
+    // هذه الوظيفة تتطلب إعداد Access Point
+    return updateAccessPoint({{"ssid", newSSID}});
 }
 
 bool WifiManager::changePassword(const QString &newPassword) {
-    QStringList configPaths = {
-        "/etc/hostapd/hostapd.conf",
-        "/etc/hostapd.conf"
-    };
-    
+    return updateAccessPoint({{"wpa_passphrase", newPassword}});
+}
+
+bool WifiManager::changeChannel(int channel) {
+    return updateAccessPoint({{"channel", QString::number(channel)}});
+}
+
+bool WifiManager::updateAccessPoint(const QHash<QString, QString> &changes) {
+    // wpa_supplicant يشارك hostapd اسم الشبكة فقط
+    QHash<QString, QString> supplicantChanges;
+    if (changes.contains("ssid")) {
+        supplicantChanges.insert("ssid", changes.value("ssid"));
+    }
+    QStringList paths = m_config.hostapdConfigPaths;
+    if (!supplicantChanges.isEmpty()) {
+        paths += m_config.supplicantConfigPaths;
+    }
+
+    // قراءة كل الملفات أولاً؛ أي قيمة مرفوضة تلغي العملية قبل كتابة أي ملف
+    std::vector<QByteArray> contents(paths.size());
+    std::vector<bool> present(paths.size(), false);
+    if (PrivilegedHelper::isConnected()) {
+        PrivilegedHelper::Batch reads;
+        for (const QString &path : paths) {
+            reads.readFile(path);
+        }
+        std::vector<PrivilegedHelper::Result> results;
+        if (!reads.submit(&results)) {
+            emit errorOccurred("انقطع الاتصال بالمساعد المميز");
+            return false;
+        }
+        for (int i = 0; i < paths.size(); ++i) {
+            present[i] = results[i].status == PrivilegedHelper::Ok;
+            contents[i] = results[i].payload;
+        }
+    } else {
+        for (int i = 0; i < paths.size(); ++i) {
+            QFile file(paths[i]);
+            present[i] = file.open(QIODevice::ReadOnly);
+            if (present[i]) {
+                contents[i] = file.readAll();
+            }
+        }
+    }
+
+    std::vector<std::pair<QString, QByteArray>> writes;
+    bool hostapdChanged = false;
+    bool supplicantChanged = false;
     bool found = false;
-    for (const QString &path : configPaths) {
-        if (QFile::exists(path)) {
-            QString command = QString("sed -i 's/^wpa_passphrase=.*/wpa_passphrase=%1/' %2").arg(newPassword, path);
-            executeCommand(command);
-            found = true;
+    for (int i = 0; i < paths.size(); ++i) {
+        if (!present[i]) {
+            continue;
+        }
+        found = true;
+        // الصيغة من القائمة التي جاء منها المسار لا من اسمه
+        ApConfigFile file(i < m_config.hostapdConfigPaths.size() ? ApConfigFile::Hostapd : ApConfigFile::Supplicant);
+        file.parse(contents[i]);
+        QString error;
+        if (!file.apply(file.format() == ApConfigFile::Hostapd ? changes : supplicantChanges, &error)) {
+            emit errorOccurred(error);
+            return false;
+        }
+        if (file.isModified()) {
+            writes.emplace_back(paths[i], file.serialize());
+            (file.format() == ApConfigFile::Hostapd ? hostapdChanged : supplicantChanged) = true;
         }
     }
-    
     if (!found) {
         emit errorOccurred("لم يتم العثور على ملفات تكوين Access Point");
         return false;
     }
-    
-    return restartRouter();
+    if (writes.empty()) {
+        return true;
+    }
+
+    // كتابة ذرية لكل ملف (ملف مؤقت ثم إعادة تسمية)، ثم إعادة تحميل hostapd.
+    // RELOAD يكفي لملفات hostapd وحدها؛ تغيير wpa_supplicant أو فشل RELOAD يحتاج إعادة تشغيل
+    const bool tryReload = hostapdChanged && !supplicantChanged;
+    bool reloaded = false;
+    if (PrivilegedHelper::isConnected()) {
+        PrivilegedHelper::Batch batch;
+        for (const auto &write : writes) {
+            batch.writeFile(write.first, write.second);
+        }
+        int reload = tryReload ? batch.hostapdCommand(m_activeInterface, "RELOAD") : -1;
+        std::vector<PrivilegedHelper::Result> results;
+        if (!batch.submit(&results)) {
+            emit errorOccurred("انقطع الاتصال بالمساعد المميز");
+            return false;
+        }
+        for (int i = 0; i < static_cast<int>(writes.size()); ++i) {
+            if (results[i].status != PrivilegedHelper::Ok) {
+                emit errorOccurred(QString("فشلت كتابة ملف التكوين: %1").arg(QString::fromUtf8(results[i].payload)));
+                return false;
+            }
+        }
+        reloaded = reload >= 0 && results[reload].status == PrivilegedHelper::Ok &&
+                   results[reload].payload.startsWith("OK");
+    } else {
+        for (const auto &write : writes) {
+            // QSaveFile يحتفظ بصلاحيات الملف الأصلي ويستبدله ذرياً
+            QSaveFile output(write.first);
+            if (!output.open(QIODevice::WriteOnly) || output.write(write.second) != write.second.size() ||
+                !output.commit()) {
+                emit errorOccurred(QString("فشلت كتابة ملف التكوين: %1").arg(write.first));
+                return false;
+            }
+        }
+        reloaded = tryReload && HostapdControl::reload(m_config.hostapdControlDir, m_activeInterface);
+    }
+
+    // RELOAD فشل أو لم يكفِ: إعادة تشغيل ما تغير ملفه فقط؛ تعديل wpa_supplicant
+    // وحده لا يعيد تشغيل hostapd فيفصل كل العملاء
+    return reloaded || restartServices((hostapdChanged ? ServiceOrchestrator::AccessPointConfig : 0) |
+                                       (supplicantChanged ? ServiceOrchestrator::SupplicantConfig : 0));
 }
 
 bool WifiManager::restartRouter() {
-    // محاولة إعادة تشغيل خدمات الشبكة المختلفة
-    QStringList services = {"hostapd", "dnsmasq", "networking", "NetworkManager"};
-    
-    bool success = false;
-    for (const QString &service : services) {
-        if (isCommandAvailable("systemctl")) {
-            QString command = QString("systemctl restart %1 2>/dev/null").arg(service);
-            executeCommand(command);
-            if (m_process->exitCode() == 0) {
-                success = true;
-            }
+    return restartServices(ServiceOrchestrator::AllServices);
+}
+
+bool WifiManager::restartServices(int changes) {
+    // الجاهزية تُفحص على عنوان الحلقة المحلية وعناوين واجهة نقطة الوصول
+    QList<QHostAddress> dnsAddresses = {QHostAddress::LocalHost};
+    for (const QNetworkAddressEntry &entry : QNetworkInterface::interfaceFromName(m_activeInterface).addressEntries()) {
+        if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+            dnsAddresses << entry.ip();
         }
     }
+    m_services->setHostapd(m_config.hostapdControlDir, m_activeInterface);
+    m_services->setDnsAddresses(dnsAddresses);
     
-    return success;
+    if (m_services->restart(changes)) {
+        return true;
+    }
+    emit errorOccurred(m_services->isBusy() ? "إعادة تشغيل سابقة للخدمات ما زالت جارية"
+                                            : "لا توجد خدمات مثبتة متأثرة بالتغيير");
+    return false;
 }
 
 bool WifiManager::checkSystemRequirements() {
-    QStringList requiredTools = {"ip", "arp"};
-    QStringList optionalTools = {"nmap", "arp-scan", "iwconfig", "iw", "nmcli", "iptables"};
-    
     bool hasRequired = true;
-    for (const QString &tool : requiredTools) {
+    for (const QString &tool : kRequiredTools) {
         if (!isCommandAvailable(tool)) {
             hasRequired = false;
             emit errorOccurred(QString("الأداة المطلوبة %1 غير متوفرة").arg(tool));
@@ -433,7 +1041,7 @@ bool WifiManager::checkSystemRequirements() {
     }
     
     int optionalCount = 0;
-    for (const QString &tool : optionalTools) {
+    for (const QString &tool : kOptionalTools) {
         if (isCommandAvailable(tool)) {
             optionalCount++;
         }
@@ -448,9 +1056,7 @@ bool WifiManager::checkSystemRequirements() {
 
 QStringList WifiManager::getMissingTools() {
     QStringList missing;
-    QStringList tools = {"nmap", "arp-scan", "iwconfig", "iw", "nmcli", "iptables", "hostapd", "dnsmasq"};
-    
-    for (const QString &tool : tools) {
+    for (const QString &tool : kOptionalTools + kServiceTools) {
         if (!isCommandAvailable(tool)) {
             missing.append(tool);
         }
@@ -500,22 +1106,201 @@ double WifiManager::getCurrentSpeed() {
 }
 
 void WifiManager::refreshDevices() {
-    getConnectedDevices();
+    runScan(ScanScheduler::FullSweep);
+}
+
+void WifiManager::runScan(ScanScheduler::Depth depth) {
+    QElapsedTimer timer;
+    timer.start();
+    quint64 changesBefore = m_changeCount;
+    int packets = 0;
+    
+    switch (depth) {
+    case ScanScheduler::FullSweep:
+        // المسح يعمل في خيط DeviceSweeper ويبلغ المجدول عند انتهائه؛ طلب أثناء مسح
+        // جارٍ تخدمه نتيجة ذلك المسح
+        startFullSweep();
+        return;
+    case ScanScheduler::Reprobe:
+        packets = reprobeStaleDevices();
+        readNeighborTable();
+        break;
+    case ScanScheduler::NeighborRead:
+        readNeighborTable();
+        packets = 1;
+        break;
+    }
+    
+    m_scheduler->setReprobeCandidates(m_liveness->dueCount());
+    m_scheduler->reportScan(depth, static_cast<int>(m_changeCount - changesBefore), timer.elapsed(), packets);
+    m_lastScanFinished.restart();
+}
+
+void WifiManager::readNeighborTable() {
+    std::vector<NeighborEntry> neighbors;
+    if (!NeighborTable::dump(m_activeInterface, &neighbors)) {
+        // بدون netlink: arp -a في خيط المسح، والنتيجة تُدمج عند وصولها
+        m_sweeper->readArpTable(m_config.commandTimeoutMs);
+        return;
+    }
+    
+    quint64 changesBefore = m_changeCount;
+    mergeNeighborDevices(DeviceSweeper::neighborDevices(neighbors));
+    refreshIpv6Neighbors(neighbors);
+    
+    if (m_changeCount != changesBefore) {
+        schedulePublish();
+    }
+}
+
+void WifiManager::mergeNeighborDevices(const std::vector<Device> &devices) {
+    quint64 changesBefore = m_changeCount;
+    for (const Device &device : devices) {
+        m_arpGuard->observe(device.macAddress, device.ipAddress, device.lastSeen.toMSecsSinceEpoch(),
+                            false, ArpGuard::Scan);
+        mergeDevice(device);
+    }
+    
+    if (m_changeCount != changesBefore) {
+        schedulePublish();
+    }
+}
+
+int WifiManager::reprobeStaleDevices() {
+    // حد أعلى لكل دورة حتى لا يتحول الفحص الموجه إلى مسح كامل
+    std::vector<LivenessTracker::Probe> probes = m_liveness->takeDueProbes(64);
+    if (probes.empty()) {
+        return 0;
+    }
+    
+    // مع الاكتشاف السلبي نرسل ARP أحادياً ونلتقط الرد مباشرة من الحلقة
+    if (m_passiveDiscovery->isRunning()) {
+        std::vector<std::pair<QString, QString>> targets;
+        targets.reserve(probes.size());
+        for (const LivenessTracker::Probe &probe : probes) {
+            targets.emplace_back(probe.macAddress, probe.ipAddress);
+        }
+        int sent = NeighborTable::probeArp(m_activeInterface, targets);
+        if (sent > 0) {
+            return sent;
+        }
+    }
+    
+    // وإلا نترك النواة تتحقق من الجار ونقرأ النتيجة من جدول الجيران لاحقاً
+    QStringList addresses;
+    for (const LivenessTracker::Probe &probe : probes) {
+        addresses.append(probe.ipAddress);
+    }
+    return NeighborTable::probeUnicast(addresses);
+}
+
+void WifiManager::setUpdateBus(UpdateBus *bus) {
+    m_updateBus = bus;
+}
+
+ScanScheduler::Counters WifiManager::scanCounters() const {
+    return m_scheduler->counters();
 }
 
 void WifiManager::startMonitoring() {
-    // فحص المتطلبات عند البدء
-    if (!checkSystemRequirements()) {
-        QStringList missing = getMissingTools();
-        if (!missing.isEmpty()) {
-            emit errorOccurred(QString("أدوات مفقودة: %1").arg(missing.join(", ")));
+    // فحص الأدوات والبوابة وقواعد الحظر في خيط المسح؛ النتيجة في onStartupProbed.
+    // مع المساعد المميز تبقى قراءة القواعد طلباً واحداً عبر مقبسه
+    bool helper = PrivilegedHelper::isConnected();
+    m_sweeper->probeStartup(m_activeInterface, kRequiredTools + kOptionalTools + kServiceTools, !helper,
+                            m_config.commandTimeoutMs);
+    if (helper) {
+        loadBlockedDevices();
+    }
+    
+    // مع الاكتشاف السلبي تصل الأجهزة الجديدة فوراً، فيمكن إبطاء الجدولة
+    bool passive = m_passiveDiscovery->start(m_activeInterface);
+    m_leaseWatcher->start();
+    m_dnsLog->start(m_config.dnsLogPath);
+    m_neighborMonitor->start(m_activeInterface);
+    m_associations->start(m_activeInterface);
+    m_telemetry->start(m_activeInterface, m_config.telemetryIntervalMs);
+    m_history->open();
+    
+    // عنوان هذا الجهاز يُثبت على MAC واجهته، والبوابة عند وصول فحص البدء
+    m_arpGuard->clearWatched();
+    QNetworkInterface local = QNetworkInterface::interfaceFromName(m_activeInterface);
+    for (const QNetworkAddressEntry &entry : local.addressEntries()) {
+        if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+            m_arpGuard->watchAddress(entry.ip().toString(), local.hardwareAddress(), "هذا الجهاز");
         }
     }
     
-    m_refreshTimer->start(5000); // تحديث كل 5 ثواني
-    refreshDevices();
+    // قراءة جدول الجيران رخيصة وتعطي قائمة حقيقية فوراً؛ المسح الكامل الأول
+    // يتأخر قليلاً حتى تستقر النافذة بعد الظهور
+    readNeighborTable();
+    
+    applyScanProfile(passive);
+    m_liveness->start();
+    m_scheduler->start(3000);
+}
+
+void WifiManager::onStartupProbed(const StartupProbe &probe) {
+    // فحص المتطلبات عند البدء: الذاكرة معبأة الآن فلا يبحث أي منهما في PATH
+    for (auto it = probe.tools.constBegin(); it != probe.tools.constEnd(); ++it) {
+        m_toolCache.insert(it.key(), it.value());
+    }
+    QStringList missing = getMissingTools();
+    if (!checkSystemRequirements() && !missing.isEmpty()) {
+        emit errorOccurred(QString("أدوات مفقودة: %1").arg(missing.join(", ")));
+    }
+    emit toolsChecked(missing);
+    
+    // البوابة تُثبت على أول MAC يُرى لها بعد الآن
+    if (!probe.gateway.isEmpty()) {
+        m_arpGuard->watchAddress(probe.gateway, QString(), "البوابة");
+    }
+    
+    // الأجهزة المحظورة من تشغيل سابق تظهر كمحظورة
+    if (probe.firewallRead) {
+        applyBlockRules(probe.blockRules);
+    }
+}
+
+void WifiManager::applyScanProfile(bool passive) {
+    // ملف الجدولة حسب توفر الاكتشاف السلبي؛ يسري على الدورة التالية
+    const AppConfig::ScanProfile &profile = passive ? m_config.passiveScan : m_config.activeScan;
+    m_scheduler->setIntervalRange(profile.minIntervalMs, profile.maxIntervalMs);
+    m_scheduler->setFullSweepInterval(profile.fullSweepIntervalMs);
+}
+
+void WifiManager::applyConfig(const AppConfig &config) {
+    m_config = config;
+    
+    ScanScheduler::Budget budget;
+    budget.scanMsPerMinute = m_config.scanBudgetMsPerMinute;
+    budget.packetsPerMinute = m_config.scanBudgetPacketsPerMinute;
+    m_scheduler->setBudget(budget);
+    m_liveness->setTimeouts(m_config.probeAfterMs, m_config.probeIntervalMs, m_config.missesBeforeInactive);
+    m_telemetry->setInterval(m_config.telemetryIntervalMs);
+    m_associations->setHostapdControlDir(m_config.hostapdControlDir);
+    m_services->setServices(m_config.services);
+    m_fingerprinter->setEnabled(m_config.fingerprintEnabled);
+    m_fingerprinter->setProbing(m_config.fingerprintProbe);
+    m_fingerprinter->setProbeLimits(m_config.fingerprintMaxConnections, m_config.fingerprintHostIntervalMs,
+                                    m_config.fingerprintConnectTimeoutMs);
+    m_dnsLog->setCapacity(m_config.dnsLogCapacity);
+    QString dnsLogPath = m_config.dnsLogPath.isEmpty() ? DnsQueryLog::defaultLogFile() : m_config.dnsLogPath;
+    if (m_dnsLog->isRunning() && m_dnsLog->logFile() != dnsLogPath) {
+        m_dnsLog->start(dnsLogPath);
+    }
+    
+    if (m_scheduler->isRunning()) {
+        applyScanProfile(m_passiveDiscovery->isRunning());
+    }
 }
 
 void WifiManager::stopMonitoring() {
-    m_refreshTimer->stop();
+    m_scheduler->stop();
+    m_liveness->stop();
+    m_neighborMonitor->stop();
+    m_associations->stop();
+    m_telemetry->stop();
+    m_passiveDiscovery->stop();
+    m_leaseWatcher->stop();
+    m_dnsLog->stop();
 }
@@ -6,18 +6,41 @@
 #include <QTimer>
 #include <QNetworkInterface>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
 #include <memory>
 #include <vector>
+#include "passivediscovery.h"
+#include "dhcpleases.h"
+#include "neighbortable.h"
+#include "scanscheduler.h"
+#include "livenesstracker.h"
+#include "associationtracker.h"
+#include "stationtelemetry.h"
+#include "traffichistory.h"
+#include "anomalydetector.h"
+#include "arpguard.h"
+#include "appconfig.h"
+#include "firewall.h"
+#include "serviceorchestrator.h"
+#include "fingerprinter.h"
+#include "dnsquerylog.h"
 
 struct Device {
     QString macAddress;
-    QString ipAddress;
+    QString ipAddress;          // عنوان IPv4 الأساسي المعروض
+    QStringList ipv4Addresses;
+    QStringList ipv6Addresses;
     QString hostname;
     QString manufacturer;
-    double signalStrength = 0.0;
+    QString deviceType;         // مفتاح DeviceFingerprint::typeKey، فارغ قبل التصنيف
+    double signalStrength = 0.0;   // dBm من قياسات المحطة (0 = غير معروف)
     qint64 bytesReceived = 0;
     qint64 bytesSent = 0;
     bool isActive = false;
+    bool isBlocked = false;     // له قاعدة DROP في INPUT/FORWARD
+    bool weakLink = false;      // إشارة ضعيفة أو إعادات إرسال كثيرة
     QDateTime lastSeen;
 };
 
@@ -32,6 +55,11 @@ struct NetworkInfo {
     QString interface;
 };
 
+class UpdateBus;
+class DeviceSweeper;
+struct SweepResult;
+struct StartupProbe;
+
 class WifiManager : public QObject {
     Q_OBJECT
 
@@ -44,14 +72,26 @@ public:
     std::vector<NetworkInfo> getAvailableNetworks();
     
     // إدارة الأجهزة
-    std::vector<Device> getConnectedDevices();
     bool blockDevice(const QString &macAddress);
     bool unblockDevice(const QString &macAddress);
     
+    // تغييرات الجدار الناري تُجمع في طابور وتُطبق معاً في دفعة واحدة
+    // عبر iptables-restore (كلها أو لا شيء). false لعنوان MAC غير صالح
+    bool queueBlock(const QString &macAddress);
+    bool queueUnblock(const QString &macAddress);
+    int pendingFirewallChanges() const;
+    bool commitFirewallChanges();
+    void discardFirewallChanges();
+    QSet<QString> blockedDevices() const;
+    // إعادة قراءة الأجهزة المحظورة من الجدار الناري (يتطلب الجذر أو المساعد)
+    void loadBlockedDevices();
+    
     // إعدادات الشبكة
     bool changeSSID(const QString &newSSID);
     bool changePassword(const QString &newPassword);
     bool changeChannel(int channel);
+    // عدة مفاتيح hostapd في كتابة ذرية واحدة لكل ملف ثم RELOAD
+    bool updateAccessPoint(const QHash<QString, QString> &changes);
     bool restartRouter();
     
     // إحصائيات
@@ -61,6 +101,42 @@ public:
     // فحص المتطلبات
     bool checkSystemRequirements();
     QStringList getMissingTools();
+    
+    // عدادات المسح الفعلي الذي قامت به الجدولة
+    ScanScheduler::Counters scanCounters() const;
+    
+    // كل تحديث لقائمة الأجهزة يُنشر أيضاً كلقطة على الناقل
+    void setUpdateBus(UpdateBus *bus);
+    
+    // آخر قائمة أجهزة محفوظة على القرص، لعرضها قبل أول مسح
+    bool loadDeviceCache();
+    void saveDeviceCache();
+    
+    // أحداث الارتباط والانفصال من nl80211/hostapd وجلسات كل جهاز
+    const AssociationTracker *associationTracker() const { return m_associations.get(); }
+    
+    // قياسات الرابط (الإشارة، معدل البت، الإعادات) لكل عميل مرتبط
+    const StationTelemetry *stationTelemetry() const { return m_telemetry.get(); }
+    
+    // تاريخ الحركة لكل جهاز على القرص، واستيراد قائمة أجهزة مصدرة من جهاز آخر
+    TrafficHistory *trafficHistory() { return m_history.get(); }
+    void importDevices(const std::vector<Device> &devices);
+    
+    // إحصاءات الحركة المتدفقة لكل جهاز وحدود التنبيه
+    AnomalyDetector *anomalyDetector() { return m_anomalies.get(); }
+    
+    // خرائط IP <-> MAC عبر المسح والالتقاط السلبي وكشف انتحال ARP
+    const ArpGuard *arpGuard() const { return m_arpGuard.get(); }
+    
+    // نوع الجهاز ونظامه مع الأدلة، مخزنة لكل MAC
+    const Fingerprinter *fingerprinter() const { return m_fingerprinter.get(); }
+    
+    // أكثر النطاقات طلباً من الجهاز عبر كل عناوينه، من سجل استعلامات dnsmasq
+    std::vector<DomainCount> topDomains(const QString &macAddress, int count) const;
+    const DnsQueryLog *dnsQueryLog() const { return m_dnsLog.get(); }
+    
+    // تطبيق الإعدادات؛ أثناء المراقبة تُعاد معايرة المؤقتات والمسارات في مكانها
+    void applyConfig(const AppConfig &config);
 
 public slots:
     void refreshDevices();
@@ -71,15 +147,78 @@ signals:
     void devicesUpdated(const std::vector<Device> &devices);
     void networkStatusChanged(const NetworkInfo &info);
     void errorOccurred(const QString &error);
+    // نتيجة فحص الأدوات غير المتزامن عند بدء المراقبة
+    void toolsChecked(const QStringList &missing);
+    // انتهاء مسح كامل بعد دمج نتائجه ونشرها
+    void sweepFinished();
     void bandwidthUpdated(qint64 download, qint64 upload);
+    void trafficAlert(const TrafficAlert &alert);
+    // نهاية إعادة تشغيل الخدمات بعد جاهزيتها فعلاً (restartRouter يعود فور البدء)
+    void servicesRestarted(bool success, qint64 elapsedMs);
+
+private slots:
+    void onPassiveObservation(const PassiveObservation &observation);
+    void onFingerprintChanged(const QString &macAddress, const DeviceFingerprint &fingerprint);
+    void onLeaseUpdated(const DhcpLease &lease);
+    void onLeaseRemoved(const QString &macAddress);
+    void runScan(ScanScheduler::Depth depth);
+    void onLivenessChanged(const QString &macAddress, bool isActive);
+    void onStationConnected(const QString &macAddress, qint64 timestampUs);
+    void onStationDisconnected(const QString &macAddress, quint16 reasonCode, qint64 timestampUs);
+    void onStationsSampled();
+    void publishDevices();
 
 private:
     std::unique_ptr<QProcess> m_process;
-    std::unique_ptr<QTimer> m_refreshTimer;
+    std::unique_ptr<QTimer> m_publishTimer;
+    std::unique_ptr<ScanScheduler> m_scheduler;
+    std::unique_ptr<NeighborMonitor> m_neighborMonitor;
+    std::unique_ptr<LivenessTracker> m_liveness;
+    std::unique_ptr<PassiveDiscovery> m_passiveDiscovery;
+    std::unique_ptr<DhcpLeaseWatcher> m_leaseWatcher;
+    std::unique_ptr<AssociationTracker> m_associations;
+    std::unique_ptr<StationTelemetry> m_telemetry;
+    std::unique_ptr<TrafficHistory> m_history;
+    std::unique_ptr<AnomalyDetector> m_anomalies;
+    std::unique_ptr<ArpGuard> m_arpGuard;
+    std::unique_ptr<ServiceOrchestrator> m_services;
+    std::unique_ptr<Fingerprinter> m_fingerprinter;
+    std::unique_ptr<DnsQueryLog> m_dnsLog;
+    std::unique_ptr<DeviceSweeper> m_sweeper;
     NetworkInfo m_currentNetwork;
     std::vector<Device> m_devices;
+    QHash<QString, size_t> m_deviceIndex; // MAC (أو IP عند غيابه) -> موقع في m_devices
     QString m_activeInterface;
+    UpdateBus *m_updateBus = nullptr;
+    AppConfig m_config;
+    QHash<QString, bool> m_pendingFirewall; // MAC -> حظر (true) أو إلغاء (false)
+    QHash<QString, QPair<quint64, quint64>> m_stationBytes; // MAC -> آخر عدادي tx/rx من التفريغ
+    QSet<QString> m_blockedMacs;
+    quint64 m_changeCount = 0;   // يزداد مع كل جهاز جديد أو متغير
+    int m_lastSweepPackets = 0;
+    QElapsedTimer m_lastScanFinished;
+    QElapsedTimer m_lastCacheSave;
+    QElapsedTimer m_lastIpv6Probe;
+    QElapsedTimer m_sweepStarted;
+    mutable QHash<QString, bool> m_toolCache;
     
+    bool mergeDevice(const Device &device);
+    void pruneStaleDevices(const QDateTime &cutoff);
+    QString deviceKey(const Device &device) const;
+    QString deviceCachePath() const;
+    void restoreDevices(const std::vector<Device> &devices);
+    bool readFirewallState(Firewall::BlockRules *rules);
+    void applyBlockRules(const Firewall::BlockRules &rules);
+    void schedulePublish();
+    void applyScanProfile(bool passive);
+    bool restartServices(int changes);
+    void readNeighborTable();
+    void mergeNeighborDevices(const std::vector<Device> &devices);
+    bool startFullSweep();
+    void onSweepFinished(const SweepResult &result);
+    void onStartupProbed(const StartupProbe &probe);
+    int reprobeStaleDevices();
+
     void parseConnectedDevices(const QString &output);
     void updateDeviceInfo(Device &device);
     QString executeCommand(const QString &command);
@@ -87,10 +226,7 @@ private:
     bool isCommandAvailable(const QString &command) const;
     QString getActiveWifiInterface() const;
     QString getManufacturer(const QString &macAddress) const;
-    QString getHostname(const QString &ipAddress) const;
-    std::vector<Device> scanWithNmap();
-    std::vector<Device> scanWithArpScan();
-    std::vector<Device> scanWithArpTable();
+    void refreshIpv6Neighbors(const std::vector<NeighborEntry> &neighbors);
 };
 
 #endif // WIFIMANAGER_H
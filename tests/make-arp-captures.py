@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# يولد التقاطات ARP الصغيرة في tests/data لاختبار --replay-arp.
+# الملفات الناتجة محفوظة في المستودع؛ يُعاد تشغيله فقط عند تعديل السيناريوهات.
+
+import os
+import struct
+
+GATEWAY_IP = "192.168.1.1"
+GATEWAY_MAC = "00:11:22:33:44:01"
+ATTACKER_MAC = "00:11:22:33:44:66"
+HOSTS = [("00:11:22:33:44:17", "192.168.1.23"), ("00:11:22:33:44:18", "192.168.1.24")]
+BROADCAST = "ff:ff:ff:ff:ff:ff"
+START = 1760000000  # وقت ثابت فتبقى الملفات متطابقة بين التشغيلات
+
+
+def mac(text):
+    return bytes(int(part, 16) for part in text.split(":"))
+
+
+def ip(text):
+    return bytes(int(part) for part in text.split("."))
+
+
+def arp(op, sender_mac, sender_ip, target_mac, target_ip, destination=None):
+    ethernet = mac(destination or (BROADCAST if op == 1 else target_mac)) + mac(sender_mac) + b"\x08\x06"
+    body = struct.pack("!HHBBH", 1, 0x0800, 6, 4, op)
+    body += mac(sender_mac) + ip(sender_ip) + mac(target_mac) + ip(target_ip)
+    return ethernet + body + bytes(18)  # حشو إلى 60 بايت
+
+
+def gratuitous(sender_mac, sender_ip):
+    return arp(1, sender_mac, sender_ip, "00:00:00:00:00:00", sender_ip, BROADCAST)
+
+
+def write(path, frames):
+    with open(path, "wb") as output:
+        output.write(struct.pack("<IHHiIII", 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        for offset_ms, frame in frames:
+            seconds, millis = divmod(offset_ms, 1000)
+            output.write(struct.pack("<IIII", START + seconds, millis * 1000, len(frame), len(frame)))
+            output.write(frame)
+
+
+def normal_traffic(duration_ms):
+    frames = []
+    for t in range(0, duration_ms, 5000):
+        for host_mac, host_ip in HOSTS:
+            frames.append((t, arp(1, host_mac, host_ip, "00:00:00:00:00:00", GATEWAY_IP)))
+            frames.append((t + 1, arp(2, GATEWAY_MAC, GATEWAY_IP, host_mac, host_ip)))
+    return frames
+
+
+def main():
+    directory = os.path.join(os.path.dirname(os.path.abspath(__file__)), "data")
+    os.makedirs(directory, exist_ok=True)
+
+    # حركة عادية: لا تنبيهات
+    write(os.path.join(directory, "arp-clean.pcap"), normal_traffic(60000))
+
+    # جهاز له عنوانه الخاص يرد باسم البوابة بعد 30 ثانية
+    frames = normal_traffic(30000)
+    frames.append((30000, arp(1, ATTACKER_MAC, "192.168.1.66", "00:00:00:00:00:00", GATEWAY_IP)))
+    for t in range(31000, 40000, 2000):
+        for host_mac, host_ip in HOSTS:
+            frames.append((t, arp(2, ATTACKER_MAC, GATEWAY_IP, host_mac, host_ip)))
+    write(os.path.join(directory, "arp-spoofed-gateway.pcap"), sorted(frames, key=lambda f: f[0]))
+
+    # جهازان يدعيان العنوان نفسه خلال دقيقة
+    frames = normal_traffic(20000)
+    frames.append((2000, gratuitous("00:11:22:33:44:31", "192.168.1.50")))
+    frames.append((45000, gratuitous("00:11:22:33:44:32", "192.168.1.50")))
+    write(os.path.join(directory, "arp-duplicate-ip.pcap"), sorted(frames, key=lambda f: f[0]))
+
+    # 40 حزمة ARP مجانية في 4 ثوانٍ من جهاز واحد
+    frames = normal_traffic(10000)
+    for i in range(40):
+        frames.append((1000 + i * 100, gratuitous("00:11:22:33:44:41", "192.168.1.70")))
+    write(os.path.join(directory, "arp-gratuitous-flood.pcap"), sorted(frames, key=lambda f: f[0]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# إعادة تشغيل التقاطات tests/data عبر --replay-arp والتحقق من التنبيهات ورمز الخروج
+#   replay-arp.sh <WifiManager> <data-dir>
+
+binary="$1"
+data="$2"
+status=0
+
+# الملف، رمز الخروج المتوقع، نص يجب أن يظهر في التنبيهات (فارغ: لا تنبيهات)، وسائط إضافية
+check() {
+    local capture="$1" expected="$2" pattern="$3"
+    shift 3
+    local output code
+    output=$(QT_QPA_PLATFORM=offscreen "$binary" --replay-arp "$capture" "$@" 2>/dev/null)
+    code=$?
+    if [[ $code -ne $expected ]]; then
+        echo "FAIL $(basename "$capture"): exit $code, expected $expected"
+        echo "$output"
+        status=1
+    elif [[ -n "$pattern" && "$output" != *"$pattern"* ]]; then
+        echo "FAIL $(basename "$capture"): no alert matching '$pattern'"
+        echo "$output"
+        status=1
+    elif [[ -z "$pattern" && -n "$output" ]]; then
+        echo "FAIL $(basename "$capture"): unexpected alerts"
+        echo "$output"
+        status=1
+    else
+        echo "PASS $(basename "$capture")"
+    fi
+}
+
+check "$data/arp-clean.pcap" 0 "" --gateway 192.168.1.1
+check "$data/arp-spoofed-gateway.pcap" 2 "تغير MAC البوابة (192.168.1.1) من 00:11:22:33:44:01 إلى 00:11:22:33:44:66" \
+    --gateway 192.168.1.1
+check "$data/arp-spoofed-gateway.pcap" 2 "انتحال ARP محتمل" --gateway 192.168.1.1
+check "$data/arp-duplicate-ip.pcap" 2 "تعارض عناوين: 192.168.1.50 يدعيه 00:11:22:33:44:31 و 00:11:22:33:44:32"
+check "$data/arp-gratuitous-flood.pcap" 2 "سيل ARP مجاني من 00:11:22:33:44:41"
+
+# ملف غير صالح: خطأ قراءة لا تنبيه
+invalid=$(mktemp)
+printf 'not a capture file' > "$invalid"
+check "$invalid" 1 ""
+rm -f "$invalid"
+
+exit $status
@@ -0,0 +1,74 @@
+#include <QtTest>
+#include <QHash>
+#include <QSet>
+#include "livenesstracker.h"
+
+// محاكاة 1000 جهاز متتبع يصمت نصفها: النصف المجيب لا يُفحص أبداً، وكل جهاز
+// صامت يُفحص 3 مرات بالضبط قبل اعتباره غير متصل. المهل مصغرة إلى ثانية
+// (أصغر tick في العجلة) حتى تنتهي المحاكاة في ثوانٍ.
+class LivenessTrackerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void silentHalfNeedsThreeProbesEach();
+};
+
+void LivenessTrackerTest::silentHalfNeedsThreeProbesEach() {
+    const int devices = 1000;
+    const int misses = 3;
+
+    LivenessTracker tracker;
+    tracker.setTimeouts(1000, 1000, misses);
+
+    auto mac = [](int i) {
+        return QString("02:00:00:00:%1:%2").arg(i / 256, 2, 16, QChar('0')).arg(i % 256, 2, 16, QChar('0')).toUpper();
+    };
+    auto ip = [](int i) { return QString("10.0.%1.%2").arg(i / 250).arg(i % 250 + 1); };
+    auto silent = [](int i) { return i % 2 == 1; };
+
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < devices; ++i) {
+        QVERIFY(tracker.noteReply(mac(i), ip(i), now));
+    }
+    QCOMPARE(tracker.trackedCount(), devices);
+
+    // دورة Reprobe في المجدول تسحب كل الفحوصات المستحقة، والأجهزة المجيبة ترد كل ربع ثانية
+    QHash<QString, int> probes;
+    QHash<QString, int> probesWhenInactive;
+    QSet<QString> wentInactive;
+    connect(&tracker, &LivenessTracker::livenessChanged, this,
+            [&](const QString &macAddress, bool isActive) {
+        if (!isActive) {
+            wentInactive.insert(macAddress);
+            probesWhenInactive.insert(macAddress, probes.value(macAddress));
+        }
+    });
+    QTimer traffic;
+    traffic.setInterval(250);
+    connect(&traffic, &QTimer::timeout, this, [&]() {
+        const QDateTime replyTime = QDateTime::currentDateTime();
+        for (int i = 0; i < devices; i += 2) {
+            tracker.noteReply(mac(i), ip(i), replyTime);
+        }
+        for (const LivenessTracker::Probe &probe : tracker.takeDueProbes(devices)) {
+            ++probes[probe.macAddress];
+        }
+    });
+    traffic.start();
+    tracker.start();
+
+    QTRY_COMPARE_WITH_TIMEOUT(wentInactive.size(), devices / 2, 20000);
+
+    for (int i = 0; i < devices; ++i) {
+        if (silent(i)) {
+            QVERIFY2(wentInactive.contains(mac(i)), qPrintable(mac(i)));
+            QCOMPARE(probesWhenInactive.value(mac(i)), misses);
+        } else {
+            QVERIFY2(!wentInactive.contains(mac(i)), qPrintable(mac(i)));
+            QCOMPARE(probes.value(mac(i)), 0);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(LivenessTrackerTest)
+#include "tst_livenesstracker.moc"
@@ -0,0 +1,101 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <memory>
+#include "serviceorchestrator.h"
+
+// ترتيب المراحل وجاهزية الوحدات مع systemctl وهمي (tests/mock-systemctl):
+// النسخة القديمة تبقى active إلى أن تنقضي مهلة الوحدة، كما يحدث مع --no-block
+class ServiceOrchestratorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void restartsStagesInDependencyOrder();
+    void reportsFailedUnit();
+    void skipsUnitsNotInstalled();
+
+private:
+    std::unique_ptr<QTemporaryDir> m_state;
+
+    QStringList calls() const;
+};
+
+void ServiceOrchestratorTest::init() {
+    m_state = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_state->isValid());
+    qputenv("WIFIMANAGER_SYSTEMCTL", MOCK_SYSTEMCTL);
+    qputenv("MOCK_SYSTEMCTL_STATE", m_state->path().toLocal8Bit());
+    qunsetenv("MOCK_SYSTEMCTL_UNITS");
+    qunsetenv("MOCK_SYSTEMCTL_DELAY");
+    qunsetenv("MOCK_SYSTEMCTL_FAIL");
+}
+
+QStringList ServiceOrchestratorTest::calls() const {
+    QFile file(m_state->filePath("calls.log"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QStringList();
+    }
+    return QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+}
+
+void ServiceOrchestratorTest::restartsStagesInDependencyOrder() {
+    // الشبكة بطيئة: لا يُطلب شيء من المرحلة التالية قبل أن تجيب نسختها الجديدة
+    qputenv("MOCK_SYSTEMCTL_DELAY", "networking=800 wpa_supplicant=300");
+
+    ServiceOrchestrator orchestrator;
+    orchestrator.setServices({"networking", "wpa_supplicant", "vpn.service"});
+    orchestrator.setReadyTimeout(5000);
+    QSignalSpy ready(&orchestrator, &ServiceOrchestrator::unitReady);
+    QSignalSpy finished(&orchestrator, &ServiceOrchestrator::finished);
+
+    QVERIFY(orchestrator.restart(ServiceOrchestrator::AllServices));
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.first().at(0).toBool(), true);
+
+    QCOMPARE(ready.size(), 3);
+    QCOMPARE(ready.at(0).at(0).toString(), QString("networking"));
+
+    const QStringList log = calls();
+    const int recorded = log.indexOf("show -p InvocationID networking");
+    const int restartNetworking = log.indexOf("restart --no-block networking");
+    const int networkingReady = log.indexOf("ready networking active");
+    const int restartSupplicant = log.indexOf("restart --no-block wpa_supplicant");
+    const int restartVpn = log.indexOf("restart --no-block vpn");
+    QVERIFY2(recorded >= 0 && recorded < restartNetworking, qPrintable(log.join('\n')));
+    QVERIFY2(networkingReady > restartNetworking, qPrintable(log.join('\n')));
+    QVERIFY2(restartSupplicant > networkingReady, qPrintable(log.join('\n')));
+    QVERIFY2(restartVpn > networkingReady, qPrintable(log.join('\n')));
+}
+
+void ServiceOrchestratorTest::reportsFailedUnit() {
+    qputenv("MOCK_SYSTEMCTL_FAIL", "dnsmasq");
+
+    ServiceOrchestrator orchestrator;
+    orchestrator.setServices({"networking", "dnsmasq"});
+    orchestrator.setReadyTimeout(5000);
+    QSignalSpy failed(&orchestrator, &ServiceOrchestrator::unitFailed);
+    QSignalSpy finished(&orchestrator, &ServiceOrchestrator::finished);
+
+    QVERIFY(orchestrator.restart(ServiceOrchestrator::DhcpConfig));
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.first().at(0).toBool(), false);
+    QCOMPARE(failed.size(), 1);
+    QCOMPARE(failed.first().at(0).toString(), QString("dnsmasq"));
+
+    // تغيير dnsmasq وحده لا يمس الشبكة
+    QCOMPARE(calls().indexOf("restart --no-block networking"), -1);
+}
+
+void ServiceOrchestratorTest::skipsUnitsNotInstalled() {
+    qputenv("MOCK_SYSTEMCTL_UNITS", "networking");
+
+    ServiceOrchestrator orchestrator;
+    orchestrator.setServices({"networking", "hostapd"});
+    QCOMPARE(orchestrator.installedUnits(), QStringList{"networking"});
+    QVERIFY(!orchestrator.restart(ServiceOrchestrator::AccessPointConfig));
+    QVERIFY(!orchestrator.isBusy());
+}
+
+QTEST_GUILESS_MAIN(ServiceOrchestratorTest)
+#include "tst_serviceorchestrator.moc"